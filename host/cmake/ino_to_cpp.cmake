@@ -0,0 +1,43 @@
+# Turn an Arduino sketch into a C++ translation unit the way arduino-cli does:
+# add #include <Arduino.h> and insert prototypes for every top-level function
+# just before the first function definition, keeping #line info for errors.
+#
+# Usage: cmake -DINO=<sketch.ino> -DOUT=<file.cpp> -P ino_to_cpp.cmake
+
+file(READ "${INO}" content)
+
+# Top-level definitions start at column 0 and open their body on the same line
+set(id "[A-Za-z_][A-Za-z0-9_]*")
+set(def_regex "\n${id}[A-Za-z0-9_:<>*& \t]*[ \t*&]+${id}[ \t]*\\([^;{}()]*\\)[ \t]*\\{")
+string(REGEX MATCHALL "${def_regex}" definitions "${content}")
+
+if(NOT definitions)
+  message(FATAL_ERROR "ino_to_cpp: no function definitions found in ${INO}")
+endif()
+
+set(prototypes "")
+foreach(def IN LISTS definitions)
+  string(REGEX REPLACE "^\n" "" def "${def}")
+  string(REGEX REPLACE "[ \t]*\\{$" ";" def "${def}")
+  string(APPEND prototypes "${def}\n")
+endforeach()
+
+# Split at the first definition
+list(GET definitions 0 first)
+string(FIND "${content}" "${first}" split)
+math(EXPR split "${split} + 1")
+string(SUBSTRING "${content}" 0 ${split} head)
+string(SUBSTRING "${content}" ${split} -1 tail)
+
+string(REGEX MATCHALL "\n" newlines "${head}")
+list(LENGTH newlines head_lines)
+math(EXPR tail_line "${head_lines} + 1")
+
+file(WRITE "${OUT}"
+  "#include <Arduino.h>\n"
+  "#line 1 \"${INO}\"\n"
+  "${head}"
+  "// Prototypes (generated)\n"
+  "${prototypes}"
+  "#line ${tail_line} \"${INO}\"\n"
+  "${tail}")
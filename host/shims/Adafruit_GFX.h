@@ -0,0 +1,460 @@
+/*
+ * Host shim: Adafruit_GFX
+ *
+ * Same virtual primitive interface as the real library so subclasses
+ * (InstrumentedST7789) override the same calls, and the same shape/text
+ * algorithms so primitive counts match the device. Text uses a built-in
+ * 5x7 font; the FreeSans fonts are metric stand-ins drawn with it scaled.
+ *
+ * Every public API call is also attributed to hostGfxApiStats (outermost
+ * call only) so tools can see what each API costs.
+ */
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Metric stand-in for a GFX font: the 5x7 glyphs scaled, baseline positioned
+typedef struct {
+  uint8_t scale;     // Glyph pixel size
+  uint8_t xAdvance;  // Cursor advance per character
+  uint8_t yAdvance;  // Line height
+} GFXfont;
+
+// Classic 5x7 font, column-major, LSB at the top (ASCII 0x20-0x7E)
+static const uint8_t hostFont5x7[95][5] = {
+  {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+  {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+  {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+  {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+  {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+  {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+  {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+  {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+  {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+  {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32},
+  {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+  {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+  {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F},
+  {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+  {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+  {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+  {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C},
+  {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x00,0x7F,0x10,0x28,0x44},
+  {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+  {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+  {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+  {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+  {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x10,0x08,0x08,0x10,0x08}
+};
+
+// Code page 437 arrows used in footers (0x18-0x1B), unknown codes draw a box
+static const uint8_t hostFontArrows[4][5] = {
+  {0x04,0x02,0x7F,0x02,0x04}, {0x10,0x20,0x7F,0x20,0x10}, {0x08,0x08,0x2A,0x1C,0x08}, {0x08,0x1C,0x2A,0x08,0x08}
+};
+static const uint8_t hostFontBox[5] = {0x7F,0x41,0x41,0x41,0x7F};
+
+inline const uint8_t* hostGlyph(unsigned char c) {
+  if (c >= 0x20 && c <= 0x7E) return hostFont5x7[c - 0x20];
+  if (c >= 0x18 && c <= 0x1B) return hostFontArrows[c - 0x18];
+  return hostFontBox;
+}
+
+// Cost of each GFX API, filled in by the display driver shim
+struct HostGfxApiStats {
+  const char* name;
+  uint32_t calls;
+  uint64_t pixels;
+  uint64_t transactions;
+  uint64_t bytes;
+};
+
+#define HOST_GFX_MAX_APIS 48
+inline HostGfxApiStats hostGfxApiStats[HOST_GFX_MAX_APIS];
+inline int hostGfxApiCount = 0;
+inline HostGfxApiStats* hostGfxCurrentApi = nullptr;
+
+// Called on every outermost API call (simulators record display activity)
+inline void (*hostGfxCallHook)(const char* name) = nullptr;
+
+inline HostGfxApiStats* hostGfxApi(const char* name) {
+  for (int i = 0; i < hostGfxApiCount; i++) {
+    if (strcmp(hostGfxApiStats[i].name, name) == 0) return &hostGfxApiStats[i];
+  }
+  if (hostGfxApiCount >= HOST_GFX_MAX_APIS) return nullptr;
+  HostGfxApiStats* s = &hostGfxApiStats[hostGfxApiCount++];
+  *s = HostGfxApiStats{name, 0, 0, 0, 0};
+  return s;
+}
+
+inline void hostGfxResetApiStats() {
+  for (int i = 0; i < hostGfxApiCount; i++) {
+    hostGfxApiStats[i] = HostGfxApiStats{hostGfxApiStats[i].name, 0, 0, 0, 0};
+  }
+}
+
+// Attributes driver cost to the outermost API call on the stack
+class HostGfxApiScope {
+public:
+  explicit HostGfxApiScope(const char* name) : outer(hostGfxCurrentApi == nullptr) {
+    if (outer) {
+      hostGfxCurrentApi = hostGfxApi(name);
+      if (hostGfxCurrentApi) hostGfxCurrentApi->calls++;
+      if (hostGfxCallHook) hostGfxCallHook(name);
+    }
+  }
+  ~HostGfxApiScope() { if (outer) hostGfxCurrentApi = nullptr; }
+private:
+  bool outer;
+};
+
+#define HOST_GFX_API(name) HostGfxApiScope hostGfxScope_(name)
+
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+  virtual ~Adafruit_GFX() {}
+
+  // Primitives subclasses override
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+  virtual void startWrite(void) {}
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+  virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color); }
+  virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { drawFastVLine(x, y, h, color); }
+  virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { drawFastHLine(x, y, w, color); }
+  virtual void endWrite(void) {}
+
+  virtual void setRotation(uint8_t r) {
+    rotation = r & 3;
+    _width = (rotation & 1) ? HEIGHT : WIDTH;
+    _height = (rotation & 1) ? WIDTH : HEIGHT;
+  }
+
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    startWrite();
+    writeLine(x, y, x, y + h - 1, color);
+    endWrite();
+  }
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    startWrite();
+    writeLine(x, y, x + w - 1, y, color);
+    endWrite();
+  }
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    startWrite();
+    for (int16_t i = x; i < x + w; i++) writeFastVLine(i, y, h, color);
+    endWrite();
+  }
+  virtual void fillScreen(uint16_t color) {
+    HOST_GFX_API("fillScreen");
+    fillRect(0, 0, _width, _height, color);
+  }
+
+  virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    HOST_GFX_API("drawLine");
+    if (x0 == x1) {
+      if (y0 > y1) std::swap(y0, y1);
+      drawFastVLine(x0, y0, y1 - y0 + 1, color);
+    } else if (y0 == y1) {
+      if (x0 > x1) std::swap(x0, x1);
+      drawFastHLine(x0, y0, x1 - x0 + 1, color);
+    } else {
+      startWrite();
+      writeLine(x0, y0, x1, y1, color);
+      endWrite();
+    }
+  }
+
+  virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+    if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+    int16_t dx = x1 - x0, dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+      if (steep) writePixel(y0, x0, color);
+      else writePixel(x0, y0, color);
+      err -= dy;
+      if (err < 0) { y0 += ystep; err += dx; }
+    }
+  }
+
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    HOST_GFX_API("drawRect");
+    startWrite();
+    writeFastHLine(x, y, w, color);
+    writeFastHLine(x, y + h - 1, w, color);
+    writeFastVLine(x, y, h, color);
+    writeFastVLine(x + w - 1, y, h, color);
+    endWrite();
+  }
+
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    HOST_GFX_API("drawCircle");
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    startWrite();
+    writePixel(x0, y0 + r, color);
+    writePixel(x0, y0 - r, color);
+    writePixel(x0 + r, y0, color);
+    writePixel(x0 - r, y0, color);
+    while (x < y) {
+      if (f >= 0) { y--; ddF_y += 2; f += ddF_y; }
+      x++; ddF_x += 2; f += ddF_x;
+      writePixel(x0 + x, y0 + y, color);
+      writePixel(x0 - x, y0 + y, color);
+      writePixel(x0 + x, y0 - y, color);
+      writePixel(x0 - x, y0 - y, color);
+      writePixel(x0 + y, y0 + x, color);
+      writePixel(x0 - y, y0 + x, color);
+      writePixel(x0 + y, y0 - x, color);
+      writePixel(x0 - y, y0 - x, color);
+    }
+    endWrite();
+  }
+
+  void drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while (x < y) {
+      if (f >= 0) { y--; ddF_y += 2; f += ddF_y; }
+      x++; ddF_x += 2; f += ddF_x;
+      if (cornername & 0x4) { writePixel(x0 + x, y0 + y, color); writePixel(x0 + y, y0 + x, color); }
+      if (cornername & 0x2) { writePixel(x0 + x, y0 - y, color); writePixel(x0 + y, y0 - x, color); }
+      if (cornername & 0x8) { writePixel(x0 - y, y0 + x, color); writePixel(x0 - x, y0 + y, color); }
+      if (cornername & 0x1) { writePixel(x0 - y, y0 - x, color); writePixel(x0 - x, y0 - y, color); }
+    }
+  }
+
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    HOST_GFX_API("fillCircle");
+    startWrite();
+    writeFastVLine(x0, y0 - r, 2 * r + 1, color);
+    fillCircleHelper(x0, y0, r, 3, 0, color);
+    endWrite();
+  }
+
+  void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    int16_t px = x, py = y;
+    delta++;
+    while (x < y) {
+      if (f >= 0) { y--; ddF_y += 2; f += ddF_y; }
+      x++; ddF_x += 2; f += ddF_x;
+      if (x < (y + 1)) {
+        if (corners & 1) writeFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+        if (corners & 2) writeFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+      }
+      if (y != py) {
+        if (corners & 1) writeFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+        if (corners & 2) writeFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+        py = y;
+      }
+      px = x;
+    }
+  }
+
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    HOST_GFX_API("drawRoundRect");
+    int16_t max_radius = ((w < h) ? w : h) / 2;
+    if (r > max_radius) r = max_radius;
+    startWrite();
+    writeFastHLine(x + r, y, w - 2 * r, color);
+    writeFastHLine(x + r, y + h - 1, w - 2 * r, color);
+    writeFastVLine(x, y + r, h - 2 * r, color);
+    writeFastVLine(x + w - 1, y + r, h - 2 * r, color);
+    drawCircleHelper(x + r, y + r, r, 1, color);
+    drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+    drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+    endWrite();
+  }
+
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    HOST_GFX_API("fillRoundRect");
+    int16_t max_radius = ((w < h) ? w : h) / 2;
+    if (r > max_radius) r = max_radius;
+    startWrite();
+    writeFillRect(x + r, y, w - 2 * r, h, color);
+    fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
+    fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
+    endWrite();
+  }
+
+  void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+    HOST_GFX_API("drawTriangle");
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+  }
+
+  void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+    HOST_GFX_API("fillTriangle");
+    int16_t a, b, y, last;
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+
+    startWrite();
+    if (y0 == y2) {
+      a = b = x0;
+      if (x1 < a) a = x1; else if (x1 > b) b = x1;
+      if (x2 < a) a = x2; else if (x2 > b) b = x2;
+      writeFastHLine(a, y0, b - a + 1, color);
+      endWrite();
+      return;
+    }
+
+    int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0, dx12 = x2 - x1, dy12 = y2 - y1;
+    int32_t sa = 0, sb = 0;
+    last = (y1 == y2) ? y1 : y1 - 1;
+    for (y = y0; y <= last; y++) {
+      a = x0 + sa / dy01;
+      b = x0 + sb / dy02;
+      sa += dx01;
+      sb += dx02;
+      if (a > b) std::swap(a, b);
+      writeFastHLine(a, y, b - a + 1, color);
+    }
+    sa = (int32_t)dx12 * (y - y1);
+    sb = (int32_t)dx02 * (y - y0);
+    for (; y <= y2; y++) {
+      a = x1 + sa / dy12;
+      b = x0 + sb / dy02;
+      sa += dx12;
+      sb += dx02;
+      if (a > b) std::swap(a, b);
+      writeFastHLine(a, y, b - a + 1, color);
+    }
+    endWrite();
+  }
+
+  // Text
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y) {
+    HOST_GFX_API("drawChar");
+    const uint8_t* glyph = hostGlyph(c);
+
+    if (!gfxFont) {
+      if ((x >= _width) || (y >= _height) || ((x + 6 * size_x - 1) < 0) || ((y + 8 * size_y - 1) < 0)) return;
+      startWrite();
+      for (int8_t i = 0; i < 5; i++) {
+        uint8_t line = glyph[i];
+        for (int8_t j = 0; j < 8; j++, line >>= 1) {
+          if (line & 1) {
+            if (size_x == 1 && size_y == 1) writePixel(x + i, y + j, color);
+            else writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, color);
+          } else if (bg != color) {
+            if (size_x == 1 && size_y == 1) writePixel(x + i, y + j, bg);
+            else writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
+          }
+        }
+      }
+      if (bg != color) {
+        if (size_x == 1 && size_y == 1) writeFastVLine(x + 5, y, 8, bg);
+        else writeFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+      }
+      endWrite();
+    } else {
+      // Custom fonts draw foreground only, glyph sits on the baseline
+      int16_t sx = gfxFont->scale * size_x, sy = gfxFont->scale * size_y;
+      int16_t top = y - 7 * sy;
+      startWrite();
+      for (int8_t i = 0; i < 5; i++) {
+        uint8_t line = glyph[i];
+        for (int8_t j = 0; j < 7; j++, line >>= 1) {
+          if (line & 1) writeFillRect(x + i * sx, top + j * sy, sx, sy, color);
+        }
+      }
+      endWrite();
+    }
+  }
+
+  size_t write(uint8_t c) override {
+    if (!gfxFont) {
+      if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += textsize_y * 8;
+      } else if (c != '\r') {
+        if (wrap && ((cursor_x + textsize_x * 6) > _width)) {
+          cursor_x = 0;
+          cursor_y += textsize_y * 8;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+        cursor_x += textsize_x * 6;
+      }
+    } else {
+      if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+      } else if (c != '\r') {
+        int16_t advance = (int16_t)textsize_x * gfxFont->xAdvance;
+        if (wrap && ((cursor_x + advance) > _width)) {
+          cursor_x = 0;
+          cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+        }
+        if (c != ' ') drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+        cursor_x += advance;
+      }
+    }
+    return 1;
+  }
+  using Print::write;
+
+  void getTextBounds(const char* str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    int16_t lineWidth = 0, maxWidth = 0, lines = 1;
+    for (const char* p = str; *p; p++) {
+      if (*p == '\n') { lines++; lineWidth = 0; continue; }
+      if (*p == '\r') continue;
+      lineWidth++;
+      if (lineWidth > maxWidth) maxWidth = lineWidth;
+    }
+    if (!gfxFont) {
+      *x1 = x;
+      *y1 = y;
+      *w = maxWidth ? maxWidth * 6 * textsize_x - textsize_x : 0;  // No trailing gap
+      *h = maxWidth ? lines * 8 * textsize_y : 0;
+    } else {
+      int16_t sy = gfxFont->scale * textsize_y;
+      *x1 = x;
+      *y1 = y - 7 * sy;
+      *w = maxWidth ? maxWidth * gfxFont->xAdvance * textsize_x : 0;
+      *h = maxWidth ? 7 * sy + (lines - 1) * gfxFont->yAdvance * textsize_y : 0;
+    }
+  }
+  void getTextBounds(const String& str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    getTextBounds(str.c_str(), x, y, x1, y1, w, h);
+  }
+
+  void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+  void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+  void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+  void setTextSize(uint8_t s) { setTextSize(s, s); }
+  void setTextSize(uint8_t sx, uint8_t sy) { textsize_x = sx > 0 ? sx : 1; textsize_y = sy > 0 ? sy : 1; }
+  void setTextWrap(bool w) { wrap = w; }
+  void setFont(const GFXfont* f = nullptr) {
+    // Same cursor adjustment as the real library when switching font kinds
+    if (f && !gfxFont) cursor_y += 6;
+    else if (!f && gfxFont) cursor_y -= 6;
+    gfxFont = f;
+  }
+  void cp437(bool x = true) {}
+
+  int16_t width(void) const { return _width; }
+  int16_t height(void) const { return _height; }
+  uint8_t getRotation(void) const { return rotation; }
+  int16_t getCursorX(void) const { return cursor_x; }
+  int16_t getCursorY(void) const { return cursor_y; }
+
+protected:
+  int16_t WIDTH, HEIGHT;
+  int16_t _width, _height;
+  int16_t cursor_x = 0, cursor_y = 0;
+  uint16_t textcolor = 0xFFFF, textbgcolor = 0xFFFF;
+  uint8_t textsize_x = 1, textsize_y = 1;
+  uint8_t rotation = 0;
+  bool wrap = true;
+  const GFXfont* gfxFont = nullptr;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
@@ -0,0 +1,38 @@
+/*
+ * Host shim: LC709203F fuel gauge (absent unless hostPresent is set)
+ */
+
+#ifndef HOST_ADAFRUIT_LC709203F_H
+#define HOST_ADAFRUIT_LC709203F_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+typedef enum {
+  LC709203F_APA_100MAH = 0x08,
+  LC709203F_APA_200MAH = 0x0B,
+  LC709203F_APA_500MAH = 0x10,
+  LC709203F_APA_1000MAH = 0x19,
+  LC709203F_APA_2000MAH = 0x2D,
+  LC709203F_APA_3000MAH = 0x36
+} lc709203_adjustment_t;
+
+class Adafruit_LC709203F {
+public:
+  bool hostPresent = false;
+  float hostVoltage = 3.95f;
+  float hostPercent = 80.0f;
+
+  // One register read: address + register, restart, address + 2 data bytes
+  void hostReadRegister() { Wire.hostBusTime(5); }
+
+  bool begin(TwoWire* wire = &Wire) { return hostPresent; }
+  uint16_t getICversion() { return 0x2717; }
+  bool setThermistorB(uint16_t b) { return true; }
+  bool setPackSize(lc709203_adjustment_t size) { return true; }
+  bool setAlarmVoltage(float voltage) { return true; }
+  float cellVoltage() { hostReadRegister(); return hostVoltage; }
+  float cellPercent() { hostReadRegister(); return hostPercent; }
+};
+
+#endif // HOST_ADAFRUIT_LC709203F_H
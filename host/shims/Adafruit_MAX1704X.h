@@ -0,0 +1,32 @@
+/*
+ * Host shim: MAX17048 fuel gauge (absent unless hostPresent is set)
+ */
+
+#ifndef HOST_ADAFRUIT_MAX1704X_H
+#define HOST_ADAFRUIT_MAX1704X_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class Adafruit_MAX17048 {
+public:
+  bool hostPresent = false;
+  float hostVoltage = 3.95f;
+  float hostPercent = 80.0f;
+  float hostChargeRate = -2.0f;  // %/hr
+
+  // One register read: address + register, restart, address + 2 data bytes
+  void hostReadRegister() { Wire.hostBusTime(5); }
+
+  bool begin(TwoWire* wire = &Wire) { return hostPresent; }
+  uint16_t getChipID() { return 0x0C; }
+  float cellVoltage() { hostReadRegister(); return hostVoltage; }
+  float cellPercent() { hostReadRegister(); return hostPercent; }
+  float chargeRate() { hostReadRegister(); return hostChargeRate; }
+  bool isDeviceReady() { return hostPresent; }
+  void quickStart() {}
+  void hibernate() {}
+  void wake() {}
+};
+
+#endif // HOST_ADAFRUIT_MAX1704X_H
@@ -0,0 +1,187 @@
+/*
+ * Host shim: Adafruit_ST7789 backed by an RGB565 framebuffer
+ *
+ * The framebuffer holds the logical (rotated) image. Each primitive is
+ * costed the way the SPI driver would send it: a transaction per
+ * startWrite(), an 11-byte address window (CASET/RASET/RAMWR) per region
+ * and 2 bytes per pixel. The virtual clock advances by the estimated bus
+ * time, so micros() based measurements in the firmware see SPI cost.
+ */
+
+#ifndef HOST_ADAFRUIT_ST7789_H
+#define HOST_ADAFRUIT_ST7789_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <vector>
+
+// Colors (RGB565), same values as Adafruit_ST77xx.h
+#define ST77XX_BLACK   0x0000
+#define ST77XX_WHITE   0xFFFF
+#define ST77XX_RED     0xF800
+#define ST77XX_GREEN   0x07E0
+#define ST77XX_BLUE    0x001F
+#define ST77XX_CYAN    0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW  0xFFE0
+#define ST77XX_ORANGE  0xFC00
+
+#define ST7789_WINDOW_BYTES 11  // CASET + 4, RASET + 4, RAMWR
+
+// Bus totals (all draws since the last reset)
+struct HostDisplayBus {
+  uint32_t spiHz = 40000000;       // SPI clock used for the time estimate
+  uint32_t transactionMicros = 2;  // CS/transaction overhead
+  uint64_t transactions = 0;
+  uint64_t windows = 0;
+  uint64_t pixels = 0;
+  uint64_t bytes = 0;
+  double busMicros = 0;            // Estimated wire time
+  bool advanceClock = true;        // Charge bus time to the virtual clock
+};
+
+inline HostDisplayBus hostDisplayBus;
+
+class Adafruit_ST7789 : public Adafruit_GFX {
+public:
+  Adafruit_ST7789(int8_t cs, int8_t dc, int8_t rst) : Adafruit_GFX(240, 320) {}
+
+  void init(uint16_t width, uint16_t height, uint8_t spiMode = 0) {
+    WIDTH = width;
+    HEIGHT = height;
+    framebuffer.assign((size_t)width * height, 0x0000);
+    setRotation(0);
+    delay(200);  // Init sequence delays (SWRESET 150 ms, then 10 ms steps)
+  }
+
+  void setRotation(uint8_t m) override {
+    Adafruit_GFX::setRotation(m);
+    // The image is kept in logical orientation, so a rotation starts blank
+    std::fill(framebuffer.begin(), framebuffer.end(), 0x0000);
+  }
+
+  void setSPISpeed(uint32_t freq) { hostDisplayBus.spiHz = freq; }
+  void invertDisplay(bool i) {}
+  void enableDisplay(bool enable) {}
+  void enableSleep(bool enable) {}
+
+  void startWrite(void) override {
+    HostDisplayBus& bus = hostDisplayBus;
+    bus.transactions++;
+    if (hostGfxCurrentApi) hostGfxCurrentApi->transactions++;
+    charge(0, bus.transactionMicros);
+  }
+  void endWrite(void) override {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    HOST_GFX_API("drawPixel");
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    startWrite();
+    writeFillRectPreclipped(x, y, 1, 1, color);
+    endWrite();
+  }
+
+  void writePixel(int16_t x, int16_t y, uint16_t color) override {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    writeFillRectPreclipped(x, y, 1, 1, color);
+  }
+
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    if (clip(x, y, w, h)) writeFillRectPreclipped(x, y, w, h, color);
+  }
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    int16_t h = 1;
+    if (clip(x, y, w, h)) writeFillRectPreclipped(x, y, w, 1, color);
+  }
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    int16_t w = 1;
+    if (clip(x, y, w, h)) writeFillRectPreclipped(x, y, 1, h, color);
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    HOST_GFX_API("fillRect");
+    if (!clip(x, y, w, h)) return;
+    startWrite();
+    writeFillRectPreclipped(x, y, w, h, color);
+    endWrite();
+  }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    HOST_GFX_API("drawFastHLine");
+    int16_t h = 1;
+    if (!clip(x, y, w, h)) return;
+    startWrite();
+    writeFillRectPreclipped(x, y, w, 1, color);
+    endWrite();
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    HOST_GFX_API("drawFastVLine");
+    int16_t w = 1;
+    if (!clip(x, y, w, h)) return;
+    startWrite();
+    writeFillRectPreclipped(x, y, 1, h, color);
+    endWrite();
+  }
+
+  // Host side: read back the image (logical orientation, RGB565)
+  const uint16_t* hostFramebuffer() const { return framebuffer.data(); }
+  uint16_t hostPixel(int16_t x, int16_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    return framebuffer[(size_t)y * _width + x];
+  }
+
+private:
+  std::vector<uint16_t> framebuffer;
+
+  // Clip to the screen, normalizing negative sizes; false when nothing is left
+  bool clip(int16_t& x, int16_t& y, int16_t& w, int16_t& h) {
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    int32_t x2 = (int32_t)x + w, y2 = (int32_t)y + h;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x2 > _width) x2 = _width;
+    if (y2 > _height) y2 = _height;
+    if (x2 <= x || y2 <= y) return false;
+    w = (int16_t)(x2 - x);
+    h = (int16_t)(y2 - y);
+    return true;
+  }
+
+  // One address window plus the pixel stream
+  void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (framebuffer.size() != (size_t)_width * _height) return;  // init() not called
+    for (int16_t row = y; row < y + h; row++) {
+      uint16_t* p = &framebuffer[(size_t)row * _width + x];
+      for (int16_t col = 0; col < w; col++) p[col] = color;
+    }
+
+    uint64_t pixels = (uint64_t)w * h;
+    uint64_t bytes = ST7789_WINDOW_BYTES + pixels * 2;
+    HostDisplayBus& bus = hostDisplayBus;
+    bus.windows++;
+    bus.pixels += pixels;
+    bus.bytes += bytes;
+    if (hostGfxCurrentApi) {
+      hostGfxCurrentApi->pixels += pixels;
+      hostGfxCurrentApi->bytes += bytes;
+    }
+    charge(bytes, 0);
+  }
+
+  void charge(uint64_t bytes, uint32_t overheadMicros) {
+    HostDisplayBus& bus = hostDisplayBus;
+    double us = bytes * 8.0 * 1e6 / bus.spiHz + overheadMicros;
+    bus.busMicros += us;
+    if (bus.advanceClock) {
+      // Carry the fractional part so many small writes still add up
+      busCarry += us;
+      uint64_t whole = (uint64_t)busCarry;
+      busCarry -= whole;
+      if (whole) hostAdvanceMicros(whole);
+    }
+  }
+
+  double busCarry = 0;
+};
+
+#endif // HOST_ADAFRUIT_ST7789_H
@@ -0,0 +1,410 @@
+/*
+ * Host shim: Arduino core for ESP32
+ * Just enough of the Arduino/ESP-IDF API for the sketch to build on Linux.
+ *
+ * Time is virtual: millis()/micros() read hostNowMicros, which only moves
+ * when the sketch calls delay()/delayMicroseconds() or a host tool calls
+ * hostAdvanceMicros(). Runs are therefore deterministic.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <strings.h>
+#include <sys/time.h>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW  0
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ============================================
+// Virtual clock
+// ============================================
+inline uint64_t hostNowMicros = 0;
+
+// Called whenever virtual time moves (simulators hook this to run events)
+inline void (*hostTimeHook)(uint64_t nowMicros) = nullptr;
+
+// Scheduled host callbacks (esp_timer), fired in deadline order as time moves
+struct HostDeadline {
+  uint64_t due;
+  void (*fn)(void* arg);
+  void* arg;
+  uint32_t id;
+};
+inline std::vector<HostDeadline> hostDeadlines;
+inline uint32_t hostDeadlineNextId = 1;
+
+inline uint32_t hostSchedule(uint64_t due, void (*fn)(void*), void* arg) {
+  hostDeadlines.push_back({due, fn, arg, hostDeadlineNextId});
+  return hostDeadlineNextId++;
+}
+inline void hostCancel(uint32_t id) {
+  for (size_t i = 0; i < hostDeadlines.size(); i++) {
+    if (hostDeadlines[i].id == id) { hostDeadlines.erase(hostDeadlines.begin() + i); return; }
+  }
+}
+inline uint64_t hostNextDeadline() {
+  uint64_t next = UINT64_MAX;
+  for (const HostDeadline& d : hostDeadlines) next = std::min(next, d.due);
+  return next;
+}
+
+inline void hostAdvanceMicros(uint64_t us) {
+  uint64_t target = hostNowMicros + us;
+  // Run everything due on the way, each at its own time
+  while (true) {
+    size_t best = hostDeadlines.size();
+    for (size_t i = 0; i < hostDeadlines.size(); i++) {
+      if (hostDeadlines[i].due <= target && (best == hostDeadlines.size() || hostDeadlines[i].due < hostDeadlines[best].due)) best = i;
+    }
+    if (best == hostDeadlines.size()) break;
+    HostDeadline d = hostDeadlines[best];
+    hostDeadlines.erase(hostDeadlines.begin() + best);
+    if (d.due > hostNowMicros) hostNowMicros = d.due;
+    d.fn(d.arg);
+    if (hostNowMicros > target) target = hostNowMicros;  // Callback consumed time
+  }
+  hostNowMicros = target;
+  if (hostTimeHook) hostTimeHook(hostNowMicros);
+}
+
+inline unsigned long millis() { return (unsigned long)(hostNowMicros / 1000); }
+inline unsigned long micros() { return (unsigned long)hostNowMicros; }
+inline void delay(uint32_t ms) { hostAdvanceMicros((uint64_t)ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { hostAdvanceMicros(us); }
+inline void yield() { if (hostTimeHook) hostTimeHook(hostNowMicros); }
+
+/*
+ * gettimeofday() on the virtual clock: time since boot, as on a device that
+ * has not synced with SNTP (the firmware then falls back to millis() + skew)
+ */
+inline int hostGettimeofday(struct timeval* tv, void* tz) {
+  tv->tv_sec = (time_t)(hostNowMicros / 1000000);
+  tv->tv_usec = (suseconds_t)(hostNowMicros % 1000000);
+  return 0;
+}
+#define gettimeofday hostGettimeofday
+
+inline uint32_t hostCpuFrequencyMhz = 240;
+inline bool setCpuFrequencyMhz(uint32_t mhz) { hostCpuFrequencyMhz = mhz; return true; }
+inline uint32_t getCpuFrequencyMhz() { return hostCpuFrequencyMhz; }
+
+// ============================================
+// GPIO, ADC, PWM
+// ============================================
+inline uint8_t hostPinLevel[64];      // Levels seen by digitalRead()
+inline uint8_t hostPinMode[64];
+inline uint32_t hostLedcDuty[64];     // Last ledcWrite() per pin (backlight)
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+#define IRAM_ATTR
+#define RTC_DATA_ATTR   // Plain globals on the host survive a simulated deep sleep
+#define digitalPinToInterrupt(p) (p)
+
+inline void (*hostPinIsr[64])(void) = {};
+inline uint8_t hostPinIsrMode[64];
+
+inline void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  if (pin < 64) { hostPinIsr[pin] = isr; hostPinIsrMode[pin] = (uint8_t)mode; }
+}
+inline void detachInterrupt(uint8_t pin) { if (pin < 64) hostPinIsr[pin] = nullptr; }
+
+// Host side: drive an input pin, running its interrupt handler on a matching edge
+inline void hostSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= 64 || hostPinLevel[pin] == level) { if (pin < 64) hostPinLevel[pin] = level; return; }
+  hostPinLevel[pin] = level;
+  uint8_t edge = level ? RISING : FALLING;
+  if (hostPinIsr[pin] && (hostPinIsrMode[pin] & edge)) hostPinIsr[pin]();
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= 64) return;
+  hostPinMode[pin] = mode;
+  if (mode == INPUT_PULLUP) hostPinLevel[pin] = HIGH;
+}
+inline int digitalRead(uint8_t pin) { return pin < 64 ? hostPinLevel[pin] : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t val) { if (pin < 64) hostPinLevel[pin] = val; }
+inline uint16_t analogRead(uint8_t pin) { return (uint16_t)(pin * 37u + 1000u); }
+
+inline bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution) { return true; }
+inline bool ledcWrite(uint8_t pin, uint32_t duty) { if (pin < 64) hostLedcDuty[pin] = duty; return true; }
+
+// newlib has strlcpy; older glibc does not
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// ============================================
+// Random (deterministic LCG)
+// ============================================
+inline uint32_t hostRandomState = 1;
+
+inline void randomSeed(unsigned long seed) { if (seed != 0) hostRandomState = (uint32_t)seed; }
+inline long random(long howbig) {
+  if (howbig <= 0) return 0;
+  hostRandomState = hostRandomState * 1664525u + 1013904223u;
+  return (long)((hostRandomState >> 8) % (uint32_t)howbig);
+}
+inline long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+// Hardware RNG: its own sequence, so it does not shift random()'s
+inline uint32_t hostHwRandomState = 0x9E3779B9u;
+inline uint32_t esp_random() {
+  hostHwRandomState = hostHwRandomState * 1664525u + 1013904223u;
+  return hostHwRandomState;
+}
+
+// ============================================
+// ESP-IDF basics pulled in by the ESP32 Arduino core
+// ============================================
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+#define ESP_INTR_FLAG_LEVEL3 (1 << 3)
+
+typedef int gpio_num_t;
+
+#include <freertos/FreeRTOS.h>
+
+// ============================================
+// String
+// ============================================
+class String {
+public:
+  String() {}
+  String(const char* s) : str(s ? s : "") {}
+  String(const std::string &s) : str(s) {}
+  String(char c) : str(1, c) {}
+  String(unsigned char value, unsigned char base = 10) : str(formatUnsigned(value, base)) {}
+  String(int value, unsigned char base = 10) : str(base == 10 ? std::to_string(value) : formatUnsigned((unsigned)value, base)) {}
+  String(unsigned int value, unsigned char base = 10) : str(formatUnsigned(value, base)) {}
+  String(long value, unsigned char base = 10) : str(base == 10 ? std::to_string(value) : formatUnsigned((unsigned long)value, base)) {}
+  String(unsigned long value, unsigned char base = 10) : str(formatUnsigned(value, base)) {}
+  String(long long value) : str(std::to_string(value)) {}
+  String(unsigned long long value) : str(std::to_string(value)) {}
+  String(float value, unsigned int decimals = 2) : str(formatFloat(value, decimals)) {}
+  String(double value, unsigned int decimals = 2) : str(formatFloat(value, decimals)) {}
+
+  const char* c_str() const { return str.c_str(); }
+  unsigned int length() const { return (unsigned int)str.length(); }
+  bool isEmpty() const { return str.empty(); }
+
+  char charAt(unsigned int index) const { return index < str.length() ? str[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return str[index]; }
+
+  String substring(unsigned int from) const { return from < str.length() ? String(str.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= str.length()) return String();
+    return String(str.substr(from, to - from));
+  }
+
+  void remove(unsigned int index) { if (index < str.length()) str.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < str.length()) str.erase(index, count); }
+  void toUpperCase() { for (auto &c : str) c = (char)toupper((unsigned char)c); }
+  void toLowerCase() { for (auto &c : str) c = (char)tolower((unsigned char)c); }
+  void trim() {
+    size_t b = str.find_first_not_of(" \t\r\n");
+    size_t e = str.find_last_not_of(" \t\r\n");
+    str = (b == std::string::npos) ? std::string() : str.substr(b, e - b + 1);
+  }
+
+  long toInt() const { return strtol(str.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(str.c_str(), nullptr); }
+
+  int indexOf(char c, unsigned int from = 0) const { size_t p = str.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String &s, unsigned int from = 0) const { size_t p = str.find(s.str, from); return p == std::string::npos ? -1 : (int)p; }
+  bool startsWith(const String &s) const { return str.compare(0, s.str.length(), s.str) == 0; }
+  bool endsWith(const String &s) const {
+    return str.length() >= s.str.length() && str.compare(str.length() - s.str.length(), s.str.length(), s.str) == 0;
+  }
+
+  bool equals(const String &s) const { return str == s.str; }
+  bool equalsIgnoreCase(const String &s) const { return strcasecmp(str.c_str(), s.str.c_str()) == 0; }
+  bool operator==(const String &s) const { return str == s.str; }
+  bool operator==(const char* s) const { return str == (s ? s : ""); }
+  bool operator!=(const String &s) const { return str != s.str; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  bool operator<(const String &s) const { return str < s.str; }
+
+  bool concat(const String &s) { str += s.str; return true; }
+  String &operator+=(const String &s) { str += s.str; return *this; }
+  String &operator+=(const char* s) { str += (s ? s : ""); return *this; }
+  String &operator+=(char c) { str += c; return *this; }
+  String &operator+=(int v) { str += std::to_string(v); return *this; }
+  String &operator+=(unsigned int v) { str += std::to_string(v); return *this; }
+  String &operator+=(long v) { str += std::to_string(v); return *this; }
+  String &operator+=(unsigned long v) { str += std::to_string(v); return *this; }
+
+  friend String operator+(const String &a, const String &b) { return String(a.str + b.str); }
+  friend String operator+(const String &a, const char* b) { return String(a.str + (b ? b : "")); }
+  friend String operator+(const char* a, const String &b) { return String(std::string(a ? a : "") + b.str); }
+  friend String operator+(const String &a, char c) { return String(a.str + c); }
+  friend String operator+(const String &a, int v) { return String(a.str + std::to_string(v)); }
+  friend String operator+(const String &a, unsigned long v) { return String(a.str + std::to_string(v)); }
+
+  const std::string &std() const { return str; }
+
+private:
+  std::string str;
+
+  static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 16) base = 10;
+    if (value == 0) return "0";
+    std::string out;
+    while (value) { out.insert(out.begin(), "0123456789ABCDEF"[value % base]); value /= base; }
+    return out;
+  }
+  static std::string formatFloat(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    return buf;
+  }
+};
+
+// ============================================
+// Print / Serial
+// ============================================
+class Print;
+
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(int v, int base = DEC) { return base == DEC ? printf("%d", v) : print((unsigned long)(unsigned int)v, base); }
+  size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC) { return base == DEC ? printf("%ld", v) : print((unsigned long)v, base); }
+  size_t print(unsigned long v, int base = DEC) { return print(String(v, (unsigned char)base)); }
+  size_t print(long long v, int base = DEC) { return printf("%lld", v); }
+  size_t print(unsigned long long v, int base = DEC) { return printf("%llu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t print(const Printable &p) { return p.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) { size_t n = print(v); return n + println(); }
+  template <typename T> size_t println(const T &v, int base) { size_t n = print(v, base); return n + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    return write((const uint8_t*)buf, std::min((size_t)len, sizeof(buf) - 1));
+  }
+};
+
+// Serial: output goes to stdout when hostSerialEcho is set; input is fed by host tools
+class HardwareSerial : public Print {
+public:
+  bool echo = false;
+  std::string output;   // Captured output (kept when capture is set)
+  bool capture = false;
+  std::string input;    // Pending input for available()/read()
+
+  void begin(unsigned long baud) {}
+  void end() {}
+  operator bool() const { return true; }
+
+  size_t write(uint8_t c) override {
+    if (echo) fputc(c, stdout);
+    if (capture) output += (char)c;
+    return 1;
+  }
+  using Print::write;
+
+  int available() { return (int)input.size(); }
+  int read() {
+    if (input.empty()) return -1;
+    int c = (unsigned char)input[0];
+    input.erase(0, 1);
+    return c;
+  }
+  int peek() { return input.empty() ? -1 : (unsigned char)input[0]; }
+  void flush() { if (echo) fflush(stdout); }
+};
+
+inline HardwareSerial Serial;
+
+// ============================================
+// Deep sleep / misc ESP32 APIs used by the sketch
+// ============================================
+inline bool hostDeepSleepRequested = false;
+
+inline esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio, int level) { return ESP_OK; }
+inline void esp_deep_sleep_start() {
+  // A real device resets; host runs just record the request and carry on
+  hostDeepSleepRequested = true;
+}
+
+// The ESP32 core's Arduino.h pulls in the FreeRTOS task API
+#include <freertos/task.h>
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,403 @@
+/*
+ * Host shim: the subset of ArduinoJson 6 the firmware uses
+ *
+ * A small tree-based parser/serializer: StaticJsonDocument, member access
+ * with as<T>(), JsonArray iteration/add, createNestedArray, deserializeJson
+ * and serializeJson. Capacity is not enforced.
+ */
+
+#ifndef HOST_ARDUINO_JSON_H
+#define HOST_ARDUINO_JSON_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct JsonNode {
+  enum Type { NUL, BOOL, INT, FLOAT, STRING, ARRAY, OBJECT } type = NUL;
+  bool boolean = false;
+  int64_t integer = 0;
+  double number = 0;
+  std::string text;
+  std::vector<std::shared_ptr<JsonNode>> items;                          // ARRAY
+  std::vector<std::pair<std::string, std::shared_ptr<JsonNode>>> members;  // OBJECT, in insertion order
+
+  std::shared_ptr<JsonNode> member(const std::string& key) const {
+    for (auto& m : members) if (m.first == key) return m.second;
+    return nullptr;
+  }
+  std::shared_ptr<JsonNode> memberOrCreate(const std::string& key) {
+    std::shared_ptr<JsonNode> node = member(key);
+    if (!node) {
+      node = std::make_shared<JsonNode>();
+      members.emplace_back(key, node);
+    }
+    return node;
+  }
+
+  void set(int64_t v) { type = INT; integer = v; }
+  void set(double v) { type = FLOAT; number = v; }
+  void set(bool v) { type = BOOL; boolean = v; }
+  void set(const char* v) { type = STRING; text = v ? v : ""; }
+};
+
+class JsonVariant;
+
+class JsonArray {
+public:
+  JsonArray() {}
+  explicit JsonArray(std::shared_ptr<JsonNode> n) : node(n && n->type == JsonNode::ARRAY ? n : nullptr) {}
+
+  size_t size() const { return node ? node->items.size() : 0; }
+  bool isNull() const { return !node; }
+
+  template <typename T>
+  bool add(T value) {
+    if (!node) return false;
+    auto item = std::make_shared<JsonNode>();
+    assign(*item, value);
+    node->items.push_back(item);
+    return true;
+  }
+
+  class iterator {
+  public:
+    iterator(const std::vector<std::shared_ptr<JsonNode>>* v, size_t i) : items(v), index(i) {}
+    JsonVariant operator*() const;
+    iterator& operator++() { index++; return *this; }
+    bool operator!=(const iterator& other) const { return index != other.index; }
+  private:
+    const std::vector<std::shared_ptr<JsonNode>>* items;
+    size_t index;
+  };
+
+  iterator begin() const { return iterator(node ? &node->items : nullptr, 0); }
+  iterator end() const { return iterator(node ? &node->items : nullptr, size()); }
+
+  JsonVariant operator[](size_t index) const;
+
+  template <typename T> static void assign(JsonNode& n, T value);
+
+private:
+  std::shared_ptr<JsonNode> node;
+};
+
+// Read-only view of a value (null when the member is missing)
+class JsonVariant {
+public:
+  JsonVariant() {}
+  explicit JsonVariant(std::shared_ptr<JsonNode> n) : node(n) {}
+
+  bool isNull() const { return !node || node->type == JsonNode::NUL; }
+
+  template <typename T>
+  T as() const {
+    if constexpr (std::is_same<T, bool>::value) {
+      return node && (node->type == JsonNode::BOOL ? node->boolean : node->type == JsonNode::INT ? node->integer != 0 : false);
+    } else if constexpr (std::is_integral<T>::value) {
+      if (!node) return 0;
+      if (node->type == JsonNode::INT) return (T)node->integer;
+      if (node->type == JsonNode::FLOAT) return (T)node->number;
+      return 0;
+    } else if constexpr (std::is_floating_point<T>::value) {
+      if (!node) return 0;
+      if (node->type == JsonNode::INT) return (T)node->integer;
+      if (node->type == JsonNode::FLOAT) return (T)node->number;
+      return 0;
+    } else if constexpr (std::is_same<T, const char*>::value) {
+      return node && node->type == JsonNode::STRING ? node->text.c_str() : nullptr;
+    } else if constexpr (std::is_same<T, String>::value) {
+      return node && node->type == JsonNode::STRING ? String(node->text.c_str()) : String();
+    } else if constexpr (std::is_same<T, JsonArray>::value) {
+      return JsonArray(node);
+    }
+  }
+
+  template <typename T>
+  operator T() const { return as<T>(); }
+
+  JsonVariant operator[](const char* key) const {
+    return JsonVariant(node && node->type == JsonNode::OBJECT ? node->member(key) : nullptr);
+  }
+
+protected:
+  std::shared_ptr<JsonNode> node;
+};
+
+inline JsonVariant JsonArray::iterator::operator*() const { return JsonVariant((*items)[index]); }
+inline JsonVariant JsonArray::operator[](size_t index) const {
+  return JsonVariant(node && index < node->items.size() ? node->items[index] : nullptr);
+}
+
+template <typename T>
+void JsonArray::assign(JsonNode& n, T value) {
+  if constexpr (std::is_same<T, bool>::value) n.set(value);
+  else if constexpr (std::is_integral<T>::value) n.set((int64_t)value);
+  else if constexpr (std::is_floating_point<T>::value) n.set((double)value);
+  else if constexpr (std::is_same<T, String>::value) n.set(value.c_str());
+  else n.set((const char*)value);
+}
+
+// doc["key"]: reads like a JsonVariant, assignment creates the member
+class JsonMemberProxy : public JsonVariant {
+public:
+  JsonMemberProxy(std::shared_ptr<JsonNode> obj, const char* k)
+    : JsonVariant(obj->member(k)), object(obj), key(k) {}
+
+  template <typename T>
+  JsonMemberProxy& operator=(T value) {
+    node = object->memberOrCreate(key);
+    JsonArray::assign(*node, value);
+    return *this;
+  }
+
+private:
+  std::shared_ptr<JsonNode> object;
+  std::string key;
+};
+
+class DeserializationError {
+public:
+  enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory };
+  DeserializationError(Code c = Ok) : code_(c) {}
+  explicit operator bool() const { return code_ != Ok; }
+  Code code() const { return code_; }
+  const char* c_str() const {
+    static const char* names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory"};
+    return names[code_];
+  }
+private:
+  Code code_;
+};
+
+class JsonDocument {
+public:
+  JsonDocument() : root(std::make_shared<JsonNode>()) { root->type = JsonNode::OBJECT; }
+
+  JsonMemberProxy operator[](const char* key) { return JsonMemberProxy(root, key); }
+  JsonVariant operator[](const char* key) const { return JsonVariant(root->member(key)); }
+
+  JsonArray createNestedArray(const char* key) {
+    std::shared_ptr<JsonNode> node = root->memberOrCreate(key);
+    node->type = JsonNode::ARRAY;
+    node->items.clear();
+    return JsonArray(node);
+  }
+
+  void clear() { root = std::make_shared<JsonNode>(); root->type = JsonNode::OBJECT; }
+
+  std::shared_ptr<JsonNode> root;
+};
+
+template <size_t Capacity>
+class StaticJsonDocument : public JsonDocument {};
+
+class DynamicJsonDocument : public JsonDocument {
+public:
+  explicit DynamicJsonDocument(size_t capacity) {}
+};
+
+// Recursive-descent parser
+class HostJsonParser {
+public:
+  HostJsonParser(const char* text, size_t len) : p(text), end(text + len) {}
+
+  DeserializationError parse(JsonNode& out) {
+    skipSpace();
+    if (p >= end) return DeserializationError::EmptyInput;
+    DeserializationError err = value(out, 0);
+    if (err) return err;
+    skipSpace();
+    return p == end ? DeserializationError::Ok : DeserializationError::InvalidInput;
+  }
+
+private:
+  const char* p;
+  const char* end;
+
+  void skipSpace() { while (p < end && isspace((unsigned char)*p)) p++; }
+
+  bool literal(const char* word) {
+    size_t n = strlen(word);
+    if ((size_t)(end - p) < n || strncmp(p, word, n) != 0) return false;
+    p += n;
+    return true;
+  }
+
+  DeserializationError string(std::string& out) {
+    p++;  // Opening quote
+    while (p < end && *p != '"') {
+      if (*p == '\\') {
+        if (++p >= end) return DeserializationError::IncompleteInput;
+        switch (*p) {
+          case 'n': out += '\n'; break;
+          case 't': out += '\t'; break;
+          case 'r': out += '\r'; break;
+          case 'b': out += '\b'; break;
+          case 'f': out += '\f'; break;
+          case 'u': {
+            if (end - p < 5) return DeserializationError::IncompleteInput;
+            unsigned code = (unsigned)strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+            if (code < 0x80) out += (char)code;
+            else if (code < 0x800) { out += (char)(0xC0 | (code >> 6)); out += (char)(0x80 | (code & 0x3F)); }
+            else { out += (char)(0xE0 | (code >> 12)); out += (char)(0x80 | ((code >> 6) & 0x3F)); out += (char)(0x80 | (code & 0x3F)); }
+            p += 4;
+            break;
+          }
+          default: out += *p; break;
+        }
+        p++;
+      } else {
+        out += *p++;
+      }
+    }
+    if (p >= end) return DeserializationError::IncompleteInput;
+    p++;  // Closing quote
+    return DeserializationError::Ok;
+  }
+
+  DeserializationError value(JsonNode& out, int depth) {
+    if (depth > 10) return DeserializationError::NoMemory;
+    skipSpace();
+    if (p >= end) return DeserializationError::IncompleteInput;
+
+    if (*p == '{') {
+      out.type = JsonNode::OBJECT;
+      p++;
+      skipSpace();
+      if (p < end && *p == '}') { p++; return DeserializationError::Ok; }
+      while (true) {
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+        if (*p != '"') return DeserializationError::InvalidInput;
+        std::string key;
+        DeserializationError err = string(key);
+        if (err) return err;
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+        if (*p++ != ':') return DeserializationError::InvalidInput;
+        auto child = std::make_shared<JsonNode>();
+        err = value(*child, depth + 1);
+        if (err) return err;
+        out.members.emplace_back(key, child);
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+        if (*p == ',') { p++; continue; }
+        if (*p == '}') { p++; return DeserializationError::Ok; }
+        return DeserializationError::InvalidInput;
+      }
+    }
+
+    if (*p == '[') {
+      out.type = JsonNode::ARRAY;
+      p++;
+      skipSpace();
+      if (p < end && *p == ']') { p++; return DeserializationError::Ok; }
+      while (true) {
+        auto child = std::make_shared<JsonNode>();
+        DeserializationError err = value(*child, depth + 1);
+        if (err) return err;
+        out.items.push_back(child);
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+        if (*p == ',') { p++; continue; }
+        if (*p == ']') { p++; return DeserializationError::Ok; }
+        return DeserializationError::InvalidInput;
+      }
+    }
+
+    if (*p == '"') {
+      out.type = JsonNode::STRING;
+      return string(out.text);
+    }
+    if (literal("true")) { out.set(true); return DeserializationError::Ok; }
+    if (literal("false")) { out.set(false); return DeserializationError::Ok; }
+    if (literal("null")) { out.type = JsonNode::NUL; return DeserializationError::Ok; }
+
+    // Number
+    const char* start = p;
+    bool isFloat = false;
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    while (p < end && (isdigit((unsigned char)*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) {
+      if (*p == '.' || *p == 'e' || *p == 'E') isFloat = true;
+      p++;
+    }
+    if (p == start) return DeserializationError::InvalidInput;
+    std::string num(start, p);
+    if (isFloat) out.set(strtod(num.c_str(), nullptr));
+    else out.set((int64_t)strtoll(num.c_str(), nullptr, 10));
+    return DeserializationError::Ok;
+  }
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+  doc.clear();
+  HostJsonParser parser(input, length);
+  JsonNode parsed;
+  DeserializationError err = parser.parse(parsed);
+  if (!err) *doc.root = parsed;
+  return err;
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input) { return deserializeJson(doc, input, input ? strlen(input) : 0); }
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input) { return deserializeJson(doc, input.c_str(), input.length()); }
+inline DeserializationError deserializeJson(JsonDocument& doc, const uint8_t* input, size_t length) { return deserializeJson(doc, (const char*)input, length); }
+
+inline void hostJsonWrite(const JsonNode& n, std::string& out) {
+  switch (n.type) {
+    case JsonNode::NUL: out += "null"; break;
+    case JsonNode::BOOL: out += n.boolean ? "true" : "false"; break;
+    case JsonNode::INT: out += std::to_string(n.integer); break;
+    case JsonNode::FLOAT: { char buf[32]; snprintf(buf, sizeof(buf), "%.9g", n.number); out += buf; break; }
+    case JsonNode::STRING:
+      out += '"';
+      for (char c : n.text) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (c == '\n') out += "\\n";
+        else if ((unsigned char)c < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+        else out += c;
+      }
+      out += '"';
+      break;
+    case JsonNode::ARRAY:
+      out += '[';
+      for (size_t i = 0; i < n.items.size(); i++) {
+        if (i) out += ',';
+        hostJsonWrite(*n.items[i], out);
+      }
+      out += ']';
+      break;
+    case JsonNode::OBJECT:
+      out += '{';
+      for (size_t i = 0; i < n.members.size(); i++) {
+        if (i) out += ',';
+        JsonNode key;
+        key.set(n.members[i].first.c_str());
+        hostJsonWrite(key, out);
+        out += ':';
+        hostJsonWrite(*n.members[i].second, out);
+      }
+      out += '}';
+      break;
+  }
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& output) {
+  std::string out;
+  hostJsonWrite(*doc.root, out);
+  output = String(out);
+  return out.size();
+}
+
+inline size_t serializeJson(const JsonDocument& doc, char* buffer, size_t size) {
+  std::string out;
+  hostJsonWrite(*doc.root, out);
+  if (size == 0) return 0;
+  size_t n = out.size() < size - 1 ? out.size() : size - 1;
+  memcpy(buffer, out.data(), n);
+  buffer[n] = '\0';
+  return n;
+}
+
+#endif // HOST_ARDUINO_JSON_H
@@ -0,0 +1,224 @@
+/*
+ * Host shim: Arduino-ESP32 FS (File, FS) over an in-memory file tree
+ *
+ * Files persist for the life of the process. Tools can preload or export
+ * hostFsFiles directly. Writes cost virtual time, roughly what
+ * LittleFS on SPI flash would cost: HOST_FS_WRITE_MICROS per write() plus
+ * HOST_FS_BYTE_NANOS per byte, and HOST_FS_SYNC_MICROS when a file with
+ * unsynced data is flushed or closed (metadata commit). Reads are free.
+ */
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#define HOST_FS_WRITE_MICROS 20
+#define HOST_FS_BYTE_NANOS   2500
+#define HOST_FS_SYNC_MICROS  2000
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+inline std::map<std::string, std::vector<uint8_t>> hostFsFiles;  // Path -> contents
+inline std::set<std::string> hostFsDirs = {"/"};
+inline uint32_t hostFsWrites = 0;   // write() calls
+inline uint32_t hostFsSyncs = 0;    // flush()/close() commits
+inline size_t hostFsCapacity = 1536 * 1024;  // Default 1.5 MB "spiffs" partition
+
+// "/a/b/c" -> "/a/b"
+inline std::string hostFsParent(const std::string& path) {
+  size_t slash = path.find_last_of('/');
+  return slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+}
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+public:
+  File() {}
+
+  size_t write(const uint8_t* buf, size_t size) {
+    if (!h || h->dir || !h->writable) return 0;
+    std::vector<uint8_t>& data = hostFsFiles[h->path];
+    if (hostFsUsed() + size > hostFsCapacity) return 0;
+    data.insert(data.end(), buf, buf + size);
+    h->pos = data.size();
+    h->dirty = true;
+    hostFsWrites++;
+    hostAdvanceMicros(HOST_FS_WRITE_MICROS + (uint64_t)size * HOST_FS_BYTE_NANOS / 1000);
+    return size;
+  }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t read(uint8_t* buf, size_t size) {
+    const std::vector<uint8_t>* data = contents();
+    if (!data || h->pos >= data->size()) return 0;
+    size_t n = std::min(size, data->size() - h->pos);
+    memcpy(buf, data->data() + h->pos, n);
+    h->pos += n;
+    return n;
+  }
+  int peek() {
+    const std::vector<uint8_t>* data = contents();
+    return data && h->pos < data->size() ? (*data)[h->pos] : -1;
+  }
+  int available() {
+    const std::vector<uint8_t>* data = contents();
+    return data ? (int)(data->size() - std::min(h->pos, data->size())) : 0;
+  }
+
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+    const std::vector<uint8_t>* data = contents();
+    if (!data) return false;
+    size_t base = mode == SeekSet ? 0 : (mode == SeekCur ? h->pos : data->size());
+    if (base + pos > data->size()) return false;
+    h->pos = base + pos;
+    return true;
+  }
+  size_t position() const { return h ? h->pos : 0; }
+  size_t size() {
+    const std::vector<uint8_t>* data = contents();
+    return data ? data->size() : 0;
+  }
+
+  void flush() {
+    if (!h || !h->dirty) return;
+    h->dirty = false;
+    hostFsSyncs++;
+    hostAdvanceMicros(HOST_FS_SYNC_MICROS);
+  }
+  void close() {
+    flush();
+    h.reset();
+  }
+
+  operator bool() const { return (bool)h; }
+  bool isDirectory() const { return h && h->dir; }
+  const char* path() const { return h ? h->path.c_str() : ""; }
+  const char* name() const {
+    if (!h) return "";
+    size_t slash = h->path.find_last_of('/');
+    return h->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+  }
+
+  // Directory: the next entry (an empty File at the end)
+  File openNextFile(const char* mode = FILE_READ) {
+    if (!h || !h->dir || h->pos >= h->children.size()) return File();
+    return File::open(h->children[h->pos++], FILE_READ);
+  }
+  void rewindDirectory() { if (h && h->dir) h->pos = 0; }
+
+  // What FS::open() hands out (nullptr-like File if path is missing)
+  static File open(const std::string& path, const char* mode) {
+    File f;
+    bool isDir = hostFsDirs.count(path) > 0;
+    if (isDir) {
+      f.h = std::make_shared<Handle>();
+      f.h->path = path;
+      f.h->dir = true;
+      std::string prefix = path == "/" ? "/" : path + "/";
+      for (const std::string& d : hostFsDirs) {
+        if (d != path && d.compare(0, prefix.size(), prefix) == 0 && hostFsParent(d) == path) f.h->children.push_back(d);
+      }
+      for (const auto& entry : hostFsFiles) {
+        if (hostFsParent(entry.first) == path) f.h->children.push_back(entry.first);
+      }
+      return f;
+    }
+    bool exists = hostFsFiles.count(path) > 0;
+    bool write = mode[0] == 'w' || mode[0] == 'a';
+    if (!exists && !write) return f;
+    if (write && !hostFsDirs.count(hostFsParent(path))) return f;
+    if (mode[0] == 'w') {
+      hostFsFiles[path].clear();
+    } else if (!exists) {
+      hostFsFiles[path];
+    }
+    f.h = std::make_shared<Handle>();
+    f.h->path = path;
+    f.h->writable = write;
+    f.h->pos = mode[0] == 'a' ? hostFsFiles[path].size() : 0;
+    f.h->dirty = write && !exists;
+    return f;
+  }
+
+  static size_t hostFsUsed() {
+    size_t used = 0;
+    for (const auto& entry : hostFsFiles) used += (entry.second.size() + 4095) / 4096 * 4096;  // Whole blocks
+    return used;
+  }
+
+private:
+  struct Handle {
+    std::string path;
+    bool dir = false;
+    bool writable = false;
+    bool dirty = false;
+    size_t pos = 0;
+    std::vector<std::string> children;
+    ~Handle() {
+      if (dirty) {
+        hostFsSyncs++;
+        hostAdvanceMicros(HOST_FS_SYNC_MICROS);
+      }
+    }
+  };
+  std::shared_ptr<Handle> h;
+
+  const std::vector<uint8_t>* contents() const {
+    if (!h || h->dir) return nullptr;
+    auto it = hostFsFiles.find(h->path);
+    return it == hostFsFiles.end() ? nullptr : &it->second;
+  }
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode = FILE_READ, bool create = false) {
+    if (!mounted) return File();
+    return File::open(path, mode);
+  }
+  File open(const String& path, const char* mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+  bool exists(const char* path) { return mounted && (hostFsFiles.count(path) || hostFsDirs.count(path)); }
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path) { return mounted && hostFsFiles.erase(path) > 0; }
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to) {
+    auto it = hostFsFiles.find(from);
+    if (!mounted || it == hostFsFiles.end()) return false;
+    hostFsFiles[to] = std::move(it->second);
+    hostFsFiles.erase(from);
+    return true;
+  }
+  bool mkdir(const char* path) {
+    if (!mounted || !hostFsDirs.count(hostFsParent(path))) return false;
+    hostFsDirs.insert(path);
+    return true;
+  }
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool rmdir(const char* path) { return mounted && hostFsDirs.erase(path) > 0; }
+
+protected:
+  bool mounted = false;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+
+#endif // HOST_FS_H
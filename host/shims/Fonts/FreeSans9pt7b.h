@@ -0,0 +1,4 @@
+// Host shim: metrics-only stand-in for FreeSans9pt7b
+#pragma once
+#include <Adafruit_GFX.h>
+const GFXfont FreeSans9pt7b = {2, 12, 22};
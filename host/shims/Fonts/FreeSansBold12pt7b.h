@@ -0,0 +1,4 @@
+// Host shim: metrics-only stand-in for FreeSansBold12pt7b
+#pragma once
+#include <Adafruit_GFX.h>
+const GFXfont FreeSansBold12pt7b = {2, 14, 29};
@@ -0,0 +1,36 @@
+/*
+ * Host shim: LittleFS on the in-memory file tree in FS.h
+ *
+ * begin() always mounts (there is nothing to format). hostFsCapacity
+ * stands in for the partition size.
+ */
+
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = "spiffs") {
+    mounted = true;
+    return true;
+  }
+  void end() { mounted = false; }
+  bool format() {
+    hostFsFiles.clear();
+    hostFsDirs = {"/"};
+    return true;
+  }
+  size_t totalBytes() { return hostFsCapacity; }
+  size_t usedBytes() { return File::hostFsUsed(); }
+};
+
+} // namespace fs
+
+inline fs::LittleFSFS LittleFS;
+
+#endif // HOST_LITTLEFS_H
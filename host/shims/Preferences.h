@@ -0,0 +1,109 @@
+/*
+ * Host shim: ESP32 Preferences (NVS) backed by an in-memory store
+ *
+ * Namespaces persist for the life of the process; writes are counted so
+ * tools can see how often settings hit flash.
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> HostNvsNamespace;
+
+inline std::map<std::string, HostNvsNamespace> hostNvs;
+inline uint32_t hostNvsWrites = 0;
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false, const char* partition = nullptr) {
+    ns = &hostNvs[name];
+    this->readOnly = readOnly;
+    return true;
+  }
+  void end() { ns = nullptr; }
+
+  bool clear() { if (!writable()) return false; ns->clear(); hostNvsWrites++; return true; }
+  bool remove(const char* key) { if (!writable()) return false; hostNvsWrites++; return ns->erase(key) > 0; }
+  bool isKey(const char* key) { return ns && ns->count(key) > 0; }
+
+  size_t putChar(const char* key, int8_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putUChar(const char* key, uint8_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putShort(const char* key, int16_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putUShort(const char* key, uint16_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putInt(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putUInt(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putLong(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putULong(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putLong64(const char* key, int64_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putULong64(const char* key, uint64_t value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putFloat(const char* key, float value) { return putRaw(key, &value, sizeof(value)); }
+  size_t putBool(const char* key, bool value) { uint8_t v = value; return putRaw(key, &v, sizeof(v)); }
+  size_t putString(const char* key, const char* value) { return putRaw(key, value, strlen(value)); }
+  size_t putString(const char* key, const String& value) { return putRaw(key, value.c_str(), value.length()); }
+  size_t putBytes(const char* key, const void* value, size_t len) { return putRaw(key, value, len); }
+
+  int8_t getChar(const char* key, int8_t def = 0) { return getRaw(key, def); }
+  uint8_t getUChar(const char* key, uint8_t def = 0) { return getRaw(key, def); }
+  int16_t getShort(const char* key, int16_t def = 0) { return getRaw(key, def); }
+  uint16_t getUShort(const char* key, uint16_t def = 0) { return getRaw(key, def); }
+  int32_t getInt(const char* key, int32_t def = 0) { return getRaw(key, def); }
+  uint32_t getUInt(const char* key, uint32_t def = 0) { return getRaw(key, def); }
+  int32_t getLong(const char* key, int32_t def = 0) { return getRaw(key, def); }
+  uint32_t getULong(const char* key, uint32_t def = 0) { return getRaw(key, def); }
+  int64_t getLong64(const char* key, int64_t def = 0) { return getRaw(key, def); }
+  uint64_t getULong64(const char* key, uint64_t def = 0) { return getRaw(key, def); }
+  float getFloat(const char* key, float def = 0) { return getRaw(key, def); }
+  bool getBool(const char* key, bool def = false) { return getRaw<uint8_t>(key, def) != 0; }
+
+  String getString(const char* key, const String& def = String()) {
+    const std::vector<uint8_t>* v = find(key);
+    if (!v) return def;
+    return String(std::string(v->begin(), v->end()).c_str());
+  }
+  size_t getBytesLength(const char* key) {
+    const std::vector<uint8_t>* v = find(key);
+    return v ? v->size() : 0;
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    const std::vector<uint8_t>* v = find(key);
+    if (!v || v->size() > maxLen) return 0;
+    memcpy(buf, v->data(), v->size());
+    return v->size();
+  }
+
+private:
+  HostNvsNamespace* ns = nullptr;
+  bool readOnly = false;
+
+  bool writable() { return ns && !readOnly; }
+
+  const std::vector<uint8_t>* find(const char* key) {
+    if (!ns) return nullptr;
+    auto it = ns->find(key);
+    return it == ns->end() ? nullptr : &it->second;
+  }
+
+  size_t putRaw(const char* key, const void* data, size_t len) {
+    if (!writable()) return 0;
+    const uint8_t* bytes = (const uint8_t*)data;
+    (*ns)[key] = std::vector<uint8_t>(bytes, bytes + len);
+    hostNvsWrites++;
+    return len;
+  }
+
+  template <typename T>
+  T getRaw(const char* key, T def) {
+    const std::vector<uint8_t>* v = find(key);
+    if (!v || v->size() != sizeof(T)) return def;
+    T value;
+    memcpy(&value, v->data(), sizeof(T));
+    return value;
+  }
+};
+
+#endif // HOST_PREFERENCES_H
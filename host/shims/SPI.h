@@ -0,0 +1,10 @@
+/*
+ * Host shim: SPI (the display emulator does not need a bus)
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#endif // HOST_SPI_H
@@ -0,0 +1,99 @@
+/*
+ * Host shim: Links2004 WebSocketsClient
+ *
+ * Records outgoing frames; host tools deliver incoming events with
+ * hostDeliver(). Nothing touches the network: a tool that plays the server
+ * (the simulator's local repeater) follows begin() and disconnect()
+ * through the hooks.
+ */
+
+#ifndef HOST_WEBSOCKETS_CLIENT_H
+#define HOST_WEBSOCKETS_CLIENT_H
+
+#include <Arduino.h>
+#include <vector>
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG
+} WStype_t;
+
+typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t* payload, size_t length);
+
+class WebSocketsClient {
+public:
+  std::vector<String> hostSent;  // Every sendTXT() payload
+  void (*hostSendHook)(const String& payload) = nullptr;  // Called on every sendTXT()
+  void (*hostBeginHook)() = nullptr;       // begin()/beginSSL() started a connection
+  void (*hostDisconnectHook)() = nullptr;  // disconnect() on a begun socket
+  String hostHost;
+  uint16_t hostPort = 0;
+  String hostPath;
+  bool hostSSL = false;
+  bool hostBegun = false;
+
+  void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino") { setTarget(host, port, url, false); }
+  void begin(const String& host, uint16_t port, const String& url = "/", const String& protocol = "arduino") { setTarget(host.c_str(), port, url.c_str(), false); }
+  void beginSSL(const char* host, uint16_t port, const char* url = "/", const char* fingerprint = "", const char* protocol = "arduino") { setTarget(host, port, url, true); }
+  void beginSSL(const String& host, uint16_t port, const String& url = "/", const String& fingerprint = "", const String& protocol = "arduino") { setTarget(host.c_str(), port, url.c_str(), true); }
+
+  void onEvent(WebSocketClientEvent cb) { callback = cb; }
+  void setExtraHeaders(const char* headers = nullptr) {}
+  void setReconnectInterval(unsigned long interval) {}
+  void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {}
+  void loop() {}
+
+  void disconnect() {
+    if (hostBegun && hostDisconnectHook) hostDisconnectHook();
+    if (hostBegun && connected) {
+      connected = false;
+      hostDeliver(WStype_DISCONNECTED, "");
+    }
+    hostBegun = false;
+  }
+  bool isConnected() { return connected; }
+
+  bool sendTXT(const char* payload) {
+    if (!connected) return false;
+    hostSent.push_back(String(payload));
+    if (hostSendHook) hostSendHook(hostSent.back());
+    return true;
+  }
+  bool sendTXT(const String& payload) { return sendTXT(payload.c_str()); }
+  bool sendTXT(uint8_t* payload, size_t length) { return sendTXT(String(std::string((const char*)payload, length).c_str())); }
+
+  // Host side: deliver an event as if it came off the socket
+  void hostDeliver(WStype_t type, const String& payload) {
+    if (type == WStype_CONNECTED) connected = true;
+    if (type == WStype_DISCONNECTED) connected = false;
+    if (callback) {
+      std::string copy(payload.c_str(), payload.length());
+      copy.push_back('\0');
+      callback(type, (uint8_t*)&copy[0], payload.length());
+    }
+  }
+
+private:
+  WebSocketClientEvent callback = nullptr;
+  bool connected = false;
+
+  void setTarget(const char* host, uint16_t port, const char* url, bool ssl) {
+    hostHost = host;
+    hostPort = port;
+    hostPath = url;
+    hostSSL = ssl;
+    hostBegun = true;
+    if (hostBeginHook) hostBeginHook();
+  }
+};
+
+#endif // HOST_WEBSOCKETS_CLIENT_H
@@ -0,0 +1,306 @@
+/*
+ * Host shim: ESP32 WiFi (station only)
+ *
+ * Connection outcome and scan results are set by the host tool. begin()
+ * returns at once and raises STA_CONNECTED / GOT_IP (or DISCONNECTED) from
+ * the virtual-clock scheduler, like the real WiFi task does.
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <vector>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK,
+  WIFI_AUTH_WPA2_ENTERPRISE,
+  WIFI_AUTH_WPA3_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_READY = 0,
+  ARDUINO_EVENT_WIFI_SCAN_DONE,
+  ARDUINO_EVENT_WIFI_STA_START,
+  ARDUINO_EVENT_WIFI_STA_STOP,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP,
+  ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef enum {
+  WIFI_REASON_UNSPECIFIED = 1,
+  WIFI_REASON_AUTH_EXPIRE = 2,
+  WIFI_REASON_ASSOC_LEAVE = 8,
+  WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+  WIFI_REASON_BEACON_TIMEOUT = 200,
+  WIFI_REASON_NO_AP_FOUND = 201,
+  WIFI_REASON_AUTH_FAIL = 202,
+  WIFI_REASON_ASSOC_FAIL = 203,
+  WIFI_REASON_HANDSHAKE_TIMEOUT = 204,
+  WIFI_REASON_CONNECTION_FAIL = 205
+} wifi_err_reason_t;
+
+typedef struct {
+  struct { uint8_t reason; } wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef void (*WiFiEventSysCb)(arduino_event_id_t event, arduino_event_info_t info);
+typedef size_t wifi_event_id_t;
+
+class IPAddress : public Printable {
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d; }
+  IPAddress(uint32_t address) { memcpy(octets, &address, 4); }
+
+  uint8_t operator[](int index) const { return octets[index]; }
+  uint8_t& operator[](int index) { return octets[index]; }
+  bool operator==(const IPAddress& other) const { return memcmp(octets, other.octets, 4) == 0; }
+  operator uint32_t() const { return (uint32_t)octets[0] | ((uint32_t)octets[1] << 8) | ((uint32_t)octets[2] << 16) | ((uint32_t)octets[3] << 24); }
+
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+  }
+  size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+  uint8_t octets[4] = {0, 0, 0, 0};
+};
+
+struct HostWiFiNetwork {
+  String ssid;
+  int32_t rssi;
+  wifi_auth_mode_t auth;
+  int32_t channel;
+  uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+};
+
+class WiFiClass {
+public:
+  // Host-side controls
+  std::vector<HostWiFiNetwork> hostNetworks;  // Returned by scanNetworks()
+  bool hostJoinable = true;                   // begin() succeeds
+  uint8_t hostFailReason = WIFI_REASON_NO_AP_FOUND;  // Reported when not joinable
+  uint32_t hostAssocMicros = 1200000;         // begin() to STA_CONNECTED (or failure)
+  uint32_t hostFastAssocMicros = 250000;      // Association when channel + BSSID are given
+  uint32_t hostDhcpMicros = 300000;           // STA_CONNECTED to GOT_IP (static IP: 1ms)
+  bool hostStaticIPValid = true;              // A static config gets connectivity
+  uint32_t hostPassiveScanMicros = 0;         // Last passive scan (for the tool to inspect)
+  IPAddress hostGateway = IPAddress(192, 168, 1, 1);
+  IPAddress hostSubnet = IPAddress(255, 255, 255, 0);
+  IPAddress hostDNS = IPAddress(192, 168, 1, 1);
+  uint32_t hostBeginCount = 0;
+  bool hostLastBeginFast = false;             // Last begin() had channel + BSSID
+  uint32_t hostScanMicros = 2000000;          // Blocking scan duration
+  IPAddress hostIP = IPAddress(192, 168, 1, 42);
+
+  wifi_event_id_t onEvent(WiFiEventCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+    handlers.push_back({cb, nullptr, event});
+    return handlers.size();
+  }
+  wifi_event_id_t onEvent(WiFiEventSysCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+    handlers.push_back({nullptr, cb, event});
+    return handlers.size();
+  }
+  void removeEvent(wifi_event_id_t id) {
+    if (id > 0 && id <= handlers.size()) handlers[id - 1] = {nullptr, nullptr, ARDUINO_EVENT_MAX};
+  }
+
+  // Host side: raise an event as the WiFi task would
+  void hostRaise(arduino_event_id_t event, uint8_t reason = 0) {
+    arduino_event_info_t info = {};
+    info.wifi_sta_disconnected.reason = reason;
+    for (const Handler& h : handlers) {
+      if (h.filter != ARDUINO_EVENT_MAX && h.filter != event) continue;
+      if (h.simple) h.simple(event);
+      if (h.sys) h.sys(event, info);
+    }
+  }
+
+  wl_status_t status() { return currentStatus; }
+  bool mode(wifi_mode_t m) { currentMode = m; if (m == WIFI_OFF) currentStatus = WL_DISCONNECTED; return true; }
+  wifi_mode_t getMode() { return currentMode; }
+  bool setSleep(wifi_ps_type_t type) { sleepType = type; return true; }
+  wifi_ps_type_t getSleep() { return sleepType; }
+
+  // Static IP; all-zero local_ip switches back to DHCP
+  bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress()) {
+    staticIP = local_ip;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDNS = dns1;
+    return true;
+  }
+
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr, bool connect = true) {
+    cancelPending();
+    currentSSID = ssid ? ssid : "";
+    currentStatus = WL_DISCONNECTED;
+    hostBeginCount++;
+    hostLastBeginFast = channel > 0 && bssid != nullptr;
+    currentChannel = channel;
+    uint32_t assoc = hostLastBeginFast ? hostFastAssocMicros : hostAssocMicros;
+    pending = hostSchedule(hostNowMicros + assoc, [](void* arg) {
+      WiFiClass* self = (WiFiClass*)arg;
+      self->pending = 0;
+      if (!self->hostJoinable) {
+        self->currentStatus = WL_CONNECT_FAILED;
+        self->hostRaise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, self->hostFailReason);
+        return;
+      }
+      self->hostRaise(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+      bool isStatic = (uint32_t)self->staticIP != 0;
+      if (isStatic && !self->hostStaticIPValid) return;  // Associated but no usable IP
+      uint32_t ipDelay = isStatic ? 1000 : self->hostDhcpMicros;
+      self->pending = hostSchedule(hostNowMicros + ipDelay, [](void* arg) {
+        WiFiClass* self = (WiFiClass*)arg;
+        self->pending = 0;
+        self->currentStatus = WL_CONNECTED;
+        self->hostRaise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+      }, self);
+    }, this);
+    return currentStatus;
+  }
+  bool disconnect(bool wifioff = false, bool eraseap = false) {
+    cancelPending();
+    if (currentStatus == WL_CONNECTED) hostRaise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    currentStatus = WL_DISCONNECTED;
+    if (wifioff) currentMode = WIFI_OFF;
+    return true;
+  }
+
+  // Host side: the AP goes away (beacon timeout) while connected
+  void hostDrop(uint8_t reason = WIFI_REASON_BEACON_TIMEOUT) {
+    cancelPending();
+    if (currentStatus != WL_CONNECTED) return;
+    currentStatus = WL_DISCONNECTED;
+    hostRaise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, reason);
+  }
+
+  IPAddress localIP() {
+    if (currentStatus != WL_CONNECTED) return IPAddress();
+    return (uint32_t)staticIP != 0 ? staticIP : hostIP;
+  }
+  IPAddress gatewayIP() { return currentStatus == WL_CONNECTED ? hostGateway : IPAddress(); }
+  IPAddress subnetMask() { return currentStatus == WL_CONNECTED ? hostSubnet : IPAddress(); }
+  IPAddress dnsIP(uint8_t dns_no = 0) { return currentStatus == WL_CONNECTED ? hostDNS : IPAddress(); }
+  String SSID() { return currentSSID; }
+  int32_t RSSI() { return currentStatus == WL_CONNECTED ? -55 : 0; }
+  int32_t channel() {
+    const HostWiFiNetwork* n = findNetwork(currentSSID);
+    return n ? n->channel : currentChannel;
+  }
+  uint8_t* BSSID(uint8_t* bssid = nullptr) {
+    static uint8_t current[6];
+    const HostWiFiNetwork* n = findNetwork(currentSSID);
+    memset(current, 0, 6);
+    if (n && currentStatus == WL_CONNECTED) memcpy(current, n->bssid, 6);
+    if (bssid) memcpy(bssid, current, 6);
+    return current;
+  }
+
+  // Full scan (channel 0) takes hostScanMicros active or 13 dwell times passive;
+  // a single-channel scan takes one dwell time. Async scans raise SCAN_DONE.
+  int16_t scanNetworks(bool async = false, bool show_hidden = false, bool passive = false, uint32_t max_ms_per_chan = 300, uint8_t channel = 0) {
+    uint32_t scanMicros = channel ? max_ms_per_chan * 1000 : (passive ? 13 * max_ms_per_chan * 1000 : hostScanMicros);
+    if (passive) hostPassiveScanMicros = scanMicros;
+    scanChannel = channel;
+    hostScanCount++;
+    if (!async) {
+      hostAdvanceMicros(scanMicros);
+      collectScanResults();
+      return scanState;
+    }
+    if (scanPending) hostCancel(scanPending);
+    scanState = WIFI_SCAN_RUNNING;
+    scanPending = hostSchedule(hostNowMicros + scanMicros, [](void* arg) {
+      WiFiClass* self = (WiFiClass*)arg;
+      self->scanPending = 0;
+      self->collectScanResults();
+      self->hostRaise(ARDUINO_EVENT_WIFI_SCAN_DONE);
+    }, this);
+    return WIFI_SCAN_RUNNING;
+  }
+  int16_t scanComplete() { return scanState; }
+  void scanDelete() { scanResults.clear(); if (scanState != WIFI_SCAN_RUNNING) scanState = WIFI_SCAN_FAILED; }
+  // esp_wifi_scan_stop()
+  void hostStopScan() {
+    if (scanPending) hostCancel(scanPending);
+    scanPending = 0;
+    scanState = WIFI_SCAN_FAILED;
+  }
+  uint32_t hostScanCount = 0;
+
+  uint8_t* BSSID(uint8_t i) { return i < scanResults.size() ? scanResults[i].bssid : nullptr; }
+  String SSID(uint8_t i) { return i < scanResults.size() ? scanResults[i].ssid : String(); }
+  int32_t RSSI(uint8_t i) { return i < scanResults.size() ? scanResults[i].rssi : 0; }
+  wifi_auth_mode_t encryptionType(uint8_t i) { return i < scanResults.size() ? scanResults[i].auth : WIFI_AUTH_OPEN; }
+  int32_t channel(uint8_t i) { return i < scanResults.size() ? scanResults[i].channel : 0; }
+
+private:
+  struct Handler {
+    WiFiEventCb simple;
+    WiFiEventSysCb sys;
+    arduino_event_id_t filter;
+  };
+  std::vector<Handler> handlers;
+  uint32_t pending = 0;  // Scheduled connect step
+  int32_t currentChannel = 0;
+  std::vector<HostWiFiNetwork> scanResults;
+  int16_t scanState = WIFI_SCAN_FAILED;
+  uint8_t scanChannel = 0;
+  uint32_t scanPending = 0;
+  void collectScanResults() {
+    scanResults.clear();
+    for (const HostWiFiNetwork& n : hostNetworks) {
+      if (scanChannel == 0 || n.channel == scanChannel) scanResults.push_back(n);
+    }
+    scanState = (int16_t)scanResults.size();
+  }
+  IPAddress staticIP, staticGateway, staticSubnet, staticDNS;
+  const HostWiFiNetwork* findNetwork(const String& ssid) {
+    for (const HostWiFiNetwork& n : hostNetworks) {
+      if (n.ssid == ssid) return &n;
+    }
+    return nullptr;
+  }
+  void cancelPending() {
+    if (pending) hostCancel(pending);
+    pending = 0;
+  }
+  wl_status_t currentStatus = WL_DISCONNECTED;
+  wifi_mode_t currentMode = WIFI_OFF;
+  wifi_ps_type_t sleepType = WIFI_PS_MIN_MODEM;
+  String currentSSID;
+};
+
+inline WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,15 @@
+/*
+ * Host shim: WiFiClientSecure (TLS is handled inside WebSocketsClient)
+ */
+
+#ifndef HOST_WIFI_CLIENT_SECURE_H
+#define HOST_WIFI_CLIENT_SECURE_H
+
+#include <WiFi.h>
+
+class WiFiClientSecure {
+public:
+  void setInsecure() {}
+};
+
+#endif // HOST_WIFI_CLIENT_SECURE_H
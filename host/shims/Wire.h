@@ -0,0 +1,84 @@
+/*
+ * Host shim: Arduino TwoWire
+ *
+ * No devices answer by default. Host tools can mark addresses present and
+ * queue CardKB key codes, which are returned one byte per requestFrom().
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <set>
+
+class TwoWire {
+public:
+  std::set<uint8_t> presentAddresses;  // Addresses that ACK
+  std::deque<uint8_t> keyQueue;        // Bytes returned by the CardKB (0x5F)
+  uint32_t clockHz = 100000;
+  uint32_t transactions = 0;
+  uint64_t busMicros = 0;              // Virtual time spent on the wire
+
+  // Start, 9 bits per byte (ACK included), stop; charged to the virtual clock
+  uint32_t hostTransferMicros(size_t bytes) {
+    return (uint32_t)(((uint64_t)bytes * 9 + 2) * 1000000 / clockHz);
+  }
+  void hostBusTime(size_t bytes) {
+    uint32_t us = hostTransferMicros(bytes);
+    busMicros += us;
+    delayMicroseconds(us);
+  }
+
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    if (frequency) clockHz = frequency;
+    return true;
+  }
+  bool setClock(uint32_t frequency) { clockHz = frequency; return true; }
+  uint32_t getClock() { return clockHz; }
+
+  void beginTransmission(uint8_t address) { txAddress = address; txCount = 0; }
+  size_t write(uint8_t data) { txCount++; return 1; }
+  size_t write(const uint8_t* data, size_t len) { txCount += len; return len; }
+  uint8_t endTransmission(bool sendStop = true) {
+    transactions++;
+    hostBusTime(1 + (presentAddresses.count(txAddress) ? txCount : 0));
+    return presentAddresses.count(txAddress) ? 0 : 2;  // 2 = NACK on address
+  }
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true) {
+    transactions++;
+    hostBusTime(1 + ((address == 0x5F || presentAddresses.count(address)) ? quantity : 0));
+    rxCount = 0;
+    rxIndex = 0;
+    if (address == 0x5F) {
+      // CardKB returns 0 when no key is waiting
+      for (uint8_t i = 0; i < quantity && rxCount < sizeof(rxBuffer); i++) {
+        uint8_t key = 0;
+        if (!keyQueue.empty()) {
+          key = keyQueue.front();
+          keyQueue.pop_front();
+        }
+        rxBuffer[rxCount++] = key;
+      }
+    } else if (presentAddresses.count(address)) {
+      for (uint8_t i = 0; i < quantity && rxCount < sizeof(rxBuffer); i++) rxBuffer[rxCount++] = 0;
+    }
+    return rxCount;
+  }
+  uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+  int available() { return rxCount - rxIndex; }
+  int read() { return rxIndex < rxCount ? rxBuffer[rxIndex++] : -1; }
+
+private:
+  uint8_t txAddress = 0;
+  size_t txCount = 0;
+  uint8_t rxBuffer[32];
+  uint8_t rxCount = 0;
+  uint8_t rxIndex = 0;
+};
+
+inline TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,32 @@
+/*
+ * Host shim: ESP-IDF GPIO driver
+ */
+
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include <Arduino.h>
+
+typedef enum {
+  GPIO_DRIVE_CAP_0,
+  GPIO_DRIVE_CAP_1,
+  GPIO_DRIVE_CAP_2,
+  GPIO_DRIVE_CAP_3
+} gpio_drive_cap_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+
+inline esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t intr_type) { return ESP_OK; }
+inline esp_err_t gpio_wakeup_disable(gpio_num_t gpio) { return ESP_OK; }
+inline esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t intr_type) { return ESP_OK; }
+
+inline esp_err_t gpio_set_drive_capability(gpio_num_t gpio, gpio_drive_cap_t strength) { return ESP_OK; }
+
+#endif // HOST_DRIVER_GPIO_H
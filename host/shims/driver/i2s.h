@@ -0,0 +1,201 @@
+/*
+ * Host shim: ESP-IDF legacy I2S driver
+ *
+ * Models the TX DMA ring so i2s_write() blocks in virtual time the way it
+ * does on the device: the ring drains at the configured sample rate and a
+ * write that does not fit advances the clock until it does.
+ *
+ * With capture set, everything the DAC would play is kept in memory
+ * (silence filled in where the ring ran dry) for hostI2SWriteWav().
+ */
+
+#ifndef HOST_DRIVER_I2S_H
+#define HOST_DRIVER_I2S_H
+
+#include <Arduino.h>
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1, I2S_NUM_MAX } i2s_port_t;
+
+typedef enum {
+  I2S_MODE_MASTER = (1 << 0),
+  I2S_MODE_SLAVE  = (1 << 1),
+  I2S_MODE_TX     = (1 << 2),
+  I2S_MODE_RX     = (1 << 3)
+} i2s_mode_t;
+
+typedef enum {
+  I2S_BITS_PER_SAMPLE_8BIT  = 8,
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+  I2S_BITS_PER_SAMPLE_24BIT = 24,
+  I2S_BITS_PER_SAMPLE_32BIT = 32
+} i2s_bits_per_sample_t;
+
+typedef enum {
+  I2S_CHANNEL_FMT_RIGHT_LEFT,
+  I2S_CHANNEL_FMT_ALL_RIGHT,
+  I2S_CHANNEL_FMT_ALL_LEFT,
+  I2S_CHANNEL_FMT_ONLY_RIGHT,
+  I2S_CHANNEL_FMT_ONLY_LEFT
+} i2s_channel_fmt_t;
+
+typedef enum {
+  I2S_COMM_FORMAT_STAND_I2S = 0x01,
+  I2S_COMM_FORMAT_STAND_MSB = 0x02
+} i2s_comm_format_t;
+
+#define I2S_PIN_NO_CHANGE (-1)
+
+typedef struct {
+  i2s_mode_t mode;
+  uint32_t sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t channel_format;
+  i2s_comm_format_t communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+  bool tx_desc_auto_clear;
+  int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+  int mck_io_num;
+  int bck_io_num;
+  int ws_io_num;
+  int data_out_num;
+  int data_in_num;
+} i2s_pin_config_t;
+
+// Emulated TX channel state (stereo 16-bit frames)
+struct HostI2S {
+  bool installed = false;
+  bool running = false;            // Clocks running (i2s_start/i2s_stop)
+  uint32_t sampleRate = 44100;
+  uint32_t capacityFrames = 512;   // dma_buf_count * dma_buf_len
+  double queuedFrames = 0;         // Frames waiting in the DMA ring
+  uint64_t lastDrainMicros = 0;
+  uint64_t framesWritten = 0;
+  uint64_t nonZeroFrames = 0;
+
+  // Optional sink for every written frame (left channel), set by host tools
+  void (*sink)(const int16_t* stereo, size_t frames, uint64_t startMicros) = nullptr;
+  // Optional: queued frames due at or after this time were dropped unplayed
+  void (*dropped)(uint64_t fromMicros) = nullptr;
+
+  // PCM capture (stereo interleaved), set by host tools
+  bool capture = false;
+  std::vector<int16_t> captured;
+  uint64_t captureStartMicros = 0;  // When the first captured frame plays
+
+  void record(const int16_t* stereo, size_t frames, uint64_t startMicros) {
+    if (captured.empty()) captureStartMicros = startMicros;
+    // Underrun: the DAC played zeros until this write reached it
+    uint64_t due = (startMicros - captureStartMicros) * sampleRate / 1000000;
+    if (due > captured.size() / 2) captured.resize(due * 2, 0);
+    captured.insert(captured.end(), stereo, stereo + frames * 2);
+  }
+
+  // The queued frames were dropped (stop/zero): keep only what has played
+  void truncateCapture() {
+    if (captured.empty()) return;
+    uint64_t played = (hostNowMicros - std::min(hostNowMicros, captureStartMicros)) * sampleRate / 1000000;
+    if (played * 2 < captured.size()) captured.resize(played * 2);
+  }
+
+  void drain() {
+    uint64_t now = hostNowMicros;
+    double drained = (double)(now - lastDrainMicros) * sampleRate / 1e6;
+    queuedFrames = queuedFrames > drained ? queuedFrames - drained : 0;
+    lastDrainMicros = now;
+  }
+};
+
+inline HostI2S hostI2S;
+
+inline esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queue_size, void* queue) {
+  hostI2S.installed = true;
+  hostI2S.running = true;
+  hostI2S.sampleRate = config->sample_rate;
+  hostI2S.capacityFrames = (uint32_t)(config->dma_buf_count * config->dma_buf_len);
+  hostI2S.queuedFrames = 0;
+  hostI2S.lastDrainMicros = hostNowMicros;
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_driver_uninstall(i2s_port_t port) { hostI2S.installed = false; return ESP_OK; }
+inline esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pin) { return ESP_OK; }
+
+inline esp_err_t i2s_stop(i2s_port_t port) {
+  if (hostI2S.capture) hostI2S.truncateCapture();
+  if (hostI2S.dropped) hostI2S.dropped(hostNowMicros);
+  hostI2S.running = false;
+  hostI2S.queuedFrames = 0;  // Pending DMA data is dropped
+  return ESP_OK;
+}
+inline esp_err_t i2s_start(i2s_port_t port) {
+  hostI2S.running = true;
+  hostI2S.lastDrainMicros = hostNowMicros;
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_zero_dma_buffer(i2s_port_t port) {
+  if (hostI2S.capture) hostI2S.truncateCapture();
+  if (hostI2S.dropped) hostI2S.dropped(hostNowMicros);
+  hostI2S.queuedFrames = 0;
+  hostI2S.lastDrainMicros = hostNowMicros;
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_write(i2s_port_t port, const void* src, size_t size, size_t* bytes_written, TickType_t ticks_to_wait) {
+  if (!hostI2S.installed) return ESP_FAIL;
+  if (!hostI2S.running) {
+    // A stopped channel never drains: a blocking write would hang forever
+    if (bytes_written) *bytes_written = 0;
+    return ESP_FAIL;
+  }
+  size_t frames = size / (2 * sizeof(int16_t));
+  hostI2S.drain();
+
+  // Block (in virtual time) until the frames fit, or give up after the timeout
+  double overflow = hostI2S.queuedFrames + frames - hostI2S.capacityFrames;
+  if (overflow > 0) {
+    uint64_t waitMicros = (uint64_t)ceil(overflow * 1e6 / hostI2S.sampleRate);
+    if (ticks_to_wait != portMAX_DELAY && waitMicros > (uint64_t)ticks_to_wait * 1000) {
+      waitMicros = (uint64_t)ticks_to_wait * 1000;
+    }
+    hostAdvanceMicros(waitMicros);
+    hostI2S.drain();
+  }
+
+  // Frame start time = when it will reach the DAC
+  uint64_t startMicros = hostNowMicros + (uint64_t)(hostI2S.queuedFrames * 1e6 / hostI2S.sampleRate);
+  const int16_t* samples = (const int16_t*)src;
+  for (size_t i = 0; i < frames; i++) {
+    if (samples[i * 2] != 0 || samples[i * 2 + 1] != 0) hostI2S.nonZeroFrames++;
+  }
+  if (hostI2S.sink) hostI2S.sink(samples, frames, startMicros);
+  if (hostI2S.capture) hostI2S.record(samples, frames, startMicros);
+
+  hostI2S.queuedFrames += frames;
+  hostI2S.framesWritten += frames;
+  if (bytes_written) *bytes_written = size;
+  return ESP_OK;
+}
+
+// Write the captured PCM as a 16-bit stereo WAV file
+inline bool hostI2SWriteWav(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  uint32_t dataBytes = (uint32_t)(hostI2S.captured.size() * sizeof(int16_t));
+  uint32_t rate = hostI2S.sampleRate;
+  auto put32 = [f](uint32_t v) { uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)}; fwrite(b, 1, 4, f); };
+  auto put16 = [f](uint16_t v) { uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)}; fwrite(b, 1, 2, f); };
+  fwrite("RIFF", 1, 4, f); put32(36 + dataBytes); fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f); put32(16); put16(1); put16(2); put32(rate); put32(rate * 4); put16(4); put16(16);
+  fwrite("data", 1, 4, f); put32(dataBytes);
+  fwrite(hostI2S.captured.data(), sizeof(int16_t), hostI2S.captured.size(), f);  // Host is little-endian
+  return fclose(f) == 0;
+}
+
+#endif // HOST_DRIVER_I2S_H
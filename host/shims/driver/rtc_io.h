@@ -0,0 +1,15 @@
+/*
+ * Host shim: ESP-IDF RTC GPIO driver (pull-ups kept through deep sleep)
+ */
+
+#ifndef HOST_DRIVER_RTC_IO_H
+#define HOST_DRIVER_RTC_IO_H
+
+#include <Arduino.h>
+
+inline esp_err_t rtc_gpio_pullup_en(gpio_num_t gpio) { return ESP_OK; }
+inline esp_err_t rtc_gpio_pullup_dis(gpio_num_t gpio) { return ESP_OK; }
+inline esp_err_t rtc_gpio_pulldown_en(gpio_num_t gpio) { return ESP_OK; }
+inline esp_err_t rtc_gpio_pulldown_dis(gpio_num_t gpio) { return ESP_OK; }
+
+#endif // HOST_DRIVER_RTC_IO_H
@@ -0,0 +1,23 @@
+/*
+ * Host shim: esp_cpu cycle counter
+ *
+ * Unlike the rest of the shims this is on the host's real clock: it is only
+ * used to time code (benchmarks). Counts are host nanoseconds scaled to
+ * getCpuFrequencyMhz(), so cycles/op read as cycles at the configured clock.
+ */
+
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <Arduino.h>
+#include <chrono>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+inline esp_cpu_cycle_count_t esp_cpu_get_cycle_count() {
+  uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+  return (esp_cpu_cycle_count_t)(ns * getCpuFrequencyMhz() / 1000);
+}
+
+#endif // HOST_ESP_CPU_H
@@ -0,0 +1,41 @@
+/*
+ * Host shim: ESP-IDF heap capabilities
+ *
+ * The host heap is nothing like the ESP32's, so these report fixed figures
+ * (an S3 with WiFi up, no PSRAM) that tools may change to stage a screen.
+ * Free size never moves, so subsystem heap deltas read 0 on the host.
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_EXEC      (1 << 0)
+#define MALLOC_CAP_32BIT     (1 << 1)
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+
+struct HostHeap {
+  size_t total;
+  size_t free;
+  size_t minFree;
+  size_t largest;
+};
+inline HostHeap hostHeap = {327680, 196608, 180224, 110592};
+inline HostHeap hostPsram = {0, 0, 0, 0};
+
+inline const HostHeap& hostHeapFor(uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? hostPsram : hostHeap;
+}
+
+inline size_t heap_caps_get_total_size(uint32_t caps) { return hostHeapFor(caps).total; }
+inline size_t heap_caps_get_free_size(uint32_t caps) { return hostHeapFor(caps).free; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { return hostHeapFor(caps).minFree; }
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return hostHeapFor(caps).largest; }
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,45 @@
+/*
+ * Host shim: ESP-IDF power management (records configuration and lock state)
+ */
+
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#include <Arduino.h>
+
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+typedef struct {
+  int max_freq_mhz;
+  int min_freq_mhz;
+  bool light_sleep_enable;
+} esp_pm_config_t;
+
+typedef enum { ESP_PM_CPU_FREQ_MAX, ESP_PM_APB_FREQ_MAX, ESP_PM_NO_LIGHT_SLEEP } esp_pm_lock_type_t;
+
+struct HostPmLock {
+  esp_pm_lock_type_t type;
+  const char* name;
+  int count;
+};
+typedef HostPmLock* esp_pm_lock_handle_t;
+
+inline esp_pm_config_t hostPmConfig = {240, 240, false};
+
+inline esp_err_t esp_pm_configure(const void* config) {
+  hostPmConfig = *(const esp_pm_config_t*)config;
+  return ESP_OK;
+}
+inline esp_err_t esp_pm_get_configuration(void* config) {
+  *(esp_pm_config_t*)config = hostPmConfig;
+  return ESP_OK;
+}
+inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* out) {
+  *out = new HostPmLock{type, name, 0};
+  return ESP_OK;
+}
+inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t h) { h->count++; return ESP_OK; }
+inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t h) { if (h->count == 0) return ESP_FAIL; h->count--; return ESP_OK; }
+inline esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t h) { delete h; return ESP_OK; }
+
+#endif // HOST_ESP_PM_H
@@ -0,0 +1,59 @@
+/*
+ * Host shim: esp_sleep wakeup sources (deep sleep itself is in Arduino.h)
+ *
+ * Tools simulate a paddle wake by setting hostWakeupCause/hostExt1WakeMask
+ * after esp_deep_sleep_start() and running setup() again; RTC_DATA_ATTR
+ * variables are plain globals, so they survive like RTC memory does.
+ */
+
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <Arduino.h>
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+  ESP_SLEEP_WAKEUP_ULP,
+  ESP_SLEEP_WAKEUP_GPIO
+} esp_sleep_source_t;
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+typedef enum {
+  ESP_EXT1_WAKEUP_ANY_LOW = 0,
+  ESP_EXT1_WAKEUP_ANY_HIGH = 1
+} esp_sleep_ext1_wakeup_mode_t;
+
+typedef enum {
+  ESP_PD_DOMAIN_RTC_PERIPH,
+  ESP_PD_DOMAIN_RTC_SLOW_MEM,
+  ESP_PD_DOMAIN_RTC_FAST_MEM,
+  ESP_PD_DOMAIN_XTAL
+} esp_sleep_pd_domain_t;
+
+typedef enum {
+  ESP_PD_OPTION_OFF,
+  ESP_PD_OPTION_ON,
+  ESP_PD_OPTION_AUTO
+} esp_sleep_pd_option_t;
+
+inline esp_sleep_wakeup_cause_t hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+inline uint64_t hostExt1WakeMask = 0;      // Pins that "woke" the host
+inline uint64_t hostExt1EnabledMask = 0;   // Set by esp_sleep_enable_ext1_wakeup()
+
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+
+inline esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t mode) {
+  hostExt1EnabledMask = mask;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_sleep_pd_config(esp_sleep_pd_domain_t domain, esp_sleep_pd_option_t option) { return ESP_OK; }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return hostWakeupCause; }
+inline uint64_t esp_sleep_get_ext1_wakeup_status() { return hostExt1WakeMask; }
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,67 @@
+/*
+ * Host shim: esp_timer on the virtual clock
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <Arduino.h>
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct HostEspTimer {
+  esp_timer_cb_t callback;
+  void* arg;
+  uint64_t period;     // 0 = one-shot
+  uint32_t deadline;   // Host deadline id, 0 when stopped
+};
+typedef HostEspTimer* esp_timer_handle_t;
+
+inline void hostEspTimerFire(void* p) {
+  HostEspTimer* t = (HostEspTimer*)p;
+  t->deadline = 0;
+  if (t->period) t->deadline = hostSchedule(hostNowMicros + t->period, hostEspTimerFire, t);
+  t->callback(t->arg);
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  *out = new HostEspTimer{args->callback, args->arg, 0, 0};
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+  if (!t->deadline) return ESP_FAIL;  // ESP_ERR_INVALID_STATE
+  hostCancel(t->deadline);
+  t->deadline = 0;
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period) {
+  if (t->deadline) return ESP_FAIL;
+  t->period = period;
+  t->deadline = hostSchedule(hostNowMicros + period, hostEspTimerFire, t);
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout) {
+  if (t->deadline) return ESP_FAIL;
+  t->period = 0;
+  t->deadline = hostSchedule(hostNowMicros + timeout, hostEspTimerFire, t);
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_delete(esp_timer_handle_t t) {
+  if (t->deadline) hostCancel(t->deadline);
+  delete t;
+  return ESP_OK;
+}
+inline bool esp_timer_is_active(esp_timer_handle_t t) { return t->deadline != 0; }
+inline int64_t esp_timer_get_time() { return (int64_t)hostNowMicros; }
+
+#endif // HOST_ESP_TIMER_H
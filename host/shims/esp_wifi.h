@@ -0,0 +1,15 @@
+/*
+ * Host shim: ESP-IDF WiFi driver calls used next to the Arduino WiFi class
+ */
+
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+#include <WiFi.h>
+
+inline esp_err_t esp_wifi_scan_stop() {
+  WiFi.hostStopScan();
+  return ESP_OK;
+}
+
+#endif // HOST_ESP_WIFI_H
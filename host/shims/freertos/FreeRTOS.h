@@ -0,0 +1,40 @@
+/*
+ * Host shim: FreeRTOS basics (1 tick = 1 ms, single core, virtual time)
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY      0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+#define errQUEUE_FULL 0
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+// Spinlocks are no-ops: host code runs on one thread
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// Task introspection, as the ESP32 Arduino core configures FreeRTOS
+#define configUSE_TRACE_FACILITY       1
+#define configGENERATE_RUN_TIME_STATS  1
+#define configTASKLIST_INCLUDE_COREID  1
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,78 @@
+/*
+ * Host shim: FreeRTOS queues
+ *
+ * A blocking receive from loop() advances the virtual clock to the next
+ * scheduled deadline (a timer or task that may post) until an item arrives
+ * or the timeout passes. A blocking receive inside a task suspends it until
+ * a send wakes it or the timeout deadline fires.
+ */
+
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct HostQueue {
+  size_t itemSize;
+  size_t length;
+  std::deque<std::vector<uint8_t>> items;
+  HostWaiter receiver;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  return new HostQueue{itemSize, length, {}, {}};
+}
+inline void vQueueDelete(QueueHandle_t q) { delete q; }
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+  if (q->items.size() >= q->length) return errQUEUE_FULL;
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  hostWake(q->receiver);
+  return pdPASS;
+}
+#define xQueueSendToBack xQueueSend
+inline BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken) {
+  BaseType_t r = xQueueSend(q, item, 0);
+  if (woken && r == pdPASS) *woken = pdTRUE;
+  return r;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+  uint64_t limit = ticks == portMAX_DELAY ? UINT64_MAX : hostNowMicros + (uint64_t)ticks * 1000;
+  if (hostCurrentTask) {
+    while (q->items.empty()) {
+      if (ticks == 0 || hostNowMicros >= limit) return pdFALSE;
+      hostBlock(q->receiver, limit);
+    }
+  }
+  // loop() waiting here is idle time, less what tasks ran (uxTaskGetSystemState)
+  struct IdleCount {
+    uint64_t start = hostNowMicros, tasks = hostTaskRunMicros;
+    ~IdleCount() {
+      if (!hostCurrentTask) hostIdleMicros += hostNowMicros - start - (hostTaskRunMicros - tasks);
+    }
+  } idleCount;
+  while (q->items.empty()) {
+    uint64_t next = hostNextDeadline();
+    if (next == UINT64_MAX && limit == UINT64_MAX) return pdFALSE;  // Would block forever
+    if (next > limit || hostNowMicros >= limit) {
+      if (limit > hostNowMicros) hostAdvanceMicros(limit - hostNowMicros);
+      if (q->items.empty()) return pdFALSE;
+      break;
+    }
+    hostAdvanceMicros(next > hostNowMicros ? next - hostNowMicros : 0);
+  }
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  return pdPASS;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return (UBaseType_t)q->items.size(); }
+inline BaseType_t xQueueReset(QueueHandle_t q) { q->items.clear(); return pdPASS; }
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,49 @@
+/*
+ * Host shim: FreeRTOS mutexes and binary semaphores
+ *
+ * A task waiting for a taken semaphore suspends until xSemaphoreGive() or
+ * its timeout; loop() advances the virtual clock instead. Either way the
+ * holder (a suspended task) gets to run and give it back.
+ */
+
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct HostSemaphore {
+  bool taken;
+  HostWaiter waiter;
+};
+typedef HostSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new HostSemaphore{false, {}}; }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return new HostSemaphore{true, {}}; }  // Created empty
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+  uint64_t limit = ticks == portMAX_DELAY ? UINT64_MAX : hostNowMicros + (uint64_t)ticks * 1000;
+  while (s->taken) {
+    if (ticks == 0 || hostNowMicros >= limit) return pdFALSE;
+    if (hostCurrentTask) {
+      hostBlock(s->waiter, limit);
+    } else {
+      uint64_t next = std::min(hostNextDeadline(), limit);
+      if (next == UINT64_MAX) return pdFALSE;  // Would block forever
+      hostAdvanceMicros(next > hostNowMicros ? next - hostNowMicros : 1);
+    }
+  }
+  s->taken = true;
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  if (!s->taken) return pdFALSE;
+  s->taken = false;
+  hostWake(s->waiter);
+  return pdTRUE;
+}
+
+#endif // HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,252 @@
+/*
+ * Host shim: FreeRTOS tasks
+ *
+ * A new task is scheduled as a host deadline at the current time, so it
+ * first runs the next time the virtual clock moves (the creating task
+ * blocking or delaying), like a task on the other core getting going.
+ * Each task runs on its own stack (ucontext); vTaskDelay() inside a task
+ * suspends it and schedules its resumption, so tasks that loop forever
+ * work. vTaskDelete(NULL) ends a task early.
+ *
+ * Under AddressSanitizer every switch is announced as a fiber switch, so
+ * ASan tracks the task stacks instead of reporting false positives.
+ *
+ * uxTaskGetSystemState() reports virtual time: a task's run time is the
+ * clock's advance while it ran (bus transfers and the like), loopTask has
+ * the rest minus its blocking queue waits (which are IDLE). Task stacks are
+ * painted, so high-water marks are real, though x86-64 frames are larger
+ * than Xtensa ones.
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <memory>
+#include <ucontext.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define HOST_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define HOST_ASAN 1
+#endif
+#endif
+#ifdef HOST_ASAN
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+typedef void (*TaskFunction_t)(void* param);
+
+#define HOST_TASK_STACK_BYTES (256 * 1024)
+#define HOST_STACK_PAINT      0xA5
+#define HOST_LOOP_STACK_BYTES 8192  // CONFIG_ARDUINO_LOOP_STACK_SIZE (the main thread is not painted)
+
+struct HostTask {
+  TaskFunction_t fn;
+  void* param;
+  const char* name;
+  bool finished;
+  bool started;
+  ucontext_t context;
+  ucontext_t* caller;       // Whoever resumed the task last
+  std::vector<char> stack;
+  void* fakeStack;          // ASan bookkeeping while switched away
+  const void* callerStack;  // ASan: the resumer's stack bounds
+  size_t callerStackSize;
+  uint32_t stackDepth;      // Bytes asked for at creation
+  UBaseType_t priority;
+  BaseType_t core;
+  uint64_t runMicros;       // Virtual time advanced while it ran
+};
+typedef HostTask* TaskHandle_t;
+
+// Every task ever created (freed at exit; finished tasks keep their slot)
+inline std::vector<std::unique_ptr<HostTask>> hostTasks;
+
+// Fiber switch announcements for ASan (no-ops otherwise)
+inline void hostSwitchStart(void** fakeStack, const void* bottom, size_t size) {
+#ifdef HOST_ASAN
+  __sanitizer_start_switch_fiber(fakeStack, bottom, size);
+#endif
+}
+inline void hostSwitchFinish(void* fakeStack, const void** oldBottom, size_t* oldSize) {
+#ifdef HOST_ASAN
+  __sanitizer_finish_switch_fiber(fakeStack, oldBottom, oldSize);
+#endif
+}
+
+struct HostTaskExit {};  // Thrown by vTaskDelete(NULL) to unwind the task
+
+inline HostTask* hostCurrentTask = nullptr;
+inline uint64_t hostTaskRunMicros = 0;   // All tasks' run time together
+inline uint64_t hostIdleMicros = 0;      // loop() blocked in a queue wait
+
+inline void hostTaskEntry() {
+  HostTask* task = hostCurrentTask;
+  hostSwitchFinish(nullptr, &task->callerStack, &task->callerStackSize);
+  try {
+    task->fn(task->param);
+  } catch (const HostTaskExit&) {
+  }
+  task->finished = true;
+  hostSwitchStart(nullptr, task->callerStack, task->callerStackSize);  // This stack is done
+  setcontext(task->caller);
+}
+
+// Deadline callback: start the task or resume it where it suspended
+inline void hostRunTask(void* p) {
+  HostTask* task = (HostTask*)p;
+  if (task->finished) return;
+  HostTask* previous = hostCurrentTask;
+  hostCurrentTask = task;
+  ucontext_t here;
+  task->caller = &here;
+  if (!task->started) {
+    task->started = true;
+    task->stack.assign(HOST_TASK_STACK_BYTES, (char)HOST_STACK_PAINT);
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack.data();
+    task->context.uc_stack.ss_size = task->stack.size();
+    task->context.uc_link = nullptr;
+    makecontext(&task->context, hostTaskEntry, 0);
+  }
+  void* fakeStack = nullptr;
+  uint64_t start = hostNowMicros;
+  uint64_t othersBefore = hostTaskRunMicros;
+  hostSwitchStart(&fakeStack, task->stack.data(), task->stack.size());
+  swapcontext(&here, &task->context);
+  hostSwitchFinish(fakeStack, nullptr, nullptr);
+  uint64_t ran = hostNowMicros - start - (hostTaskRunMicros - othersBefore);  // Less tasks it woke
+  task->runMicros += ran;
+  hostTaskRunMicros += ran;
+  hostCurrentTask = previous;
+}
+
+// Suspend the running task until something schedules hostRunTask() for it
+inline void hostTaskSuspend() {
+  HostTask* task = hostCurrentTask;
+  hostSwitchStart(&task->fakeStack, task->callerStack, task->callerStackSize);
+  swapcontext(&task->context, task->caller);
+  hostSwitchFinish(task->fakeStack, &task->callerStack, &task->callerStackSize);
+}
+
+// Suspend the running task for a while (other deadlines and loop() run meanwhile)
+inline void hostTaskSleep(uint64_t us) {
+  hostSchedule(hostNowMicros + us, hostRunTask, hostCurrentTask);
+  hostTaskSuspend();
+}
+
+/*
+ * A task blocked on a queue or semaphore: woken by the other side, or by
+ * its timeout deadline
+ */
+struct HostWaiter {
+  HostTask* task = nullptr;
+  uint32_t timeoutId = 0;
+};
+
+// Block the running task until hostWake() or the timeout (UINT64_MAX = none)
+inline void hostBlock(HostWaiter& waiter, uint64_t limit) {
+  waiter.task = hostCurrentTask;
+  waiter.timeoutId = (limit == UINT64_MAX) ? 0 : hostSchedule(limit, hostRunTask, hostCurrentTask);
+  hostTaskSuspend();
+  if (waiter.timeoutId) hostCancel(waiter.timeoutId);
+  waiter.task = nullptr;
+  waiter.timeoutId = 0;
+}
+
+inline void hostWake(HostWaiter& waiter) {
+  if (waiter.task == nullptr) return;
+  if (waiter.timeoutId) hostCancel(waiter.timeoutId);
+  waiter.timeoutId = 0;
+  hostSchedule(hostNowMicros, hostRunTask, waiter.task);
+  waiter.task = nullptr;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                          void* param, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  HostTask* task = new HostTask{fn, param, name, false, false, {}, nullptr, {}, nullptr, nullptr, 0,
+                                stackDepth, priority, core, 0};
+  hostTasks.emplace_back(task);
+  if (handle) *handle = task;
+  hostSchedule(hostNowMicros, hostRunTask, task);
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                              void* param, UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr || task == hostCurrentTask) throw HostTaskExit();
+  task->finished = true;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+  if (hostCurrentTask) {
+    hostTaskSleep((uint64_t)ticks * 1000);
+  } else {
+    hostAdvanceMicros((uint64_t)ticks * 1000);
+  }
+}
+inline TickType_t xTaskGetTickCount() { return (TickType_t)(hostNowMicros / 1000); }
+inline BaseType_t xPortGetCoreID() { return hostCurrentTask ? 0 : 1; }
+
+// loop() runs outside any task: a null handle, named as on the device
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return hostCurrentTask; }
+inline const char* pcTaskGetName(TaskHandle_t task) {
+  if (task == nullptr) task = hostCurrentTask;
+  return task ? task->name : "loopTask";
+}
+
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+
+typedef struct {
+  TaskHandle_t xHandle;
+  const char* pcTaskName;
+  UBaseType_t xTaskNumber;
+  eTaskState eCurrentState;
+  UBaseType_t uxCurrentPriority;
+  UBaseType_t uxBasePriority;
+  uint32_t ulRunTimeCounter;
+  void* pxStackBase;
+  uint32_t usStackHighWaterMark;
+  BaseType_t xCoreID;
+} TaskStatus_t;
+
+// Least stack a task has had free: its depth less what the paint shows was used
+inline uint32_t hostStackHighWater(const HostTask* task) {
+  if (!task->started) return task->stackDepth;
+  size_t untouched = 0;
+  while (untouched < task->stack.size() && (uint8_t)task->stack[untouched] == HOST_STACK_PAINT) untouched++;
+  size_t used = task->stack.size() - untouched;
+  return used < task->stackDepth ? (uint32_t)(task->stackDepth - used) : 0;
+}
+
+inline UBaseType_t uxTaskGetNumberOfTasks() {
+  UBaseType_t count = 2;  // loopTask, IDLE1
+  for (const auto& task : hostTasks) count += !task->finished;
+  return count;
+}
+
+inline UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* totalRunTime) {
+  if (size < uxTaskGetNumberOfTasks()) return 0;
+  UBaseType_t n = 0;
+  uint64_t loopMicros = hostNowMicros - hostTaskRunMicros - hostIdleMicros;
+  status[n++] = {nullptr, "loopTask", 1, eRunning, 1, 1, (uint32_t)loopMicros, nullptr, HOST_LOOP_STACK_BYTES, 1};
+  status[n++] = {nullptr, "IDLE1", 2, eReady, 0, 0, (uint32_t)hostIdleMicros, nullptr, 1024, 1};
+  for (const auto& task : hostTasks) {
+    if (task->finished) continue;
+    HostTask* t = task.get();
+    status[n] = {t, t->name, n + 1, t == hostCurrentTask ? eRunning : eBlocked, t->priority, t->priority,
+                 (uint32_t)t->runMicros, t->stack.data(), hostStackHighWater(t), t->core};
+    n++;
+  }
+  if (totalRunTime) *totalRunTime = (uint32_t)hostNowMicros;
+  return n;
+}
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,19 @@
+/*
+ * Host shim: ESP-IDF GPIO low-level HAL (register writes are no-ops)
+ */
+
+#ifndef HOST_HAL_GPIO_LL_H
+#define HOST_HAL_GPIO_LL_H
+
+#include <driver/gpio.h>
+
+typedef struct {
+  uint32_t unused;
+} gpio_dev_t;
+
+inline gpio_dev_t GPIO;
+
+inline void gpio_ll_set_intr_type(gpio_dev_t* hw, uint32_t gpio_num, gpio_int_type_t intr_type) {}
+inline void gpio_ll_wakeup_disable(gpio_dev_t* hw, uint32_t gpio_num) {}
+
+#endif // HOST_HAL_GPIO_LL_H
@@ -0,0 +1,108 @@
+/*
+ * Run the firmware microbenchmarks (benchmarks.h) on the host
+ *
+ *   bench [--filter PREFIX] [--no-display] [--compare BASELINE.csv] [--out FILE.csv]
+ *
+ * Boots the firmware, then runs the same suite as the serial "bench"
+ * command and prints its CSV. Time is the host's real clock (esp_cpu.h
+ * shim); allocations are counted through operator new. With --compare,
+ * each benchmark's ns/op is set against a saved run (the device's serial
+ * output works too) and the change is printed.
+ *
+ * Build with -DHOST_PERF=ON to profile a single benchmark:
+ *   perf record -g ./bench --filter tone_block
+ */
+
+#include "morse_trainer_menu.cpp"
+
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+
+// Every C++ allocation (String, std::vector, ...) goes through the heap hook.
+// Kept out of line so GCC does not pair the inlined malloc/free with new/delete.
+__attribute__((noinline)) void* operator new(size_t size) {
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  esp_heap_trace_alloc_hook(p, size, 0);
+  return p;
+}
+__attribute__((noinline)) void* operator new[](size_t size) { return operator new(size); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// benchmark -> ns/op from a CSV (comment lines and the header are skipped)
+static std::map<std::string, double> readResults(std::istream& in) {
+  std::map<std::string, double> results;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#' || line.rfind("benchmark,", 0) == 0) continue;
+    std::istringstream row(line);
+    std::string name, iterations, ns;
+    if (std::getline(row, name, ',') && std::getline(row, iterations, ',') && std::getline(row, ns, ',')) {
+      results[name] = atof(ns.c_str());
+    }
+  }
+  return results;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: bench [--filter PREFIX] [--no-display] [--compare BASELINE.csv] [--out FILE.csv]\n");
+}
+
+int main(int argc, char** argv) {
+  std::string filter, comparePath, outPath;
+  bool display = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+    else if (arg == "--no-display") display = false;
+    else if (arg == "--compare" && i + 1 < argc) comparePath = argv[++i];
+    else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+    else { usage(); return 2; }
+  }
+
+  setup();
+
+  // Display primitives cost host CPU only; bus time would run timers and tasks mid-batch
+  hostDisplayBus.advanceClock = false;
+  Serial.output.clear();
+  Serial.capture = true;
+  int ran = runBenchmarks(filter.c_str(), display ? &tft : nullptr);
+  Serial.capture = false;
+  fputs(Serial.output.c_str(), stdout);
+  if (ran == 0) {
+    fprintf(stderr, "bench: no benchmark matches \"%s\"\n", filter.c_str());
+    return 1;
+  }
+
+  if (!outPath.empty()) {
+    std::ofstream out(outPath);
+    out << Serial.output;
+  }
+
+  if (!comparePath.empty()) {
+    std::ifstream baselineFile(comparePath);
+    if (!baselineFile) {
+      fprintf(stderr, "bench: cannot read %s\n", comparePath.c_str());
+      return 1;
+    }
+    std::map<std::string, double> baseline = readResults(baselineFile);
+    std::istringstream current(Serial.output);
+    printf("\nbenchmark,baseline_ns,ns,change_pct\n");
+    for (const auto& [name, ns] : readResults(current)) {
+      auto it = baseline.find(name);
+      if (it == baseline.end() || it->second <= 0) {
+        printf("%s,,%.1f,\n", name.c_str(), ns);
+      } else {
+        printf("%s,%.1f,%.1f,%+.1f\n", name.c_str(), it->second, ns, 100.0 * (ns - it->second) / it->second);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * RGB565 framebuffer <-> image files for the host tools
+ *
+ * PNG is written with one fixed-Huffman deflate block (LZ77 on the
+ * scanlines, no zlib needed); flat UI colours compress well, so golden
+ * images are small enough to commit. readPNG() reads back stored and
+ * fixed-Huffman streams, i.e. what writePNG() produces, not every PNG.
+ * PPM (P6) is kept for diff images and quick viewing.
+ */
+
+#ifndef HOST_IMAGE_IO_H
+#define HOST_IMAGE_IO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct RGBImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgb;  // width * height * 3
+
+  bool empty() const { return rgb.empty(); }
+};
+
+// Expand RGB565 to 8-bit channels (replicating high bits like the panel does)
+inline RGBImage imageFromRGB565(const uint16_t* pixels, int width, int height) {
+  RGBImage img;
+  img.width = width;
+  img.height = height;
+  img.rgb.resize((size_t)width * height * 3);
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    uint16_t c = pixels[i];
+    uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+    img.rgb[i * 3 + 0] = (uint8_t)((r << 3) | (r >> 2));
+    img.rgb[i * 3 + 1] = (uint8_t)((g << 2) | (g >> 4));
+    img.rgb[i * 3 + 2] = (uint8_t)((b << 3) | (b >> 2));
+  }
+  return img;
+}
+
+inline bool writePPM(const std::string& path, const RGBImage& img) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", img.width, img.height);
+  fwrite(img.rgb.data(), 1, img.rgb.size(), f);
+  return fclose(f) == 0;
+}
+
+inline bool readPPM(const std::string& path, RGBImage& img) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  int maxval = 0;
+  if (fscanf(f, "P6 %d %d %d", &img.width, &img.height, &maxval) != 3 || maxval != 255) {
+    fclose(f);
+    return false;
+  }
+  fgetc(f);  // Single whitespace after the header
+  img.rgb.resize((size_t)img.width * img.height * 3);
+  size_t got = fread(img.rgb.data(), 1, img.rgb.size(), f);
+  fclose(f);
+  return got == img.rgb.size();
+}
+
+inline uint32_t pngCrc(const uint8_t* data, size_t len, uint32_t crc = 0xFFFFFFFF) {
+  static uint32_t table[256];
+  static bool ready = false;
+  if (!ready) {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+    ready = true;
+  }
+  for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+inline void pngPut32(std::vector<uint8_t>& out, uint32_t v) {
+  out.push_back(v >> 24); out.push_back(v >> 16); out.push_back(v >> 8); out.push_back(v);
+}
+
+inline void pngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+  pngPut32(out, (uint32_t)data.size());
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  pngPut32(out, pngCrc(&out[start], out.size() - start) ^ 0xFFFFFFFF);
+}
+
+// Length and distance codes of deflate (RFC 1951 3.2.5)
+constexpr uint16_t pngLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t pngLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t pngDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                      257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                      8193, 12289, 16385, 24577};
+constexpr uint8_t pngDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Deflate bits go out LSB first; Huffman codes MSB first
+struct PngBitWriter {
+  std::vector<uint8_t>& out;
+  uint32_t bits = 0;
+  int count = 0;
+
+  void put(uint32_t value, int n) {
+    bits |= value << count;
+    count += n;
+    while (count >= 8) { out.push_back(bits & 0xFF); bits >>= 8; count -= 8; }
+  }
+  void putCode(uint32_t code, int n) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < n; i++) reversed |= ((code >> i) & 1) << (n - 1 - i);
+    put(reversed, n);
+  }
+  void putSymbol(int sym) {  // Fixed literal/length table
+    if (sym < 144) putCode(0x30 + sym, 8);
+    else if (sym < 256) putCode(0x190 + sym - 144, 9);
+    else if (sym < 280) putCode(sym - 256, 7);
+    else putCode(0xC0 + sym - 280, 8);
+  }
+  void flush() { if (count > 0) out.push_back(bits & 0xFF); bits = 0; count = 0; }
+};
+
+// One final fixed-Huffman block; greedy matches from a hash chain
+inline void pngDeflate(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out) {
+  const int hashSize = 1 << 15, window = 32768, maxChain = 64;
+  std::vector<int32_t> head(hashSize, -1), prev(raw.size(), -1);
+  auto hashAt = [&](size_t i) { return ((raw[i] << 10) ^ (raw[i + 1] << 5) ^ raw[i + 2]) & (hashSize - 1); };
+  auto insert = [&](size_t i) {
+    if (i + 3 > raw.size()) return;
+    int h = hashAt(i);
+    prev[i] = head[h];
+    head[h] = (int32_t)i;
+  };
+
+  PngBitWriter w{out};
+  w.put(1, 1);  // BFINAL
+  w.put(1, 2);  // BTYPE 01: fixed Huffman
+  size_t pos = 0;
+  while (pos < raw.size()) {
+    int bestLen = 0, bestDist = 0;
+    if (pos + 3 <= raw.size()) {
+      int limit = (int)std::min<size_t>(258, raw.size() - pos);
+      int chain = maxChain;
+      for (int32_t c = head[hashAt(pos)]; c >= 0 && (int)(pos - c) <= window && chain-- > 0; c = prev[c]) {
+        int len = 0;
+        while (len < limit && raw[c + len] == raw[pos + len]) len++;
+        if (len > bestLen) { bestLen = len; bestDist = (int)(pos - c); }
+        if (len == limit) break;
+      }
+    }
+    if (bestLen < 3) {
+      w.putSymbol(raw[pos]);
+      insert(pos++);
+      continue;
+    }
+    int li = 28;
+    while (pngLengthBase[li] > bestLen) li--;
+    w.putSymbol(257 + li);
+    w.put(bestLen - pngLengthBase[li], pngLengthExtra[li]);
+    int di = 29;
+    while (pngDistBase[di] > bestDist) di--;
+    w.putCode(di, 5);
+    w.put(bestDist - pngDistBase[di], pngDistExtra[di]);
+    for (int i = 0; i < bestLen; i++) insert(pos++);
+  }
+  w.putSymbol(256);  // End of block
+  w.flush();
+}
+
+inline bool writePNG(const std::string& path, const RGBImage& img) {
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+  std::vector<uint8_t> ihdr;
+  pngPut32(ihdr, img.width);
+  pngPut32(ihdr, img.height);
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8-bit RGB, no interlace
+  pngChunk(png, "IHDR", ihdr);
+
+  // Scanlines with filter byte 0
+  std::vector<uint8_t> raw;
+  size_t stride = (size_t)img.width * 3;
+  for (int y = 0; y < img.height; y++) {
+    raw.push_back(0);
+    raw.insert(raw.end(), img.rgb.begin() + y * stride, img.rgb.begin() + (y + 1) * stride);
+  }
+
+  std::vector<uint8_t> z = {0x78, 0x01};
+  pngDeflate(raw, z);
+  uint32_t a = 1, b = 0;
+  for (uint8_t byte : raw) { a = (a + byte) % 65521; b = (b + a) % 65521; }
+  pngPut32(z, (b << 16) | a);
+  pngChunk(png, "IDAT", z);
+  pngChunk(png, "IEND", {});
+
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  fwrite(png.data(), 1, png.size(), f);
+  return fclose(f) == 0;
+}
+
+// Deflate bit reader (LSB first); reads past the end return zeros and set overrun
+struct PngBitReader {
+  const std::vector<uint8_t>& in;
+  size_t pos;
+  uint32_t bits = 0;
+  int count = 0;
+  bool overrun = false;
+
+  uint32_t get(int n) {
+    while (count < n) {
+      if (pos < in.size()) bits |= (uint32_t)in[pos++] << count;
+      else overrun = true;
+      count += 8;
+    }
+    uint32_t v = bits & ((1u << n) - 1);
+    bits >>= n;
+    count -= n;
+    return v;
+  }
+  int getSymbol() {  // Fixed literal/length table, code read MSB first
+    uint32_t code = 0;
+    for (int len = 1; len <= 9; len++) {
+      code = (code << 1) | get(1);
+      if (len == 7 && code <= 0x17) return 256 + code;
+      if (len == 8 && code >= 0x30 && code <= 0xBF) return code - 0x30;
+      if (len == 8 && code >= 0xC0 && code <= 0xC7) return 280 + code - 0xC0;
+      if (len == 9 && code >= 0x190) return 144 + code - 0x190;
+    }
+    return -1;
+  }
+};
+
+// zlib stream of stored and fixed-Huffman blocks (dynamic ones: false)
+inline bool pngInflate(const std::vector<uint8_t>& z, std::vector<uint8_t>& out) {
+  if (z.size() < 6 || (z[0] & 0x0F) != 8 || (z[1] & 0x20) || ((z[0] << 8) | z[1]) % 31 != 0) return false;
+  PngBitReader r{z, 2};
+  bool last = false;
+  while (!last) {
+    last = r.get(1);
+    uint32_t type = r.get(2);
+    if (type == 0) {
+      r.bits = 0;  // Stored: byte aligned
+      r.count = 0;
+      if (r.pos + 4 > z.size()) return false;
+      uint16_t len = z[r.pos] | (z[r.pos + 1] << 8);
+      uint16_t nlen = z[r.pos + 2] | (z[r.pos + 3] << 8);
+      r.pos += 4;
+      if ((uint16_t)~nlen != len || r.pos + len > z.size()) return false;
+      out.insert(out.end(), z.begin() + r.pos, z.begin() + r.pos + len);
+      r.pos += len;
+    } else if (type == 1) {
+      while (true) {
+        int sym = r.getSymbol();
+        if (sym < 0 || r.overrun) return false;
+        if (sym < 256) { out.push_back((uint8_t)sym); continue; }
+        if (sym == 256) break;
+        if (sym > 285) return false;
+        int len = pngLengthBase[sym - 257] + r.get(pngLengthExtra[sym - 257]);
+        uint32_t di = 0;
+        for (int i = 0; i < 5; i++) di = (di << 1) | r.get(1);
+        if (di > 29) return false;
+        size_t dist = pngDistBase[di] + r.get(pngDistExtra[di]);
+        if (dist > out.size()) return false;
+        for (int i = 0; i < len; i++) out.push_back(out[out.size() - dist]);
+      }
+    } else {
+      return false;
+    }
+  }
+  return !r.overrun;
+}
+
+// 8-bit RGB, non-interlaced, filter 0 scanlines (what writePNG() writes)
+inline bool readPNG(const std::string& path, RGBImage& img) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  std::vector<uint8_t> file;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) file.insert(file.end(), buf, buf + n);
+  fclose(f);
+
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (file.size() < 8 || !std::equal(signature, signature + 8, file.begin())) return false;
+  auto get32 = [&](size_t i) { return (uint32_t)file[i] << 24 | file[i + 1] << 16 | file[i + 2] << 8 | file[i + 3]; };
+
+  std::vector<uint8_t> z;
+  for (size_t pos = 8; pos + 12 <= file.size();) {
+    uint32_t len = get32(pos);
+    if (pos + 12 + len > file.size()) return false;
+    std::string type(file.begin() + pos + 4, file.begin() + pos + 8);
+    const uint8_t* data = &file[pos + 8];
+    if (type == "IHDR") {
+      if (len != 13 || data[8] != 8 || data[9] != 2 || data[12] != 0) return false;
+      img.width = (int)get32(pos + 8);
+      img.height = (int)get32(pos + 12);
+    } else if (type == "IDAT") {
+      z.insert(z.end(), data, data + len);
+    } else if (type == "IEND") {
+      break;
+    }
+    pos += 12 + len;
+  }
+
+  std::vector<uint8_t> raw;
+  size_t stride = (size_t)img.width * 3;
+  if (img.width <= 0 || img.height <= 0 || !pngInflate(z, raw) || raw.size() != (stride + 1) * img.height) return false;
+  img.rgb.clear();
+  for (int y = 0; y < img.height; y++) {
+    const uint8_t* line = &raw[y * (stride + 1)];
+    if (line[0] != 0) return false;
+    img.rgb.insert(img.rgb.end(), line + 1, line + 1 + stride);
+  }
+  return true;
+}
+
+#endif // HOST_IMAGE_IO_H
@@ -0,0 +1,252 @@
+/*
+ * Local Vail repeater: the vail.woozle.org chat protocol without the internet
+ *
+ * Shared by host/tools/vail_server (a real WebSocket server for the device)
+ * and the simulator ("ws repeater", on the virtual clock). A repeater is a
+ * named channel. Every message a member sends goes back out to all
+ * members, the sender included (the firmware drops its own echo by
+ * Timestamp), with Clients set to the member count. Joining or leaving
+ * sends everyone an empty-Duration message stamped with server time, which
+ * clients take as a clock sync. Messages stamped more than
+ * REPEATER_MAX_SKEW_MS from server time are dropped, as the real server does.
+ *
+ * Link settings apply to every frame sent to a member: a fixed delay plus
+ * uniform jitter (frames to one member stay in order, as on a TCP socket)
+ * and a loss probability (a frame the repeater never sends). Simulated
+ * members need no connection: listeners count toward Clients and the
+ * fan-out, senders key a fixed message every period. Random choices come
+ * from a seeded generator, so a run can be repeated.
+ */
+
+#ifndef HOST_LOCAL_REPEATER_H
+#define HOST_LOCAL_REPEATER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#define REPEATER_MAX_SKEW_MS   10000  // Messages stamped further from server time are dropped
+#define REPEATER_MAX_DURATIONS 256    // Longest Duration list accepted
+
+struct RepeaterLink {
+  uint32_t delayMs = 0;     // Every frame to a member
+  uint32_t jitterMs = 0;    // Plus 0..jitterMs, uniform
+  double loss = 0;          // Probability a frame is dropped (0..1)
+};
+
+struct RepeaterStats {
+  uint64_t received = 0;    // Messages from members (simulated senders included)
+  uint64_t rejected = 0;    // Unparseable, or stamped too far from server time
+  uint64_t delivered = 0;   // Frames handed to connected members
+  uint64_t lost = 0;        // Frames dropped by the link loss
+  uint64_t simulated = 0;   // Frames to simulated listeners (counted only)
+  size_t peakInFlight = 0;  // Most frames waiting out their delay at once
+};
+
+// Decoded chat message (Duration empty for a clock sync)
+struct RepeaterMessage {
+  int64_t timestamp = 0;
+  std::vector<uint16_t> durations;
+};
+
+// {"Timestamp":...,"Duration":[...]} -> message; false if either is missing
+inline bool parseRepeaterMessage(const std::string& text, RepeaterMessage& msg) {
+  size_t at = text.find("\"Timestamp\":");
+  if (at == std::string::npos) return false;
+  const char* start = text.c_str() + at + 12;
+  char* end;
+  msg.timestamp = strtoll(start, &end, 10);
+  if (end == start) return false;
+
+  at = text.find("\"Duration\":");
+  if (at == std::string::npos) return false;
+  at = text.find('[', at);
+  if (at == std::string::npos) return false;
+  msg.durations.clear();
+  const char* p = text.c_str() + at + 1;
+  while (*p == ' ') p++;
+  while (*p != ']') {
+    long value = strtol(p, &end, 10);
+    if (end == p || value < 0 || value > 65535 || msg.durations.size() >= REPEATER_MAX_DURATIONS) return false;
+    msg.durations.push_back((uint16_t)value);
+    p = end;
+    while (*p == ' ') p++;
+    if (*p == ',') p++;
+    else if (*p != ']') return false;
+    while (*p == ' ') p++;
+  }
+  return true;
+}
+
+inline std::string buildRepeaterMessage(int64_t timestamp, size_t clients, const std::vector<uint16_t>& durations) {
+  std::string text = "{\"Timestamp\":" + std::to_string(timestamp) + ",\"Clients\":" + std::to_string(clients) +
+                     ",\"Duration\":[";
+  for (size_t i = 0; i < durations.size(); i++) {
+    if (i) text += ',';
+    text += std::to_string(durations[i]);
+  }
+  return text + "]}";
+}
+
+// "60,60,180" -> durations; false if malformed
+inline bool parseDurationList(const std::string& text, std::vector<uint16_t>& durations) {
+  RepeaterMessage msg;
+  if (!parseRepeaterMessage("{\"Timestamp\":0,\"Duration\":[" + text + "]}", msg) || msg.durations.empty()) {
+    return false;
+  }
+  durations = msg.durations;
+  return true;
+}
+
+class LocalRepeater {
+public:
+  typedef std::function<void(int member, const std::string& frame)> Deliver;
+
+  RepeaterLink link;
+  RepeaterStats stats;
+
+  // epochMs: server time at micros 0 (all times are one caller clock)
+  LocalRepeater(int64_t epochMs, uint32_t seed) : epochMs(epochMs), random(seed) {}
+
+  int64_t serverMillis(uint64_t nowMicros) const { return epochMs + (int64_t)(nowMicros / 1000); }
+
+  // A member joins; everyone gets the new Clients count. Returns its id.
+  int join(const std::string& channel, uint64_t nowMicros, bool simulated = false) {
+    int id = (int)members.size();
+    members.push_back({channel, simulated, true, 0});
+    broadcast(channel, serverMillis(nowMicros), {}, nowMicros);
+    return id;
+  }
+
+  void leave(int member, uint64_t nowMicros) {
+    if (!valid(member)) return;
+    members[member].joined = false;
+    broadcast(members[member].channel, serverMillis(nowMicros), {}, nowMicros);
+  }
+
+  // A frame from a member: rebroadcast, or count it as rejected
+  void receive(int member, const std::string& text, uint64_t nowMicros) {
+    RepeaterMessage msg;
+    if (!valid(member) || !parseRepeaterMessage(text, msg) || msg.durations.empty()) {
+      stats.rejected++;
+      return;
+    }
+    send(member, msg.timestamp, msg.durations, nowMicros);
+  }
+
+  // A message from a member (connected or simulated) stamped at timestamp
+  void send(int member, int64_t timestamp, const std::vector<uint16_t>& durations, uint64_t nowMicros) {
+    if (!valid(member)) return;
+    stats.received++;
+    if (llabs(timestamp - serverMillis(nowMicros)) > REPEATER_MAX_SKEW_MS) {
+      stats.rejected++;
+      return;
+    }
+    broadcast(members[member].channel, timestamp, durations, nowMicros);
+  }
+
+  // A simulated member keying durations every periodMs, first at firstMicros
+  int addSender(const std::string& channel, uint32_t periodMs, const std::vector<uint16_t>& durations,
+                uint64_t firstMicros, uint64_t nowMicros) {
+    int id = join(channel, nowMicros, true);
+    senders.push_back({id, (uint64_t)periodMs * 1000, firstMicros, durations});
+    return id;
+  }
+
+  // Run senders and hand over frames due by nowMicros
+  void poll(uint64_t nowMicros, const Deliver& deliver) {
+    for (Sender& s : senders) {
+      while (s.nextMicros <= nowMicros && members[s.member].joined) {
+        send(s.member, serverMillis(s.nextMicros), s.durations, s.nextMicros);
+        s.nextMicros += s.periodMicros;
+      }
+    }
+    while (!inFlight.empty() && inFlight.top().due <= nowMicros) {
+      Frame frame = inFlight.top();
+      inFlight.pop();
+      if (valid(frame.member)) {
+        stats.delivered++;
+        deliver(frame.member, frame.text);
+      }
+    }
+  }
+
+  // When poll() next has something to do (UINT64_MAX: nothing scheduled)
+  uint64_t nextDue() const {
+    uint64_t next = inFlight.empty() ? UINT64_MAX : inFlight.top().due;
+    for (const Sender& s : senders) {
+      if (members[s.member].joined && s.nextMicros < next) next = s.nextMicros;
+    }
+    return next;
+  }
+
+  size_t clients(const std::string& channel) const {
+    size_t n = 0;
+    for (const Member& m : members) n += (m.joined && m.channel == channel);
+    return n;
+  }
+
+  size_t framesInFlight() const { return inFlight.size(); }
+
+private:
+  struct Member {
+    std::string channel;
+    bool simulated;
+    bool joined;
+    uint64_t lastDue;  // Frames to one member leave in order
+  };
+  struct Sender {
+    int member;
+    uint64_t periodMicros;
+    uint64_t nextMicros;
+    std::vector<uint16_t> durations;
+  };
+  struct Frame {
+    uint64_t due;
+    uint64_t sequence;
+    int member;
+    std::string text;
+    bool operator<(const Frame& other) const {  // Earliest first out of the priority queue
+      return due != other.due ? due > other.due : sequence > other.sequence;
+    }
+  };
+
+  int64_t epochMs;
+  std::mt19937 random;
+  std::vector<Member> members;
+  std::vector<Sender> senders;
+  std::priority_queue<Frame> inFlight;
+  uint64_t sequence = 0;
+
+  bool valid(int member) const { return member >= 0 && member < (int)members.size() && members[member].joined; }
+
+  void broadcast(const std::string& channel, int64_t timestamp, const std::vector<uint16_t>& durations,
+                 uint64_t nowMicros) {
+    std::string text = buildRepeaterMessage(timestamp, clients(channel), durations);
+    for (size_t id = 0; id < members.size(); id++) {
+      Member& m = members[id];
+      if (!m.joined || m.channel != channel) continue;
+      if (m.simulated) {
+        stats.simulated++;
+        continue;
+      }
+      if (link.loss > 0 && std::uniform_real_distribution<double>(0, 1)(random) < link.loss) {
+        stats.lost++;
+        continue;
+      }
+      uint64_t delay = (uint64_t)link.delayMs * 1000;
+      if (link.jitterMs) delay += std::uniform_int_distribution<uint32_t>(0, link.jitterMs * 1000)(random);
+      uint64_t due = std::max(nowMicros + delay, m.lastDue);
+      m.lastDue = due;
+      inFlight.push({due, sequence++, (int)id, text});
+    }
+    if (inFlight.size() > stats.peakInFlight) stats.peakInFlight = inFlight.size();
+  }
+};
+
+#endif // HOST_LOCAL_REPEATER_H
@@ -0,0 +1,333 @@
+/*
+ * Render every firmware screen into the emulated ST7789 and report its cost
+ *
+ *   render_screens [--out DIR] [--compare GOLDEN_DIR] [--only NAME]
+ *
+ * Each screen is put into a known state with the firmware's own functions,
+ * drawn, and written as DIR/<name>.png and DIR/<name>.ppm. With --compare,
+ * each frame is checked against GOLDEN_DIR/<name>.png; mismatches write a
+ * DIR/<name>.diff.ppm and make the tool exit with status 1.
+ *
+ * Cost is the estimated SPI traffic (pixels, transactions, address windows,
+ * bytes, bus time) plus the host CPU time of the draw call.
+ */
+
+#include "morse_trainer_menu.cpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <sys/stat.h>
+
+#include "image_io.h"
+
+struct Screen {
+  const char* name;
+  std::function<void()> prepare;  // Bring the firmware into the screen's state
+  std::function<void()> draw;     // The measured draw
+};
+
+struct ScreenResult {
+  const char* name;
+  uint64_t pixels, transactions, windows, bytes;
+  double busMicros, cpuMicros;
+  long mismatched;  // -1 = not compared
+};
+
+// Host environment the screens are rendered in
+static void setupHost() {
+  WiFi.hostNetworks = {
+    {"VailNet", -48, WIFI_AUTH_WPA2_PSK, 6},
+    {"Shack", -61, WIFI_AUTH_WPA2_PSK, 11},
+    {"CoffeeShop", -70, WIFI_AUTH_OPEN, 1},
+    {"W1AW-Guest", -82, WIFI_AUTH_WPA_WPA2_PSK, 11},
+  };
+  WiFi.hostJoinable = true;
+  randomSeed(1);
+}
+
+// Associate and get an IP (begin() completes on the virtual clock)
+static void joinWiFi() {
+  WiFi.begin("VailNet", "hunter2");
+  hostAdvanceMicros(WiFi.hostAssocMicros + WiFi.hostDhcpMicros);
+}
+
+// Run the channel-by-channel scan to the end
+static void finishWiFiScan() {
+  while (wifiScanActive) {
+    hostAdvanceMicros(hostNextDeadline() - hostNowMicros);
+    updateWiFiSettings(tft);
+  }
+}
+
+static void enterMode(MenuMode mode, int selection = 0) {
+  currentMode = mode;
+  currentSelection = selection;
+  invalidateMenuCards();
+}
+
+static std::vector<Screen> buildScreens() {
+  std::vector<Screen> screens;
+
+  screens.push_back({"main_menu", [] { enterMode(MODE_MAIN_MENU); }, [] { drawMenu(); }});
+  screens.push_back({"main_menu_scroll",
+    [] { enterMode(MODE_MAIN_MENU); drawMenu(); },
+    [] { currentSelection = 1; drawMenu(); }});
+  screens.push_back({"training_menu", [] { enterMode(MODE_TRAINING_MENU); }, [] { drawMenu(); }});
+  screens.push_back({"settings_menu", [] { enterMode(MODE_SETTINGS_MENU); }, [] { drawMenu(); }});
+  screens.push_back({"menu_to_menu",
+    [] { enterMode(MODE_MAIN_MENU); drawMenu(); currentMode = MODE_SETTINGS_MENU; },
+    [] { drawMenu(); }});
+
+  screens.push_back({"hear_it_type_it",
+    [] {
+      enterMode(MODE_HEAR_IT_TYPE_IT);
+      randomSeed(7);
+      startNewCallsign();
+      userInput = "W1A";
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"practice",
+    [] { enterMode(MODE_PRACTICE); startPracticeMode(tft); },
+    [] { drawMenu(); }});
+
+  screens.push_back({"wifi_networks",
+    [] { enterMode(MODE_WIFI_SETTINGS); startWiFiSettings(tft); finishWiFiScan(); selectedNetwork = 1; },
+    [] { drawMenu(); }});
+  screens.push_back({"wifi_password",
+    [] {
+      enterMode(MODE_WIFI_SETTINGS);
+      startWiFiSettings(tft);
+      finishWiFiScan();
+      wifiState = WIFI_STATE_PASSWORD_INPUT;
+      passwordInput = "hunter2";
+    },
+    [] { drawMenu(); }});
+  screens.push_back({"wifi_connecting",
+    [] {
+      enterMode(MODE_WIFI_SETTINGS);
+      startWiFiSettings(tft);
+      finishWiFiScan();
+      wifiState = WIFI_STATE_CONNECTING;
+      startWiFiConnection("VailNet", "hunter2", false);
+      hostAdvanceMicros(WiFi.hostAssocMicros + 100000);
+      updateWiFiConnection();
+    },
+    [] { drawMenu(); }});
+  screens.push_back({"wifi_connected",
+    [] {
+      enterMode(MODE_WIFI_SETTINGS);
+      joinWiFi();
+      wifiState = WIFI_STATE_CONNECTED;
+      statusMessage = "Connected!";
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"cw_settings",
+    [] { enterMode(MODE_CW_SETTINGS); startCWSettings(tft); },
+    [] { drawMenu(); }});
+  screens.push_back({"volume",
+    [] { enterMode(MODE_VOLUME_SETTINGS); initVolumeSettings(tft); },
+    [] { drawMenu(); }});
+
+  screens.push_back({"power_diagnostics",
+    [] {
+      enterMode(MODE_POWER_DIAGNOSTICS);
+      applyPowerProfile(POWER_PROFILE_MENU);
+      powerProfileStats[POWER_PROFILE_MENU] = {36, 36 * 41.0f};
+      powerProfileStats[POWER_PROFILE_PRACTICE] = {120, 120 * 58.5f};
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"energy_report",
+    [] {
+      enterMode(MODE_ENERGY_REPORT);
+      energyLoaded = true;
+      energyStates[0] = {MODE_MAIN_MENU, ENERGY_WIFI_CONNECTED, 0, 1, 1203, 0, 229, 229 * 42.0f, 1203, 3.95f, 0.024f};
+      energyStates[1] = {MODE_PRACTICE, ENERGY_WIFI_OFF, 1, 1, 900, 210, 168, 168 * 70.0f, 900, 4.95f, 0.011f};
+      energyStates[2] = {MODE_VAIL_REPEATER, ENERGY_WIFI_CONNECTED, 1, 1, 420, 35, 0, 0, 420, 3.1f, 0.015f};
+      energyStates[3] = {MODE_SETTINGS_MENU, ENERGY_WIFI_ON, 0, 1, 60, 0, 0, 0, 0, 0, 0};
+      energySlot = 1;
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"latency_report",
+    [] {
+      enterMode(MODE_LATENCY_REPORT);
+      for (uint32_t i = 0; i < 40; i++) {
+        latencyRecord(LATENCY_PADDLE_KEYER, 300 + i * 17);
+        latencyRecord(LATENCY_PADDLE_AUDIO, 1400 + i * 90);
+        latencyRecord(LATENCY_WIRE_SPEAKER, 512000 + i * 600);
+        latencyRecord(LATENCY_PLAYOUT_LATE, 1000 + (i % 9) * 1000);
+      }
+      latencyRecord(LATENCY_PADDLE_AUDIO, 11800);
+      latencyRecord(LATENCY_PADDLE_WIRE, 61200);
+      latencyRecord(LATENCY_PADDLE_WIRE, 182400);
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"runtime_diagnostics",
+    [] {
+      enterMode(MODE_RUNTIME_DIAGNOSTICS);
+      runtimeSample();  // Host heap figures, then staged per-subsystem ones
+      const float cpu[SUBSYSTEM_COUNT] = {6.4f, 11.2f, 3.1f, 1.8f, 4.5f};
+      const int32_t held[SUBSYSTEM_COUNT] = {0, 5312, -96, 48, 0};
+      const uint32_t stack[SUBSYSTEM_COUNT] = {RUNTIME_NO_STACK, 2640, 1180, 5204, 412};
+      for (int i = 0; i < SUBSYSTEM_COUNT; i++) {
+        runtimeSampleData.subsystems[i].cpuPercent = cpu[i];
+        runtimeSampleData.subsystems[i].heldBytes = held[i];
+        runtimeSampleData.subsystems[i].stackFree = stack[i];
+      }
+      runtimeSampleData.heapLargest = 69632;  // Fragmented
+      runtimeSampleData.fragmentation = 64;
+      for (uint32_t i = 0; i < 200; i++) latencyRecord(runtimeLoopHistogram, 180 + (i % 13) * 40);
+      latencyRecord(runtimeLoopHistogram, 38400);
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"vail_repeater",
+    [] {
+      joinWiFi();
+      enterMode(MODE_VAIL_REPEATER);
+      startVailRepeater(tft);
+      vailState = VAIL_CONNECTED;
+      connectedClients = 3;
+    },
+    [] { drawMenu(); }});
+
+  screens.push_back({"vail_link",
+    [] {
+      vailState = VAIL_CONNECTED;
+      vailLinkView = true;
+      vailProbing = true;
+      vailLinkConnected();
+      int64_t timestamp = 1700000000000LL;
+      for (int i = 0; i < 40; i++) {
+        vailLinkSent(++timestamp, true);
+        if (i % 20 == 7) continue;  // Lost
+        hostAdvanceMicros((70 + (i * 37) % 50) * 1000);
+        vailLinkEcho(timestamp);
+      }
+      hostAdvanceMicros((VAIL_PROBE_TIMEOUT_MS + 1) * 1000ULL);
+      updateVailLink();  // The unanswered ones expire
+      for (int i = 0; i < 12; i++) vailLinkAge(90 + (i * 53) % 140);
+      playbackDelay = vailTunePlayout(playbackDelay, false);
+    },
+    [] { drawMenu(); }});
+
+  return screens;
+}
+
+// Count differing pixels and write a diff image (changed pixels in red)
+static long compareImages(const RGBImage& actual, const RGBImage& golden, const std::string& diffPath) {
+  if (actual.width != golden.width || actual.height != golden.height) return (long)actual.width * actual.height;
+
+  RGBImage diff = actual;
+  long mismatched = 0;
+  for (size_t i = 0; i < (size_t)actual.width * actual.height; i++) {
+    bool same = memcmp(&actual.rgb[i * 3], &golden.rgb[i * 3], 3) == 0;
+    if (same) {
+      // Dimmed context
+      for (int c = 0; c < 3; c++) diff.rgb[i * 3 + c] = actual.rgb[i * 3 + c] / 4;
+    } else {
+      mismatched++;
+      diff.rgb[i * 3 + 0] = 255;
+      diff.rgb[i * 3 + 1] = 0;
+      diff.rgb[i * 3 + 2] = 0;
+    }
+  }
+  if (mismatched) writePPM(diffPath, diff);
+  return mismatched;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: render_screens [--out DIR] [--compare GOLDEN_DIR] [--only NAME]\n");
+}
+
+int main(int argc, char** argv) {
+  std::string outDir = "screens";
+  std::string goldenDir;
+  std::string only;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) outDir = argv[++i];
+    else if (arg == "--compare" && i + 1 < argc) goldenDir = argv[++i];
+    else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+    else { usage(); return 2; }
+  }
+  mkdir(outDir.c_str(), 0755);
+
+  // Boot the firmware once (virtual time, so the boot delays cost nothing)
+  setupHost();
+  setup();
+
+  std::vector<ScreenResult> results;
+  bool failed = false;
+
+  for (Screen& screen : buildScreens()) {
+    if (!only.empty() && only != screen.name) continue;
+
+    screen.prepare();
+
+    HostDisplayBus before = hostDisplayBus;
+    auto start = std::chrono::steady_clock::now();
+    screen.draw();
+    auto end = std::chrono::steady_clock::now();
+
+    ScreenResult r;
+    r.name = screen.name;
+    r.pixels = hostDisplayBus.pixels - before.pixels;
+    r.transactions = hostDisplayBus.transactions - before.transactions;
+    r.windows = hostDisplayBus.windows - before.windows;
+    r.bytes = hostDisplayBus.bytes - before.bytes;
+    r.busMicros = hostDisplayBus.busMicros - before.busMicros;
+    r.cpuMicros = std::chrono::duration<double, std::micro>(end - start).count();
+    r.mismatched = -1;
+
+    RGBImage img = imageFromRGB565(tft.hostFramebuffer(), tft.width(), tft.height());
+    std::string base = outDir + "/" + screen.name;
+    writePNG(base + ".png", img);
+    writePPM(base + ".ppm", img);
+
+    if (!goldenDir.empty()) {
+      RGBImage golden;
+      if (!readPNG(goldenDir + "/" + screen.name + ".png", golden)) {
+        fprintf(stderr, "%s: no golden image in %s\n", screen.name, goldenDir.c_str());
+        failed = true;
+      } else {
+        r.mismatched = compareImages(img, golden, base + ".diff.ppm");
+        if (r.mismatched) failed = true;
+      }
+    }
+    results.push_back(r);
+  }
+
+  // Per-screen cost (CSV)
+  printf("screen,pixels,transactions,windows,bytes,bus_us,cpu_us,mismatched\n");
+  for (const ScreenResult& r : results) {
+    printf("%s,%llu,%llu,%llu,%llu,%.0f,%.0f,%ld\n", r.name,
+           (unsigned long long)r.pixels, (unsigned long long)r.transactions,
+           (unsigned long long)r.windows, (unsigned long long)r.bytes,
+           r.busMicros, r.cpuMicros, r.mismatched);
+  }
+
+  // Per-API cost over all screens (CSV)
+  printf("\napi,calls,pixels,transactions,bytes,bytes_per_call\n");
+  for (int i = 0; i < hostGfxApiCount; i++) {
+    const HostGfxApiStats& s = hostGfxApiStats[i];
+    if (s.calls == 0) continue;
+    printf("%s,%u,%llu,%llu,%llu,%llu\n", s.name, s.calls,
+           (unsigned long long)s.pixels, (unsigned long long)s.transactions,
+           (unsigned long long)s.bytes, (unsigned long long)(s.bytes / s.calls));
+  }
+
+  // Firmware's own per-routine stats (display_stats.h)
+  printf("\n");
+  fflush(stdout);
+  Serial.echo = true;
+  printDisplayStats();
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Run the unmodified firmware (setup() then loop()) on the virtual clock
+ *
+ *   run_firmware [--seconds N] [--keys TEXT] [--keys-at MS] [--serial CMD]...
+ *                [--wav FILE] [--screenshot FILE] [--quiet]
+ *
+ * --keys types TEXT on the emulated CardKB, one key every KEY_INTERVAL_MS
+ * starting at --keys-at (default 2000 ms after boot); {up} {down} {left}
+ * {right} {enter} {esc} {tab} {bs} name the special keys. Each --serial
+ * line is fed to the serial console after setup(). --wav writes everything
+ * the I2S DAC played, --screenshot the final frame. Serial output goes to
+ * stdout unless --quiet.
+ *
+ * Virtual time runs as fast as the host allows, so a run doubles as a
+ * workload for perf (build with -DHOST_PERF=ON):
+ *   perf record -g ./run_firmware --seconds 600 --keys "{down}{enter}" --quiet
+ */
+
+#include "morse_trainer_menu.cpp"
+
+#include <chrono>
+#include <string>
+
+#include "image_io.h"
+
+#define KEY_INTERVAL_MS 300
+
+static void usage() {
+  fprintf(stderr, "usage: run_firmware [--seconds N] [--keys TEXT] [--keys-at MS] [--serial CMD]...\n"
+                  "                    [--wav FILE] [--screenshot FILE] [--quiet]\n");
+}
+
+// Expand {name} tokens into CardKB codes (-1 on an unknown name)
+static int parseKeys(const std::string& text, std::vector<uint8_t>& keys) {
+  static const struct { const char* name; uint8_t code; } names[] = {
+    {"up", KEY_UP}, {"down", KEY_DOWN}, {"left", KEY_LEFT}, {"right", KEY_RIGHT},
+    {"enter", KEY_ENTER}, {"esc", KEY_ESC}, {"tab", KEY_TAB}, {"bs", KEY_BACKSPACE},
+  };
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '{') { keys.push_back((uint8_t)text[i]); continue; }
+    size_t end = text.find('}', i);
+    if (end == std::string::npos) return -1;
+    std::string name = text.substr(i + 1, end - i - 1);
+    bool found = false;
+    for (const auto& n : names) {
+      if (name == n.name) { keys.push_back(n.code); found = true; break; }
+    }
+    if (!found) return -1;
+    i = end;
+  }
+  return 0;
+}
+
+// Deadline callback: the key reaches the CardKB's buffer
+static void pressKey(void* arg) {
+  Wire.keyQueue.push_back((uint8_t)(uintptr_t)arg);
+}
+
+int main(int argc, char** argv) {
+  double seconds = 10;
+  std::string keyText;
+  uint32_t keysAtMs = 2000;
+  std::vector<std::string> serialLines;
+  std::string wavPath, screenshotPath;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (arg == "--keys" && i + 1 < argc) keyText = argv[++i];
+    else if (arg == "--keys-at" && i + 1 < argc) keysAtMs = (uint32_t)atol(argv[++i]);
+    else if (arg == "--serial" && i + 1 < argc) serialLines.push_back(argv[++i]);
+    else if (arg == "--wav" && i + 1 < argc) wavPath = argv[++i];
+    else if (arg == "--screenshot" && i + 1 < argc) screenshotPath = argv[++i];
+    else if (arg == "--quiet") quiet = true;
+    else { usage(); return 2; }
+  }
+
+  std::vector<uint8_t> keys;
+  if (parseKeys(keyText, keys) != 0) {
+    fprintf(stderr, "run_firmware: bad key name in \"%s\"\n", keyText.c_str());
+    return 2;
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    hostSchedule((uint64_t)(keysAtMs + i * KEY_INTERVAL_MS) * 1000, pressKey, (void*)(uintptr_t)keys[i]);
+  }
+
+  Serial.echo = !quiet;
+  hostI2S.capture = !wavPath.empty();
+
+  auto start = std::chrono::steady_clock::now();
+  setup();
+  for (const std::string& line : serialLines) Serial.input += line + "\n";
+
+  uint64_t endMicros = (uint64_t)(seconds * 1e6);
+  uint64_t passes = 0;
+  while (hostNowMicros < endMicros && !hostDeepSleepRequested) {
+    loop();
+    passes++;
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fflush(stdout);
+
+  int status = 0;
+  if (!wavPath.empty() && !hostI2SWriteWav(wavPath.c_str())) {
+    fprintf(stderr, "run_firmware: cannot write %s\n", wavPath.c_str());
+    status = 1;
+  }
+  if (!screenshotPath.empty() &&
+      !writePNG(screenshotPath, imageFromRGB565(tft.hostFramebuffer(), tft.width(), tft.height()))) {
+    fprintf(stderr, "run_firmware: cannot write %s\n", screenshotPath.c_str());
+    status = 1;
+  }
+
+  fprintf(stderr, "Ran %.1f s of firmware time in %.3f s (%.0fx), %llu loop passes, %llu audio frames%s\n",
+          hostNowMicros / 1e6, wall, wall > 0 ? hostNowMicros / 1e6 / wall : 0.0,
+          (unsigned long long)passes, (unsigned long long)hostI2S.framesWritten,
+          hostDeepSleepRequested ? ", stopped at deep sleep" : "");
+  return status;
+}
@@ -0,0 +1,733 @@
+/*
+ * Deterministic simulator: drive the firmware from a timed script
+ *
+ *   simulate SCRIPT [--record DIR] [--fs DIR] [--seconds N] [--verbose]
+ *
+ * setup()/loop() run on the virtual clock; script actions fire at exact
+ * virtual times (deadlines on the same clock as the firmware's timers), so
+ * a run is the same every time and hours of keying take seconds. Every
+ * audio tone, display call and outgoing WebSocket frame is recorded with
+ * its time and checked against the script's expectations. Exit status is
+ * 1 when an expectation fails.
+ *
+ * --fs DIR preloads the LittleFS shim with DIR's files (DIR/vail/0001.vcap
+ * becomes /vail/0001.vcap); --record writes the files the run left on
+ * LittleFS to DIR/littlefs.
+ *
+ * Script lines, times in ms (" #" starts a comment):
+ *   @T [every P xN] key TEXT               CardKB keys ({enter}, {esc}, ... as in run_firmware)
+ *   @T [every P xN] paddle dit|dah down|up
+ *   @T [every P xN] ws vail D1,D2,... [age MS] [clients N]
+ *                                          Vail message stamped server time - age
+ *   @T ws sync | ws connected | ws disconnected | ws text JSON
+ *   @T ws repeater [delay MS] [jitter MS] [loss PCT] [listeners N] [seed N]
+ *                                          Serve the socket from a local repeater
+ *                                          (local_repeater.h) from here on: it connects
+ *                                          a round trip after begin(), echoes sends, and
+ *                                          "ws vail" goes through it with the link settings
+ *   @T ws sender PERIOD D1,D2,...          Repeater member keying every PERIOD ms
+ *   @T wifi join SSID [PASS] | wifi drop
+ *   @T serial LINE
+ *   @T end                                 Stop the run here
+ *
+ * Expectations look at what was recorded between A and B (the whole run
+ * without a range); COUNT is N or MIN-MAX:
+ *   @A[-B] expect tones COUNT              Tone segments played
+ *   @A[-B] expect tone-ms MIN MAX          Every tone's length
+ *   @A[-B] expect gap-ms MIN MAX           Every silence between tones
+ *   @A[-B] expect sent COUNT               Outgoing WebSocket frames
+ *   @A[-B] expect sent-contains TEXT
+ *   @A[-B] expect playout-late-ms MAX      Vail messages: first tone vs Timestamp + playout delay
+ *   @A[-B] expect rx-queue MAX             Vail messages waiting to play, at most
+ *   @A[-B] expect ui-ms MAX                Keys: press to the first display call
+ *   @A[-B] expect serial-contains TEXT
+ *   @T expect mode NAME                    Screen shown at T (menuModeName)
+ */
+
+#include "morse_trainer_menu.cpp"
+#include "local_repeater.h"
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+#define SIM_SERVER_EPOCH_MS 1700000000000LL  // Repeater clock at boot
+#define SIM_TONE_GAP_US     1000             // Shorter silences belong to the tone
+#define SIM_KEY_INTERVAL_MS 150              // Between keys of one "key" action
+#define SIM_PLAYOUT_LIMIT_MS 10000           // A message not heard by then is missing
+
+struct Action {
+  int line;
+  uint64_t atMicros;
+  uint64_t everyMicros;
+  uint32_t count;
+  std::string verb;   // key, paddle, ws, wifi, serial, mode-check
+  std::string args;
+};
+
+struct Expect {
+  int line;
+  uint64_t fromMicros, toMicros;
+  std::string kind;
+  std::string args;
+};
+
+struct ActionRun {
+  const Action* action;
+  uint32_t done;
+};
+
+struct ToneSegment { uint64_t start, end; };
+struct TimedText { uint64_t t; std::string text; };
+struct TimedName { uint64_t t; const char* name; };
+struct PlayoutRecord { uint64_t injected; uint64_t due; };
+struct TimedCount { uint64_t t; size_t n; };
+
+// Recordings
+static std::vector<ToneSegment> tones;
+static std::vector<TimedName> displayCalls;
+static std::vector<TimedText> sentFrames;
+static std::vector<TimedText> inputs;
+static std::vector<uint64_t> keyTimes;
+static std::vector<PlayoutRecord> playouts;
+static std::vector<TimedText> modeChecks;
+static std::vector<TimedCount> rxQueueSizes;
+static std::deque<ActionRun> actionRuns;
+static bool stopRequested = false;
+static bool recordSerial = false;
+
+// Local repeater ("ws repeater"), on the same clock as the firmware
+static LocalRepeater* repeater = nullptr;
+static int deviceMember = -1;   // The firmware's socket once connected
+static int scriptMember = -1;   // Sends "ws vail" messages
+static uintptr_t pumpGeneration = 0;
+static uint64_t pumpAt = UINT64_MAX;
+
+static int64_t serverMillis() { return SIM_SERVER_EPOCH_MS + (int64_t)(hostNowMicros / 1000); }
+
+// ============================================
+// Recording hooks
+// ============================================
+
+// Every frame sent to the DAC; non-silent runs become tone segments
+static void onAudio(const int16_t* stereo, size_t frames, uint64_t startMicros) {
+  for (size_t i = 0; i < frames; i++) {
+    if (stereo[i * 2] == 0 && stereo[i * 2 + 1] == 0) continue;
+    uint64_t t = startMicros + (uint64_t)i * 1000000 / hostI2S.sampleRate;
+    uint64_t end = t + 1000000 / hostI2S.sampleRate;
+    if (!tones.empty() && t <= tones.back().end + SIM_TONE_GAP_US) {
+      tones.back().end = end;
+    } else {
+      tones.push_back({t, end});
+    }
+  }
+}
+
+// Queued frames were dropped (i2s_stop / i2s_zero_dma_buffer): they never play
+static void onAudioDropped(uint64_t fromMicros) {
+  while (!tones.empty() && tones.back().start >= fromMicros) tones.pop_back();
+  if (!tones.empty() && tones.back().end > fromMicros) tones.back().end = fromMicros;
+}
+
+static void onDisplayCall(const char* name) { displayCalls.push_back({hostNowMicros, name}); }
+
+// ============================================
+// Local repeater
+// ============================================
+
+static void scheduleRepeater();
+
+/*
+ * Hand a frame to the firmware. A message it queued (not an echo, marker
+ * or clock sync) is due when the firmware's clock (millis() + clockSkew)
+ * reaches the playAt it was queued with.
+ */
+static void deliverVail(const String& frame) {
+  size_t queued = rxQueue.size();
+  webSocket.hostDeliver(WStype_TEXT, frame);
+  if (rxQueue.size() > queued) {
+    int64_t dueMs = rxQueue.back().playAt - clockSkew;
+    playouts.push_back({hostNowMicros, dueMs > 0 ? (uint64_t)dueMs * 1000 : 0});
+  }
+  rxQueueSizes.push_back({hostNowMicros, rxQueue.size()});
+}
+
+// A frame the repeater sends; only the firmware's socket is real
+static void repeaterDeliver(int member, const std::string& frame) {
+  if (member != deviceMember) return;
+  deliverVail(String(frame.c_str()));
+}
+
+// Deadline callback; a later schedule with an earlier time makes older ones stale
+static void pumpRepeater(void* arg) {
+  if ((uintptr_t)arg != pumpGeneration) return;
+  pumpAt = UINT64_MAX;
+  repeater->poll(hostNowMicros, repeaterDeliver);
+  scheduleRepeater();
+}
+
+static void scheduleRepeater() {
+  uint64_t next = repeater->nextDue();
+  if (next >= pumpAt) return;
+  pumpAt = std::max(next, hostNowMicros);
+  hostSchedule(pumpAt, pumpRepeater, (void*)++pumpGeneration);
+}
+
+static void repeaterConnect(void*) {
+  if (!webSocket.hostBegun || deviceMember >= 0) return;
+  std::string path = webSocket.hostPath.c_str();
+  size_t at = path.find("repeater=");
+  webSocket.hostDeliver(WStype_CONNECTED, webSocket.hostPath);
+  deviceMember = repeater->join(at == std::string::npos ? "General" : path.substr(at + 9), hostNowMicros);
+  scheduleRepeater();
+}
+
+// Socket hooks: the handshake takes a round trip
+static void onWebSocketBegin() {
+  if (repeater) hostSchedule(hostNowMicros + (uint64_t)repeater->link.delayMs * 2000, repeaterConnect, nullptr);
+}
+
+static void onWebSocketDisconnect() {
+  if (!repeater || deviceMember < 0) return;
+  repeater->leave(deviceMember, hostNowMicros);
+  deviceMember = -1;
+  scheduleRepeater();
+}
+
+static void onWebSocketSend(const String& payload) {
+  sentFrames.push_back({hostNowMicros, payload.c_str()});
+  if (repeater && deviceMember >= 0) {
+    repeater->receive(deviceMember, payload.c_str(), hostNowMicros);
+    scheduleRepeater();
+  }
+}
+
+// "ws repeater ...": members join the channel the firmware uses (vailChannel)
+static void startRepeater(const std::string& args) {
+  std::istringstream in(args);
+  std::string word;
+  RepeaterLink link;
+  int listeners = 0;
+  uint32_t seed = 1;
+  while (in >> word) {
+    double value = 0;
+    in >> value;
+    if (word == "delay") link.delayMs = (uint32_t)value;
+    else if (word == "jitter") link.jitterMs = (uint32_t)value;
+    else if (word == "loss") link.loss = value / 100.0;
+    else if (word == "listeners") listeners = (int)value;
+    else if (word == "seed") seed = (uint32_t)value;
+  }
+  delete repeater;
+  repeater = new LocalRepeater(SIM_SERVER_EPOCH_MS, seed);
+  repeater->link = link;
+  deviceMember = -1;
+  pumpAt = UINT64_MAX;
+  std::string channel = vailChannel.c_str();
+  scriptMember = repeater->join(channel, hostNowMicros, true);
+  for (int i = 0; i < listeners; i++) repeater->join(channel, hostNowMicros, true);
+  if (webSocket.hostBegun && !webSocket.isConnected()) onWebSocketBegin();
+}
+
+// ============================================
+// Script actions
+// ============================================
+
+static bool parseKeys(const std::string& text, std::vector<uint8_t>& keys) {
+  static const struct { const char* name; uint8_t code; } names[] = {
+    {"up", KEY_UP}, {"down", KEY_DOWN}, {"left", KEY_LEFT}, {"right", KEY_RIGHT},
+    {"enter", KEY_ENTER}, {"esc", KEY_ESC}, {"tab", KEY_TAB}, {"bs", KEY_BACKSPACE},
+  };
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '{') { keys.push_back((uint8_t)text[i]); continue; }
+    size_t end = text.find('}', i);
+    if (end == std::string::npos) return false;
+    std::string name = text.substr(i + 1, end - i - 1);
+    bool found = false;
+    for (const auto& n : names) {
+      if (name == n.name) { keys.push_back(n.code); found = true; break; }
+    }
+    if (!found) return false;
+    i = end;
+  }
+  return true;
+}
+
+static void pressKey(void* arg) {
+  Wire.keyQueue.push_back((uint8_t)(uintptr_t)arg);
+  keyTimes.push_back(hostNowMicros);
+}
+
+static void injectVail(const std::string& args) {
+  std::istringstream in(args);
+  std::string durations, word;
+  in >> durations;
+  int64_t age = 0;
+  int clients = 2;
+  while (in >> word) {
+    if (word == "age") in >> age;
+    else if (word == "clients") in >> clients;
+  }
+  int64_t timestamp = serverMillis() - age;
+  std::vector<uint16_t> list;
+  if (repeater && parseDurationList(durations, list)) {
+    repeater->send(scriptMember, timestamp, list, hostNowMicros);  // Played out when delivered
+    scheduleRepeater();
+    return;
+  }
+  String json = String("{\"Timestamp\":") + String((long long)timestamp) + ",\"Clients\":" + String(clients) +
+                ",\"Duration\":[" + String(durations.c_str()) + "]}";
+  deliverVail(json);
+}
+
+static void runAction(const Action& a) {
+  inputs.push_back({hostNowMicros, a.verb + " " + a.args});
+  std::istringstream in(a.args);
+  std::string what, arg;
+  in >> what;
+
+  if (a.verb == "key") {
+    std::vector<uint8_t> keys;
+    parseKeys(a.args, keys);
+    for (size_t i = 0; i < keys.size(); i++) {
+      hostSchedule(hostNowMicros + (uint64_t)i * SIM_KEY_INTERVAL_MS * 1000, pressKey, (void*)(uintptr_t)keys[i]);
+    }
+  } else if (a.verb == "paddle") {
+    in >> arg;
+    hostSetPin(what == "dit" ? DIT_PIN : DAH_PIN, arg == "down" ? LOW : HIGH);
+  } else if (a.verb == "ws") {
+    std::string rest;
+    std::getline(in >> std::ws, rest);
+    if (what == "vail") injectVail(rest);
+    else if (what == "sync") webSocket.hostDeliver(WStype_TEXT, String("{\"Timestamp\":") + String((long long)serverMillis()) + ",\"Clients\":1,\"Duration\":[]}");
+    else if (what == "connected") webSocket.hostDeliver(WStype_CONNECTED, "/chat");
+    else if (what == "disconnected") webSocket.hostDeliver(WStype_DISCONNECTED, "");
+    else if (what == "text") webSocket.hostDeliver(WStype_TEXT, String(rest.c_str()));
+    else if (what == "repeater") startRepeater(rest);
+    else if (what == "sender" && repeater) {
+      unsigned period = 0;
+      std::string list;
+      std::vector<uint16_t> durations;
+      std::istringstream(rest) >> period >> list;
+      if (period > 0 && parseDurationList(list, durations)) {
+        repeater->addSender(vailChannel.c_str(), period, durations, hostNowMicros + period * 1000ull, hostNowMicros);
+        scheduleRepeater();
+      }
+    }
+  } else if (a.verb == "wifi") {
+    if (what == "join") {
+      std::string ssid, pass;
+      in >> ssid >> pass;
+      WiFi.mode(WIFI_STA);
+      WiFi.begin(ssid.c_str(), pass.c_str());
+    } else if (what == "drop") {
+      WiFi.hostDrop();
+    }
+  } else if (a.verb == "serial") {
+    Serial.input += a.args + "\n";
+  } else if (a.verb == "mode-check") {
+    modeChecks.push_back({hostNowMicros, menuModeName(currentMode)});
+  } else if (a.verb == "end") {
+    stopRequested = true;
+    postEvent(EVENT_STATUS, 0);  // An idle loop() waits forever; wake it so the run stops here
+  }
+}
+
+// Deadline callback: run the action, then schedule its next repetition
+static void fireAction(void* arg) {
+  ActionRun* run = (ActionRun*)arg;
+  runAction(*run->action);
+  if (++run->done < run->action->count) {
+    hostSchedule(run->action->atMicros + run->done * run->action->everyMicros, fireAction, run);
+  }
+}
+
+// ============================================
+// Script parsing
+// ============================================
+
+static const char* verbs[] = {"key", "paddle", "ws", "wifi", "serial", "end"};
+static const char* expectKinds[] = {"tones", "tone-ms", "gap-ms", "sent", "sent-contains", "playout-late-ms",
+                                    "rx-queue", "ui-ms", "serial-contains", "mode"};
+
+static bool parseScript(const char* path, std::vector<Action>& actions, std::vector<Expect>& expects) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "simulate: cannot read %s\n", path);
+    return false;
+  }
+  std::string text;
+  int lineNo = 0;
+  while (std::getline(file, text)) {
+    lineNo++;
+    // "#" at the start or after a space starts a comment (JSON may contain '#')
+    for (size_t i = 0; i < text.size(); i++) {
+      if (text[i] == '#' && (i == 0 || isspace((unsigned char)text[i - 1]))) { text.erase(i); break; }
+    }
+    while (!text.empty() && isspace((unsigned char)text.back())) text.pop_back();  // Not part of key TEXT
+    std::istringstream in(text);
+    std::string when;
+    if (!(in >> when)) continue;
+
+    unsigned long long from = 0, to = 0;
+    int fields = sscanf(when.c_str(), "@%llu-%llu", &from, &to);
+    std::string verb;
+    in >> verb;
+    if (fields < 1 || verb.empty()) {
+      fprintf(stderr, "%s:%d: expected \"@TIME verb ...\"\n", path, lineNo);
+      return false;
+    }
+
+    Action a = {lineNo, from * 1000, 0, 1, "", ""};
+    if (verb == "every") {
+      unsigned long long every = 0, count = 0;
+      std::string times;
+      in >> every >> times >> verb;
+      if (every == 0 || sscanf(times.c_str(), "x%llu", &count) != 1 || count == 0) {
+        fprintf(stderr, "%s:%d: expected \"every PERIOD xCOUNT\"\n", path, lineNo);
+        return false;
+      }
+      a.everyMicros = every * 1000;
+      a.count = (uint32_t)count;
+    }
+    std::string rest;
+    std::getline(in >> std::ws, rest);
+
+    if (verb == "expect") {
+      Expect e = {lineNo, from * 1000, fields == 2 ? to * 1000 : UINT64_MAX, "", ""};
+      std::istringstream ein(rest);
+      ein >> e.kind;
+      std::getline(ein >> std::ws, e.args);
+      bool known = false;
+      for (const char* k : expectKinds) known = known || e.kind == k;
+      if (!known) {
+        fprintf(stderr, "%s:%d: unknown expectation \"%s\"\n", path, lineNo, e.kind.c_str());
+        return false;
+      }
+      if (fields == 1 && e.kind != "mode") e.toMicros = UINT64_MAX;
+      if (e.kind == "mode") actions.push_back({lineNo, from * 1000, 0, 1, "mode-check", ""});
+      expects.push_back(e);
+      continue;
+    }
+
+    bool known = false;
+    for (const char* v : verbs) known = known || verb == v;
+    std::vector<uint8_t> keys;
+    if (!known || (verb == "key" && !parseKeys(rest, keys))) {
+      fprintf(stderr, "%s:%d: bad action \"%s %s\"\n", path, lineNo, verb.c_str(), rest.c_str());
+      return false;
+    }
+    a.verb = verb;
+    a.args = rest;
+    actions.push_back(a);
+  }
+  return true;
+}
+
+// ============================================
+// Expectations
+// ============================================
+
+static bool inWindow(const Expect& e, uint64_t t) { return t >= e.fromMicros && t <= e.toMicros; }
+
+static bool parseRange(const std::string& text, double& lo, double& hi) {
+  if (sscanf(text.c_str(), "%lf-%lf", &lo, &hi) == 2) return true;
+  if (sscanf(text.c_str(), "%lf %lf", &lo, &hi) == 2) return true;
+  if (sscanf(text.c_str(), "%lf", &lo) == 1) { hi = lo; return true; }
+  return false;
+}
+
+// Check one expectation; detail describes what was measured
+static bool check(const Expect& e, std::string& detail) {
+  char buf[160];
+  double lo = 0, hi = 0;
+  bool numeric = e.kind != "sent-contains" && e.kind != "serial-contains" && e.kind != "mode";
+  if (numeric && !parseRange(e.args, lo, hi)) {
+    detail = "bad arguments";
+    return false;
+  }
+
+  if (e.kind == "tones" || e.kind == "sent") {
+    size_t n = 0;
+    if (e.kind == "tones") {
+      for (const ToneSegment& s : tones) n += inWindow(e, s.start);
+    } else {
+      for (const TimedText& f : sentFrames) n += inWindow(e, f.t);
+    }
+    snprintf(buf, sizeof(buf), "%zu", n);
+    detail = buf;
+    return n >= lo && n <= hi;
+  }
+
+  if (e.kind == "tone-ms" || e.kind == "gap-ms") {
+    double minMs = 1e18, maxMs = 0;
+    size_t n = 0, bad = 0;
+    for (size_t i = 0; i < tones.size(); i++) {
+      if (!inWindow(e, tones[i].start)) continue;
+      double ms;
+      if (e.kind == "tone-ms") {
+        ms = (tones[i].end - tones[i].start) / 1000.0;
+      } else {
+        if (i + 1 >= tones.size() || !inWindow(e, tones[i + 1].start)) continue;
+        ms = (tones[i + 1].start - tones[i].end) / 1000.0;
+      }
+      n++;
+      minMs = std::min(minMs, ms);
+      maxMs = std::max(maxMs, ms);
+      if (ms < lo || ms > hi) bad++;
+    }
+    if (n == 0) {
+      detail = "nothing to measure";
+      return false;
+    }
+    snprintf(buf, sizeof(buf), "%zu measured, %.1f-%.1f ms, %zu out of range", n, minMs, maxMs, bad);
+    detail = buf;
+    return bad == 0;
+  }
+
+  if (e.kind == "playout-late-ms") {
+    double maxLate = -1e18;
+    size_t n = 0, missing = 0;
+    for (const PlayoutRecord& p : playouts) {
+      if (!inWindow(e, p.injected)) continue;
+      n++;
+      const ToneSegment* heard = nullptr;
+      for (const ToneSegment& s : tones) {
+        if (s.start + SIM_TONE_GAP_US >= p.due) { heard = &s; break; }
+      }
+      if (heard == nullptr || heard->start > p.due + (uint64_t)SIM_PLAYOUT_LIMIT_MS * 1000) {
+        missing++;
+        continue;
+      }
+      maxLate = std::max(maxLate, ((double)heard->start - (double)p.due) / 1000.0);
+    }
+    if (n == 0) {
+      detail = "no Vail messages";
+      return false;
+    }
+    snprintf(buf, sizeof(buf), "%zu messages, latest %.1f ms after due, %zu missing", n, maxLate, missing);
+    detail = buf;
+    return missing == 0 && maxLate <= lo;
+  }
+
+  if (e.kind == "rx-queue") {
+    size_t peak = 0, n = 0;
+    for (const TimedCount& q : rxQueueSizes) {
+      if (!inWindow(e, q.t)) continue;
+      n++;
+      peak = std::max(peak, q.n);
+    }
+    if (n == 0) {
+      detail = "no Vail messages";
+      return false;
+    }
+    snprintf(buf, sizeof(buf), "%zu messages, at most %zu waiting", n, peak);
+    detail = buf;
+    return peak <= lo;
+  }
+
+  if (e.kind == "ui-ms") {
+    double maxMs = 0;
+    size_t n = 0, silent = 0;
+    size_t d = 0;
+    for (size_t k = 0; k < keyTimes.size(); k++) {
+      if (!inWindow(e, keyTimes[k])) continue;
+      n++;
+      while (d < displayCalls.size() && displayCalls[d].t < keyTimes[k]) d++;
+      uint64_t next = k + 1 < keyTimes.size() ? keyTimes[k + 1] : UINT64_MAX;
+      if (d >= displayCalls.size() || displayCalls[d].t >= next) {
+        silent++;  // Key did not change the screen
+        continue;
+      }
+      maxMs = std::max(maxMs, (displayCalls[d].t - keyTimes[k]) / 1000.0);
+    }
+    if (n == 0) {
+      detail = "no keys";
+      return false;
+    }
+    snprintf(buf, sizeof(buf), "%zu keys, slowest %.1f ms to the first draw, %zu without a redraw", n, maxMs, silent);
+    detail = buf;
+    return maxMs <= lo;
+  }
+
+  if (e.kind == "sent-contains") {
+    for (const TimedText& f : sentFrames) {
+      if (inWindow(e, f.t) && f.text.find(e.args) != std::string::npos) {
+        detail = "found";
+        return true;
+      }
+    }
+    detail = "not sent";
+    return false;
+  }
+
+  if (e.kind == "serial-contains") {
+    bool found = Serial.output.find(e.args) != std::string::npos;
+    detail = found ? "found" : "not printed";
+    return found;
+  }
+
+  // mode: the check recorded at the expectation's time
+  for (const TimedText& m : modeChecks) {
+    if (m.t == e.fromMicros) {
+      detail = m.text;
+      return m.text == e.args;
+    }
+  }
+  detail = "not reached";
+  return false;
+}
+
+// ============================================
+// Recording files
+// ============================================
+
+static void writeRecording(const std::string& dir) {
+  mkdir(dir.c_str(), 0755);
+  hostI2SWriteWav((dir + "/audio.wav").c_str());
+
+  FILE* f = fopen((dir + "/tones.csv").c_str(), "w");
+  if (f) {
+    fprintf(f, "start_us,end_us,ms\n");
+    for (const ToneSegment& s : tones) {
+      fprintf(f, "%llu,%llu,%.2f\n", (unsigned long long)s.start, (unsigned long long)s.end, (s.end - s.start) / 1000.0);
+    }
+    fclose(f);
+  }
+  f = fopen((dir + "/display.csv").c_str(), "w");
+  if (f) {
+    fprintf(f, "t_us,call\n");
+    for (const TimedName& c : displayCalls) fprintf(f, "%llu,%s\n", (unsigned long long)c.t, c.name);
+    fclose(f);
+  }
+  f = fopen((dir + "/sent.csv").c_str(), "w");
+  if (f) {
+    fprintf(f, "t_us,payload\n");
+    for (const TimedText& s : sentFrames) fprintf(f, "%llu,%s\n", (unsigned long long)s.t, s.text.c_str());
+    fclose(f);
+  }
+  f = fopen((dir + "/inputs.csv").c_str(), "w");
+  if (f) {
+    fprintf(f, "t_us,input\n");
+    for (const TimedText& s : inputs) fprintf(f, "%llu,%s\n", (unsigned long long)s.t, s.text.c_str());
+    fclose(f);
+  }
+  f = fopen((dir + "/serial.log").c_str(), "w");
+  if (f) {
+    fwrite(Serial.output.data(), 1, Serial.output.size(), f);
+    fclose(f);
+  }
+  for (const auto& entry : hostFsFiles) {
+    std::filesystem::path path = dir + "/littlefs" + entry.first;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary).write((const char*)entry.second.data(), entry.second.size());
+  }
+}
+
+// DIR's tree -> LittleFS shim (paths relative to DIR)
+static bool loadFs(const std::string& dir) {
+  std::error_code error;
+  std::filesystem::recursive_directory_iterator it(dir, error);
+  if (error) {
+    fprintf(stderr, "simulate: cannot read %s\n", dir.c_str());
+    return false;
+  }
+  for (const auto& entry : it) {
+    std::string path = "/" + std::filesystem::relative(entry.path(), dir).generic_string();
+    if (entry.is_directory()) {
+      hostFsDirs.insert(path);
+    } else if (entry.is_regular_file()) {
+      std::ifstream in(entry.path(), std::ios::binary);
+      hostFsFiles[path].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+  }
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: simulate SCRIPT [--record DIR] [--fs DIR] [--seconds N] [--verbose]\n");
+}
+
+int main(int argc, char** argv) {
+  const char* scriptPath = nullptr;
+  std::string recordDir;
+  double seconds = 0;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--record" && i + 1 < argc) recordDir = argv[++i];
+    else if (arg == "--fs" && i + 1 < argc) { if (!loadFs(argv[++i])) return 2; }
+    else if (arg == "--seconds" && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (arg == "--verbose") verbose = true;
+    else if (arg[0] != '-' && scriptPath == nullptr) scriptPath = argv[i];
+    else { usage(); return 2; }
+  }
+  if (scriptPath == nullptr) { usage(); return 2; }
+
+  std::vector<Action> actions;
+  std::vector<Expect> expects;
+  if (!parseScript(scriptPath, actions, expects)) return 2;
+
+  // Run to --seconds, the "end" action, or 2 s past the last thing in the script
+  uint64_t endMicros = 0;
+  for (const Action& a : actions) endMicros = std::max(endMicros, a.atMicros + (a.count - 1) * a.everyMicros);
+  for (const Expect& e : expects) {
+    if (e.toMicros != UINT64_MAX) endMicros = std::max(endMicros, e.toMicros);
+  }
+  endMicros += 2000000;
+  if (seconds > 0) endMicros = (uint64_t)(seconds * 1e6);
+
+  WiFi.hostNetworks = {{"VailNet", -48, WIFI_AUTH_WPA2_PSK, 6}};
+  for (const Action& a : actions) {
+    actionRuns.push_back({&a, 0});
+    hostSchedule(a.atMicros, fireAction, &actionRuns.back());
+  }
+
+  hostI2S.sink = onAudio;
+  hostI2S.dropped = onAudioDropped;
+  hostI2S.capture = !recordDir.empty();
+  hostGfxCallHook = onDisplayCall;
+  webSocket.hostSendHook = onWebSocketSend;
+  webSocket.hostBeginHook = onWebSocketBegin;
+  webSocket.hostDisconnectHook = onWebSocketDisconnect;
+  Serial.echo = verbose;
+  for (const Expect& e : expects) recordSerial = recordSerial || e.kind == "serial-contains";
+  Serial.capture = recordSerial || !recordDir.empty();
+
+  auto start = std::chrono::steady_clock::now();
+  setup();
+  while (hostNowMicros < endMicros && !stopRequested && !hostDeepSleepRequested) {
+    loop();
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fflush(stdout);
+
+  if (!recordDir.empty()) writeRecording(recordDir);
+
+  fprintf(stderr, "Simulated %.1f s in %.3f s (%.0fx): %zu tones, %zu display calls, %zu frames sent\n",
+          hostNowMicros / 1e6, wall, wall > 0 ? hostNowMicros / 1e6 / wall : 0.0,
+          tones.size(), displayCalls.size(), sentFrames.size());
+  if (repeater) {
+    const RepeaterStats& s = repeater->stats;
+    fprintf(stderr, "Repeater: %llu received, %llu rejected, %llu delivered, %llu lost, %llu to simulated members, "
+            "%zu in flight at most\n", (unsigned long long)s.received, (unsigned long long)s.rejected,
+            (unsigned long long)s.delivered, (unsigned long long)s.lost, (unsigned long long)s.simulated,
+            s.peakInFlight);
+  }
+
+  int failed = 0;
+  for (const Expect& e : expects) {
+    std::string detail;
+    bool ok = check(e, detail);
+    if (!ok) failed++;
+    fprintf(stderr, "%s %s:%d expect %s %s: %s\n", ok ? "PASS" : "FAIL", scriptPath, e.line,
+            e.kind.c_str(), e.args.c_str(), detail.c_str());
+  }
+  if (failed) fprintf(stderr, "%d of %zu expectations failed\n", failed, expects.size());
+  return failed ? 1 : 0;
+}
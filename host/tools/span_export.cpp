@@ -0,0 +1,249 @@
+/*
+ * Pull span dumps out of a serial capture as a Chrome trace file
+ *
+ *   span_export [--all] [CAPTURE [OUT.json]]     (stdin/stdout without files)
+ *
+ * "spans" prints the span ring as Chrome trace JSON between
+ * "=== SPANS BEGIN ===" and "=== SPANS END ===" lines, in among whatever
+ * else the console wrote (span_trace.h). This writes the last dump (or,
+ * with --all, every dump merged by task name, repeats dropped) as a file
+ * for ui.perfetto.dev or chrome://tracing. A dump cut off mid-line still
+ * converts.
+ *
+ * A summary goes to stderr: time per span name, and for an "audio
+ * underrun" marker ("spans arm") the spans that overlapped the gap,
+ * longest overlap first.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct Span {
+  std::string name;
+  int core;
+  std::string task;
+  long long ts;
+  long long dur;
+};
+
+struct Marker {
+  long long ts;
+  long long gap;
+};
+
+struct Dump {
+  std::vector<Span> spans;
+  std::vector<Marker> markers;
+};
+
+// "key":"value" in one event line ("" if absent)
+static std::string textField(const std::string& line, const char* key) {
+  std::string tag = std::string("\"") + key + "\":\"";
+  size_t at = line.find(tag);
+  if (at == std::string::npos) return "";
+  at += tag.size();
+  size_t end = line.find('"', at);
+  return end == std::string::npos ? "" : line.substr(at, end - at);
+}
+
+// "key":number in one event line; false if absent
+static bool numberField(const std::string& line, const char* key, long long& value) {
+  std::string tag = std::string("\"") + key + "\":";
+  size_t at = line.find(tag);
+  if (at == std::string::npos) return false;
+  const char* start = line.c_str() + at + tag.size();
+  char* end;
+  value = strtoll(start, &end, 10);
+  return end != start;
+}
+
+// One dump's lines -> spans with task names resolved
+static Dump parseDump(const std::vector<std::string>& lines) {
+  Dump dump;
+  std::map<std::pair<long long, long long>, std::string> threadNames;  // (pid, tid) -> task
+  std::vector<std::string> events;
+  for (std::string line : lines) {
+    if (!line.empty() && line[0] == ',') line.erase(0, 1);
+    if (line.empty() || line[0] != '{' || line.back() != '}') continue;  // Header, footer, cut line
+    std::string ph = textField(line, "ph");
+    long long pid, tid;
+    if (ph == "M" && textField(line, "name") == "thread_name" && numberField(line, "pid", pid) &&
+        numberField(line, "tid", tid)) {
+      size_t args = line.find("\"args\"");
+      if (args != std::string::npos) threadNames[{pid, tid}] = textField(line.substr(args), "name");
+    } else if (ph == "X" || ph == "i") {
+      events.push_back(line);
+    }
+  }
+
+  for (const std::string& line : events) {
+    long long pid = 0, tid = 0, ts, dur;
+    numberField(line, "pid", pid);
+    numberField(line, "tid", tid);
+    if (!numberField(line, "ts", ts)) continue;
+    if (textField(line, "ph") == "i") {
+      long long gap = 0;
+      numberField(line, "gap_us", gap);
+      dump.markers.push_back({ts, gap});
+    } else if (numberField(line, "dur", dur)) {
+      auto name = threadNames.find({pid, tid});
+      std::string task = name != threadNames.end() ? name->second : "task " + std::to_string(tid);
+      dump.spans.push_back({textField(line, "name"), (int)pid, task, ts, dur});
+    }
+  }
+  return dump;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: span_export [--all] [CAPTURE [OUT.json]]\n");
+}
+
+int main(int argc, char** argv) {
+  bool all = false;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--all") all = true;
+    else if (arg.size() > 1 && arg[0] == '-') { usage(); return 2; }
+    else files.push_back(arg);
+  }
+  if (files.size() > 2) { usage(); return 2; }
+
+  std::ifstream file;
+  if (!files.empty() && files[0] != "-") {
+    file.open(files[0], std::ios::binary);
+    if (!file) {
+      fprintf(stderr, "span_export: cannot read %s\n", files[0].c_str());
+      return 1;
+    }
+  }
+  std::istream& in = file.is_open() ? file : std::cin;
+
+  // Lines between the markers (binary trace frames and other text around them are ignored)
+  std::vector<std::vector<std::string>> dumps;
+  bool inDump = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.find("=== SPANS BEGIN") != std::string::npos) {
+      dumps.emplace_back();
+      inDump = true;
+    } else if (line.find("=== SPANS END") != std::string::npos) {
+      inDump = false;
+    } else if (inDump) {
+      dumps.back().push_back(line);
+    }
+  }
+  if (dumps.empty()) {
+    fprintf(stderr, "span_export: no \"spans\" dump in the capture\n");
+    return 1;
+  }
+
+  // Merge (repeats of a span from an earlier dump are dropped)
+  Dump merged;
+  std::set<std::tuple<std::string, std::string, long long, long long>> seen;
+  for (size_t d = all ? 0 : dumps.size() - 1; d < dumps.size(); d++) {
+    Dump dump = parseDump(dumps[d]);
+    for (const Span& span : dump.spans) {
+      if (seen.insert({span.name, span.task, span.ts, span.dur}).second) merged.spans.push_back(span);
+    }
+    merged.markers.insert(merged.markers.end(), dump.markers.begin(), dump.markers.end());
+  }
+  std::sort(merged.spans.begin(), merged.spans.end(), [](const Span& a, const Span& b) {
+    return a.ts != b.ts ? a.ts < b.ts : a.dur > b.dur;  // Parents before the spans they contain
+  });
+
+  // Task names -> tids, in order of first appearance
+  std::vector<std::string> tasks;
+  std::set<std::pair<int, int>> threads;  // (core, tid) pairs to name
+  auto tidOf = [&](const std::string& task) {
+    auto it = std::find(tasks.begin(), tasks.end(), task);
+    if (it != tasks.end()) return (int)(it - tasks.begin()) + 1;
+    tasks.push_back(task);
+    return (int)tasks.size();
+  };
+
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  json += "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":0,\"args\":{\"name\":\"Core 0\"}},\n";
+  json += "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"Core 1\"}}";
+  char text[256];
+  std::string events;
+  for (const Span& span : merged.spans) {
+    int tid = tidOf(span.task);
+    threads.insert({span.core, tid});
+    snprintf(text, sizeof(text), ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+             span.name.c_str(), span.core, tid, span.ts, span.dur);
+    events += text;
+  }
+  for (const auto& [core, tid] : threads) {
+    snprintf(text, sizeof(text), ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+             core, tid, tasks[tid - 1].c_str());
+    json += text;
+  }
+  json += events;
+  for (const Marker& marker : merged.markers) {
+    snprintf(text, sizeof(text), ",\n{\"ph\":\"i\",\"name\":\"audio underrun\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%lld,"
+             "\"args\":{\"gap_us\":%lld}}", marker.ts, marker.gap);
+    json += text;
+  }
+  json += "\n]}\n";
+
+  if (files.size() == 2 && files[1] != "-") {
+    std::ofstream out(files[1]);
+    out << json;
+    if (!out) {
+      fprintf(stderr, "span_export: cannot write %s\n", files[1].c_str());
+      return 1;
+    }
+  } else {
+    fputs(json.c_str(), stdout);
+  }
+
+  // Summary: where the time went, then what overlapped each underrun
+  struct Total { long long count = 0, micros = 0, worst = 0; };
+  std::map<std::string, Total> totals;
+  for (const Span& span : merged.spans) {
+    Total& t = totals[span.name];
+    t.count++;
+    t.micros += span.dur;
+    t.worst = std::max(t.worst, span.dur);
+  }
+  std::vector<std::pair<std::string, Total>> byTime(totals.begin(), totals.end());
+  std::sort(byTime.begin(), byTime.end(), [](const auto& a, const auto& b) { return a.second.micros > b.second.micros; });
+  long long first = merged.spans.empty() ? 0 : merged.spans.front().ts;
+  long long last = first;
+  for (const Span& span : merged.spans) last = std::max(last, span.ts + span.dur);
+
+  fprintf(stderr, "span_export: %zu spans from %zu dump(s), %zu tasks, %.1f ms\n", merged.spans.size(),
+          all ? dumps.size() : (size_t)1, tasks.size(), (last - first) / 1000.0);
+  fprintf(stderr, "span,count,total_us,max_us\n");
+  for (const auto& [name, t] : byTime) {
+    fprintf(stderr, "%s,%lld,%lld,%lld\n", name.c_str(), t.count, t.micros, t.worst);
+  }
+  for (const Marker& marker : merged.markers) {
+    long long from = marker.ts - marker.gap;
+    std::vector<std::pair<long long, const Span*>> overlaps;
+    for (const Span& span : merged.spans) {
+      long long overlap = std::min(span.ts + span.dur, marker.ts) - std::max(span.ts, from);
+      if (overlap > 0) overlaps.push_back({overlap, &span});
+    }
+    std::sort(overlaps.begin(), overlaps.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    fprintf(stderr, "audio underrun at %lld us (%lld us gap), overlapping:\n", marker.ts, marker.gap);
+    for (size_t i = 0; i < overlaps.size() && i < 8; i++) {
+      const Span& span = *overlaps[i].second;
+      fprintf(stderr, "  %-28s %-12s core %d  %lld us of %lld us\n", span.name.c_str(), span.task.c_str(),
+              span.core, overlaps[i].first, span.dur);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Decode binary trace records in a serial capture
+ *
+ *   trace_decode [CAPTURE]          (stdin without a file)
+ *
+ * After "trace binary" the firmware writes COBS frames between 0x00
+ * bytes in among its ordinary console text (trace.h). This prints the text as
+ * is and each frame as the line "trace text" would have printed, using
+ * the formats in trace_events.h, so decode with the tree of the build
+ * that wrote the capture. Times are unwrapped past the 32-bit
+ * microsecond counter's 71 minutes.
+ *
+ * A capture from the device, for example:
+ *   stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > capture.bin
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "trace_events.h"
+
+#define FRAME_MAX 30  // Longest record frame without its delimiters (trace.h TRACE_FRAME_MAX - 2)
+
+// COBS frame (without the 0x00) -> raw bytes; false if malformed
+static bool unstuff(const std::vector<uint8_t>& frame, std::vector<uint8_t>& raw) {
+  raw.clear();
+  size_t i = 0;
+  while (i < frame.size()) {
+    uint8_t code = frame[i++];
+    if (code == 0 || i + code - 1 > frame.size()) return false;
+    raw.insert(raw.end(), frame.begin() + i, frame.begin() + i + code - 1);
+    i += code - 1;
+    if (code < 0xFF && i < frame.size()) raw.push_back(0);
+  }
+  return true;
+}
+
+struct Decoder {
+  uint64_t lastMicros = 0;  // Unwrapped time of the previous record
+  bool haveTime = false;
+  unsigned frames = 0, bad = 0;
+
+  // One record -> text line; false if it does not parse
+  bool decode(const std::vector<uint8_t>& raw, std::string& line) {
+    if (raw.size() < 6) return false;
+    unsigned event = raw[0];
+    unsigned argc = raw[1];
+    if (event >= TRACE_EVENT_COUNT || argc > 3) return false;
+    uint32_t micros = raw[2] | (raw[3] << 8) | (raw[4] << 16) | ((uint32_t)raw[5] << 24);
+
+    int32_t args[3] = {0, 0, 0};
+    size_t pos = 6;
+    for (unsigned a = 0; a < argc; a++) {
+      uint32_t zigzag = 0;
+      for (int shift = 0;; shift += 7) {
+        if (pos >= raw.size() || shift > 28) return false;
+        uint8_t b = raw[pos++];
+        zigzag |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+      }
+      args[a] = (int32_t)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    }
+    if (pos != raw.size()) return false;
+
+    // Records leave the ring in order, so time only runs backwards on a wrap
+    uint64_t t = (lastMicros & ~0xFFFFFFFFull) | micros;
+    if (haveTime && t < lastMicros) t += 1ull << 32;
+    lastMicros = t;
+    haveTime = true;
+
+    char text[200];
+    int n = snprintf(text, sizeof(text), "[%llu.%06llu] %c ", (unsigned long long)(t / 1000000),
+                     (unsigned long long)(t % 1000000), "?EWID"[traceEventLevels[event]]);
+    snprintf(text + n, sizeof(text) - n, traceEventFormats[event], args[0], args[1], args[2]);
+    line = text;
+    return true;
+  }
+};
+
+int main(int argc, char** argv) {
+  FILE* in = stdin;
+  if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1] != '\0')) {
+    fprintf(stderr, "usage: trace_decode [CAPTURE]\n");
+    return 2;
+  }
+  if (argc == 2 && std::string(argv[1]) != "-") {
+    in = fopen(argv[1], "rb");
+    if (in == nullptr) {
+      fprintf(stderr, "trace_decode: cannot read %s\n", argv[1]);
+      return 1;
+    }
+  }
+
+  // 0x00 opens and closes a frame; everything else is console text. A
+  // "frame" that does not decode was text after all (capture started
+  // inside a frame), and its closing 0x00 opens the next one.
+  Decoder decoder;
+  std::vector<uint8_t> pending, raw;
+  std::string line;
+  bool inFrame = false;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (c != 0) {
+      pending.push_back((uint8_t)c);
+      continue;
+    }
+    if (!inFrame) {
+      fwrite(pending.data(), 1, pending.size(), stdout);
+      inFrame = true;
+    } else if (pending.empty()) {
+      continue;  // Still waiting for the frame
+    } else if (pending.size() <= FRAME_MAX && unstuff(pending, raw) && decoder.decode(raw, line)) {
+      printf("%s\n", line.c_str());
+      decoder.frames++;
+      inFrame = false;
+    } else {
+      fwrite(pending.data(), 1, pending.size(), stdout);
+      decoder.bad++;
+    }
+    pending.clear();
+  }
+  fwrite(pending.data(), 1, pending.size(), stdout);
+  if (in != stdin) fclose(in);
+
+  fprintf(stderr, "trace_decode: %u records, %u undecodable\n", decoder.frames, decoder.bad);
+  return decoder.bad ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * Convert a Vail session capture to text or a WAV
+ *
+ *   vail_capture [INPUT] [--wav OUT] [--tone HZ] [--tx-tone HZ] [--rate HZ]
+ *
+ * INPUT (stdin without a file) is a .vcap file (LittleFS, or a simulate
+ * --record run's littlefs/vail directory) or a serial capture holding
+ * "vailrec dump" output (the last dump in it is used). Prints one line
+ * per record: time since the capture started, kind, Timestamp against the
+ * start with the message's age when logged, Clients and the elements
+ * (tone, gap, tone...). --wav renders every message's tones at their
+ * Timestamp (received at --tone, sent at --tx-tone), so the file plays the
+ * channel as it was keyed, without the playback delay.
+ *
+ * The record format is vail_capture_format.h in the sketch; decode with
+ * the tree of the build that wrote the capture.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "vail_capture_format.h"
+
+#define WAV_RAMP_MS   4      // Raised-cosine edges on every tone
+#define WAV_LEVEL     0.5    // Peak of one tone (overlaps add, then clip)
+
+static bool readAll(FILE* f, std::vector<uint8_t>& data) {
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+  return !ferror(f);
+}
+
+// Last "=== VAILREC BEGIN ... === / END" block in a serial capture -> bytes
+static bool extractDump(const std::vector<uint8_t>& capture, std::vector<uint8_t>& data) {
+  std::string text(capture.begin(), capture.end());
+  size_t begin = text.rfind("=== VAILREC BEGIN");
+  if (begin == std::string::npos) return false;
+  begin = text.find('\n', begin);
+  size_t end = text.find("=== VAILREC END", begin);
+  if (begin == std::string::npos || end == std::string::npos) return false;
+
+  data.clear();
+  uint32_t bits = 0;
+  int have = 0;
+  for (size_t i = begin; i < end; i++) {
+    char c = text[i];
+    int value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') value = c - '0' + 52;
+    else if (c == '+') value = 62;
+    else if (c == '/') value = 63;
+    else if (c == '=') { bits = 0; have = 0; continue; }  // Padding ends a line's last group
+    else continue;
+    bits = (bits << 6) | value;
+    have += 6;
+    if (have >= 8) {
+      have -= 8;
+      data.push_back((uint8_t)(bits >> have));
+    }
+  }
+  return true;
+}
+
+static void writeWav(const char* path, const std::vector<float>& samples, int rate) {
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "vail_capture: cannot write %s\n", path);
+    return;
+  }
+  uint32_t dataBytes = (uint32_t)samples.size() * 2;
+  auto u32 = [&](uint32_t v) { uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)}; fwrite(b, 1, 4, f); };
+  auto u16 = [&](uint16_t v) { uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)}; fwrite(b, 1, 2, f); };
+  fwrite("RIFF", 1, 4, f); u32(36 + dataBytes); fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f); u32(16); u16(1); u16(1); u32(rate); u32(rate * 2); u16(2); u16(16);
+  fwrite("data", 1, 4, f); u32(dataBytes);
+  for (float s : samples) {
+    float clipped = s > 1 ? 1 : (s < -1 ? -1 : s);
+    u16((uint16_t)(int16_t)lrintf(clipped * 32767));
+  }
+  fclose(f);
+}
+
+// One tone into the mix, startMs from the capture start
+static void addTone(std::vector<float>& mix, int rate, double startMs, double lengthMs, double hz) {
+  size_t first = (size_t)(startMs * rate / 1000);
+  size_t count = (size_t)(lengthMs * rate / 1000);
+  size_t ramp = std::min(count / 2, (size_t)(WAV_RAMP_MS * rate / 1000));
+  if (mix.size() < first + count) mix.resize(first + count, 0);
+  for (size_t i = 0; i < count; i++) {
+    double gain = WAV_LEVEL;
+    if (i < ramp) gain *= 0.5 - 0.5 * cos(M_PI * i / ramp);
+    else if (i >= count - ramp) gain *= 0.5 - 0.5 * cos(M_PI * (count - i) / ramp);
+    mix[first + i] += (float)(gain * sin(2 * M_PI * hz * i / rate));
+  }
+}
+
+static void usage() {
+  fprintf(stderr, "usage: vail_capture [INPUT] [--wav OUT] [--tone HZ] [--tx-tone HZ] [--rate HZ]\n");
+}
+
+int main(int argc, char** argv) {
+  const char* inputPath = nullptr;
+  const char* wavPath = nullptr;
+  double rxTone = 600, txTone = 750;
+  int rate = 16000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--wav" && i + 1 < argc) wavPath = argv[++i];
+    else if (arg == "--tone" && i + 1 < argc) rxTone = atof(argv[++i]);
+    else if (arg == "--tx-tone" && i + 1 < argc) txTone = atof(argv[++i]);
+    else if (arg == "--rate" && i + 1 < argc) rate = atoi(argv[++i]);
+    else if (arg[0] != '-' && inputPath == nullptr) inputPath = argv[i];
+    else { usage(); return 2; }
+  }
+  if (rate < 4000) { usage(); return 2; }
+
+  FILE* in = inputPath ? fopen(inputPath, "rb") : stdin;
+  if (!in) {
+    fprintf(stderr, "vail_capture: cannot open %s\n", inputPath);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  bool ok = readAll(in, data);
+  if (inputPath) fclose(in);
+  if (!ok) {
+    fprintf(stderr, "vail_capture: read error\n");
+    return 1;
+  }
+  if (data.size() < 4 || std::string(data.begin(), data.begin() + 4) != "VCAP") {
+    std::vector<uint8_t> dump;
+    if (!extractDump(data, dump)) {
+      fprintf(stderr, "vail_capture: no capture (neither a .vcap file nor \"vailrec dump\" output)\n");
+      return 1;
+    }
+    data.swap(dump);
+  }
+
+  VcapHeader header;
+  int used = vcapDecodeHeader(data.data(), data.size(), header);
+  if (used <= 0) {
+    fprintf(stderr, "vail_capture: %s\n", used == 0 ? "header cut short" : "not a capture version this build reads");
+    return 1;
+  }
+
+  time_t seconds = (time_t)(header.startMs / 1000);
+  char when[32];
+  strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", gmtime(&seconds));
+  printf("# channel %s, started %s.%03d UTC (server time)\n", header.channel, when, (int)(header.startMs % 1000));
+  printf("#   logged s  kind  Timestamp s   age ms  clients  elements ms\n");
+
+  VcapCursor cursor = {header.startMs, header.startMs};
+  static VcapRecord record;
+  std::vector<float> mix;
+  size_t pos = used;
+  unsigned rx = 0, tx = 0, syncs = 0;
+  int64_t lastLogged = header.startMs;
+  while (pos < data.size()) {
+    int n = vcapDecodeRecord(data.data() + pos, data.size() - pos, cursor, record);
+    if (n <= 0) {
+      fprintf(stderr, "vail_capture: %s at byte %zu, stopping\n", n == 0 ? "record cut short" : "bad record", pos);
+      break;
+    }
+    pos += n;
+    lastLogged = record.loggedAt;
+
+    const char* kind = record.kind == VCAP_TX ? "TX" : (record.count ? "RX" : "SYNC");
+    printf("%11.3f  %-4s  %11.3f  %7lld  ", (record.loggedAt - header.startMs) / 1000.0, kind,
+           (record.timestamp - header.startMs) / 1000.0, (long long)(record.loggedAt - record.timestamp));
+    if (record.kind == VCAP_RX) printf("%7u  ", record.clients);
+    else printf("%7s  ", "-");
+    for (uint16_t i = 0; i < record.count; i++) printf(i ? " %u" : "%u", record.durations[i]);
+    printf("\n");
+
+    if (record.kind == VCAP_TX) tx++;
+    else if (record.count) rx++;
+    else syncs++;
+
+    if (wavPath && record.count) {
+      double at = (double)(record.timestamp - header.startMs);
+      for (uint16_t i = 0; i < record.count; i++) {
+        if (i % 2 == 0 && at >= 0) addTone(mix, rate, at, record.durations[i], record.kind == VCAP_TX ? txTone : rxTone);
+        at += record.durations[i];
+      }
+    }
+  }
+  printf("# %u received, %u sent, %u clock syncs over %.1f s, %zu bytes\n", rx, tx, syncs,
+         (lastLogged - header.startMs) / 1000.0, data.size());
+
+  if (wavPath) {
+    writeWav(wavPath, mix, rate);
+    fprintf(stderr, "vail_capture: %s, %.1f s at %d Hz\n", wavPath, (double)mix.size() / rate, rate);
+  }
+  return 0;
+}
@@ -0,0 +1,487 @@
+/*
+ * Local Vail repeater server
+ *
+ *   vail_server [--port N] [--delay MS] [--jitter MS] [--loss PCT] [--seed N]
+ *               [--channel NAME] [--listeners N] [--sender PERIOD_MS:D1,D2,...]
+ *               [--script FILE] [--stats S]
+ *
+ * Speaks the vail.woozle.org chat protocol (WebSocket, /chat?repeater=NAME,
+ * subprotocol json.vail.woozle.org) on a LAN port, so the device can be
+ * soak-tested without the live service: build it with VAIL_SERVER_TLS 0
+ * and VAIL_SERVER_HOST/PORT pointing here. Repeater behaviour, link delay,
+ * jitter and loss are in local_repeater.h.
+ *
+ * --listeners adds N simulated members to --channel (default General),
+ * --sender adds one that keys the durations every PERIOD_MS (repeatable),
+ * and --script plays "T_MS D1,D2,..." lines (T from server start) as one
+ * more member. Counters go to stderr every --stats seconds (default 10)
+ * and on Ctrl-C.
+ */
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "local_repeater.h"
+
+#define SERVER_MAX_REQUEST  8192        // HTTP upgrade request
+#define SERVER_MAX_MESSAGE  65536       // One WebSocket message
+#define SERVER_MAX_OUTPUT   (1 << 20)   // Unsent bytes before a slow client is dropped
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_PROTOCOL "json.vail.woozle.org"
+
+// ============================================
+// SHA-1 and base64 (Sec-WebSocket-Accept)
+// ============================================
+
+static std::string sha1(const std::string& data) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::string msg = data;
+  uint64_t bits = (uint64_t)data.size() * 8;
+  msg += (char)0x80;
+  while (msg.size() % 64 != 56) msg += (char)0;
+  for (int i = 7; i >= 0; i--) msg += (char)(bits >> (i * 8));
+
+  auto rol = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+  for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t* p = (const uint8_t*)&msg[chunk + i * 4];
+      w[i] = ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  std::string digest;
+  for (uint32_t word : h) {
+    for (int i = 3; i >= 0; i--) digest += (char)(word >> (i * 8));
+  }
+  return digest;
+}
+
+static std::string base64(const std::string& data) {
+  static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < data.size(); i += 3) {
+    uint32_t n = (uint8_t)data[i] << 16;
+    if (i + 1 < data.size()) n |= (uint8_t)data[i + 1] << 8;
+    if (i + 2 < data.size()) n |= (uint8_t)data[i + 2];
+    out += table[(n >> 18) & 63];
+    out += table[(n >> 12) & 63];
+    out += i + 1 < data.size() ? table[(n >> 6) & 63] : '=';
+    out += i + 2 < data.size() ? table[n & 63] : '=';
+  }
+  return out;
+}
+
+// ============================================
+// Connections
+// ============================================
+
+struct Connection {
+  int fd;
+  std::string peer;
+  bool upgraded = false;
+  bool closing = false;     // Close once the output is flushed
+  int member = -1;
+  std::string channel;
+  std::string input;        // Bytes not yet parsed
+  std::string output;       // Bytes not yet written
+  std::string message;      // Fragments of the current message
+  bool messageText = false;
+};
+
+static std::vector<Connection> connections;
+static volatile sig_atomic_t stopRequested = 0;
+static std::chrono::steady_clock::time_point startTime;
+static uint64_t bytesOut = 0;
+
+static uint64_t nowMicros() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - startTime).count();
+}
+
+static void queueFrame(Connection& c, uint8_t opcode, const std::string& payload) {
+  std::string frame;
+  frame += (char)(0x80 | opcode);
+  if (payload.size() < 126) {
+    frame += (char)payload.size();
+  } else if (payload.size() < 65536) {
+    frame += (char)126;
+    frame += (char)(payload.size() >> 8);
+    frame += (char)payload.size();
+  } else {
+    frame += (char)127;
+    for (int i = 7; i >= 0; i--) frame += (char)((uint64_t)payload.size() >> (i * 8));
+  }
+  c.output += frame + payload;
+}
+
+// "%41b+c" -> "Ab c"
+static std::string urlDecode(const std::string& text) {
+  std::string out;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '+') {
+      out += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size()) {
+      out += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += text[i];
+    }
+  }
+  return out;
+}
+
+// Header value from an HTTP request ("" if absent; names compare case-insensitively)
+static std::string header(const std::string& request, const char* name) {
+  std::istringstream in(request);
+  std::string line;
+  size_t length = strlen(name);
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.size() > length && line[length] == ':' && strncasecmp(line.c_str(), name, length) == 0) {
+      size_t start = line.find_first_not_of(' ', length + 1);
+      return start == std::string::npos ? "" : line.substr(start);
+    }
+  }
+  return "";
+}
+
+static void reject(Connection& c, const char* status) {
+  c.output += std::string("HTTP/1.1 ") + status + "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+  c.closing = true;
+}
+
+// The upgrade request is complete in c.input: answer it and join the repeater
+static void upgrade(Connection& c, size_t requestEnd, LocalRepeater& repeater) {
+  std::string request = c.input.substr(0, requestEnd);
+  c.input.erase(0, requestEnd + 4);
+
+  std::string path;
+  std::istringstream(request.substr(0, request.find('\r'))) >> path >> path;  // "GET PATH HTTP/1.1"
+  std::string key = header(request, "Sec-WebSocket-Key");
+  std::string protocols = header(request, "Sec-WebSocket-Protocol");
+  if (path.compare(0, 5, "/chat") != 0 || key.empty()) {
+    reject(c, "404 Not Found");
+    return;
+  }
+  if (!protocols.empty() && protocols.find(WS_PROTOCOL) == std::string::npos) {
+    reject(c, "400 Bad Request");  // Only the JSON protocol is spoken
+    return;
+  }
+
+  c.channel = "General";
+  size_t query = path.find("repeater=");
+  if (query != std::string::npos) {
+    std::string name = path.substr(query + 9);
+    name = urlDecode(name.substr(0, name.find('&')));
+    if (!name.empty()) c.channel = name;
+  }
+
+  c.output += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+              "Sec-WebSocket-Accept: " + base64(sha1(key + WS_GUID)) + "\r\n";
+  if (!protocols.empty()) c.output += "Sec-WebSocket-Protocol: " WS_PROTOCOL "\r\n";
+  c.output += "\r\n";
+  c.upgraded = true;
+  c.member = repeater.join(c.channel, nowMicros());
+  fprintf(stderr, "vail_server: %s joined %s (%zu clients)\n", c.peer.c_str(), c.channel.c_str(),
+          repeater.clients(c.channel));
+}
+
+// Parse whole frames out of c.input; false when the connection should close
+static bool readFrames(Connection& c, LocalRepeater& repeater) {
+  while (c.input.size() >= 2) {
+    const uint8_t* p = (const uint8_t*)c.input.data();
+    bool fin = p[0] & 0x80;
+    uint8_t opcode = p[0] & 0x0F;
+    bool masked = p[1] & 0x80;
+    uint64_t length = p[1] & 0x7F;
+    size_t header = 2;
+    if (length == 126) {
+      if (c.input.size() < 4) return true;
+      length = (p[2] << 8) | p[3];
+      header = 4;
+    } else if (length == 127) {
+      if (c.input.size() < 10) return true;
+      length = 0;
+      for (int i = 0; i < 8; i++) length = (length << 8) | p[2 + i];
+      header = 10;
+    }
+    if (!masked || length > SERVER_MAX_MESSAGE) return false;  // Clients must mask (RFC 6455 5.1)
+    if (c.input.size() < header + 4 + length) return true;
+
+    const uint8_t* mask = p + header;
+    std::string payload(c.input, header + 4, length);
+    for (size_t i = 0; i < payload.size(); i++) payload[i] ^= mask[i % 4];
+    c.input.erase(0, header + 4 + length);
+
+    if (opcode == 0x8) {  // Close: echo it and hang up
+      queueFrame(c, 0x8, payload.substr(0, 2));
+      c.closing = true;
+      return true;
+    } else if (opcode == 0x9) {
+      queueFrame(c, 0xA, payload);
+    } else if (opcode == 0x1 || opcode == 0x2 || opcode == 0x0) {
+      if (opcode != 0x0) {
+        c.message.clear();
+        c.messageText = (opcode == 0x1);
+      }
+      c.message += payload;
+      if (c.message.size() > SERVER_MAX_MESSAGE) return false;
+      if (fin) {
+        if (c.messageText) {
+          repeater.receive(c.member, c.message, nowMicros());
+        } else {
+          repeater.stats.rejected++;  // Binary protocol not supported
+        }
+        c.message.clear();
+      }
+    }
+  }
+  return true;
+}
+
+static void printStats(const LocalRepeater& repeater) {
+  const RepeaterStats& s = repeater.stats;
+  size_t open = 0;
+  for (const Connection& c : connections) open += c.upgraded;
+  fprintf(stderr, "vail_server: %.0f s, %zu connected, %llu received, %llu rejected, %llu delivered, "
+          "%llu lost, %llu to simulated, %zu in flight (peak %zu), %llu bytes out\n",
+          nowMicros() / 1e6, open, (unsigned long long)s.received, (unsigned long long)s.rejected,
+          (unsigned long long)s.delivered, (unsigned long long)s.lost, (unsigned long long)s.simulated,
+          repeater.framesInFlight(), s.peakInFlight, (unsigned long long)bytesOut);
+}
+
+// ============================================
+// Main
+// ============================================
+
+struct ScriptLine {
+  uint64_t atMicros;
+  std::vector<uint16_t> durations;
+};
+
+static void usage() {
+  fprintf(stderr, "usage: vail_server [--port N] [--delay MS] [--jitter MS] [--loss PCT] [--seed N]\n"
+                  "                   [--channel NAME] [--listeners N] [--sender PERIOD_MS:D1,D2,...]\n"
+                  "                   [--script FILE] [--stats S]\n");
+}
+
+static void onSignal(int) { stopRequested = 1; }
+
+int main(int argc, char** argv) {
+  int port = 8080;
+  uint32_t seed = 1;
+  int listeners = 0;
+  double statsSeconds = 10;
+  std::string channel = "General";
+  std::string scriptPath;
+  RepeaterLink link;
+  std::vector<std::pair<uint32_t, std::vector<uint16_t>>> senders;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) { usage(); return 2; }
+    i++;
+    if (arg == "--port") port = atoi(value);
+    else if (arg == "--delay") link.delayMs = (uint32_t)atoi(value);
+    else if (arg == "--jitter") link.jitterMs = (uint32_t)atoi(value);
+    else if (arg == "--loss") link.loss = atof(value) / 100.0;
+    else if (arg == "--seed") seed = (uint32_t)strtoul(value, nullptr, 10);
+    else if (arg == "--channel") channel = value;
+    else if (arg == "--listeners") listeners = atoi(value);
+    else if (arg == "--script") scriptPath = value;
+    else if (arg == "--stats") statsSeconds = atof(value);
+    else if (arg == "--sender") {
+      std::string spec = value;
+      size_t colon = spec.find(':');
+      std::vector<uint16_t> durations;
+      if (colon == std::string::npos || atoi(spec.c_str()) <= 0 || !parseDurationList(spec.substr(colon + 1), durations)) {
+        fprintf(stderr, "vail_server: bad --sender \"%s\" (PERIOD_MS:D1,D2,...)\n", value);
+        return 2;
+      }
+      senders.push_back({(uint32_t)atoi(spec.c_str()), durations});
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  std::vector<ScriptLine> script;
+  if (!scriptPath.empty()) {
+    std::ifstream file(scriptPath);
+    if (!file) {
+      fprintf(stderr, "vail_server: cannot read %s\n", scriptPath.c_str());
+      return 1;
+    }
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+      lineNo++;
+      line = line.substr(0, line.find('#'));
+      std::istringstream in(line);
+      unsigned long long at;
+      std::string list;
+      if (!(in >> at)) continue;
+      ScriptLine entry = {at * 1000, {}};
+      if (!(in >> list) || !parseDurationList(list, entry.durations)) {
+        fprintf(stderr, "%s:%d: expected \"T_MS D1,D2,...\"\n", scriptPath.c_str(), lineNo);
+        return 2;
+      }
+      script.push_back(entry);
+    }
+  }
+
+  int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 16) != 0) {
+    fprintf(stderr, "vail_server: cannot listen on port %d: %s\n", port, strerror(errno));
+    return 1;
+  }
+  fcntl(listenFd, F_SETFL, O_NONBLOCK);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  startTime = std::chrono::steady_clock::now();
+  int64_t epochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  LocalRepeater repeater(epochMs, seed);
+  repeater.link = link;
+  for (int i = 0; i < listeners; i++) repeater.join(channel, 0, true);
+  for (const auto& [period, durations] : senders) repeater.addSender(channel, period, durations, (uint64_t)period * 1000, 0);
+  int scriptMember = script.empty() ? -1 : repeater.join(channel, 0, true);
+  size_t scriptNext = 0;
+
+  fprintf(stderr, "vail_server: ws://0.0.0.0:%d/chat?repeater=NAME, delay %u ms, jitter %u ms, loss %.1f%%, "
+          "%d listener(s), %zu sender(s) on %s\n", port, link.delayMs, link.jitterMs, link.loss * 100,
+          listeners, senders.size(), channel.c_str());
+
+  uint64_t nextStats = (uint64_t)(statsSeconds * 1e6);
+  auto deliver = [](int member, const std::string& frame) {
+    for (Connection& c : connections) {
+      if (c.member == member && c.upgraded && !c.closing) queueFrame(c, 0x1, frame);
+    }
+  };
+
+  while (!stopRequested) {
+    uint64_t now = nowMicros();
+    while (scriptNext < script.size() && script[scriptNext].atMicros <= now) {
+      repeater.send(scriptMember, repeater.serverMillis(script[scriptNext].atMicros), script[scriptNext].durations, now);
+      scriptNext++;
+    }
+    repeater.poll(now, deliver);
+    if (statsSeconds > 0 && now >= nextStats) {
+      printStats(repeater);
+      nextStats += (uint64_t)(statsSeconds * 1e6);
+    }
+
+    // Sleep until a socket is ready or the next frame, sender or stats line is due
+    uint64_t wake = repeater.nextDue();
+    if (scriptNext < script.size()) wake = std::min(wake, script[scriptNext].atMicros);
+    if (statsSeconds > 0) wake = std::min(wake, nextStats);
+    int timeoutMs = wake == UINT64_MAX ? 1000 : (int)std::min<uint64_t>((wake > now ? wake - now : 0) / 1000 + 1, 1000);
+
+    std::vector<pollfd> fds = {{listenFd, POLLIN, 0}};
+    for (const Connection& c : connections) {
+      fds.push_back({c.fd, (short)(POLLIN | (c.output.empty() ? 0 : POLLOUT)), 0});
+    }
+    if (poll(fds.data(), fds.size(), timeoutMs) < 0) continue;  // EINTR on Ctrl-C
+
+    if (fds[0].revents & POLLIN) {
+      sockaddr_in peer;
+      socklen_t size = sizeof(peer);
+      int fd = accept(listenFd, (sockaddr*)&peer, &size);
+      if (fd >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));  // Elements are small and timed
+        char name[64];
+        snprintf(name, sizeof(name), "%s:%d", inet_ntoa(peer.sin_addr), ntohs(peer.sin_port));
+        connections.push_back({fd, name});
+      }
+    }
+
+    // Connections accepted above have no pollfd yet (nothing to read)
+    std::vector<bool> dropped(connections.size(), false);
+    for (size_t i = 0; i < connections.size(); i++) {
+      Connection& c = connections[i];
+      short events = i + 1 < fds.size() ? fds[i + 1].revents : 0;
+      bool drop = (events & (POLLERR | POLLHUP)) != 0;
+
+      if (!drop && (events & POLLIN)) {
+        char buffer[4096];
+        ssize_t n = read(c.fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+          drop = true;
+        } else {
+          c.input.append(buffer, n);
+          if (!c.upgraded && !c.closing) {
+            size_t end = c.input.find("\r\n\r\n");
+            if (end != std::string::npos) upgrade(c, end, repeater);
+            else if (c.input.size() > SERVER_MAX_REQUEST) drop = true;
+          }
+          if (c.upgraded && !c.closing && !readFrames(c, repeater)) drop = true;
+        }
+      }
+
+      if (!drop && !c.output.empty()) {
+        ssize_t n = write(c.fd, c.output.data(), c.output.size());
+        if (n > 0) {
+          c.output.erase(0, n);
+          bytesOut += n;
+        } else if (n < 0 && errno != EAGAIN) {
+          drop = true;
+        }
+        if (c.output.size() > SERVER_MAX_OUTPUT) {
+          fprintf(stderr, "vail_server: %s is not reading, dropped\n", c.peer.c_str());
+          drop = true;
+        }
+      }
+      if (c.closing && c.output.empty()) drop = true;
+
+      if (drop) {
+        if (c.upgraded) {
+          repeater.leave(c.member, nowMicros());
+          fprintf(stderr, "vail_server: %s left %s\n", c.peer.c_str(), c.channel.c_str());
+        }
+        close(c.fd);
+        dropped[i] = true;
+      }
+    }
+    for (size_t i = connections.size(); i-- > 0;) {
+      if (dropped[i]) connections.erase(connections.begin() + i);
+    }
+  }
+
+  printStats(repeater);
+  for (const Connection& c : connections) close(c.fd);
+  close(listenFd);
+  return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Microbenchmarks
+ * Firmware hot paths timed in place: serial "bench" on the device,
+ * host/tools/bench.cpp on a workstation (same code, same output)
+ *
+ * Each benchmark runs in batches of N operations, N doubled until a batch
+ * takes BENCH_BATCH_MS; the best of BENCH_BATCHES batches is reported as
+ * ns/op and CPU cycles/op (CCOUNT). Allocations/op come from the heap hooks
+ * (CONFIG_HEAP_USE_HOOKS; "n/a" on builds without them). The CPU runs at
+ * BENCH_CPU_MHZ whatever power profile is active (menus run at 80 MHz), and
+ * the profile's clock is put back afterwards. Output is CSV, so results
+ * from two builds can be compared line by line.
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <Adafruit_ST7789.h>
+#include <esp_cpu.h>
+#include <esp_pm.h>
+#include "config.h"
+#include "i2s_audio.h"
+#include "morse_code.h"
+#include "training_practice.h"
+#include "vail_repeater.h"
+
+struct Benchmark {
+  const char* name;
+  bool display;                  // Draws on the screen
+  void (*run)(uint32_t count);   // Runs the operation count times
+};
+
+esp_pm_lock_handle_t benchPmLock = nullptr;
+Adafruit_ST7789* benchDisplay = nullptr;  // Target of the display benchmarks
+volatile uint32_t benchSink = 0;       // Results land here so the work is not optimized away
+volatile uint32_t benchAllocations = 0;
+volatile bool benchCounting = false;
+int benchCore = -1;
+
+// Keep a result alive so the compiler cannot drop the work
+inline void benchKeep(uint32_t value) { benchSink = benchSink + value; }
+
+// Forward declarations
+int runBenchmarks(const char* filter, Adafruit_ST7789* display);
+
+// Heap hooks (called for every allocation when the core has CONFIG_HEAP_USE_HOOKS)
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+  if (benchCounting && xPortGetCoreID() == benchCore) benchAllocations = benchAllocations + 1;
+}
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {}
+
+// ============================================
+// Benchmarked operations
+// ============================================
+
+const char benchText[] = "CQ CQ DE W1AW W1AW K 5NN TU 73";
+const char benchVailJson[] = "{\"Timestamp\":1700000012345,\"Clients\":3,\"Duration\":[60,60,180,60,60,60,180,180,60]}";
+
+// One I2S block of the practice/Vail sidetone (continueTone() without the DMA write)
+void benchToneBlock(uint32_t count) {
+  int16_t buffer[I2S_BUFFER_SIZE];
+  float savedPhase = phase;
+  for (uint32_t i = 0; i < count; i++) {
+    fillToneBlock(buffer, I2S_BUFFER_SIZE / 2, cwTone);
+    benchKeep(buffer[7]);
+  }
+  phase = savedPhase;
+}
+
+// One character to its pattern
+void benchMorseLookup(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    const char* pattern = getMorseCode(benchText[i % (sizeof(benchText) - 1)]);
+    benchKeep(pattern ? pattern[0] : 0);
+  }
+}
+
+// A whole phrase to element durations (tone, gap, tone, ...) as Vail sends them
+void benchMorseEncode(uint32_t count) {
+  MorseTiming timing(cwSpeed);
+  for (uint32_t i = 0; i < count; i++) {
+    std::vector<uint16_t> durations;
+    for (const char* c = benchText; *c; c++) {
+      const char* pattern = getMorseCode(*c);
+      if (pattern == nullptr) continue;
+      for (const char* e = pattern; *e; e++) {
+        durations.push_back(*e == '-' ? timing.dahDuration : timing.ditDuration);
+        durations.push_back(e[1] ? timing.elementGap : timing.letterGap);
+      }
+    }
+    benchKeep(durations.size());
+  }
+}
+
+#if VAIL_ENABLED
+void benchVailParse(uint32_t count) {
+  String json = benchVailJson;
+  VailMessage msg;
+  for (uint32_t i = 0; i < count; i++) {
+    parseVailMessage(json, msg);
+    benchKeep(msg.durations.size());
+  }
+}
+
+void benchVailSerialize(uint32_t count) {
+  std::vector<uint16_t> durations = {60, 60, 180, 60, 60, 60, 180, 180, 60};
+  for (uint32_t i = 0; i < count; i++) {
+    String json = buildVailMessage(durations, 1700000012345LL + i);
+    benchKeep(json.length());
+  }
+}
+#endif
+
+// Keyer state is saved and restored around the keyer benchmarks
+struct BenchKeyerState {
+  bool ditPressed, dahPressed, keyerActive, sendingDit, sendingDah, inSpacing, ditMemory, dahMemory;
+  unsigned long elementStartTime;
+  int ditDuration;
+};
+
+BenchKeyerState saveKeyerState() {
+  return {ditPressed, dahPressed, keyerActive, sendingDit, sendingDah, inSpacing, ditMemory, dahMemory,
+          elementStartTime, ditDuration};
+}
+
+void restoreKeyerState(const BenchKeyerState &s) {
+  ditPressed = s.ditPressed; dahPressed = s.dahPressed; keyerActive = s.keyerActive;
+  sendingDit = s.sendingDit; sendingDah = s.sendingDah; inSpacing = s.inSpacing;
+  ditMemory = s.ditMemory; dahMemory = s.dahMemory;
+  elementStartTime = s.elementStartTime; ditDuration = s.ditDuration;
+}
+
+// Keyer pass with the paddles released (what every practice loop pass costs when idle)
+void benchKeyerIdle(uint32_t count) {
+  BenchKeyerState saved = saveKeyerState();
+  ditPressed = dahPressed = false;
+  keyerActive = inSpacing = ditMemory = dahMemory = false;
+  for (uint32_t i = 0; i < count; i++) {
+    iambicKeyerHandler();
+  }
+  restoreKeyerState(saved);
+}
+
+// Keyer pass in the inter-element gap with a squeeze (paddle memory); no audio
+void benchKeyerSpacing(uint32_t count) {
+  BenchKeyerState saved = saveKeyerState();
+  ditPressed = dahPressed = true;
+  keyerActive = false;
+  inSpacing = true;
+  ditDuration = DIT_DURATION(cwSpeed);
+  for (uint32_t i = 0; i < count; i++) {
+    elementStartTime = millis();  // The gap never ends, so no tone starts
+    ditMemory = dahMemory = false;
+    iambicKeyerHandler();
+    benchKeep(ditMemory);
+  }
+  restoreKeyerState(saved);
+}
+
+// Display primitives (the screen is redrawn afterwards)
+void benchFillRect(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    benchDisplay->fillRect(20, 200, 32, 32, (i & 1) ? 0x1082 : 0x34BF);
+  }
+}
+
+void benchCard(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    benchDisplay->fillRoundRect(20, 200, 280, 30, 8, 0x1082);
+    benchDisplay->drawRoundRect(20, 200, 280, 30, 8, 0x34BF);
+  }
+}
+
+void benchTextLine(uint32_t count) {
+  benchDisplay->setFont();
+  benchDisplay->setTextSize(1);
+  benchDisplay->setTextColor(ST77XX_WHITE, 0x1082);
+  for (uint32_t i = 0; i < count; i++) {
+    benchDisplay->setCursor(30, 210);
+    benchDisplay->print(benchText);
+  }
+}
+
+const Benchmark benchmarks[] = {
+  {"tone_block",     false, benchToneBlock},
+  {"morse_lookup",   false, benchMorseLookup},
+  {"morse_encode",   false, benchMorseEncode},
+#if VAIL_ENABLED
+  {"vail_parse",     false, benchVailParse},
+  {"vail_serialize", false, benchVailSerialize},
+#endif
+  {"keyer_idle",     false, benchKeyerIdle},
+  {"keyer_spacing",  false, benchKeyerSpacing},
+  {"fill_rect_32",   true,  benchFillRect},
+  {"menu_card",      true,  benchCard},
+  {"text_line",      true,  benchTextLine},
+};
+
+// ============================================
+// Runner
+// ============================================
+
+uint32_t benchBatchCycles(const Benchmark &b, uint32_t count) {
+  uint32_t start = esp_cpu_get_cycle_count();
+  b.run(count);
+  return esp_cpu_get_cycle_count() - start;
+}
+
+/*
+ * Run the benchmarks whose name starts with filter ("" = all) and print
+ * one CSV row each; display benchmarks only when given a display. Returns
+ * the number run.
+ */
+int runBenchmarks(const char* filter, Adafruit_ST7789* display) {
+  benchDisplay = display;
+
+  // Fixed clock, so ns/op does not depend on the screen "bench" was typed on
+  esp_pm_config_t savedPm = {};
+  uint32_t savedMhz = getCpuFrequencyMhz();
+  esp_pm_config_t benchPm = {};
+  benchPm.max_freq_mhz = BENCH_CPU_MHZ;
+  benchPm.min_freq_mhz = BENCH_CPU_MHZ;
+  benchPm.light_sleep_enable = false;
+  bool pmConfigured = esp_pm_get_configuration(&savedPm) == ESP_OK && esp_pm_configure(&benchPm) == ESP_OK;
+  if (!pmConfigured) {
+    setCpuFrequencyMhz(BENCH_CPU_MHZ);  // Core without power management
+  }
+  if (benchPmLock == nullptr) {
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "bench", &benchPmLock);
+  }
+  esp_pm_lock_acquire(benchPmLock);
+  benchCore = xPortGetCoreID();
+
+  // Are allocations visible to the hooks on this build?
+  benchAllocations = 0;
+  benchCounting = true;
+  char* volatile probe = new char[32];
+  delete[] probe;
+  benchCounting = false;
+  bool countAllocations = benchAllocations > 0;
+
+  uint32_t mhz = getCpuFrequencyMhz();
+  uint32_t targetCycles = BENCH_BATCH_MS * mhz * 1000;
+  Serial.printf("# Vail Summit benchmarks: %lu MHz, allocation counting %s\n",
+                (unsigned long)mhz, countAllocations ? "on" : "off");
+  Serial.println("benchmark,iterations,ns_per_op,cycles_per_op,allocs_per_op,cpu_mhz");
+
+  int ran = 0;
+  for (const Benchmark &b : benchmarks) {
+    if (strncmp(b.name, filter, strlen(filter)) != 0) continue;
+    if (b.display && display == nullptr) continue;
+
+    // Size the batch, then keep the best of several
+    uint32_t count = 1;
+    uint32_t cycles = benchBatchCycles(b, count);
+    while (cycles < targetCycles && count < (1u << 24)) {
+      count *= 2;
+      cycles = benchBatchCycles(b, count);
+    }
+    uint32_t best = cycles;
+    for (int i = 1; i < BENCH_BATCHES; i++) {
+      cycles = benchBatchCycles(b, count);
+      if (cycles < best) best = cycles;
+    }
+
+    char allocs[16] = "n/a";
+    if (countAllocations) {
+      benchAllocations = 0;
+      benchCounting = true;
+      b.run(count);
+      benchCounting = false;
+      snprintf(allocs, sizeof(allocs), "%.2f", (double)benchAllocations / count);
+    }
+
+    double cyclesPerOp = (double)best / count;
+    Serial.printf("%s,%lu,%.1f,%.1f,%s,%lu\n", b.name, (unsigned long)count,
+                  cyclesPerOp * 1000.0 / mhz, cyclesPerOp, allocs, (unsigned long)mhz);
+    ran++;
+    delay(1);  // Let other tasks in between benchmarks
+  }
+
+  esp_pm_lock_release(benchPmLock);
+  if (pmConfigured) {
+    esp_pm_configure(&savedPm);
+  } else {
+    setCpuFrequencyMhz(savedMhz);
+  }
+  return ran;
+}
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,77 @@
+/*
+ * Boot Timing
+ * Records how long each boot phase takes, foreground and background
+ *
+ * Times are micros() since the app started (the ROM/second-stage bootloader
+ * runs before that and is not included). The breakdown is printed once the
+ * background bring-up finishes and again with the "boot" serial command.
+ */
+
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <freertos/FreeRTOS.h>
+
+#define BOOT_MAX_PHASES 12
+
+struct BootPhase {
+  const char* name;
+  uint32_t startMicros;
+  uint32_t endMicros;
+  bool background;       // Ran in the boot background task
+  bool done;
+};
+
+BootPhase bootPhases[BOOT_MAX_PHASES];
+int bootPhaseCount = 0;
+uint32_t bootMenuMicros = 0;        // Menu on screen and backlight on
+uint32_t bootBackgroundMicros = 0;  // Background bring-up finished
+volatile bool bootBackgroundDone = false;
+portMUX_TYPE bootTimingMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Start a phase; returns its slot for bootPhaseEnd() (-1 if the table is full)
+int bootPhaseBegin(const char* name, bool background) {
+  uint32_t now = micros();
+  int index = -1;
+  portENTER_CRITICAL(&bootTimingMux);
+  if (bootPhaseCount < BOOT_MAX_PHASES) {
+    index = bootPhaseCount++;
+    bootPhases[index] = {name, now, 0, background, false};
+  }
+  portEXIT_CRITICAL(&bootTimingMux);
+  return index;
+}
+
+void bootPhaseEnd(int index) {
+  if (index < 0) return;
+  bootPhases[index].endMicros = micros();
+  bootPhases[index].done = true;
+}
+
+/*
+ * Print the phase breakdown (ms from app start)
+ */
+void printBootTiming() {
+  Serial.println("Boot timing (ms since app start):");
+  Serial.println("  phase          start    end   took  task");
+  for (int i = 0; i < bootPhaseCount; i++) {
+    const BootPhase &p = bootPhases[i];
+    if (!p.done) {
+      Serial.printf("  %-12s %7.1f      -      -  %s\n", p.name, p.startMicros / 1000.0,
+                    p.background ? "background" : "setup");
+    } else {
+      Serial.printf("  %-12s %7.1f %6.1f %6.1f  %s\n", p.name,
+                    p.startMicros / 1000.0, p.endMicros / 1000.0,
+                    (p.endMicros - p.startMicros) / 1000.0,
+                    p.background ? "background" : "setup");
+    }
+  }
+  Serial.printf("  Time to menu: %.1f ms\n", bootMenuMicros / 1000.0);
+  if (bootBackgroundDone) {
+    Serial.printf("  Background bring-up done: %.1f ms\n", bootBackgroundMicros / 1000.0);
+  } else {
+    Serial.println("  Background bring-up still running");
+  }
+}
+
+#endif // BOOT_TIMING_H
@@ -27,6 +27,7 @@
 #define CARDKB_ADDR 0x5F  // I2C Address
 #define I2C_SDA     3     // I2C Data (STEMMA QT)
 #define I2C_SCL     4     // I2C Clock (STEMMA QT)
+#define I2C_CLOCK_HZ 400000  // Bus clock (100 kHz if an LC709203F is fitted)
 
 // CardKB Special Key Codes
 #define KEY_UP      0xB5  // Up arrow
@@ -93,6 +94,15 @@
 // Battery voltage thresholds (for LiPo)
 #define VBAT_FULL   4.2   // Fully charged voltage
 #define VBAT_EMPTY  3.3   // Empty voltage (cutoff)
+#define BATTERY_CAPACITY_MAH 350  // Charge rate (%/hr) to mA
+
+// Fuel gauge sampling (background task, see fuel_gauge.h)
+#define FUEL_GAUGE_SAMPLE_MS     5000   // Gauge read interval
+#define FUEL_GAUGE_FILTER        0.3f   // Low-pass weight of each new reading
+#define FUEL_GAUGE_TREND_SAMPLES 12     // Voltage trend window (12 x 5 s = 1 minute)
+#define FUEL_GAUGE_TREND_V       0.015f // Rise/fall over the window that means charging/discharging
+#define FUEL_GAUGE_STEP_V        0.06f  // Voltage step that means the charger was plugged in/pulled
+#define FUEL_GAUGE_CHARGE_RATE   1.0f   // MAX17048 CRATE (%/hr) that means charging/discharging
 
 // ============================================
 // Morse Code Timing Settings
@@ -110,6 +120,97 @@
 // ============================================
 #define SERIAL_BAUD 115200
 #define DEBUG_ENABLED true
+#define SERIAL_WAIT_MS  1500  // Debug builds wait this long for a serial monitor
+
+// Display instrumentation (pixel/SPI/time counters per screen, see display_stats.h)
+#define DISPLAY_STATS_ENABLED 1
+
+// Trace log (deferred logging on keying/audio/Vail paths, see trace.h)
+#define TRACE_ENABLED         1     // 0 compiles trace points out (release builds)
+#define TRACE_RING_SIZE       256   // Records held between drains (power of two)
+#define TRACE_DRAIN_MS        20    // Drain task period
+
+// Span tracing (timeline of loop phases, draws and I2S writes, see span_trace.h)
+#define SPAN_TRACE_ENABLED    1     // 0 compiles spans out
+#define SPAN_RING_SIZE        1024  // Last spans kept (power of two, 20 bytes each)
+
+// Runtime diagnostics (CPU/heap/stack per subsystem, see runtime_stats.h)
+#define RUNTIME_STATS_ENABLED 1     // 0 compiles subsystem scopes out (task/heap figures remain)
+
+// ============================================
+// Event Loop / Power (see event_loop.h)
+// ============================================
+#define LIGHT_SLEEP_ENABLED   1     // Automatic light sleep between events (needs esp_pm support)
+#define CPU_FREQ_MAX_MHZ      240   // During boot; power_profile.h sets it per mode after
+#define CPU_FREQ_MIN_MHZ      80    // Frequency floor while idle
+#define KEY_POLL_MS           10    // CardKB poll interval (I2C manager task, see i2c_bus.h)
+#define KEY_POLL_PRACTICE_MS  50    // Slower CardKB polling during practice
+#define STATUS_UPDATE_MS      5000  // Battery/WiFi status refresh
+
+#define POWER_SETTLE_MS       60000 // Gauge rate counts toward a power profile/energy state this long after switching
+
+// Energy profiler (see energy_profiler.h)
+#define ENERGY_STATE_SLOTS    24      // Mode/WiFi/audio combinations kept
+#define ENERGY_DELTA_MIN_MS   120000  // Shortest stay whose percent drop is booked
+#define ENERGY_STRETCH_MS     600000  // Long stays are booked in pieces this long
+#define ENERGY_SAVE_MS        900000  // Table written to NVS at most this often
+#define ENERGY_SESSION_MIN_S  600     // Runtime uses this session's pattern once it is this long
+
+#define SETTINGS_FLUSH_DELAY_MS  2000  // Settings are written once unchanged this long (settings_store.h)
+
+// ============================================
+// WiFi Connection (see settings_wifi.h)
+// ============================================
+#define WIFI_CONNECT_TIMEOUT_MS  10000  // Give up on a connection attempt after this long
+#define WIFI_CONNECT_ATTEMPTS    3      // Association attempts before reporting failure
+#define WIFI_PROGRESS_MS         250    // Progress redraw / timeout check while connecting
+#define WIFI_MAX_SAVED_NETWORKS  5      // Credential store slots (least recently used is replaced)
+#define WIFI_FAST_CONNECT_MS     3000   // Cached channel/BSSID (and static IP) attempt before a full connect
+#define WIFI_LEASE_REUSE_S       3600   // Reuse a DHCP address statically for this long after it was handed out
+#define WIFI_PASSIVE_SCAN_MS     120    // Per-channel dwell when choosing among saved networks
+#define WIFI_SCAN_CHANNELS       13     // WiFi Setup scans channels 1..13 one at a time
+#define WIFI_SCAN_CHANNEL_MS     120    // Active dwell per channel
+#define WIFI_SCAN_MAX_RESULTS    20     // Scan result table size (weakest dropped when full)
+
+// ============================================
+// Vail Repeater Server (see vail_repeater.h)
+// ============================================
+#define VAIL_SERVER_HOST         "vail.woozle.org"
+#define VAIL_SERVER_PORT         443
+#define VAIL_SERVER_TLS          1      // 0 = plain ws:// (a LAN test repeater, host/tools/vail_server)
+
+// Link quality and playout delay (see vail_link.h)
+#define VAIL_TX_PENDING          16     // Sent messages awaiting their echo
+#define VAIL_PROBE_INTERVAL_MS   2000   // Marker frame period while probing
+#define VAIL_PROBE_TIMEOUT_MS    5000   // A send not echoed by then is lost
+#define VAIL_LINK_AGE_WINDOW     16     // Received messages the playout target looks back over
+#define VAIL_LINK_REDRAW_MS      1000   // Link card refresh (between tones)
+#define VAIL_PLAYOUT_FIXED_MS    500    // Playout delay with auto off, and where auto starts
+#define VAIL_PLAYOUT_AUTO        1      // Tune the playout delay (0 = fixed; A toggles)
+#define VAIL_PLAYOUT_MIN_MS      150
+#define VAIL_PLAYOUT_MAX_MS      2000
+#define VAIL_PLAYOUT_MARGIN_MS   60     // Above the second-highest recent age
+#define VAIL_PLAYOUT_STEP_MS     20     // Lowered by at most this ...
+#define VAIL_PLAYOUT_SETTLE_MS   5000   // ... per this long with nothing queued
+
+// Session capture on LittleFS (see vail_capture.h)
+#define VAIL_CAPTURE_DIR         "/vail"
+#define VAIL_CAPTURE_BUFFER_BYTES 512   // Records held in RAM between flash writes
+#define VAIL_CAPTURE_FLUSH_MS    5000   // Buffer written (between tones) once its oldest record is this old
+#define VAIL_CAPTURE_MAX_BYTES   262144 // One capture stops growing here
+#define VAIL_REPLAY_MAX_SPEED    20.0f  // Fastest replay ("vailrec play N SPEED")
+
+// ============================================
+// Deep Sleep Resume (see rtc_resume.h)
+// ============================================
+#define SLEEP_RESUME_ENABLED     1      // Paddle wake restores screen, settings and WiFi from RTC memory
+
+// ============================================
+// Benchmarks (see benchmarks.h)
+// ============================================
+#define BENCH_BATCH_MS           20     // Each timed batch runs at least this long
+#define BENCH_BATCHES            5      // Best batch is reported
+#define BENCH_CPU_MHZ            240    // Clock for every run (profiles differ per screen)
 
 // ============================================
 // UI Color Scheme
@@ -127,7 +228,6 @@
 // ============================================
 // Menu Configuration
 // ============================================
-#define MENU_ITEMS      4
 #define MENU_START_Y    55
 #define MENU_ITEM_HEIGHT 35
 #define MENU_TEXT_SIZE  2
@@ -0,0 +1,258 @@
+/*
+ * Display Instrumentation
+ * Counts pixels, SPI transactions and time spent in each screen's draw calls
+ *
+ * InstrumentedST7789 is a drop-in Adafruit_ST7789 that hooks the virtual
+ * drawing primitives. Draw routines mark themselves with DISPLAY_STATS_SCREEN()
+ * so the cost is attributed to the innermost screen currently drawing.
+ */
+
+#ifndef DISPLAY_STATS_H
+#define DISPLAY_STATS_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7789.h>
+#include "config.h"
+#include "span_trace.h"
+#include "subsystem_scope.h"
+
+#define DISPLAY_STATS_MAX_SCREENS 24
+
+// Per-screen totals since the last reset
+struct ScreenDrawStats {
+  const char* name;
+  uint32_t calls;         // Times the screen's draw routine ran
+  uint32_t pixels;        // Pixels written by primitives while it was innermost
+  uint32_t transactions;  // SPI transactions (startWrite/endWrite pairs)
+  uint32_t spiMicros;     // Time inside SPI transactions
+  uint32_t totalMicros;   // Wall time inside the draw routine (inclusive)
+  uint32_t worstMicros;   // Slowest single call
+};
+
+ScreenDrawStats screenStats[DISPLAY_STATS_MAX_SCREENS];
+int screenStatsCount = 0;
+ScreenDrawStats* activeScreenStats = nullptr;
+bool displayStatsOverlay = false;  // Toggled from the serial console
+
+// Last completed top-level draw (shown by the overlay)
+const char* lastDrawName = nullptr;
+uint32_t lastDrawMicros = 0;
+uint32_t lastDrawPixels = 0;
+uint32_t drawFrameCount = 0;  // Completed top-level draws
+
+// Find or create the stats slot for a screen name (names are string literals)
+ScreenDrawStats* getScreenStats(const char* name) {
+  for (int i = 0; i < screenStatsCount; i++) {
+    if (screenStats[i].name == name) {
+      return &screenStats[i];
+    }
+  }
+  if (screenStatsCount >= DISPLAY_STATS_MAX_SCREENS) {
+    return nullptr;
+  }
+  ScreenDrawStats* stats = &screenStats[screenStatsCount++];
+  memset(stats, 0, sizeof(ScreenDrawStats));
+  stats->name = name;
+  return stats;
+}
+
+// Clear all counters (names stay registered)
+void resetDisplayStats() {
+  for (int i = 0; i < screenStatsCount; i++) {
+    const char* name = screenStats[i].name;
+    memset(&screenStats[i], 0, sizeof(ScreenDrawStats));
+    screenStats[i].name = name;
+  }
+}
+
+#if DISPLAY_STATS_ENABLED
+
+// Adafruit_ST7789 with counting hooks on every virtual primitive
+class InstrumentedST7789 : public Adafruit_ST7789 {
+public:
+  InstrumentedST7789(int8_t cs, int8_t dc, int8_t rst)
+    : Adafruit_ST7789(cs, dc, rst) {}
+
+  bool counting = true;  // Off while drawing the overlay itself
+
+  void startWrite(void) override {
+    if (writeDepth++ == 0) {
+      writeStart = micros();
+      if (counting && activeScreenStats) activeScreenStats->transactions++;
+    }
+    Adafruit_ST7789::startWrite();
+  }
+
+  void endWrite(void) override {
+    Adafruit_ST7789::endWrite();
+    if (writeDepth > 0 && --writeDepth == 0) {
+      if (counting && activeScreenStats) activeScreenStats->spiMicros += micros() - writeStart;
+    }
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    countPixels(x, y, 1, 1);
+    Adafruit_ST7789::drawPixel(x, y, color);
+  }
+
+  void writePixel(int16_t x, int16_t y, uint16_t color) override {
+    countPixels(x, y, 1, 1);
+    Adafruit_ST7789::writePixel(x, y, color);
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    countPixels(x, y, w, h);
+    Adafruit_ST7789::fillRect(x, y, w, h, color);
+  }
+
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    countPixels(x, y, w, h);
+    Adafruit_ST7789::writeFillRect(x, y, w, h, color);
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    countPixels(x, y, w, 1);
+    Adafruit_ST7789::drawFastHLine(x, y, w, color);
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    countPixels(x, y, 1, h);
+    Adafruit_ST7789::drawFastVLine(x, y, h, color);
+  }
+
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    countPixels(x, y, w, 1);
+    Adafruit_ST7789::writeFastHLine(x, y, w, color);
+  }
+
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    countPixels(x, y, 1, h);
+    Adafruit_ST7789::writeFastVLine(x, y, h, color);
+  }
+
+private:
+  uint8_t writeDepth = 0;
+  uint32_t writeStart = 0;
+
+  // Count only the on-screen part, like the driver's own clipping
+  void countPixels(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (!counting || !activeScreenStats) return;
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    int32_t x1 = max((int32_t)x, (int32_t)0);
+    int32_t y1 = max((int32_t)y, (int32_t)0);
+    int32_t x2 = min((int32_t)x + w, (int32_t)width());
+    int32_t y2 = min((int32_t)y + h, (int32_t)height());
+    if (x2 > x1 && y2 > y1) {
+      activeScreenStats->pixels += (uint32_t)((x2 - x1) * (y2 - y1));
+    }
+  }
+};
+
+// Marks a draw routine; nested scopes attribute primitives to the innermost one
+class ScreenDrawScope {
+public:
+  ScreenDrawScope(const char* name) {
+    stats = getScreenStats(name);
+    parent = activeScreenStats;
+    pixelsAtStart = stats ? stats->pixels : 0;
+    startMicros = micros();
+    if (stats) activeScreenStats = stats;
+  }
+
+  ~ScreenDrawScope() {
+    if (!stats) return;
+    uint32_t elapsed = micros() - startMicros;
+    stats->calls++;
+    stats->totalMicros += elapsed;
+    if (elapsed > stats->worstMicros) stats->worstMicros = elapsed;
+    activeScreenStats = parent;
+
+    if (parent == nullptr) {
+      lastDrawName = stats->name;
+      lastDrawMicros = elapsed;
+      lastDrawPixels = stats->pixels - pixelsAtStart;
+      drawFrameCount++;
+    }
+  }
+
+private:
+  ScreenDrawStats* stats;
+  ScreenDrawStats* parent;
+  uint32_t pixelsAtStart;
+  uint32_t startMicros;
+};
+
+#define DISPLAY_STATS_CONCAT_(a, b) a##b
+#define DISPLAY_STATS_CONCAT(a, b) DISPLAY_STATS_CONCAT_(a, b)
+#define DISPLAY_STATS_SCREEN(name) \
+  ScreenDrawScope DISPLAY_STATS_CONCAT(screenScope_, __LINE__)(name); SPAN(name); SUBSYSTEM_SCOPE(SUBSYSTEM_UI)
+
+/*
+ * Draw the last frame's cost in the bottom-right corner
+ * The overlay's own pixels are not counted
+ */
+void drawDisplayStatsOverlay(InstrumentedST7789 &display) {
+  if (!displayStatsOverlay || lastDrawName == nullptr) return;
+
+  char text[40];
+  snprintf(text, sizeof(text), "%lums %lupx",
+           (unsigned long)(lastDrawMicros / 1000), (unsigned long)lastDrawPixels);
+
+  display.counting = false;
+  display.setFont();
+  display.setTextSize(1);
+  display.fillRect(SCREEN_WIDTH - 90, SCREEN_HEIGHT - 30, 90, 10, ST77XX_BLACK);
+  display.setTextColor(ST77XX_MAGENTA);
+  display.setCursor(SCREEN_WIDTH - 88, SCREEN_HEIGHT - 29);
+  display.print(text);
+  display.counting = true;
+}
+
+#else  // DISPLAY_STATS_ENABLED == 0
+
+typedef Adafruit_ST7789 InstrumentedST7789;
+#define DISPLAY_STATS_SCREEN(name) SPAN(name); SUBSYSTEM_SCOPE(SUBSYSTEM_UI)
+
+void drawDisplayStatsOverlay(InstrumentedST7789 &display) {
+  // Nothing to do
+}
+
+#endif // DISPLAY_STATS_ENABLED
+
+/*
+ * Dump per-screen draw costs over serial, worst screens first
+ */
+void printDisplayStats() {
+  if (!DISPLAY_STATS_ENABLED) {
+    Serial.println("Display stats disabled (DISPLAY_STATS_ENABLED = 0)");
+    return;
+  }
+
+  // Sort a copy of the indices by total time (small table, insertion sort)
+  int order[DISPLAY_STATS_MAX_SCREENS];
+  for (int i = 0; i < screenStatsCount; i++) {
+    int j = i;
+    while (j > 0 && screenStats[order[j - 1]].totalMicros < screenStats[i].totalMicros) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  Serial.println("screen,calls,pixels,transactions,spi_us,total_us,avg_us,worst_us");
+  for (int k = 0; k < screenStatsCount; k++) {
+    ScreenDrawStats &s = screenStats[order[k]];
+    Serial.printf("%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                  s.name,
+                  (unsigned long)s.calls,
+                  (unsigned long)s.pixels,
+                  (unsigned long)s.transactions,
+                  (unsigned long)s.spiMicros,
+                  (unsigned long)s.totalMicros,
+                  (unsigned long)(s.calls ? s.totalMicros / s.calls : 0),
+                  (unsigned long)s.worstMicros);
+  }
+}
+
+#endif // DISPLAY_STATS_H
@@ -0,0 +1,503 @@
+/*
+ * Energy Profiler
+ * Which screen, radio and audio state drains the battery, and how fast
+ *
+ * loop() calls energyTick() every pass with the current mode. Time is
+ * booked to the state (mode, WiFi off/on/connected, I2S clocks stopped or
+ * running) that held during it; sidetone time is kept inside the state,
+ * since single elements are far shorter than a gauge sample. Two current
+ * estimates are kept per state, both from the fuel gauge while discharging:
+ *  - rate: the charge rate (MAX17048 CRATE, LC709203F voltage trend) of
+ *    each sample taken after the state has held for POWER_SETTLE_MS
+ *  - delta: the drop in percent (and voltage) over stretches of at least
+ *    ENERGY_DELTA_MIN_MS in one state, closed every ENERGY_STRETCH_MS
+ * The rate is used once there are enough samples, the delta otherwise.
+ * Runtime is predicted from the time shares of this session (all-time
+ * shares until the session is ENERGY_SESSION_MIN_S long).
+ *
+ * The table is saved to NVS every ENERGY_SAVE_MS and before deep sleep.
+ * Settings > Energy shows it; the "energy" serial command dumps it as CSV.
+ */
+
+#ifndef ENERGY_PROFILER_H
+#define ENERGY_PROFILER_H
+
+#include <Adafruit_ST7789.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include "config.h"
+#include "display_stats.h"
+#include "fuel_gauge.h"
+#include "i2s_audio.h"
+
+#define ENERGY_VERSION     1
+#define ENERGY_RATE_MIN    6      // Rate samples before the rate estimate is used
+
+enum EnergyWiFi : uint8_t {
+  ENERGY_WIFI_OFF,
+  ENERGY_WIFI_ON,          // Radio on, not connected (scanning, connecting)
+  ENERGY_WIFI_CONNECTED
+};
+
+// One state's totals; persisted as is (only append fields, bump ENERGY_VERSION otherwise)
+struct EnergyState {
+  uint8_t mode;            // MenuMode
+  uint8_t wifi;            // EnergyWiFi
+  uint8_t audio;           // 1 = I2S clocks running
+  uint8_t used;
+  uint32_t seconds;        // Time in the state
+  uint32_t toneSeconds;    // Of which a tone was playing
+  uint32_t rateSamples;
+  float rateMa;            // Sum of the gauge-rate currents
+  uint32_t deltaSeconds;   // Stretches with a usable gauge delta
+  float deltaPercent;      // Charge used over them
+  float deltaVolts;        // Voltage drop over them
+};
+
+struct EnergyBlobHeader {
+  uint8_t version;
+  uint8_t stateSize;       // sizeof(EnergyState) when written
+  uint8_t count;
+  uint8_t reserved;
+};
+
+EnergyState energyStates[ENERGY_STATE_SLOTS];
+uint32_t energySessionSeconds[ENERGY_STATE_SLOTS];  // This boot only
+bool energyLoaded = false;
+bool energyDirty = false;
+unsigned long energySavedAt = 0;
+
+// Current state and what has not been booked yet
+int energySlot = -1;
+unsigned long energyLastTick = 0;
+uint32_t energyPendingMs = 0;
+uint32_t energyPendingToneMs = 0;
+uint16_t energyCarryMs[ENERGY_STATE_SLOTS];      // Pending ms a state had when it was left (this boot)
+uint16_t energyCarryToneMs[ENERGY_STATE_SLOTS];
+bool energyToneOn = false;
+unsigned long energyStateSince = 0;
+uint32_t energyLastGaugeSample = 0;
+
+// Open delta stretch (gauge reading when it started)
+bool energyStretchOpen = false;
+unsigned long energyStretchStart = 0;
+float energyStretchPercent = 0;
+float energyStretchVolts = 0;
+
+// Forward declarations
+void loadEnergyLog();
+void energyTick(uint8_t mode);
+void flushEnergyLog();
+float energyStateMa(const EnergyState &state);
+bool predictRuntime(float &patternMa, float &hours, float &coverage);
+void drawEnergyUI(Adafruit_ST7789 &display);
+int handleEnergyInput(char key, Adafruit_ST7789 &display);
+void printEnergyCSV();
+void resetEnergyLog();
+const char* menuModeName(uint8_t mode);  // Defined with the MenuMode enum
+
+void loadEnergyLog() {
+  if (energyLoaded) return;
+  energyLoaded = true;
+  memset(energyStates, 0, sizeof(energyStates));
+  memset(energySessionSeconds, 0, sizeof(energySessionSeconds));
+  memset(energyCarryMs, 0, sizeof(energyCarryMs));
+  memset(energyCarryToneMs, 0, sizeof(energyCarryToneMs));
+
+  Preferences prefs;
+  prefs.begin("energy", true);
+  size_t length = prefs.getBytesLength("blob");
+  static uint8_t blob[sizeof(EnergyBlobHeader) + sizeof(energyStates)];
+  bool valid = length >= sizeof(EnergyBlobHeader) && length <= sizeof(blob) &&
+               prefs.getBytes("blob", blob, length) == length;
+  prefs.end();
+  if (!valid) return;
+
+  EnergyBlobHeader header;
+  memcpy(&header, blob, sizeof(header));
+  if (header.version != ENERGY_VERSION || header.stateSize != sizeof(EnergyState) ||
+      header.count > ENERGY_STATE_SLOTS ||
+      length != sizeof(header) + header.count * sizeof(EnergyState)) {
+    Serial.println("Energy log: stored table has another layout, starting over");
+    return;
+  }
+  memcpy(energyStates, blob + sizeof(header), header.count * sizeof(EnergyState));
+}
+
+// Write the table (used slots only)
+void flushEnergyLog() {
+  if (!energyLoaded || !energyDirty) return;
+  static uint8_t blob[sizeof(EnergyBlobHeader) + sizeof(energyStates)];
+  EnergyBlobHeader header = {ENERGY_VERSION, (uint8_t)sizeof(EnergyState), 0, 0};
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+    if (!energyStates[i].used || energyStates[i].seconds == 0) continue;  // Passed through only
+    memcpy(blob + sizeof(header) + header.count * sizeof(EnergyState), &energyStates[i], sizeof(EnergyState));
+    header.count++;
+  }
+  memcpy(blob, &header, sizeof(header));
+
+  unsigned long start = micros();
+  Preferences prefs;
+  prefs.begin("energy", false);
+  prefs.putBytes("blob", blob, sizeof(header) + header.count * sizeof(EnergyState));
+  prefs.end();
+  energyDirty = false;
+  energySavedAt = millis();
+  Serial.printf("Energy log saved (%d states, %lu us)\n", header.count, micros() - start);
+}
+
+// Slot for a state, taking over the least-used one when the table is full
+int findEnergySlot(uint8_t mode, uint8_t wifi, uint8_t audio) {
+  int freeSlot = -1;
+  int leastUsed = 0;
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+    const EnergyState &s = energyStates[i];
+    if (!s.used) {
+      if (freeSlot < 0) freeSlot = i;
+      continue;
+    }
+    if (s.mode == mode && s.wifi == wifi && s.audio == audio) return i;
+    if (s.seconds < energyStates[leastUsed].seconds) leastUsed = i;
+  }
+  int slot = (freeSlot >= 0) ? freeSlot : leastUsed;
+  energyStates[slot] = {};
+  energyStates[slot].mode = mode;
+  energyStates[slot].wifi = wifi;
+  energyStates[slot].audio = audio;
+  energyStates[slot].used = 1;
+  energySessionSeconds[slot] = 0;
+  energyCarryMs[slot] = 0;
+  energyCarryToneMs[slot] = 0;
+  return slot;
+}
+
+// Gauge reading usable for accounting (on battery, with a sample)
+bool energyGaugeUsable(const FuelGaugeStatus &gauge) {
+  return hasBatteryMonitor && gauge.valid && !gauge.charging;
+}
+
+/*
+ * Close the open stretch, booking its percent/voltage drop if it was long
+ * enough. The sub-second time not booked yet stays with the state it was
+ * spent in, for openEnergyStretch() to pick up when that state is next open.
+ */
+void closeEnergyStretch(unsigned long now) {
+  if (energySlot >= 0) {
+    energyCarryMs[energySlot] = energyPendingMs;
+    energyCarryToneMs[energySlot] = energyPendingToneMs;
+  }
+  energyPendingMs = 0;
+  energyPendingToneMs = 0;
+
+  if (!energyStretchOpen) return;
+  energyStretchOpen = false;
+  unsigned long elapsed = now - energyStretchStart;
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  if (energySlot < 0 || elapsed < ENERGY_DELTA_MIN_MS || !energyGaugeUsable(gauge)) return;
+
+  float used = energyStretchPercent - gauge.percent;
+  if (used < 0) return;  // Gauge moved up without a charger: no evidence
+  EnergyState &state = energyStates[energySlot];
+  state.deltaSeconds += elapsed / 1000;
+  state.deltaPercent += used;
+  state.deltaVolts += energyStretchVolts - gauge.voltage;
+  energyDirty = true;
+}
+
+void openEnergyStretch(unsigned long now) {
+  energyPendingMs = energyCarryMs[energySlot];
+  energyPendingToneMs = energyCarryToneMs[energySlot];
+
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  energyStretchOpen = energyGaugeUsable(gauge);
+  energyStretchStart = now;
+  energyStretchPercent = gauge.percent;
+  energyStretchVolts = gauge.voltage;
+}
+
+/*
+ * Book the time since the last call and follow state changes and new
+ * gauge samples (every loop pass; cheap)
+ */
+void energyTick(uint8_t mode) {
+  unsigned long now = millis();
+  if (!energyLoaded) {
+    loadEnergyLog();
+    energyLastTick = now;
+    energySavedAt = now;
+  }
+
+  // Time since the last pass belongs to the state seen then
+  uint32_t elapsed = now - energyLastTick;
+  energyLastTick = now;
+  if (energySlot >= 0 && elapsed > 0) {
+    energyPendingMs += elapsed;
+    if (energyToneOn) energyPendingToneMs += elapsed;
+    if (energyPendingMs >= 1000) {
+      uint32_t seconds = energyPendingMs / 1000;
+      energyStates[energySlot].seconds += seconds;
+      energySessionSeconds[energySlot] += seconds;
+      energyPendingMs -= seconds * 1000;
+      uint32_t toneSeconds = min(energyPendingToneMs / 1000, seconds);
+      energyStates[energySlot].toneSeconds += toneSeconds;
+      energyPendingToneMs -= min(energyPendingToneMs, toneSeconds * 1000);
+      energyDirty = true;
+    }
+  }
+  energyToneOn = isTonePlaying();
+
+  uint8_t wifi = ENERGY_WIFI_OFF;
+  if (WiFi.status() == WL_CONNECTED) {
+    wifi = ENERGY_WIFI_CONNECTED;
+  } else if (WiFi.getMode() != WIFI_OFF) {
+    wifi = ENERGY_WIFI_ON;
+  }
+  uint8_t audio = i2s_running ? 1 : 0;
+
+  const EnergyState* current = (energySlot >= 0) ? &energyStates[energySlot] : nullptr;
+  if (current == nullptr || current->mode != mode || current->wifi != wifi || current->audio != audio) {
+    closeEnergyStretch(now);
+    energySlot = findEnergySlot(mode, wifi, audio);
+    energyStateSince = now;
+    openEnergyStretch(now);
+  } else if (!energyStretchOpen || now - energyStretchStart >= ENERGY_STRETCH_MS) {
+    closeEnergyStretch(now);  // Long stay: book it in pieces
+    openEnergyStretch(now);
+  }
+
+  // Each new gauge sample: its rate, once the state has held long enough for the gauge to follow
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  if (gauge.samples != energyLastGaugeSample) {
+    energyLastGaugeSample = gauge.samples;
+    float ma = fuelGaugeCurrentMa(gauge);
+    if (!isnan(ma) && ma > 0 && now - energyStateSince >= POWER_SETTLE_MS) {
+      energyStates[energySlot].rateSamples++;
+      energyStates[energySlot].rateMa += ma;
+      energyDirty = true;
+    }
+  }
+
+  if (energyDirty && now - energySavedAt >= ENERGY_SAVE_MS) {
+    flushEnergyLog();
+  }
+}
+
+// Current estimate for a state (NAN until there is enough data)
+float energyStateMa(const EnergyState &state) {
+  if (state.rateSamples >= ENERGY_RATE_MIN) {
+    return state.rateMa / state.rateSamples;
+  }
+  if (state.deltaSeconds >= ENERGY_DELTA_MIN_MS / 1000) {
+    return state.deltaPercent / 100.0f * BATTERY_CAPACITY_MAH / (state.deltaSeconds / 3600.0f);
+  }
+  return NAN;
+}
+
+/*
+ * Average current of the usage pattern and the runtime it leaves. coverage
+ * is the share of the time whose states have an estimate. False without
+ * enough data.
+ */
+bool predictRuntime(float &patternMa, float &hours, float &coverage) {
+  uint32_t sessionTotal = 0;
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) sessionTotal += energySessionSeconds[i];
+  bool useSession = sessionTotal >= ENERGY_SESSION_MIN_S;
+
+  double weighted = 0;
+  double known = 0;
+  double total = 0;
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+    if (!energyStates[i].used) continue;
+    double seconds = useSession ? energySessionSeconds[i] : energyStates[i].seconds;
+    total += seconds;
+    float ma = energyStateMa(energyStates[i]);
+    if (isnan(ma)) continue;
+    weighted += seconds * ma;
+    known += seconds;
+  }
+  if (known <= 0) return false;
+
+  patternMa = weighted / known;
+  coverage = known / total;
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  float percent = gauge.valid ? gauge.percent : 100.0f;
+  hours = (patternMa > 0) ? percent / 100.0f * BATTERY_CAPACITY_MAH / patternMa : 0;
+  return true;
+}
+
+const char* energyWiFiName(uint8_t wifi) {
+  switch (wifi) {
+    case ENERGY_WIFI_OFF: return "off";
+    case ENERGY_WIFI_ON:  return "on";
+    default:              return "up";
+  }
+}
+
+/*
+ * Settings > Energy: the states with the most time, their share and
+ * current, and the runtime prediction. Redrawn on EVENT_STATUS.
+ */
+void drawEnergyUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawEnergyUI");
+  display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
+
+  int cardX = 20;
+  int cardY = 50;
+  int cardW = SCREEN_WIDTH - 40;
+  int cardH = 136;
+
+  display.fillRoundRect(cardX, cardY, cardW, cardH, 12, 0x1082); // Dark blue fill
+  display.drawRoundRect(cardX, cardY, cardW, cardH, 12, 0x34BF); // Light blue outline
+
+  // Column headings
+  display.setTextSize(1);
+  display.setTextColor(0x7BEF); // Light gray
+  display.setCursor(cardX + 12, cardY + 8);
+  display.print("Screen");
+  display.setCursor(cardX + 110, cardY + 8);
+  display.print("WiFi Audio");
+  display.setCursor(cardX + 185, cardY + 8);
+  display.print("Time");
+  display.setCursor(cardX + 225, cardY + 8);
+  display.print("mA");
+
+  // Most-used states first (selection of the top rows, table order untouched)
+  const int rows = 6;
+  int shown[rows];
+  int shownCount = 0;
+  uint64_t totalSeconds = 0;
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+    if (energyStates[i].used) totalSeconds += energyStates[i].seconds;
+  }
+  for (int row = 0; row < rows; row++) {
+    int best = -1;
+    for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+      if (!energyStates[i].used) continue;
+      bool taken = false;
+      for (int j = 0; j < shownCount; j++) taken |= (shown[j] == i);
+      if (!taken && (best < 0 || energyStates[i].seconds > energyStates[best].seconds)) best = i;
+    }
+    if (best < 0) break;
+    shown[shownCount++] = best;
+  }
+
+  char text[16];
+  for (int row = 0; row < shownCount; row++) {
+    const EnergyState &state = energyStates[shown[row]];
+    int yPos = cardY + 24 + row * 18;
+    bool isCurrent = (shown[row] == energySlot);
+
+    if (isCurrent) {
+      display.fillRoundRect(cardX + 6, yPos - 4, cardW - 12, 16, 5, 0x249F); // Blue highlight
+    }
+    display.setTextColor(isCurrent ? ST77XX_WHITE : ST77XX_CYAN);
+    display.setCursor(cardX + 12, yPos);
+    display.print(menuModeName(state.mode));
+
+    display.setTextColor(ST77XX_WHITE);
+    display.setCursor(cardX + 110, yPos);
+    display.print(energyWiFiName(state.wifi));
+    display.setCursor(cardX + 140, yPos);
+    display.print(state.audio ? "I2S" : "-");
+
+    display.setCursor(cardX + 185, yPos);
+    snprintf(text, sizeof(text), "%d%%", totalSeconds ? (int)((uint64_t)state.seconds * 100 / totalSeconds) : 0);
+    display.print(text);
+
+    display.setCursor(cardX + 225, yPos);
+    float ma = energyStateMa(state);
+    if (isnan(ma)) {
+      display.print("--");
+    } else {
+      display.print((int)(ma + 0.5f));
+    }
+  }
+  if (shownCount == 0) {
+    display.setTextColor(ST77XX_WHITE);
+    display.setCursor(cardX + 12, cardY + 24);
+    display.print("No data yet");
+  }
+
+  // Prediction under the card
+  char line[64];
+  float patternMa, hours, coverage;
+  if (!hasBatteryMonitor) {
+    snprintf(line, sizeof(line), "No battery monitor");
+  } else if (predictRuntime(patternMa, hours, coverage)) {
+    snprintf(line, sizeof(line), "Usage %.0f mA: %.1f h left (%d%% measured)", patternMa, hours, (int)(coverage * 100));
+  } else {
+    snprintf(line, sizeof(line), "Measuring (a few minutes per screen, on battery)");
+  }
+  display.setTextSize(1);
+  display.setTextColor(ST77XX_WHITE);
+  display.setCursor(cardX + 5, cardY + cardH + 8);
+  display.print(line);
+
+  display.setTextColor(COLOR_WARNING);
+  String footerText = "R Reset  ESC Back";
+
+  int16_t x1, y1;
+  uint16_t w, h;
+  display.getTextBounds(footerText, 0, 0, &x1, &y1, &w, &h);
+  int centerX = (SCREEN_WIDTH - w) / 2;
+  display.setCursor(centerX, SCREEN_HEIGHT - 12);
+  display.print(footerText);
+}
+
+// Returns: -1 to exit, 0 to continue
+int handleEnergyInput(char key, Adafruit_ST7789 &display) {
+  if (key == KEY_ESC) {
+    return -1;
+  }
+  if (key == 'r' || key == 'R') {
+    resetEnergyLog();
+    beep(TONE_SELECT, BEEP_SHORT);
+    drawEnergyUI(display);
+  }
+  return 0;
+}
+
+// Serial "energy" command: one CSV row per state, then the prediction
+void printEnergyCSV() {
+  Serial.println("mode,wifi,audio,seconds,session_seconds,tone_seconds,rate_samples,rate_ma,"
+                 "delta_seconds,delta_percent,delta_mv,delta_ma,estimate_ma");
+  for (int i = 0; i < ENERGY_STATE_SLOTS; i++) {
+    const EnergyState &s = energyStates[i];
+    if (!s.used || s.seconds == 0) continue;
+    float rateMa = s.rateSamples ? s.rateMa / s.rateSamples : NAN;
+    float deltaMa = s.deltaSeconds ? s.deltaPercent / 100.0f * BATTERY_CAPACITY_MAH / (s.deltaSeconds / 3600.0f) : NAN;
+    Serial.printf("%s,%s,%s,%lu,%lu,%lu,%lu,%.1f,%lu,%.2f,%.0f,%.1f,%.1f\n", menuModeName(s.mode),
+                  energyWiFiName(s.wifi), s.audio ? "i2s" : "off", (unsigned long)s.seconds,
+                  (unsigned long)energySessionSeconds[i], (unsigned long)s.toneSeconds,
+                  (unsigned long)s.rateSamples, rateMa, (unsigned long)s.deltaSeconds, s.deltaPercent,
+                  s.deltaVolts * 1000, deltaMa, energyStateMa(s));
+  }
+  float patternMa, hours, coverage;
+  if (predictRuntime(patternMa, hours, coverage)) {
+    Serial.printf("# pattern %.1f mA, %.1f h remaining, %.0f%% of the time measured\n",
+                  patternMa, hours, coverage * 100);
+  } else {
+    Serial.println("# no estimate yet");
+  }
+}
+
+// Forget everything, in flash too
+void resetEnergyLog() {
+  memset(energyStates, 0, sizeof(energyStates));
+  memset(energySessionSeconds, 0, sizeof(energySessionSeconds));
+  memset(energyCarryMs, 0, sizeof(energyCarryMs));
+  memset(energyCarryToneMs, 0, sizeof(energyCarryToneMs));
+  energyPendingMs = 0;
+  energyPendingToneMs = 0;
+  energyLoaded = true;
+  energySlot = -1;
+  energyStretchOpen = false;
+  Preferences prefs;
+  prefs.begin("energy", false);
+  prefs.clear();
+  prefs.end();
+  energyDirty = false;
+  Serial.println("Energy log reset");
+}
+
+#endif // ENERGY_PROFILER_H
@@ -0,0 +1,260 @@
+/*
+ * Event Loop
+ * Wakes loop() on events instead of delay()-polling
+ *
+ * Paddle interrupts, keystrokes from the I2C manager (i2c_bus.h), the
+ * status timer and WiFi events post to one FreeRTOS queue. On idle screens loop() blocks on the
+ * queue, so with LIGHT_SLEEP_ENABLED the CPU drops into automatic light
+ * sleep between events. Practice and Vail modes hold a no-sleep lock and
+ * keep a short timeout to service audio, the keyer and the WebSocket.
+ *
+ * Light sleep only wakes on GPIO levels, and a level wakeup also sets the
+ * pin's interrupt type. The paddle pins stay on edge interrupts and are
+ * armed for a level wakeup only while loop() is blocked on an idle screen,
+ * at the level opposite to the one they are at (a held paddle wakes on
+ * release). The first interrupt after arming puts them back on edges, so
+ * a held level cannot retrigger the ISR.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <atomic>
+#include "config.h"
+#include "i2s_audio.h"
+#include "latency_stats.h"
+
+#define EVENT_QUEUE_LENGTH 16
+#define EVENT_WAIT_FOREVER 0xFFFFFFFF
+
+// Event types (data is type-specific)
+enum LoopEventType : uint8_t {
+  EVENT_KEY,        // Keystroke(s) waiting in the key FIFO
+  EVENT_PADDLE,     // Paddle edge (data: pin)
+  EVENT_STATUS,     // Refresh battery/WiFi status
+  EVENT_NETWORK,    // WiFi event (data: arduino_event_id_t)
+  EVENT_BOOT_DONE,  // Background bring-up finished
+  EVENT_TYPE_COUNT
+};
+
+struct LoopEvent {
+  LoopEventType type;
+  uint8_t data;
+};
+
+// Event loop state
+QueueHandle_t eventQueue = nullptr;
+esp_timer_handle_t statusTimer = nullptr;
+esp_pm_lock_handle_t activeModeLock = nullptr;
+bool activeModeLockHeld = false;
+bool lightSleepAvailable = false;
+
+// Coalescing: at most one of these is ever waiting in the queue
+volatile bool keyEventPending = false;
+volatile bool paddlePending = false;
+volatile bool paddleWakeArmed = false;  // Paddle pins on level interrupts for light sleep wakeup
+
+// Statistics (serial "events" command)
+uint32_t eventCounts[EVENT_TYPE_COUNT];
+std::atomic<uint32_t> eventsDropped{0};  // Written by the ISR and by tasks
+uint32_t loopWakeups = 0;
+uint64_t eventWaitMicros = 0;   // Time blocked in waitForEvent()
+uint64_t eventStatsStart = 0;
+
+// Forward declarations
+void startEventLoop();
+bool postEvent(LoopEventType type, uint8_t data);
+bool waitForEvent(LoopEvent &event, uint32_t timeoutMs);
+void setEventLoopActive(bool active);
+void printEventLoopStats();
+
+// Post from task context (timer callbacks, WiFi event task)
+bool postEvent(LoopEventType type, uint8_t data) {
+  LoopEvent event = {type, data};
+  if (eventQueue == nullptr || xQueueSend(eventQueue, &event, 0) != pdPASS) {
+    eventsDropped++;
+    return false;
+  }
+  return true;
+}
+
+// Paddle edge: one pending event is enough, the keyer reads the pins itself
+void IRAM_ATTR onPaddleEdge() {
+  if (paddleWakeArmed) {
+    // Back to edges before leaving the ISR, or the level fires it again at once
+    // (HAL register writes: the driver calls are not in IRAM)
+    paddleWakeArmed = false;
+    gpio_ll_wakeup_disable(&GPIO, DIT_PIN);
+    gpio_ll_wakeup_disable(&GPIO, DAH_PIN);
+    gpio_ll_set_intr_type(&GPIO, DIT_PIN, GPIO_INTR_ANYEDGE);
+    gpio_ll_set_intr_type(&GPIO, DAH_PIN, GPIO_INTR_ANYEDGE);
+  }
+  latencyPaddleEdge();
+  if (paddlePending) return;
+  paddlePending = true;
+  LoopEvent event = {EVENT_PADDLE, 0};
+  BaseType_t woken = pdFALSE;
+  if (xQueueSendFromISR(eventQueue, &event, &woken) != pdPASS) {
+    paddlePending = false;
+    eventsDropped++;
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+void onStatusTimer(void* arg) {
+  postEvent(EVENT_STATUS, 0);
+}
+
+void onWiFiEventForLoop(arduino_event_id_t event) {
+  if (event == ARDUINO_EVENT_WIFI_SCAN_DONE ||
+      event == ARDUINO_EVENT_WIFI_STA_CONNECTED ||
+      event == ARDUINO_EVENT_WIFI_STA_GOT_IP ||
+      event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED ||
+      event == ARDUINO_EVENT_WIFI_STA_LOST_IP) {
+    postEvent(EVENT_NETWORK, (uint8_t)event);
+  }
+}
+
+/*
+ * Create the queue, timers and interrupts (early in setup, before any task posts)
+ */
+void startEventLoop() {
+  eventQueue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(LoopEvent));
+
+  // Paddle edges wake loop() immediately (and wake the CPU from light sleep)
+  attachInterrupt(digitalPinToInterrupt(DIT_PIN), onPaddleEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(DAH_PIN), onPaddleEdge, CHANGE);
+
+  esp_timer_create_args_t statusArgs = {};
+  statusArgs.callback = onStatusTimer;
+  statusArgs.name = "status";
+  esp_timer_create(&statusArgs, &statusTimer);
+  esp_timer_start_periodic(statusTimer, (uint64_t)STATUS_UPDATE_MS * 1000);
+
+  WiFi.onEvent(onWiFiEventForLoop);
+
+  // Held while a mode needs the CPU and peripherals clocked continuously
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "active_mode", &activeModeLock);
+
+#if LIGHT_SLEEP_ENABLED
+  esp_pm_config_t pmConfig = {};
+  pmConfig.max_freq_mhz = CPU_FREQ_MAX_MHZ;
+  pmConfig.min_freq_mhz = CPU_FREQ_MIN_MHZ;
+  pmConfig.light_sleep_enable = true;
+  esp_err_t err = esp_pm_configure(&pmConfig);
+  if (err == ESP_OK) {
+    esp_sleep_enable_gpio_wakeup();  // Pins are armed per wait (armPaddleWakeup)
+    lightSleepAvailable = true;
+    Serial.printf("Automatic light sleep enabled (%d-%d MHz)\n", CPU_FREQ_MIN_MHZ, CPU_FREQ_MAX_MHZ);
+  } else {
+    // Core built without CONFIG_PM_ENABLE / tickless idle: still event-driven, just no sleep
+    Serial.printf("Light sleep not available (esp_pm_configure: %d)\n", err);
+  }
+#endif
+
+  for (int i = 0; i < EVENT_TYPE_COUNT; i++) eventCounts[i] = 0;
+  eventStatsStart = esp_timer_get_time();
+}
+
+// Wake from light sleep when a paddle pin leaves its current level
+void armPaddleWakeup() {
+  gpio_int_type_t dit = digitalRead(DIT_PIN) == LOW ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL;
+  gpio_int_type_t dah = digitalRead(DAH_PIN) == LOW ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL;
+  paddleWakeArmed = true;
+  gpio_wakeup_enable((gpio_num_t)DIT_PIN, dit);
+  gpio_wakeup_enable((gpio_num_t)DAH_PIN, dah);
+}
+
+// Edge interrupts again (if no paddle interrupt already did it)
+void disarmPaddleWakeup() {
+  if (!paddleWakeArmed) return;
+  paddleWakeArmed = false;
+  gpio_wakeup_disable((gpio_num_t)DIT_PIN);
+  gpio_wakeup_disable((gpio_num_t)DAH_PIN);
+  gpio_set_intr_type((gpio_num_t)DIT_PIN, GPIO_INTR_ANYEDGE);
+  gpio_set_intr_type((gpio_num_t)DAH_PIN, GPIO_INTR_ANYEDGE);
+}
+
+/*
+ * Block until an event arrives or timeoutMs passes (EVENT_WAIT_FOREVER to
+ * wait for the next event). Returns false on timeout.
+ */
+bool waitForEvent(LoopEvent &event, uint32_t timeoutMs) {
+  TickType_t ticks = (timeoutMs == EVENT_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+
+  // Only an idle screen's wait can end in light sleep
+  bool armed = lightSleepAvailable && !activeModeLockHeld && ticks > 0;
+  if (armed) armPaddleWakeup();
+
+  uint64_t start = esp_timer_get_time();
+  bool received = xQueueReceive(eventQueue, &event, ticks) == pdPASS;
+  eventWaitMicros += esp_timer_get_time() - start;
+
+  if (armed) disarmPaddleWakeup();
+
+  if (!received) return false;
+
+  loopWakeups++;
+  if (event.type < EVENT_TYPE_COUNT) eventCounts[event.type]++;
+  if (event.type == EVENT_KEY) keyEventPending = false;  // Cleared before the FIFO is drained
+  if (event.type == EVENT_PADDLE) paddlePending = false;
+  return true;
+}
+
+/*
+ * Active modes keep the CPU out of light sleep; idle screens also stop the
+ * I2S clocks so the driver's own power lock does not block sleep
+ */
+void setEventLoopActive(bool active) {
+  if (active && !activeModeLockHeld) {
+    esp_pm_lock_acquire(activeModeLock);
+    activeModeLockHeld = true;
+  } else if (!active && activeModeLockHeld) {
+    esp_pm_lock_release(activeModeLock);
+    activeModeLockHeld = false;
+  }
+
+  if (!active && lightSleepAvailable) {
+    suspendI2SAudio();
+  }
+}
+
+/*
+ * Print event counts and the share of time loop() spent blocked
+ */
+void printEventLoopStats() {
+  uint64_t elapsed = esp_timer_get_time() - eventStatsStart;
+  float seconds = elapsed / 1000000.0;
+  static const char* names[EVENT_TYPE_COUNT] = {"key", "paddle", "status", "network", "boot_done"};
+
+  Serial.printf("Event loop: %.1f s, %lu wakeups (%.1f/s), %lu dropped\n",
+                seconds, (unsigned long)loopWakeups,
+                seconds > 0 ? loopWakeups / seconds : 0.0, (unsigned long)eventsDropped.load());
+  for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+    Serial.printf("  %-9s %lu\n", names[i], (unsigned long)eventCounts[i]);
+  }
+  Serial.printf("  Waiting: %.1f%% of the time\n", elapsed ? 100.0 * eventWaitMicros / elapsed : 0.0);
+  Serial.printf("  Light sleep: %s, active lock %s, I2S %s\n",
+                lightSleepAvailable ? "enabled" : "unavailable",
+                activeModeLockHeld ? "held" : "released",
+                i2s_running ? "running" : "stopped");
+}
+
+// Restart the counters
+void resetEventLoopStats() {
+  for (int i = 0; i < EVENT_TYPE_COUNT; i++) eventCounts[i] = 0;
+  eventsDropped = 0;
+  loopWakeups = 0;
+  eventWaitMicros = 0;
+  eventStatsStart = esp_timer_get_time();
+}
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,263 @@
+/*
+ * Fuel Gauge
+ * Battery monitor probe and background sampling (MAX17048 or LC709203F)
+ *
+ * A low-priority task has the I2C manager read the gauge every
+ * FUEL_GAUGE_SAMPLE_MS and publishes a filtered snapshot, so updateStatus()
+ * costs no bus time and the status is current in every mode.
+ *
+ * Charging is inferred (USB detect is unavailable, A3 is the I2S LRC pin):
+ *  - a step in cell voltage held for two samples (charger plugged in or
+ *    pulled; a single dip under a WiFi transmit burst does not count)
+ *  - the MAX17048 CRATE register (%/hr, averaged by the gauge)
+ *  - the voltage trend over FUEL_GAUGE_TREND_SAMPLES samples
+ * The state only flips on clear evidence, so a full battery on the charger
+ * (flat voltage, zero rate) keeps showing as charging.
+ */
+
+#ifndef FUEL_GAUGE_H
+#define FUEL_GAUGE_H
+
+#include <Adafruit_LC709203F.h>
+#include <Adafruit_MAX1704X.h>
+#include "config.h"
+#include "event_loop.h"
+#include "i2c_bus.h"
+#include "rtc_resume.h"
+
+// Battery monitor (one of these will be present)
+Adafruit_LC709203F lc;
+Adafruit_MAX17048 maxlipo;
+bool hasLC709203 = false;
+bool hasMAX17048 = false;
+bool hasBatteryMonitor = false;
+
+// Published by the task; read with getFuelGaugeStatus()
+struct FuelGaugeStatus {
+  bool valid;              // At least one sample taken
+  float voltage;           // Filtered cell voltage
+  float percent;           // Filtered state of charge
+  float chargeRate;        // %/hr (CRATE on the MAX17048, from the trend otherwise)
+  bool rateValid;          // chargeRate is a reading (the trend needs a full window)
+  bool charging;
+  uint32_t samples;
+  uint32_t readMicros;     // Bus time of the last sample
+};
+
+FuelGaugeStatus fuelGaugeStatus = {};
+portMUX_TYPE fuelGaugeMux = portMUX_INITIALIZER_UNLOCKED;
+float fuelGaugeHistory[FUEL_GAUGE_TREND_SAMPLES];  // Filtered voltage, oldest overwritten
+int fuelGaugeHistoryCount = 0;
+int fuelGaugePendingStep = 0;   // +1/-1: voltage step seen, confirmed by the next sample
+SemaphoreHandle_t fuelGaugeReadDone = nullptr;
+
+// One raw reading, filled in on the I2C manager task
+struct FuelGaugeRead {
+  float voltage;
+  float percent;
+  float chargeRate;        // NAN on the LC709203F
+  uint32_t micros;         // Bus time
+};
+
+// Forward declarations
+void initBatteryMonitor();
+void startFuelGaugeTask();
+void sampleFuelGauge();
+FuelGaugeStatus getFuelGaugeStatus();
+float fuelGaugeCurrentMa(const FuelGaugeStatus &gauge);
+void printFuelGaugeStatus();
+
+/*
+ * Find the battery monitor (MAX17048 or LC709203F); no bus scan on failure.
+ * After a resume only the one found before sleep is started, and the
+ * LC709203F keeps its configuration (it stays powered by the battery).
+ */
+void initBatteryMonitor() {
+  uint8_t known = resumedFromSleep ? resumeState.battery : (uint8_t)RESUME_BATTERY_UNKNOWN;
+  if (known == RESUME_BATTERY_NONE) {
+    Serial.println("No battery monitor (none found at cold boot)");
+    return;
+  }
+
+  // Try MAX17048 first (address 0x36) - like Adafruit example
+  if ((known == RESUME_BATTERY_UNKNOWN || known == RESUME_BATTERY_MAX17048) && maxlipo.begin()) {
+    Serial.print("Found MAX17048 with Chip ID: 0x");
+    Serial.println(maxlipo.getChipID(), HEX);
+    hasMAX17048 = true;
+    hasBatteryMonitor = true;
+  }
+  // Try LC709203F if MAX not found (address 0x0B, a 100 kHz part: the whole bus slows down for it)
+  else if ((known == RESUME_BATTERY_UNKNOWN || known == RESUME_BATTERY_LC709203F) &&
+           (Wire.setClock(100000), lc.begin())) {
+    Serial.println("Found LC709203F battery monitor");
+    Serial.print("Version: 0x");
+    Serial.println(lc.getICversion(), HEX);
+
+    if (!resumedFromSleep) {
+      lc.setThermistorB(3950);
+      lc.setPackSize(LC709203F_APA_500MAH); // Closest to 350mAh
+      lc.setAlarmVoltage(3.8);
+    }
+
+    hasLC709203 = true;
+    hasBatteryMonitor = true;
+  }
+  else {
+    Wire.setClock(I2C_CLOCK_HZ);
+    Serial.println("Could not find MAX17048 or LC709203F battery monitor! (serial \"i2c\" scans the bus)");
+  }
+}
+
+void fuelGaugeTask(void* param) {
+  while (true) {
+    sampleFuelGauge();
+    vTaskDelay(pdMS_TO_TICKS(FUEL_GAUGE_SAMPLE_MS));
+  }
+}
+
+// Start sampling (after initBatteryMonitor() and startI2CManager(); nothing to do without a monitor)
+void startFuelGaugeTask() {
+  if (!hasBatteryMonitor) return;
+  fuelGaugeReadDone = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(fuelGaugeTask, "fuel_gauge", 3072, NULL, 1, NULL, 0);
+}
+
+// Runs on the I2C manager task
+void readFuelGaugeJob(void* arg) {
+  FuelGaugeRead* read = (FuelGaugeRead*)arg;
+  uint32_t start = micros();
+  if (hasMAX17048) {
+    read->voltage = maxlipo.cellVoltage();
+    read->percent = maxlipo.cellPercent();
+    read->chargeRate = maxlipo.chargeRate();
+  } else {
+    read->voltage = lc.cellVoltage();
+    read->percent = lc.cellPercent();
+    read->chargeRate = NAN;
+  }
+  read->micros = micros() - start;
+}
+
+/*
+ * Read the gauge once, update the filters and the charge state, and post
+ * EVENT_STATUS when what the battery icon shows has changed
+ */
+void sampleFuelGauge() {
+  FuelGaugeRead read;
+  if (!i2cSubmit(readFuelGaugeJob, &read, I2C_PRIORITY_NORMAL, fuelGaugeReadDone)) {
+    return;  // Job queue full; try again next interval
+  }
+  xSemaphoreTake(fuelGaugeReadDone, portMAX_DELAY);
+  float voltage = read.voltage;
+  float percent = read.percent;
+  float crate = read.chargeRate;
+  uint32_t readMicros = read.micros;
+
+  if (voltage < 2.5 || voltage > 5.0 || isnan(percent)) {
+    return;  // Bad read; keep the last snapshot
+  }
+  percent = constrain(percent, 0.0f, 100.0f);
+
+  FuelGaugeStatus s = getFuelGaugeStatus();
+  bool first = !s.valid;
+  int step = 0;  // Confirmed voltage step: +1 charger plugged in, -1 pulled
+  if (!first && fabsf(voltage - s.voltage) >= FUEL_GAUGE_STEP_V) {
+    int direction = (voltage > s.voltage) ? 1 : -1;
+    if (fuelGaugePendingStep != direction) {
+      fuelGaugePendingStep = direction;
+      return;  // Wait for the next sample to confirm
+    }
+    step = direction;
+  }
+  fuelGaugePendingStep = 0;
+
+  if (first || step != 0) {
+    // Start the filters from this reading
+    s.voltage = voltage;
+    s.percent = percent;
+    fuelGaugeHistoryCount = 0;
+  } else {
+    s.voltage += (voltage - s.voltage) * FUEL_GAUGE_FILTER;
+    s.percent += (percent - s.percent) * FUEL_GAUGE_FILTER;
+  }
+
+  // Voltage trend over the history window (V per window)
+  fuelGaugeHistory[fuelGaugeHistoryCount % FUEL_GAUGE_TREND_SAMPLES] = s.voltage;
+  fuelGaugeHistoryCount++;
+  float trend = 0;
+  if (fuelGaugeHistoryCount >= FUEL_GAUGE_TREND_SAMPLES) {
+    float oldest = fuelGaugeHistory[fuelGaugeHistoryCount % FUEL_GAUGE_TREND_SAMPLES];
+    trend = s.voltage - oldest;
+  }
+
+  // Rate and trend only count with a full window since the last step (CRATE lags a plug-in)
+  bool settled = fuelGaugeHistoryCount >= FUEL_GAUGE_TREND_SAMPLES;
+  if (step != 0) {
+    s.charging = step > 0;
+  } else if (settled && !isnan(crate) && crate >= FUEL_GAUGE_CHARGE_RATE) {
+    s.charging = true;
+  } else if (settled && !isnan(crate) && crate <= -FUEL_GAUGE_CHARGE_RATE) {
+    s.charging = false;
+  } else if (settled && trend >= FUEL_GAUGE_TREND_V) {
+    s.charging = true;
+  } else if (settled && trend <= -FUEL_GAUGE_TREND_V) {
+    s.charging = false;
+  }
+
+  if (!isnan(crate)) {
+    s.chargeRate = crate;
+    s.rateValid = true;
+  } else if (settled) {
+    // Rough %/hr from the voltage trend (VBAT_EMPTY..VBAT_FULL taken as 0-100 %)
+    float windowHours = FUEL_GAUGE_TREND_SAMPLES * (FUEL_GAUGE_SAMPLE_MS / 3600000.0f);
+    s.chargeRate = trend / (VBAT_FULL - VBAT_EMPTY) * 100.0f / windowHours;
+    s.rateValid = true;
+  }
+
+  bool iconChanged = first || (int)(s.percent + 0.5f) != (int)(fuelGaugeStatus.percent + 0.5f) ||
+                     s.charging != fuelGaugeStatus.charging;
+  s.valid = true;
+  s.samples++;
+  s.readMicros = readMicros;
+
+  portENTER_CRITICAL(&fuelGaugeMux);
+  fuelGaugeStatus = s;
+  portEXIT_CRITICAL(&fuelGaugeMux);
+
+  if (iconChanged) {
+    postEvent(EVENT_STATUS, 0);
+  }
+}
+
+FuelGaugeStatus getFuelGaugeStatus() {
+  portENTER_CRITICAL(&fuelGaugeMux);
+  FuelGaugeStatus s = fuelGaugeStatus;
+  portEXIT_CRITICAL(&fuelGaugeMux);
+  return s;
+}
+
+// Battery current in mA from the charge rate (NAN while charging or without a reading)
+float fuelGaugeCurrentMa(const FuelGaugeStatus &gauge) {
+  if (!hasBatteryMonitor || !gauge.valid || !gauge.rateValid || gauge.charging) {
+    return NAN;
+  }
+  return -gauge.chargeRate * BATTERY_CAPACITY_MAH / 100.0f;
+}
+
+// Serial "battery" command
+void printFuelGaugeStatus() {
+  if (!hasBatteryMonitor) {
+    Serial.println("No battery monitor");
+    return;
+  }
+  FuelGaugeStatus s = getFuelGaugeStatus();
+  if (!s.valid) {
+    Serial.println("Fuel gauge: no sample yet");
+    return;
+  }
+  Serial.printf("Fuel gauge (%s): %.3f V, %.1f %%, %+.1f %%/hr%s, %lu samples, last read %lu us\n",
+                hasMAX17048 ? "MAX17048" : "LC709203F", s.voltage, s.percent, s.chargeRate,
+                s.charging ? ", CHARGING" : "", (unsigned long)s.samples, (unsigned long)s.readMicros);
+}
+
+#endif // FUEL_GAUGE_H
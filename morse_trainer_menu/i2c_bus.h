@@ -0,0 +1,215 @@
+/*
+ * I2C Bus Manager
+ * One task owns the Wire bus (CardKB keyboard, battery monitor)
+ *
+ * The manager polls the CardKB every keyPollIntervalMs and runs queued
+ * jobs (fuel gauge reads, the bus scan) in between, highest priority first;
+ * a due keyboard poll never waits behind more than one job. Keystrokes go
+ * into a FIFO with the time they were read and loop() gets EVENT_KEY, so
+ * loop() never touches the bus. Bus time per kind of transaction and the
+ * read-to-handled key latency are kept for the "i2c" serial command.
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "event_loop.h"
+#include "span_trace.h"
+
+#define I2C_JOB_QUEUE_LENGTH 8
+#define I2C_PENDING_MAX      8
+#define KEY_FIFO_LENGTH      16
+
+// Job priorities; the CardKB poll is above all of them
+enum I2CPriority : uint8_t {
+  I2C_PRIORITY_LOW,     // Diagnostics (bus scan)
+  I2C_PRIORITY_NORMAL   // Fuel gauge
+};
+
+typedef void (*I2CJobFn)(void* arg);
+
+struct I2CJob {
+  I2CJobFn fn;               // Runs on the manager task with the bus to itself
+  void* arg;
+  I2CPriority priority;
+  SemaphoreHandle_t done;    // Given when the job has run (may be null)
+  uint32_t queuedMicros;
+};
+
+// A keystroke and when the manager read it
+struct KeyEvent {
+  char key;
+  uint32_t readMicros;
+};
+
+// Statistics (serial "i2c" command)
+struct I2CBusStats {
+  uint32_t keyPolls;
+  uint32_t jobs;
+  uint64_t keyPollMicros;     // Bus time polling the CardKB
+  uint64_t jobMicros;         // Bus time running jobs
+  uint32_t maxJobMicros;
+  uint32_t maxJobWaitMicros;  // Queued to started
+  uint32_t keys;
+  uint32_t keysDropped;       // FIFO full
+  uint64_t keyLatencyMicros;  // Read to handled by loop()
+  uint32_t maxKeyLatencyMicros;
+  uint64_t since;
+};
+
+QueueHandle_t i2cJobQueue = nullptr;
+QueueHandle_t keyFifo = nullptr;
+TaskHandle_t i2cManagerHandle = nullptr;
+volatile uint32_t keyPollIntervalMs = KEY_POLL_MS;
+I2CBusStats i2cBusStats = {};
+
+// Forward declarations
+void startI2CManager();
+bool i2cSubmit(I2CJobFn fn, void* arg, I2CPriority priority, SemaphoreHandle_t done);
+void setKeyPollInterval(uint32_t intervalMs);
+bool readKeyEvent(KeyEvent &event);
+void printI2CBusStats();
+void resetI2CBusStats();
+
+// One CardKB read (0 = no key waiting)
+void pollCardKB() {
+  SPAN("pollCardKB");
+  uint32_t start = micros();
+  char key = 0;
+  Wire.requestFrom(CARDKB_ADDR, 1);
+  if (Wire.available()) {
+    key = Wire.read();
+  }
+  i2cBusStats.keyPollMicros += micros() - start;
+  i2cBusStats.keyPolls++;
+
+  if (key == 0) return;
+  KeyEvent event = {key, (uint32_t)micros()};
+  if (xQueueSend(keyFifo, &event, 0) != pdPASS) {
+    i2cBusStats.keysDropped++;
+    return;
+  }
+  if (!keyEventPending) {
+    keyEventPending = true;
+    if (!postEvent(EVENT_KEY, 0)) keyEventPending = false;
+  }
+}
+
+void runI2CJob(const I2CJob &job) {
+  uint32_t start = micros();
+  uint32_t waited = start - job.queuedMicros;
+  if (waited > i2cBusStats.maxJobWaitMicros) i2cBusStats.maxJobWaitMicros = waited;
+  job.fn(job.arg);
+  uint32_t took = micros() - start;
+  i2cBusStats.jobMicros += took;
+  if (took > i2cBusStats.maxJobMicros) i2cBusStats.maxJobMicros = took;
+  i2cBusStats.jobs++;
+  if (job.done) xSemaphoreGive(job.done);
+}
+
+void i2cManagerTask(void* param) {
+  I2CJob pending[I2C_PENDING_MAX];
+  int pendingCount = 0;
+  uint32_t nextPollMs = millis();
+
+  while (true) {
+    // Sleep until the next poll is due or a job arrives
+    I2CJob job;
+    int32_t untilPoll = (int32_t)(nextPollMs - millis());
+    if (pendingCount == 0 && untilPoll > 0 &&
+        xQueueReceive(i2cJobQueue, &job, pdMS_TO_TICKS(untilPoll)) == pdPASS) {
+      pending[pendingCount++] = job;
+    }
+    while (pendingCount < I2C_PENDING_MAX && xQueueReceive(i2cJobQueue, &job, 0) == pdPASS) {
+      pending[pendingCount++] = job;
+    }
+
+    if ((int32_t)(millis() - nextPollMs) >= 0) {
+      pollCardKB();
+      nextPollMs += keyPollIntervalMs;
+      if ((int32_t)(millis() - nextPollMs) >= 0) {
+        nextPollMs = millis() + keyPollIntervalMs;  // Fell behind: no burst of catch-up polls
+      }
+    }
+
+    // One job per pass, highest priority (then oldest) first
+    if (pendingCount > 0) {
+      int best = 0;
+      for (int i = 1; i < pendingCount; i++) {
+        if (pending[i].priority > pending[best].priority) best = i;
+      }
+      job = pending[best];
+      for (int i = best; i < pendingCount - 1; i++) pending[i] = pending[i + 1];
+      pendingCount--;
+      runI2CJob(job);
+    }
+  }
+}
+
+/*
+ * Start the manager (after the battery monitor probe, which has the bus
+ * to itself during boot). Keyboard polling starts with it.
+ */
+void startI2CManager() {
+  i2cJobQueue = xQueueCreate(I2C_JOB_QUEUE_LENGTH, sizeof(I2CJob));
+  keyFifo = xQueueCreate(KEY_FIFO_LENGTH, sizeof(KeyEvent));
+  i2cBusStats.since = esp_timer_get_time();
+  xTaskCreatePinnedToCore(i2cManagerTask, "i2c", 3072, NULL, 2, &i2cManagerHandle, 0);
+}
+
+// Queue a job without waiting; done (optional) is given once it has run
+bool i2cSubmit(I2CJobFn fn, void* arg, I2CPriority priority, SemaphoreHandle_t done) {
+  if (i2cJobQueue == nullptr) return false;
+  I2CJob job = {fn, arg, priority, done, (uint32_t)micros()};
+  return xQueueSend(i2cJobQueue, &job, 0) == pdPASS;
+}
+
+// Change the CardKB poll period (takes effect after the next poll)
+void setKeyPollInterval(uint32_t intervalMs) {
+  keyPollIntervalMs = intervalMs;
+}
+
+/*
+ * Take the next keystroke from the FIFO (loop() on EVENT_KEY); records the
+ * read-to-handled latency
+ */
+bool readKeyEvent(KeyEvent &event) {
+  if (keyFifo == nullptr || xQueueReceive(keyFifo, &event, 0) != pdPASS) {
+    return false;
+  }
+  uint32_t latency = micros() - event.readMicros;
+  i2cBusStats.keys++;
+  i2cBusStats.keyLatencyMicros += latency;
+  if (latency > i2cBusStats.maxKeyLatencyMicros) i2cBusStats.maxKeyLatencyMicros = latency;
+  return true;
+}
+
+void printI2CBusStats() {
+  const I2CBusStats &s = i2cBusStats;
+  uint64_t elapsed = esp_timer_get_time() - s.since;
+  uint64_t busy = s.keyPollMicros + s.jobMicros;
+  Serial.printf("I2C bus: %lu kHz, %.2f%% busy over %.1f s\n", (unsigned long)(Wire.getClock() / 1000),
+                elapsed ? 100.0 * busy / elapsed : 0.0, elapsed / 1000000.0);
+  Serial.printf("  CardKB: %lu polls every %lu ms, avg %lu us\n", (unsigned long)s.keyPolls,
+                (unsigned long)keyPollIntervalMs,
+                (unsigned long)(s.keyPolls ? s.keyPollMicros / s.keyPolls : 0));
+  Serial.printf("  Jobs: %lu, avg %lu us, max %lu us, max wait %lu us\n", (unsigned long)s.jobs,
+                (unsigned long)(s.jobs ? s.jobMicros / s.jobs : 0), (unsigned long)s.maxJobMicros,
+                (unsigned long)s.maxJobWaitMicros);
+  Serial.printf("  Keys: %lu, %lu dropped, read to handled avg %lu us, max %lu us (plus up to %lu ms to the poll)\n",
+                (unsigned long)s.keys, (unsigned long)s.keysDropped,
+                (unsigned long)(s.keys ? s.keyLatencyMicros / s.keys : 0),
+                (unsigned long)s.maxKeyLatencyMicros, (unsigned long)keyPollIntervalMs);
+}
+
+void resetI2CBusStats() {
+  i2cBusStats = {};
+  i2cBusStats.since = esp_timer_get_time();
+}
+
+#endif // I2C_BUS_H
@@ -10,45 +10,55 @@
 #include <driver/i2s.h>
 #include <driver/gpio.h>
 #include <math.h>
-#include <Preferences.h>
 #include "config.h"
+#include "latency_stats.h"
+#include "settings_store.h"
+#include "span_trace.h"
+#include "subsystem_scope.h"
+#include "trace.h"
 
 // I2S port number
 #define I2S_NUM I2S_NUM_0
 
+// DMA ring: the audio queued ahead of the writer (8 x 64 frames = 11.6 ms)
+#define I2S_DMA_BUF_COUNT 8
+#define I2S_DMA_BUF_LEN   64
+#define I2S_RING_MICROS   ((uint32_t)((uint64_t)I2S_DMA_BUF_COUNT * I2S_DMA_BUF_LEN * 1000000 / I2S_SAMPLE_RATE))
+
 // Forward declarations
 void continueTone(int frequency);
+void fillToneBlock(int16_t* sample_buffer, int frames, int frequency);
+esp_err_t writeI2SBlock(const int16_t* samples, TickType_t wait);
 
 // Global audio state
 static bool i2s_initialized = false;
+static bool i2s_running = false;  // Stopped while idle so light sleep is allowed
 static bool tone_playing = false;
 static unsigned long tone_start_time = 0;
 static unsigned long tone_duration = 0;
 static float phase = 0.0;  // Phase accumulator for continuous tone
 static int current_frequency = 0;
 static int audio_volume = DEFAULT_VOLUME;  // Volume 0-100%
-static Preferences volumePrefs;
+static uint32_t lastToneBlockAt = 0;  // micros() after the last continueTone() write (0 = not running)
 
 /*
- * Load volume from preferences
+ * Load volume from the settings store
  */
 void loadVolume() {
-  volumePrefs.begin("audio", false);
-  audio_volume = volumePrefs.getInt("volume", DEFAULT_VOLUME);
+  loadSettings();
+  audio_volume = deviceSettings.volume;
   if (audio_volume < VOLUME_MIN || audio_volume > VOLUME_MAX) {
     audio_volume = DEFAULT_VOLUME;
   }
-  volumePrefs.end();
   Serial.printf("Loaded volume: %d%%\n", audio_volume);
 }
 
 /*
- * Save volume to preferences
+ * Save volume (written to flash by the settings store)
  */
 void saveVolume() {
-  volumePrefs.begin("audio", false);
-  volumePrefs.putInt("volume", audio_volume);
-  volumePrefs.end();
+  deviceSettings.volume = audio_volume;
+  settingsChanged(1);
   Serial.printf("Saved volume: %d%%\n", audio_volume);
 }
 
@@ -87,8 +97,8 @@ void initI2SAudio() {
     .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
     .communication_format = I2S_COMM_FORMAT_STAND_I2S,
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL3,  // Highest priority - must beat SPI DMA
-    .dma_buf_count = 8,
-    .dma_buf_len = 64,
+    .dma_buf_count = I2S_DMA_BUF_COUNT,
+    .dma_buf_len = I2S_DMA_BUF_LEN,
     .use_apll = false,
     .tx_desc_auto_clear = true,
     .fixed_mclk = 0
@@ -136,6 +146,7 @@ void initI2SAudio() {
   i2s_zero_dma_buffer(I2S_NUM);
 
   i2s_initialized = true;
+  i2s_running = true;  // Driver starts on install
   Serial.println("I2S Audio initialized successfully");
   Serial.printf("  BCK: GPIO %d\n", I2S_BCK_PIN);
   Serial.printf("  LCK: GPIO %d\n", I2S_LCK_PIN);
@@ -143,6 +154,41 @@ void initI2SAudio() {
   Serial.printf("  Sample Rate: %d Hz\n", I2S_SAMPLE_RATE);
 }
 
+/*
+ * Stop the I2S clocks while nothing is playing
+ * The driver holds a power-management lock while running, which blocks
+ * automatic light sleep; the amplifier also shuts down without BCLK.
+ */
+void suspendI2SAudio() {
+  if (!i2s_initialized || !i2s_running || tone_playing) {
+    return;
+  }
+  i2s_stop(I2S_NUM);
+  i2s_running = false;
+}
+
+/*
+ * Restart the I2S clocks (called before any tone is written)
+ */
+void resumeI2SAudio() {
+  if (!i2s_initialized || i2s_running) {
+    return;
+  }
+  i2s_zero_dma_buffer(I2S_NUM);
+  i2s_start(I2S_NUM);
+  i2s_running = true;
+}
+
+/*
+ * Write one block of I2S_BUFFER_SIZE samples (waits while the DMA ring is full)
+ */
+esp_err_t writeI2SBlock(const int16_t* samples, TickType_t wait) {
+  SPAN("i2s_write");
+  SUBSYSTEM_SCOPE(SUBSYSTEM_AUDIO);
+  size_t bytes_written;
+  return i2s_write(I2S_NUM, samples, I2S_BUFFER_SIZE * sizeof(int16_t), &bytes_written, wait);
+}
+
 /*
  * Generate and play a tone at specified frequency for specified duration
  * Non-blocking - call updateTone() in loop to handle timing
@@ -153,8 +199,7 @@ void playTone(int frequency, int duration_ms) {
     return;
   }
 
-  Serial.printf("playTone(%d Hz, %d ms) - generating samples\n", frequency, duration_ms);
-
+  resumeI2SAudio();
   tone_playing = true;
   tone_start_time = millis();
   tone_duration = duration_ms;
@@ -166,16 +211,12 @@ void playTone(int frequency, int duration_ms) {
   int16_t sample_buffer[I2S_BUFFER_SIZE];
 
   // Write samples to I2S - keep writing while tone should be playing
-  size_t bytes_written;
   unsigned long samples_to_write = (unsigned long)I2S_SAMPLE_RATE * duration_ms / 1000;
   unsigned long samples_written = 0;
 
-  Serial.printf("Will write %lu samples\n", samples_to_write);
+  TRACE(TRACE_PLAY_TONE, frequency, duration_ms, samples_to_write);
 
   while (samples_written < samples_to_write && tone_playing) {
-    // Calculate volume scaling (0-100% maps to 0.0-1.0)
-    float volume_scale = audio_volume / 100.0;
-
     // Generate sine wave samples using phase accumulator with volume control
     for (int i = 0; i < I2S_BUFFER_SIZE / 2; i++) {
       // Apply volume scaling (0-100%)
@@ -193,9 +234,9 @@ void playTone(int frequency, int duration_ms) {
       }
     }
 
-    esp_err_t result = i2s_write(I2S_NUM, sample_buffer, I2S_BUFFER_SIZE * sizeof(int16_t), &bytes_written, portMAX_DELAY);
+    esp_err_t result = writeI2SBlock(sample_buffer, portMAX_DELAY);
     if (result != ESP_OK) {
-      Serial.printf("I2S write error: %d\n", result);
+      TRACE(TRACE_I2S_WRITE_ERROR, result);
     }
     samples_written += I2S_BUFFER_SIZE / 2;
 
@@ -203,11 +244,11 @@ void playTone(int frequency, int duration_ms) {
     yield();
   }
 
-  Serial.printf("Wrote %lu samples total\n", samples_written);
+  TRACE(TRACE_PLAY_TONE_DONE, samples_written);
 
   // Silence at end
   memset(sample_buffer, 0, sizeof(sample_buffer));
-  i2s_write(I2S_NUM, sample_buffer, I2S_BUFFER_SIZE * sizeof(int16_t), &bytes_written, portMAX_DELAY);
+  writeI2SBlock(sample_buffer, portMAX_DELAY);
 
   tone_playing = false;
 }
@@ -222,10 +263,12 @@ void startTone(int frequency) {
     return;
   }
 
+  resumeI2SAudio();
+
   if (!tone_playing || current_frequency != frequency) {
     phase = 0.0;  // Reset phase when starting new tone or changing frequency
     current_frequency = frequency;
-    Serial.printf("Starting tone: %d Hz\n", frequency);
+    TRACE(TRACE_START_TONE, frequency);
   }
 
   tone_playing = true;
@@ -236,24 +279,14 @@ void startTone(int frequency) {
 }
 
 /*
- * Continue playing the current tone
- * Call this repeatedly in loop while tone should continue
+ * Generate one block of the continuous tone (stereo frames), carrying the
+ * phase accumulator over from the previous block
  */
-void continueTone(int frequency) {
-  if (!i2s_initialized || !tone_playing) {
-    return;
-  }
-
-  // Update frequency if changed
-  if (current_frequency != frequency) {
-    current_frequency = frequency;
-  }
-
-  int16_t sample_buffer[I2S_BUFFER_SIZE];
-  float phase_increment = 2.0 * PI * current_frequency / I2S_SAMPLE_RATE;
+void fillToneBlock(int16_t* sample_buffer, int frames, int frequency) {
+  float phase_increment = 2.0 * PI * frequency / I2S_SAMPLE_RATE;
 
   // Generate continuous sine wave using phase accumulator with volume control
-  for (int i = 0; i < I2S_BUFFER_SIZE / 2; i++) {
+  for (int i = 0; i < frames; i++) {
     // Apply volume scaling (0-100%)
     float volume_scale = audio_volume / 100.0;
     int16_t sample = (int16_t)(sin(phase) * 8000.0 * volume_scale);
@@ -267,10 +300,36 @@ void continueTone(int frequency) {
       phase -= 2.0 * PI;
     }
   }
+}
+
+/*
+ * Continue playing the current tone
+ * Call this repeatedly in loop while tone should continue
+ */
+void continueTone(int frequency) {
+  if (!i2s_initialized || !tone_playing) {
+    return;
+  }
+
+  // Update frequency if changed
+  if (current_frequency != frequency) {
+    current_frequency = frequency;
+  }
+
+  int16_t sample_buffer[I2S_BUFFER_SIZE];
+  fillToneBlock(sample_buffer, I2S_BUFFER_SIZE / 2, current_frequency);
+
+  // A late block means the DMA ring ran dry and the tone broke up
+  uint32_t now = micros();
+  if (lastToneBlockAt != 0 && now - lastToneBlockAt > I2S_RING_MICROS) {
+    TRACE(TRACE_AUDIO_UNDERRUN, now - lastToneBlockAt);
+    spanAudioGap(now - lastToneBlockAt);
+  }
 
   // Write samples - MUST block to ensure continuous playback
-  size_t bytes_written;
-  i2s_write(I2S_NUM, sample_buffer, I2S_BUFFER_SIZE * sizeof(int16_t), &bytes_written, portMAX_DELAY);
+  writeI2SBlock(sample_buffer, portMAX_DELAY);
+  lastToneBlockAt = micros();
+  latencyToneWritten();
 }
 
 /*
@@ -284,11 +343,11 @@ void stopTone() {
   tone_playing = false;
   phase = 0.0;  // Reset phase
   current_frequency = 0;
+  lastToneBlockAt = 0;
 
   // Write silence to clear the buffer
   int16_t silence[I2S_BUFFER_SIZE] = {0};
-  size_t bytes_written;
-  i2s_write(I2S_NUM, silence, I2S_BUFFER_SIZE * sizeof(int16_t), &bytes_written, 10);
+  writeI2SBlock(silence, 10);
   i2s_zero_dma_buffer(I2S_NUM);
 }
 
@@ -304,7 +363,7 @@ bool isTonePlaying() {
  * Compatible with existing code
  */
 void beep(int frequency, int duration) {
-  Serial.printf("beep(%d Hz, %d ms)\n", frequency, duration);
+  TRACE(TRACE_BEEP, frequency, duration);
   playTone(frequency, duration);
   delay(duration + 10); // Small gap after beep
 }
@@ -0,0 +1,172 @@
+/*
+ * Keying Timeline Strip
+ * Scope-style strip showing key-down/key-up over the last few seconds
+ *
+ * Paddle handlers report keyer output with setTimelineKeyDown(). The strip
+ * sweeps left to right one pixel column per TIMELINE_COLUMN_MS, so each
+ * update is a single column blit plus an erase column ahead of the cursor.
+ * Bars are colored against the expected dit/dah lengths at the current speed,
+ * with tick marks where a dit and a dah should end.
+ */
+
+#ifndef KEYING_TIMELINE_H
+#define KEYING_TIMELINE_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7789.h>
+#include "config.h"
+#include "display_stats.h"
+
+#define TIMELINE_COLUMN_MS   10    // One column per 10ms (100 Hz)
+#define TIMELINE_X           10
+#define TIMELINE_WIDTH       300   // 3 seconds of history
+#define TIMELINE_HEIGHT      26
+#define TIMELINE_TICK_HEIGHT 4     // Guide tick row above the bars
+#define TIMELINE_MAX_CATCHUP 20    // Columns drawn per update after a stall
+
+// Column states (low bits) and guide tick flags
+#define TL_UP         0
+#define TL_DOWN_DIT   1   // Key down, still within a dit
+#define TL_DOWN_DAH   2   // Key down, past a dit but within a dah
+#define TL_DOWN_LONG  3   // Key down longer than a dah
+#define TL_STATE_MASK 0x03
+#define TL_TICK_DIT   0x04  // Expected end of a dit
+#define TL_TICK_DAH   0x08  // Expected end of a dah
+
+// Timeline state
+bool timelineActive = false;
+int timelineY = 0;
+int timelineDitMs = 60;
+uint8_t timelineColumns[TIMELINE_WIDTH];  // History, indexed by screen column
+int timelineCursor = 0;                   // Next column to draw
+unsigned long timelineLastColumnTime = 0;
+
+// Key state reported by the paddle handlers
+volatile bool timelineKeyDown = false;
+volatile bool timelineKeyLatched = false;  // Key went down since the last column
+unsigned long timelineKeyDownStart = 0;
+
+// Forward declarations
+void startKeyingTimeline(Adafruit_ST7789 &display, int y, int ditMs);
+void drawKeyingTimeline(Adafruit_ST7789 &display);
+void updateKeyingTimeline(Adafruit_ST7789 &display);
+void setTimelineKeyDown(bool down);
+
+// Report keyer output from a paddle handler (tone on/off)
+void setTimelineKeyDown(bool down) {
+  if (down && !timelineKeyDown) {
+    timelineKeyDownStart = millis();
+    timelineKeyLatched = true;  // Don't lose elements shorter than a column
+  }
+  timelineKeyDown = down;
+}
+
+// Set speed for the dit/dah overlay (call when WPM changes)
+void setTimelineSpeed(int ditMs) {
+  timelineDitMs = max(ditMs, 1);
+}
+
+// Reset history and place the strip; call before the screen is drawn
+void startKeyingTimeline(Adafruit_ST7789 &display, int y, int ditMs) {
+  timelineActive = true;
+  timelineY = y;
+  setTimelineSpeed(ditMs);
+  memset(timelineColumns, TL_UP, sizeof(timelineColumns));
+  timelineCursor = 0;
+  timelineLastColumnTime = millis();
+  timelineKeyDown = false;
+  timelineKeyLatched = false;
+}
+
+// Stop sampling (strip is left on screen until the next full redraw)
+void stopKeyingTimeline() {
+  timelineActive = false;
+}
+
+// Draw a single column from its stored state
+void drawTimelineColumn(Adafruit_ST7789 &display, int col) {
+  uint8_t value = timelineColumns[col];
+  int x = TIMELINE_X + col;
+  int barY = timelineY + TIMELINE_TICK_HEIGHT + 1;
+  int barH = TIMELINE_HEIGHT - TIMELINE_TICK_HEIGHT - 1;
+
+  // Guide tick row
+  uint16_t tickColor = COLOR_BACKGROUND;
+  if (value & TL_TICK_DAH) tickColor = ST77XX_YELLOW;
+  else if (value & TL_TICK_DIT) tickColor = ST77XX_CYAN;
+  display.drawFastVLine(x, timelineY, TIMELINE_TICK_HEIGHT, tickColor);
+
+  // Bar (or baseline when the key is up)
+  uint8_t state = value & TL_STATE_MASK;
+  if (state == TL_UP) {
+    display.drawFastVLine(x, barY, barH - 1, COLOR_BACKGROUND);
+    display.drawPixel(x, barY + barH - 1, 0x4208);  // Dim baseline
+  } else {
+    uint16_t barColor = ST77XX_CYAN;          // Dit-length so far
+    if (state == TL_DOWN_DAH) barColor = ST77XX_GREEN;
+    else if (state == TL_DOWN_LONG) barColor = ST77XX_RED;
+    display.drawFastVLine(x, barY, barH, barColor);
+  }
+}
+
+// Full repaint of the strip from history (after a screen redraw)
+void drawKeyingTimeline(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawKeyingTimeline");
+
+  display.drawRect(TIMELINE_X - 1, timelineY - 1, TIMELINE_WIDTH + 2, TIMELINE_HEIGHT + 2, 0x2104);
+  for (int col = 0; col < TIMELINE_WIDTH; col++) {
+    drawTimelineColumn(display, col);
+  }
+
+  // Sweep cursor
+  display.drawFastVLine(TIMELINE_X + timelineCursor, timelineY, TIMELINE_HEIGHT, 0x7BEF);
+}
+
+/*
+ * Advance the strip (call every loop iteration while the strip is shown)
+ * Draws one column per elapsed TIMELINE_COLUMN_MS, then the sweep cursor
+ */
+void updateKeyingTimeline(Adafruit_ST7789 &display) {
+  if (!timelineActive) return;
+
+  unsigned long now = millis();
+  if (now - timelineLastColumnTime < TIMELINE_COLUMN_MS) return;
+
+  int columns = (now - timelineLastColumnTime) / TIMELINE_COLUMN_MS;
+  timelineLastColumnTime += (unsigned long)columns * TIMELINE_COLUMN_MS;
+  if (columns > TIMELINE_MAX_CATCHUP) columns = TIMELINE_MAX_CATCHUP;
+
+  DISPLAY_STATS_SCREEN("updateKeyingTimeline");
+
+  for (int i = 0; i < columns; i++) {
+    uint8_t value = TL_UP;
+
+    // End time of this column (earlier columns when catching up after a stall)
+    unsigned long columnEnd = timelineLastColumnTime - (unsigned long)(columns - 1 - i) * TIMELINE_COLUMN_MS;
+    bool keyedInColumn = (timelineKeyDown || timelineKeyLatched) &&
+                         (long)(columnEnd - timelineKeyDownStart) >= 0;
+
+    if (keyedInColumn) {
+      // Classify the element so far against expected dit/dah lengths
+      unsigned long held = columnEnd - timelineKeyDownStart;
+      int ditMs = timelineDitMs;
+      if (held <= (unsigned long)ditMs) value = TL_DOWN_DIT;
+      else if (held <= (unsigned long)ditMs * 3) value = TL_DOWN_DAH;
+      else value = TL_DOWN_LONG;
+
+      // Tick where a dit and a dah are expected to end
+      if (held >= (unsigned long)ditMs && held < (unsigned long)ditMs + TIMELINE_COLUMN_MS) value |= TL_TICK_DIT;
+      if (held >= (unsigned long)ditMs * 3 && held < (unsigned long)ditMs * 3 + TIMELINE_COLUMN_MS) value |= TL_TICK_DAH;
+      timelineKeyLatched = false;
+    }
+
+    timelineColumns[timelineCursor] = value;
+    drawTimelineColumn(display, timelineCursor);
+    timelineCursor = (timelineCursor + 1) % TIMELINE_WIDTH;
+  }
+
+  // Sweep cursor overwrites the oldest column
+  display.drawFastVLine(TIMELINE_X + timelineCursor, timelineY, TIMELINE_HEIGHT, 0x7BEF);
+}
+
+#endif // KEYING_TIMELINE_H
@@ -0,0 +1,296 @@
+/*
+ * Latency Instrumentation
+ * End-to-end delays an operator hears: paddle to sidetone, paddle to the
+ * Vail server, Vail server to speaker
+ *
+ * Probe points stamp esp_timer time at the paddle GPIO edge (interrupt),
+ * the keyer starting an element, the first tone block written to I2S,
+ * webSocket.sendTXT(), frame receive in webSocketEvent() and playback
+ * start in playbackMessages(). Each path pairs two probes into a fixed
+ * histogram (8 buckets per power of two, so percentiles are within 1/8),
+ * which costs the same memory after a minute or a week of keying.
+ *
+ * Only presses the keyer could act on at once count: an edge before the
+ * previous element's gap ran out (squeeze, paddle memory) starts an
+ * element when the keyer says so, not when the paddle moved. Audio probes
+ * stop when the block is handed to the DMA ring, which plays it within one
+ * ring length (8 x 64 frames, 11.6 ms).
+ *
+ * Settings > Latency shows p50/p99/max; "latency" dumps the same as CSV.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <Adafruit_ST7789.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "display_stats.h"
+
+#define LATENCY_SUB_BUCKETS 8     // Buckets per power of two (values 0-7 us exact)
+#define LATENCY_BUCKETS     176   // Up to 2^24 us (16.7 s); longer lands in the last bucket
+
+enum LatencyPath : uint8_t {
+  LATENCY_PADDLE_KEYER,   // Paddle edge -> keyer starts the element
+  LATENCY_PADDLE_AUDIO,   // Paddle edge -> first sidetone block written to I2S
+  LATENCY_PADDLE_WIRE,    // Paddle edge -> sendTXT() (Vail sends an element once it ends)
+  LATENCY_WIRE_SPEAKER,   // Frame received -> first playback block written to I2S
+  LATENCY_PLAYOUT_LATE,   // Playback start past its scheduled time
+  LATENCY_PATH_COUNT
+};
+
+struct LatencyHistogram {
+  uint32_t count;
+  uint32_t maxMicros;
+  uint64_t sumMicros;
+  uint32_t buckets[LATENCY_BUCKETS];
+};
+
+LatencyHistogram latencyHistograms[LATENCY_PATH_COUNT];
+const char* const latencyPathNames[LATENCY_PATH_COUNT] = {
+  "paddle_keyer", "paddle_audio", "paddle_wire", "wire_speaker", "playout_late"
+};
+const char* const latencyPathLabels[LATENCY_PATH_COUNT] = {
+  "Paddle>keyer", "Paddle>audio", "Paddle>wire", "Wire>speaker", "Playout late"
+};
+
+// Probe timestamps (low 32 bits of esp_timer_get_time(), 0 = nothing pending)
+volatile uint32_t latencyEdgeAt = 0;   // Last paddle edge (interrupt)
+uint32_t latencyKeyerReadyAt = 0;      // End of the last element's gap
+uint32_t latencyToneFrom = 0;          // Start of the path the next tone block ends
+LatencyPath latencyTonePath = LATENCY_PADDLE_AUDIO;
+uint32_t latencyWireFrom = 0;          // Paddle edge of the element waiting to be sent
+uint32_t latencyReceivedAt = 0;        // Last Vail frame received
+
+// Forward declarations
+void latencyRecord(LatencyPath path, uint32_t micros);
+void latencyRecord(LatencyHistogram &h, uint32_t micros);
+uint32_t latencyPercentile(const LatencyHistogram &h, float fraction);
+void latencyPaddleEdge();
+void latencyElementStart(bool toWire);
+void latencyElementEnd(uint32_t gapMs);
+void latencyToneWritten();
+void latencyWireSend();
+void latencyWireReceive();
+void latencyPlaybackStart(uint32_t receivedAt, uint32_t lateMicros);
+void drawLatencyUI(Adafruit_ST7789 &display);
+int handleLatencyInput(char key, Adafruit_ST7789 &display);
+void printLatencyStats();
+void resetLatencyStats();
+void beep(int frequency, int duration);
+
+inline uint32_t latencyNow() {
+  return (uint32_t)esp_timer_get_time();
+}
+
+// Bucket of a value: exact below 8 us, then 8 linear steps per power of two
+int latencyBucket(uint32_t micros) {
+  if (micros < LATENCY_SUB_BUCKETS) return micros;
+  int octave = 31 - __builtin_clz(micros);  // >= 3
+  int bucket = (octave - 2) * LATENCY_SUB_BUCKETS + ((micros >> (octave - 3)) & (LATENCY_SUB_BUCKETS - 1));
+  return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Largest value that lands in a bucket
+uint32_t latencyBucketUpper(int bucket) {
+  if (bucket < LATENCY_SUB_BUCKETS) return bucket;
+  int octave = bucket / LATENCY_SUB_BUCKETS + 2;
+  int step = bucket % LATENCY_SUB_BUCKETS;
+  return ((uint32_t)(LATENCY_SUB_BUCKETS + step + 1) << (octave - 3)) - 1;
+}
+
+void latencyRecord(LatencyPath path, uint32_t micros) {
+  latencyRecord(latencyHistograms[path], micros);
+}
+
+void latencyRecord(LatencyHistogram &h, uint32_t micros) {
+  h.count++;
+  h.sumMicros += micros;
+  if (micros > h.maxMicros) h.maxMicros = micros;
+  h.buckets[latencyBucket(micros)]++;
+}
+
+// Upper edge of the bucket holding the given fraction of samples (capped at the max)
+uint32_t latencyPercentile(const LatencyHistogram &h, float fraction) {
+  if (h.count == 0) return 0;
+  uint32_t rank = (uint32_t)ceilf(h.count * fraction);
+  if (rank == 0) rank = 1;
+  uint32_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += h.buckets[i];
+    if (seen >= rank) {
+      uint32_t upper = latencyBucketUpper(i);
+      return upper < h.maxMicros ? upper : h.maxMicros;
+    }
+  }
+  return h.maxMicros;
+}
+
+// ============================================
+// Probe points
+// ============================================
+
+// Paddle interrupt (either pin, either direction; the latest edge before a press is the press)
+void IRAM_ATTR latencyPaddleEdge() {
+  latencyEdgeAt = latencyNow();
+}
+
+/*
+ * Keyer started an element (toWire: it will be sent to Vail). Counts when a
+ * paddle edge came after the previous gap; a held paddle has no new edge.
+ */
+void latencyElementStart(bool toWire) {
+  uint32_t now = latencyNow();
+  uint32_t edge = latencyEdgeAt;
+  latencyEdgeAt = 0;
+  if (edge == 0 || (int32_t)(edge - latencyKeyerReadyAt) < 0) {
+    latencyToneFrom = 0;
+    return;
+  }
+  latencyRecord(LATENCY_PADDLE_KEYER, now - edge);
+  latencyToneFrom = edge;
+  latencyTonePath = LATENCY_PADDLE_AUDIO;
+  if (toWire && latencyWireFrom == 0) {
+    latencyWireFrom = edge;  // First element of the message
+  }
+}
+
+// Iambic keyer ended an element; the next can start gapMs from now
+void latencyElementEnd(uint32_t gapMs) {
+  latencyKeyerReadyAt = latencyNow() + gapMs * 1000;
+}
+
+// A tone block went to the DMA ring (continueTone)
+void latencyToneWritten() {
+  if (latencyToneFrom == 0) return;
+  latencyRecord(latencyTonePath, latencyNow() - latencyToneFrom);
+  latencyToneFrom = 0;
+}
+
+// Just before webSocket.sendTXT()
+void latencyWireSend() {
+  if (latencyWireFrom == 0) return;
+  latencyRecord(LATENCY_PADDLE_WIRE, latencyNow() - latencyWireFrom);
+  latencyWireFrom = 0;
+}
+
+// Text frame arrived in webSocketEvent()
+void latencyWireReceive() {
+  latencyReceivedAt = latencyNow();
+}
+
+// playbackMessages() started a message received at receivedAt, lateMicros past its slot
+void latencyPlaybackStart(uint32_t receivedAt, uint32_t lateMicros) {
+  latencyRecord(LATENCY_PLAYOUT_LATE, lateMicros);
+  if (receivedAt != 0) {
+    latencyToneFrom = receivedAt;
+    latencyTonePath = LATENCY_WIRE_SPEAKER;
+  }
+}
+
+// ============================================
+// Report
+// ============================================
+
+/*
+ * Settings > Latency: samples, p50, p99 and max per path, in ms.
+ * Redrawn on EVENT_STATUS.
+ */
+void drawLatencyUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawLatencyUI");
+  display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
+
+  int cardX = 20;
+  int cardY = 50;
+  int cardW = SCREEN_WIDTH - 40;
+  int cardH = 136;
+
+  display.fillRoundRect(cardX, cardY, cardW, cardH, 12, 0x1082); // Dark blue fill
+  display.drawRoundRect(cardX, cardY, cardW, cardH, 12, 0x34BF); // Light blue outline
+
+  // Column headings
+  display.setTextSize(1);
+  display.setTextColor(0x7BEF); // Light gray
+  display.setCursor(cardX + 12, cardY + 10);
+  display.print("ms");
+  display.setCursor(cardX + 100, cardY + 10);
+  display.print("n");
+  display.setCursor(cardX + 140, cardY + 10);
+  display.print("p50");
+  display.setCursor(cardX + 180, cardY + 10);
+  display.print("p99");
+  display.setCursor(cardX + 220, cardY + 10);
+  display.print("max");
+
+  char text[16];
+  for (int path = 0; path < LATENCY_PATH_COUNT; path++) {
+    const LatencyHistogram &h = latencyHistograms[path];
+    int yPos = cardY + 30 + path * 20;
+
+    display.setTextColor(ST77XX_CYAN);
+    display.setCursor(cardX + 12, yPos);
+    display.print(latencyPathLabels[path]);
+
+    display.setTextColor(ST77XX_WHITE);
+    display.setCursor(cardX + 100, yPos);
+    if (h.count == 0) {
+      display.print("-");
+      continue;
+    }
+    display.print(h.count > 9999 ? 9999 : h.count);
+
+    uint32_t values[3] = {latencyPercentile(h, 0.50f), latencyPercentile(h, 0.99f), h.maxMicros};
+    for (int col = 0; col < 3; col++) {
+      snprintf(text, sizeof(text), values[col] < 10000 ? "%.1f" : "%.0f", values[col] / 1000.0);
+      display.setCursor(cardX + 140 + col * 40, yPos);
+      display.print(text);
+    }
+  }
+
+  display.setTextColor(ST77XX_WHITE);
+  display.setCursor(cardX + 5, cardY + cardH + 8);
+  display.print("Key in Practice or Vail to collect samples");
+
+  display.setTextColor(COLOR_WARNING);
+  String footerText = "R Reset  ESC Back";
+
+  int16_t x1, y1;
+  uint16_t w, h;
+  display.getTextBounds(footerText, 0, 0, &x1, &y1, &w, &h);
+  int centerX = (SCREEN_WIDTH - w) / 2;
+  display.setCursor(centerX, SCREEN_HEIGHT - 12);
+  display.print(footerText);
+}
+
+// Returns: -1 to exit, 0 to continue
+int handleLatencyInput(char key, Adafruit_ST7789 &display) {
+  if (key == KEY_ESC) {
+    return -1;
+  }
+  if (key == 'r' || key == 'R') {
+    resetLatencyStats();
+    beep(TONE_SELECT, BEEP_SHORT);
+    drawLatencyUI(display);
+  }
+  return 0;
+}
+
+// Serial "latency" command: one CSV row per path
+void printLatencyStats() {
+  Serial.println("path,samples,mean_us,p50_us,p90_us,p99_us,max_us");
+  for (int path = 0; path < LATENCY_PATH_COUNT; path++) {
+    const LatencyHistogram &h = latencyHistograms[path];
+    Serial.printf("%s,%lu,%lu,%lu,%lu,%lu,%lu\n", latencyPathNames[path], (unsigned long)h.count,
+                  (unsigned long)(h.count ? h.sumMicros / h.count : 0),
+                  (unsigned long)latencyPercentile(h, 0.50f), (unsigned long)latencyPercentile(h, 0.90f),
+                  (unsigned long)latencyPercentile(h, 0.99f), (unsigned long)h.maxMicros);
+  }
+}
+
+void resetLatencyStats() {
+  memset(latencyHistograms, 0, sizeof(latencyHistograms));
+  latencyToneFrom = 0;
+  latencyWireFrom = 0;
+}
+
+#endif // LATENCY_STATS_H
@@ -6,9 +6,10 @@
 #include "config.h"
 #include <Fonts/FreeSansBold12pt7b.h>
 #include <Fonts/FreeSans9pt7b.h>
-#include <Adafruit_LC709203F.h>
-#include <Adafruit_MAX1704X.h>
 #include "i2s_audio.h"
+#include "boot_timing.h"
+#include "display_stats.h"
+#include "event_loop.h"
 #include "morse_code.h"
 #include "training_hear_it_type_it.h"
 #include "settings_wifi.h"
@@ -16,16 +17,21 @@
 #include "settings_volume.h"
 #include "training_practice.h"
 #include "vail_repeater.h"
-
-// Battery monitor (one of these will be present)
-Adafruit_LC709203F lc;
-Adafruit_MAX17048 maxlipo;
-bool hasLC709203 = false;
-bool hasMAX17048 = false;
-bool hasBatteryMonitor = false;
-
-// Create display object
-Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+#include "vail_capture.h"
+#include "rtc_resume.h"
+#include "i2c_bus.h"
+#include "fuel_gauge.h"
+#include "power_profile.h"
+#include "energy_profiler.h"
+#include "latency_stats.h"
+#include "benchmarks.h"
+#include "runtime_stats.h"
+#include "span_trace.h"
+#include "trace.h"
+
+// Create display object (instrumented, see display_stats.h)
+// The reset pin is driven in setup(), so a resume can skip the pulse
+InstrumentedST7789 tft(TFT_CS, TFT_DC, -1);
 
 // Menu System
 enum MenuMode {
@@ -38,7 +44,11 @@ enum MenuMode {
   MODE_CW_SETTINGS,
   MODE_VOLUME_SETTINGS,
   MODE_VAIL_REPEATER,
-  MODE_BLUETOOTH
+  MODE_BLUETOOTH,
+  MODE_POWER_DIAGNOSTICS,
+  MODE_ENERGY_REPORT,
+  MODE_LATENCY_REPORT,
+  MODE_RUNTIME_DIAGNOSTICS
 };
 
 MenuMode currentMode = MODE_MAIN_MENU;
@@ -48,46 +58,71 @@ int escPressCount = 0;
 unsigned long lastEscPressTime = 0;
 #define TRIPLE_ESC_TIMEOUT 2000  // 2 seconds window for 3 presses
 
-String mainMenuOptions[MENU_ITEMS] = {
-  "Training",
-  "Settings",
-  "WiFi",
-  "Bluetooth"
+// Menu tables (const data stays in flash, no heap Strings)
+// Selecting an item enters its target mode; menus are modes too
+struct MenuItem {
+  const char* label;
+  char icon;
+  MenuMode target;
+};
+
+struct MenuDef {
+  MenuMode mode;
+  const char* title;
+  const MenuItem* items;
+  uint8_t count;
+  MenuMode parent;  // ESC destination (self for the main menu)
+};
+
+#define MENU_LEN(items) (sizeof(items) / sizeof(items[0]))
+
+constexpr MenuItem mainMenuItems[] = {
+  {"Training",  'T', MODE_TRAINING_MENU},
+  {"Settings",  'S', MODE_SETTINGS_MENU},
+  {"WiFi",      'W', MODE_VAIL_REPEATER},
+  {"Bluetooth", 'B', MODE_BLUETOOTH}
 };
 
-String mainMenuIcons[MENU_ITEMS] = {
-  "T",  // Training
-  "S",  // Settings
-  "W",  // WiFi
-  "B"   // Bluetooth
+constexpr MenuItem trainingMenuItems[] = {
+  {"Hear It Type It", 'H', MODE_HEAR_IT_TYPE_IT},
+  {"Practice",        'P', MODE_PRACTICE}
 };
 
-// Training submenu
-#define TRAINING_MENU_ITEMS 2
-String trainingMenuOptions[TRAINING_MENU_ITEMS] = {
-  "Hear It Type It",
-  "Practice"
+constexpr MenuItem settingsMenuItems[] = {
+  {"WiFi Setup",  'W', MODE_WIFI_SETTINGS},
+  {"CW Settings", 'C', MODE_CW_SETTINGS},
+  {"Volume",      'V', MODE_VOLUME_SETTINGS},
+  {"Power",       'P', MODE_POWER_DIAGNOSTICS},
+  {"Energy",      'E', MODE_ENERGY_REPORT},
+  {"Latency",     'L', MODE_LATENCY_REPORT},
+  {"Diagnostics", 'D', MODE_RUNTIME_DIAGNOSTICS}
 };
 
-String trainingMenuIcons[TRAINING_MENU_ITEMS] = {
-  "H",  // Hear It Type It
-  "P"   // Practice
+constexpr MenuDef menus[] = {
+  {MODE_MAIN_MENU,     "VAIL SUMMIT", mainMenuItems,     MENU_LEN(mainMenuItems),     MODE_MAIN_MENU},
+  {MODE_TRAINING_MENU, "TRAINING",    trainingMenuItems, MENU_LEN(trainingMenuItems), MODE_MAIN_MENU},
+  {MODE_SETTINGS_MENU, "SETTINGS",    settingsMenuItems, MENU_LEN(settingsMenuItems), MODE_MAIN_MENU}
 };
 
-// Settings submenu
-#define SETTINGS_MENU_ITEMS 3
-String settingsMenuOptions[SETTINGS_MENU_ITEMS] = {
-  "WiFi Setup",
-  "CW Settings",
-  "Volume"
+// Carousel card slots, top to bottom: previous, selected, next, next+1
+struct MenuCardSlot {
+  int16_t x, y, w, h, r;
 };
 
-String settingsMenuIcons[SETTINGS_MENU_ITEMS] = {
-  "W",  // WiFi Setup
-  "C",  // CW Settings
-  "V"   // Volume
+#define MENU_SLOT_COUNT 4
+#define MENU_SLOT_MAIN  1
+
+constexpr MenuCardSlot menuSlots[MENU_SLOT_COUNT] = {
+  {25,  51, 270, 24, 6},  // Previous item (stack card above)
+  {10,  85, 300, 60, 8},  // Selected item (main card)
+  {25, 155, 270, 24, 6},  // Next item (stack card below)
+  {35, 185, 250, 18, 4}   // Next+1 item (small stack card)
 };
 
+// What each slot currently shows, so navigation only repaints changed cards
+const MenuDef* drawnMenu = nullptr;
+int8_t drawnSlotItems[MENU_SLOT_COUNT] = {-1, -1, -1, -1};
+
 int currentSelection = 0;
 bool menuActive = true;
 
@@ -98,36 +133,26 @@ bool isCharging = false;
 
 void setup() {
   Serial.begin(SERIAL_BAUD);
-  delay(3000); // Wait for serial monitor to connect
-  Serial.println("\n\n=== VAIL SUMMIT STARTING ===");
-  Serial.println("Starting setup...");
-
-  // Initialize backlight using PWM (more reliable on ESP32)
-  Serial.println("Initializing backlight...");
-  ledcAttach(TFT_BL, 5000, 8); // Pin, 5kHz, 8-bit resolution
-  ledcWrite(TFT_BL, 255); // Set to full brightness (0-255)
-  delay(50);
-  Serial.println("Backlight ON");
-
-  // Initialize I2C first (before display to avoid conflicts)
-  Serial.println("Initializing I2C...");
-  Wire.begin(I2C_SDA, I2C_SCL);
-  delay(100);
 
-  // Initialize I2S Audio BEFORE display (critical for DMA priority)
-  Serial.println("\nInitializing I2S audio...");
-  initI2SAudio();
-  delay(100);
+  // Paddle wake from deep sleep: settings, channel and network come from RTC memory
+  bool resumed = checkResumeState();
+#if DEBUG_ENABLED
+  // Give a serial monitor a moment to attach (never in production builds or on resume)
+  unsigned long serialWaitStart = millis();
+  while (!resumed && !Serial && millis() - serialWaitStart < SERIAL_WAIT_MS) {
+    delay(10);
+  }
+#endif
+  Serial.println(resumed ? "\n\n=== VAIL SUMMIT RESUMING ===" : "\n\n=== VAIL SUMMIT STARTING ===");
+  startTraceLog();
+  startRuntimeStats();
 
-  // Initialize LCD (after I2S to avoid DMA conflicts)
-  Serial.println("Initializing display...");
-  tft.init(240, 320);  // Initialize with hardware dimensions
-  tft.setRotation(SCREEN_ROTATION);  // Then rotate to landscape
-  tft.fillScreen(COLOR_BACKGROUND);
-  Serial.println("Display initialized");
+  // Backlight stays off until the first frame is drawn
+  ledcAttach(TFT_BL, 5000, 8); // Pin, 5kHz, 8-bit resolution
+  ledcWrite(TFT_BL, 0);
 
-  // DO NOT initialize buzzer pin - conflicts with I2S
-  // pinMode(BUZZER_PIN, OUTPUT);
+  // I2C bus (CardKB, battery monitor); devices are probed in the background
+  Wire.begin(I2C_SDA, I2C_SCL, I2C_CLOCK_HZ);
 
   // Initialize Paddle
   pinMode(DIT_PIN, INPUT_PULLUP);
@@ -136,95 +161,205 @@ void setup() {
   // USB detection disabled - A3 conflicts with I2S_LCK_PIN
   // pinMode(USB_DETECT_PIN, INPUT);
 
-  // Initialize battery monitoring (I2C chip)
-  Serial.println("Initializing battery monitor...");
+  // Queue and timers first: the background task posts to the queue
+  startEventLoop();
 
-  // Try MAX17048 first (address 0x36) - like Adafruit example
-  if (maxlipo.begin()) {
-    Serial.print("Found MAX17048 with Chip ID: 0x");
-    Serial.println(maxlipo.getChipID(), HEX);
-    hasMAX17048 = true;
-    hasBatteryMonitor = true;
+  // Settings blob before the background task (I2S reads the volume from it); no NVS read on resume
+  int phase = bootPhaseBegin("settings", false);
+  loadSettings();
+  loadCWSettings();
+  bootPhaseEnd(phase);
+
+  // I2S, battery monitor and WiFi come up on the other core while the menu is drawn.
+  // I2S still installs before the display (ST7789 init spends ~150ms in reset delays)
+  xTaskCreatePinnedToCore(bootBackgroundTask, "boot_bg", 4096, NULL, 1, NULL, 0);
+
+  // The ST7789 needs 10 us low and 120 ms to come out of reset (the driver's own pulse
+  // waits 400 ms). A resume skips it: the init sequence starts with a software reset.
+  phase = bootPhaseBegin("display", false);
+  pinMode(TFT_RST, OUTPUT);
+  digitalWrite(TFT_RST, resumed ? HIGH : LOW);
+  if (!resumed) {
+    delay(1);
+    digitalWrite(TFT_RST, HIGH);
+    delay(120);
   }
-  // Try LC709203F if MAX not found (address 0x0B)
-  else if (lc.begin()) {
-    Serial.println("Found LC709203F battery monitor");
-    Serial.print("Version: 0x");
-    Serial.println(lc.getICversion(), HEX);
-
-    lc.setThermistorB(3950);
-    lc.setPackSize(LC709203F_APA_500MAH); // Closest to 350mAh
-    lc.setAlarmVoltage(3.8);
+  tft.init(240, 320);  // Initialize with hardware dimensions
+  tft.setRotation(SCREEN_ROTATION);  // Then rotate to landscape
+  tft.fillScreen(COLOR_BACKGROUND);
+  bootPhaseEnd(phase);
 
-    hasLC709203 = true;
-    hasBatteryMonitor = true;
+  // Battery shows a placeholder until the monitor is found (EVENT_STATUS redraws it)
+  phase = bootPhaseBegin("menu", false);
+  updateStatus();
+  if (resumed) {
+    resumeMode((MenuMode)resumeState.mode, resumeState.selection);
+  } else {
+    drawMenu();
   }
-  else {
-    Serial.println("Could not find MAX17048 or LC709203F battery monitor!");
-    Serial.println("Scanning I2C bus...");
-    // I2C scan to see what's connected
-    for (byte i = 1; i < 127; i++) {
-      Wire.beginTransmission(i);
-      if (Wire.endTransmission() == 0) {
-        Serial.print("Found I2C device at 0x");
-        Serial.println(i, HEX);
-      }
-    }
+  applyPowerProfile(powerProfileForMode(currentMode));  // Backlight on at the profile's level
+  bootPhaseEnd(phase);
+
+  bootMenuMicros = micros();
+  if (resumed) {
+    Serial.printf("Resumed from deep sleep #%lu (%s paddle) in %.1f ms\n", (unsigned long)deepSleepCount,
+                  (resumeWakeMask & (1ULL << DAH_PIN)) ? "DAH" : "DIT", bootMenuMicros / 1000.0);
+  } else {
+    Serial.printf("Menu ready in %.1f ms\n", bootMenuMicros / 1000.0);
   }
+}
 
-  // Initialize WiFi and attempt auto-connect
-  Serial.println("Initializing WiFi...");
-  autoConnectWiFi();
-  Serial.println("WiFi initialized");
+/*
+ * Put the screen back the way it was when deep sleep was entered. Menus keep
+ * their cursor; Vail reconnects to its channel once WiFi is back. Other modes
+ * (practice and Hear It Type It need audio at once) return to the main menu.
+ */
+void resumeMode(MenuMode mode, int selection) {
+  if (mode == MODE_VAIL_REPEATER) {
+    currentMode = MODE_VAIL_REPEATER;
+    startVailRepeater(tft);
+    vailConnectPending = true;
+    return;
+  }
 
-  // Load CW settings from preferences
-  Serial.println("Loading CW settings...");
-  loadCWSettings();
+  const MenuDef* menu = findMenu(mode);
+  if (menu == nullptr) {
+    menu = findMenu(MODE_MAIN_MENU);
+    selection = 0;
+  }
+  currentMode = menu->mode;
+  currentSelection = (selection < menu->count) ? selection : 0;
+  drawMenu();
+}
 
-  // Ensure backlight is still on
-  ledcWrite(TFT_BL, 255);
+/*
+ * Background bring-up (runs once on core 0, then deletes itself)
+ * The battery monitor probe has the bus to itself; the I2C manager (and
+ * with it keyboard polling) starts once it is done
+ */
+void bootBackgroundTask(void* param) {
+  int phase = bootPhaseBegin("i2s", true);
+  initI2SAudio();
+  bootPhaseEnd(phase);
+
+  phase = bootPhaseBegin("fuel_gauge", true);
+  initBatteryMonitor();
+  startI2CManager();
+  startFuelGaugeTask();
+  bootPhaseEnd(phase);
+  postEvent(EVENT_STATUS, 0);  // Redraw the battery icon with real data
+
+  // WiFi is left to loop(): the connect state machine is only touched from there
+  bootBackgroundMicros = micros();
+  bootBackgroundDone = true;
+  postEvent(EVENT_BOOT_DONE, 0);
+  vTaskDelete(NULL);
+}
 
-  // Initial status update
-  Serial.println("Updating status...");
-  updateStatus();
+/*
+ * Start WiFi once the background bring-up is done (loop task). A resume
+ * uses the cached BSSID/channel/lease, no scan.
+ */
+void startBootWiFi() {
+  int phase = bootPhaseBegin("wifi", false);
+  if (resumedFromSleep && resumeState.wifiUp) {
+    resumeWiFiConnection(resumeState.network);
+  } else {
+    autoConnectWiFi();
+  }
+  bootPhaseEnd(phase);
+}
 
-  // Draw initial menu
-  Serial.println("Drawing menu...");
-  drawMenu();
+// List responding I2C addresses (serial "i2c" command; runs as an I2C manager job)
+void scanI2CBusJob(void* arg) {
+  Serial.println("Scanning I2C bus...");
+  for (byte i = 1; i < 127; i++) {
+    Wire.beginTransmission(i);
+    if (Wire.endTransmission() == 0) {
+      Serial.print("Found I2C device at 0x");
+      Serial.println(i, HEX);
+    }
+  }
+}
 
-  // Final backlight check
-  ledcWrite(TFT_BL, 255);
-  Serial.println("Setup complete!");
+void scanI2CBus() {
+  printI2CBusStats();
+  if (!i2cSubmit(scanI2CBusJob, NULL, I2C_PRIORITY_LOW, NULL)) {
+    Serial.println("I2C manager not running or busy, try again");
+  }
+}
 
-  // Startup beep (test I2S audio)
-  Serial.println("\nTesting I2S audio output...");
-  Serial.println("You should hear a 1000 Hz beep now");
-  beep(TONE_STARTUP, BEEP_MEDIUM);
-  delay(200);
+// Short screen name (energy report, CSV)
+const char* menuModeName(uint8_t mode) {
+  static const char* names[] = {"Main menu", "Training", "Hear It", "Practice", "Settings", "WiFi Setup",
+                                "CW Settings", "Volume", "Vail", "Bluetooth", "Power", "Energy",
+                                "Latency", "Diagnostics"};
+  return (mode < sizeof(names) / sizeof(names[0])) ? names[mode] : "?";
+}
 
-  // Second test beep
-  Serial.println("Second test beep at 700 Hz");
-  beep(700, 300);
-  Serial.println("Audio test complete\n");
+// Power profile for a screen (menus and settings share one)
+PowerProfileId powerProfileForMode(MenuMode mode) {
+  switch (mode) {
+    case MODE_PRACTICE:        return POWER_PROFILE_PRACTICE;
+    case MODE_HEAR_IT_TYPE_IT: return POWER_PROFILE_HEAR_IT_TYPE_IT;
+    case MODE_VAIL_REPEATER:   return POWER_PROFILE_VAIL;
+    default:                   return POWER_PROFILE_MENU;
+  }
 }
 
 void loop() {
-  // Update status periodically (NEVER during practice mode to avoid audio interference)
-  static unsigned long lastStatusUpdate = 0;
-  if (currentMode != MODE_PRACTICE &&
-      currentMode != MODE_HEAR_IT_TYPE_IT &&
-      millis() - lastStatusUpdate > 5000) { // Update every 5 seconds
-    updateStatus();
-    // Redraw status icons with new data
-    drawStatusIcons();
-    lastStatusUpdate = millis();
+  // Practice and Vail are serviced every pass; other screens sleep until an event
+  bool activeMode = (currentMode == MODE_PRACTICE || currentMode == MODE_VAIL_REPEATER);
+  setEventLoopActive(activeMode);
+  applyPowerProfile(powerProfileForMode(currentMode));
+  setKeyPollInterval((currentMode == MODE_PRACTICE) ? KEY_POLL_PRACTICE_MS : KEY_POLL_MS);
+
+  // Same pacing as the old delay(1)/delay(10) in active modes, but a paddle edge cuts it short
+  uint32_t timeoutMs = EVENT_WAIT_FOREVER;
+  if (currentMode == MODE_PRACTICE) {
+    timeoutMs = 1;
+  } else if (currentMode == MODE_VAIL_REPEATER) {
+    timeoutMs = isTonePlaying() ? 1 : 10;  // A tone needs a block every few ms
+  }
+  if ((wifiConnectInProgress() || wifiScanActive) && timeoutMs > WIFI_PROGRESS_MS) {
+    timeoutMs = WIFI_PROGRESS_MS;  // Progress bar, connect timeout, scan backstop
+  }
+  timeoutMs = min(timeoutMs, settingsFlushDelay());  // Wake for a pending settings write
+
+  LoopEvent event;
+  bool woken = waitForEvent(event, timeoutMs);
+  SPAN("loop");  // The pass after the wait
+  RUNTIME_LOOP_PASS();
+  if (woken) {
+    do {
+      handleLoopEvent(event);
+    } while (waitForEvent(event, 0));  // Drain anything else that is pending
+  }
+
+  updateSettingsStore();
+  updatePowerProfileStats();
+  energyTick(currentMode);
+
+  // Background bring-up finished: start WiFi here, on the task that runs its state machine
+  static bool bootWiFiStarted = false;
+  if (bootBackgroundDone && !bootWiFiStarted) {
+    bootWiFiStarted = true;
+    startBootWiFi();
+    printBootTiming();
+  }
+
+  // WiFi connection runs in the background; only the WiFi Setup screen shows it
+  updateWiFiConnection();
+  if (currentMode == MODE_WIFI_SETTINGS) {
+    updateWiFiSettings(tft);
   }
 
   // Update practice oscillator if in practice mode
   if (currentMode == MODE_PRACTICE) {
     // Call this frequently to keep audio buffer filled
-    // No display updates during practice to maximize audio performance
+    // Only the keying timeline draws during practice (one column per update)
     updatePracticeOscillator();
+    updateKeyingTimeline(tft);
   }
 
   // Update Vail repeater if in Vail mode
@@ -232,35 +367,168 @@ void loop() {
     updateVailRepeater(tft);
   }
 
-  // Check for keyboard input (reduce I2C polling frequency during practice mode)
-  static unsigned long lastKeyCheck = 0;
-  unsigned long keyCheckInterval = (currentMode == MODE_PRACTICE) ? 50 : 10; // Slower polling in practice
-
-  if (millis() - lastKeyCheck >= keyCheckInterval) {
-    Wire.requestFrom(CARDKB_ADDR, 1);
+  // Serial debug console (newline-terminated commands)
+  handleSerialConsole();
 
-    if (Wire.available()) {
-      char key = Wire.read();
+  // Display cost overlay, refreshed after each completed draw
+  static uint32_t lastOverlayFrame = 0;
+  if (displayStatsOverlay && drawFrameCount != lastOverlayFrame) {
+    drawDisplayStatsOverlay(tft);
+    lastOverlayFrame = drawFrameCount;
+  }
+}
 
-      if (key != 0) {
-        handleKeyPress(key);
+// Dispatch one event from the event queue
+void handleLoopEvent(const LoopEvent &event) {
+  switch (event.type) {
+    case EVENT_KEY: {
+      KeyEvent key;
+      while (readKeyEvent(key)) {
+        handleKeyPress(key.key);
       }
+      break;
     }
-    lastKeyCheck = millis();
+
+    case EVENT_STATUS:
+    case EVENT_NETWORK:
+      // Status is a snapshot copy (no bus time); the icons are not redrawn
+      // during practice or Hear It Type It to keep SPI time off the audio path
+      updateStatus();
+      if (currentMode != MODE_PRACTICE && currentMode != MODE_HEAR_IT_TYPE_IT) {
+        drawStatusIcons();
+      }
+      if (currentMode == MODE_POWER_DIAGNOSTICS && event.type == EVENT_STATUS) {
+        drawPowerDiagnosticsUI(tft);
+      } else if (currentMode == MODE_ENERGY_REPORT && event.type == EVENT_STATUS) {
+        drawEnergyUI(tft);
+      } else if (currentMode == MODE_LATENCY_REPORT && event.type == EVENT_STATUS) {
+        drawLatencyUI(tft);
+      }
+      if (event.type == EVENT_STATUS) {
+        runtimeSample();
+        if (currentMode == MODE_RUNTIME_DIAGNOSTICS) {
+          drawRuntimeUI(tft);
+        }
+      }
+      break;
+
+    case EVENT_BOOT_DONE:
+      // Only ends the wait; loop() checks bootBackgroundDone (the event could be dropped)
+      break;
+
+    case EVENT_PADDLE:
+      // Keyer reads the paddle pins on this pass; the event only ends the wait early
+      break;
+
+    default:
+      break;
   }
+}
 
-  // Reset ESC counter if timeout exceeded
-  if (escPressCount > 0 && (millis() - lastEscPressTime > TRIPLE_ESC_TIMEOUT)) {
-    escPressCount = 0;
+// Read serial console input without blocking, dispatching complete lines
+void handleSerialConsole() {
+  static char line[64];
+  static size_t lineLength = 0;
+
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      if (lineLength > 0) {
+        line[lineLength] = '\0';
+        handleSerialCommand(line);
+        lineLength = 0;
+      }
+    } else if (lineLength < sizeof(line) - 1) {
+      line[lineLength++] = c;
+    }
   }
+}
 
-  // Minimal delay in practice mode for better audio performance
-  delay((currentMode == MODE_PRACTICE) ? 1 : 10);
+void handleSerialCommand(const char* cmd) {
+  if (strcmp(cmd, "stats") == 0) {
+    printDisplayStats();
+  } else if (strcmp(cmd, "stats reset") == 0) {
+    resetDisplayStats();
+    Serial.println("Display stats reset");
+  } else if (strcmp(cmd, "overlay") == 0) {
+    displayStatsOverlay = !displayStatsOverlay;
+    Serial.printf("Display stats overlay %s\n", displayStatsOverlay ? "ON" : "OFF");
+  } else if (strcmp(cmd, "events") == 0) {
+    printEventLoopStats();
+  } else if (strcmp(cmd, "events reset") == 0) {
+    resetEventLoopStats();
+    Serial.println("Event loop stats reset");
+  } else if (strcmp(cmd, "boot") == 0) {
+    printBootTiming();
+  } else if (strcmp(cmd, "i2c") == 0) {
+    scanI2CBus();
+  } else if (strcmp(cmd, "i2c reset") == 0) {
+    resetI2CBusStats();
+    Serial.println("I2C bus stats reset");
+  } else if (strcmp(cmd, "battery") == 0) {
+    printFuelGaugeStatus();
+  } else if (strcmp(cmd, "power") == 0) {
+    printPowerProfiles();
+  } else if (strcmp(cmd, "energy") == 0) {
+    printEnergyCSV();
+  } else if (strcmp(cmd, "energy reset") == 0) {
+    resetEnergyLog();
+  } else if (strcmp(cmd, "latency") == 0) {
+    printLatencyStats();
+  } else if (strcmp(cmd, "latency reset") == 0) {
+    resetLatencyStats();
+    Serial.println("Latency stats reset");
+  } else if (strcmp(cmd, "trace") == 0 || strncmp(cmd, "trace ", 6) == 0) {
+    if (!handleTraceCommand(cmd[5] ? cmd + 6 : "")) {
+      Serial.println("Usage: trace [error|warn|info|debug|text|binary|off]");
+    }
+  } else if (strcmp(cmd, "spans") == 0 || strncmp(cmd, "spans ", 6) == 0) {
+    if (!handleSpanCommand(cmd[5] ? cmd + 6 : "")) {
+      Serial.println("Usage: spans [arm|reset]");
+    }
+  } else if (strcmp(cmd, "diag") == 0 || strncmp(cmd, "diag ", 5) == 0) {
+    if (!handleRuntimeCommand(cmd[4] ? cmd + 5 : "")) {
+      Serial.println("Usage: diag [stream|reset]");
+    }
+  } else if (strcmp(cmd, "vailrec") == 0 || strncmp(cmd, "vailrec ", 8) == 0) {
+    if (!handleVailCaptureCommand(cmd[7] ? cmd + 8 : "")) {
+      Serial.println("Usage: vailrec [start|stop|play [n] [speed]|dump [n]|delete n]");
+    }
+  } else if (strcmp(cmd, "link") == 0 || strncmp(cmd, "link ", 5) == 0) {
+    if (!handleVailLinkCommand(cmd[4] ? cmd + 5 : "")) {
+      Serial.println("Usage: link [probe|auto|reset]");
+    }
+  } else if (strcmp(cmd, "wifi") == 0) {
+    printWiFiConnectStats();
+  } else if (strcmp(cmd, "settings") == 0) {
+    printSettingsStore();
+  } else if (strcmp(cmd, "settings flush") == 0) {
+    flushSettings();
+  } else if (strcmp(cmd, "bench") == 0 || strncmp(cmd, "bench ", 6) == 0) {
+    // "bench NAME" runs the benchmarks whose name starts with NAME
+    if (runBenchmarks(cmd[5] ? cmd + 6 : "", &tft) == 0) {
+      Serial.println("No benchmark matches");
+    }
+    invalidateMenuCards();
+    drawMenu();  // Display benchmarks painted over the screen
+  } else {
+    Serial.println("Commands: stats, stats reset, overlay, events, events reset, boot, i2c, i2c reset, battery, power, energy, energy reset, latency, latency reset, trace [level|output], spans [arm|reset], diag [stream|reset], vailrec [start|stop|play|dump|delete], link [probe|auto|reset], wifi, settings, settings flush, bench [name]");
+  }
 }
 
 void enterDeepSleep() {
   Serial.println("Entering deep sleep...");
 
+  // Pending settings and energy totals would be lost with RAM
+  flushSettings();
+  flushEnergyLog();
+  vailCaptureStop();
+  drainTrace();
+
+  // Screen, settings, channel and network for a fast resume (before WiFi goes down)
+  uint8_t battery = hasMAX17048 ? RESUME_BATTERY_MAX17048 : (hasLC709203 ? RESUME_BATTERY_LC709203F : RESUME_BATTERY_NONE);
+  saveResumeState(currentMode, currentSelection, battery);
+
   // Disconnect WiFi if connected
   if (WiFi.status() == WL_CONNECTED) {
     WiFi.disconnect(true);
@@ -282,23 +550,25 @@ void enterDeepSleep() {
   tft.setTextSize(1);
   tft.setTextColor(0x7BEF);
   tft.setCursor(30, 180);
-  tft.print("Press DIT paddle to wake");
+  tft.print("Press a paddle to wake");
 
   delay(2000);
 
   // Turn off display
   tft.fillScreen(ST77XX_BLACK);
-  ledcWrite(0, 0);  // Turn off backlight
+  ledcWrite(TFT_BL, 0);  // Turn off backlight
 
-  // Configure wake on DIT paddle press (active LOW)
-  esp_sleep_enable_ext0_wakeup((gpio_num_t)DIT_PIN, LOW);
+  // Configure wake on either paddle (active LOW)
+  enablePaddleWakeup();
 
   // Enter deep sleep
   esp_deep_sleep_start();
-  // Device will wake here and restart from setup()
+  // Device will wake here and restart from setup(), which resumes from RTC memory
 }
 
 void handleKeyPress(char key) {
+  SPAN("handleKeyPress");
+  SUBSYSTEM_SCOPE(SUBSYSTEM_UI);
   bool redraw = false;
 
   // Handle different modes
@@ -356,6 +626,58 @@ void handleKeyPress(char key) {
     return;
   }
 
+  // Handle power diagnostics screen
+  if (currentMode == MODE_POWER_DIAGNOSTICS) {
+    int result = handlePowerDiagnosticsInput(key, tft);
+    if (result == -1) {
+      // Back to settings menu
+      currentMode = MODE_SETTINGS_MENU;
+      currentSelection = 0;
+      beep(TONE_MENU_NAV, BEEP_SHORT);
+      drawMenu();
+    }
+    return;
+  }
+
+  // Handle energy report screen
+  if (currentMode == MODE_ENERGY_REPORT) {
+    int result = handleEnergyInput(key, tft);
+    if (result == -1) {
+      // Back to settings menu
+      currentMode = MODE_SETTINGS_MENU;
+      currentSelection = 0;
+      beep(TONE_MENU_NAV, BEEP_SHORT);
+      drawMenu();
+    }
+    return;
+  }
+
+  // Handle latency report screen
+  if (currentMode == MODE_LATENCY_REPORT) {
+    int result = handleLatencyInput(key, tft);
+    if (result == -1) {
+      // Back to settings menu
+      currentMode = MODE_SETTINGS_MENU;
+      currentSelection = 0;
+      beep(TONE_MENU_NAV, BEEP_SHORT);
+      drawMenu();
+    }
+    return;
+  }
+
+  // Handle runtime diagnostics screen
+  if (currentMode == MODE_RUNTIME_DIAGNOSTICS) {
+    int result = handleRuntimeInput(key, tft);
+    if (result == -1) {
+      // Back to settings menu
+      currentMode = MODE_SETTINGS_MENU;
+      currentSelection = 0;
+      beep(TONE_MENU_NAV, BEEP_SHORT);
+      drawMenu();
+    }
+    return;
+  }
+
   // Handle Practice mode
   if (currentMode == MODE_PRACTICE) {
     int result = handlePracticeInput(key, tft);
@@ -382,12 +704,9 @@ void handleKeyPress(char key) {
     return;
   }
 
-  // Menu navigation (for MAIN_MENU, TRAINING_MENU, and SETTINGS_MENU)
-  if (currentMode == MODE_MAIN_MENU || currentMode == MODE_TRAINING_MENU || currentMode == MODE_SETTINGS_MENU) {
-    int maxItems = MENU_ITEMS;
-    if (currentMode == MODE_TRAINING_MENU) maxItems = TRAINING_MENU_ITEMS;
-    if (currentMode == MODE_SETTINGS_MENU) maxItems = SETTINGS_MENU_ITEMS;
-
+  // Menu navigation (any mode with a menu table)
+  const MenuDef* menu = findMenu(currentMode);
+  if (menu != nullptr) {
     // Arrow key navigation
     if (key == KEY_UP) {
       if (currentSelection > 0) {
@@ -397,7 +716,7 @@ void handleKeyPress(char key) {
       }
     }
     else if (key == KEY_DOWN) {
-      if (currentSelection < maxItems - 1) {
+      if (currentSelection < menu->count - 1) {
         currentSelection++;
         redraw = true;
         beep(TONE_MENU_NAV, BEEP_SHORT);
@@ -407,15 +726,19 @@ void handleKeyPress(char key) {
       selectMenuItem();
     }
     else if (key == KEY_ESC) {
-      if (currentMode == MODE_TRAINING_MENU || currentMode == MODE_SETTINGS_MENU) {
-        // Back to main menu
-        currentMode = MODE_MAIN_MENU;
+      if (menu->parent != menu->mode) {
+        // Back to parent menu
+        currentMode = menu->parent;
         currentSelection = 0;
         beep(TONE_MENU_NAV, BEEP_SHORT);
         drawMenu();
         return;
-      } else if (currentMode == MODE_MAIN_MENU) {
-        // In main menu - count ESC presses for sleep (triple tap)
+      } else {
+        // In main menu - count ESC presses for sleep (triple tap); the window is
+        // checked here, loop() may have slept through the timeout
+        if (millis() - lastEscPressTime > TRIPLE_ESC_TIMEOUT) {
+          escPressCount = 0;
+        }
         escPressCount++;
         lastEscPressTime = millis();
 
@@ -431,18 +754,23 @@ void handleKeyPress(char key) {
     }
 
     if (redraw) {
-      if (currentMode == MODE_MAIN_MENU) {
-        drawMenuItems(mainMenuOptions, mainMenuIcons, MENU_ITEMS);
-      } else if (currentMode == MODE_TRAINING_MENU) {
-        drawMenuItems(trainingMenuOptions, trainingMenuIcons, TRAINING_MENU_ITEMS);
-      } else if (currentMode == MODE_SETTINGS_MENU) {
-        drawMenuItems(settingsMenuOptions, settingsMenuIcons, SETTINGS_MENU_ITEMS);
-      }
+      drawMenuCards(*menu);
+    }
+  }
+}
+
+// Look up the menu table for a mode (nullptr if the mode is not a menu)
+const MenuDef* findMenu(MenuMode mode) {
+  for (size_t i = 0; i < MENU_LEN(menus); i++) {
+    if (menus[i].mode == mode) {
+      return &menus[i];
     }
   }
+  return nullptr;
 }
 
 void drawHeader() {
+  DISPLAY_STATS_SCREEN("drawHeader");
   // Draw modern header bar
   tft.fillRect(0, 0, SCREEN_WIDTH, 40, 0x1082); // Dark blue header
 
@@ -450,16 +778,15 @@ void drawHeader() {
   tft.setFont(&FreeSansBold12pt7b);
   tft.setTextColor(ST77XX_WHITE);
   tft.setTextSize(1);
-  String title = "VAIL SUMMIT";
+  const char* title = "VAIL SUMMIT";
 
-  if (currentMode == MODE_TRAINING_MENU) {
-    title = "TRAINING";
+  const MenuDef* menu = findMenu(currentMode);
+  if (menu != nullptr) {
+    title = menu->title;
   } else if (currentMode == MODE_HEAR_IT_TYPE_IT) {
     title = "TRAINING";
   } else if (currentMode == MODE_PRACTICE) {
     title = "PRACTICE";
-  } else if (currentMode == MODE_SETTINGS_MENU) {
-    title = "SETTINGS";
   } else if (currentMode == MODE_WIFI_SETTINGS) {
     title = "WIFI SETUP";
   } else if (currentMode == MODE_CW_SETTINGS) {
@@ -468,6 +795,14 @@ void drawHeader() {
     title = "VOLUME";
   } else if (currentMode == MODE_VAIL_REPEATER) {
     title = "VAIL CHAT";  // Also updates header
+  } else if (currentMode == MODE_POWER_DIAGNOSTICS) {
+    title = "POWER";
+  } else if (currentMode == MODE_ENERGY_REPORT) {
+    title = "ENERGY";
+  } else if (currentMode == MODE_LATENCY_REPORT) {
+    title = "LATENCY";
+  } else if (currentMode == MODE_RUNTIME_DIAGNOSTICS) {
+    title = "DIAGNOSTICS";
   }
 
   tft.setCursor(10, 27); // Left-justified
@@ -483,22 +818,23 @@ void drawHeader() {
 }
 
 void drawMenu() {
-  tft.fillScreen(COLOR_BACKGROUND);
-
-  drawHeader();
+  DISPLAY_STATS_SCREEN("drawMenu");
+  const MenuDef* menu = findMenu(currentMode);
 
-  // Draw footer (only for menu modes)
-  if (currentMode == MODE_MAIN_MENU || currentMode == MODE_TRAINING_MENU || currentMode == MODE_SETTINGS_MENU) {
-    drawFooter();
+  if (menu != nullptr && drawnMenu != nullptr) {
+    // Menu to menu: header and cards repaint in place, only the footer is cleared
+    tft.fillRect(0, SCREEN_HEIGHT - 20, SCREEN_WIDTH, 20, COLOR_BACKGROUND);
+  } else {
+    tft.fillScreen(COLOR_BACKGROUND);
+    invalidateMenuCards();
   }
 
+  drawHeader();
+
   // Draw menu items or mode-specific UI
-  if (currentMode == MODE_MAIN_MENU) {
-    drawMenuItems(mainMenuOptions, mainMenuIcons, MENU_ITEMS);
-  } else if (currentMode == MODE_TRAINING_MENU) {
-    drawMenuItems(trainingMenuOptions, trainingMenuIcons, TRAINING_MENU_ITEMS);
-  } else if (currentMode == MODE_SETTINGS_MENU) {
-    drawMenuItems(settingsMenuOptions, settingsMenuIcons, SETTINGS_MENU_ITEMS);
+  if (menu != nullptr) {
+    drawFooter();
+    drawMenuCards(*menu);
   } else if (currentMode == MODE_HEAR_IT_TYPE_IT) {
     drawHearItTypeItUI(tft);
   } else if (currentMode == MODE_PRACTICE) {
@@ -511,104 +847,112 @@ void drawMenu() {
     drawVolumeDisplay(tft);
   } else if (currentMode == MODE_VAIL_REPEATER) {
     drawVailUI(tft);
+  } else if (currentMode == MODE_POWER_DIAGNOSTICS) {
+    drawPowerDiagnosticsUI(tft);
+  } else if (currentMode == MODE_ENERGY_REPORT) {
+    drawEnergyUI(tft);
+  } else if (currentMode == MODE_LATENCY_REPORT) {
+    drawLatencyUI(tft);
+  } else if (currentMode == MODE_RUNTIME_DIAGNOSTICS) {
+    drawRuntimeUI(tft);
   }
 }
 
-void drawMenuItems(String options[], String icons[], int numItems) {
-  // Clear only the menu area (between header and footer)
-  tft.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42 - 20, COLOR_BACKGROUND);
-
-  // Draw menu items with carousel/stack design
-  // Main selected card (larger, using more screen space)
-  int mainCardWidth = 300;
-  int mainCardHeight = 60;
-  int mainCardX = (SCREEN_WIDTH - mainCardWidth) / 2;
-  int mainCardY = 85; // Moved down to avoid clipping with header
-
-  // Draw the selected card (large and prominent)
-  tft.fillRoundRect(mainCardX, mainCardY, mainCardWidth, mainCardHeight, 8, 0x249F); // Blue accent
-  tft.drawRoundRect(mainCardX, mainCardY, mainCardWidth, mainCardHeight, 8, 0x34BF); // Lighter outline
-
-  // Draw icon circle for selected
-  tft.fillCircle(mainCardX + 30, mainCardY + 30, 20, 0x34BF);
-  tft.drawCircle(mainCardX + 30, mainCardY + 30, 20, ST77XX_WHITE); // White outline
-  tft.setTextSize(3);
-  tft.setTextColor(ST77XX_WHITE);
-  tft.setCursor(mainCardX + 23, mainCardY + 20); // Letter centered in circle
-  tft.print(icons[currentSelection]);
-
-  // Draw menu text for selected (slightly larger)
-  tft.setTextSize(2);
-  tft.setTextColor(ST77XX_WHITE);
-  tft.setCursor(mainCardX + 65, mainCardY + 22);
-  tft.print(options[currentSelection]);
-
-  // Draw selection arrow
-  tft.fillTriangle(mainCardX + mainCardWidth - 20, mainCardY + 25,
-                   mainCardX + mainCardWidth - 20, mainCardY + 35,
-                   mainCardX + mainCardWidth - 10, mainCardY + 30, ST77XX_WHITE);
-
-  // Draw stacked cards underneath (previous items)
-  int stackCardWidth = 270;
-  int stackCardHeight = 24;
-  int stackCardX = (SCREEN_WIDTH - stackCardWidth) / 2;
-  int stackOffset = 10;
+// Forget what the carousel shows (something else painted over it)
+void invalidateMenuCards() {
+  drawnMenu = nullptr;
+  for (int slot = 0; slot < MENU_SLOT_COUNT; slot++) {
+    drawnSlotItems[slot] = -1;
+  }
+}
 
-  // Draw card below (next item in list)
-  if (currentSelection < numItems - 1) {
-    int stackY1 = mainCardY + mainCardHeight + stackOffset;
-    tft.fillRoundRect(stackCardX, stackY1, stackCardWidth, stackCardHeight, 6, 0x2104);
+// Draw the carousel, repainting only slots whose item changed
+void drawMenuCards(const MenuDef &menu) {
+  DISPLAY_STATS_SCREEN("drawMenuCards");
+  for (int slot = 0; slot < MENU_SLOT_COUNT; slot++) {
+    int item = currentSelection + slot - MENU_SLOT_MAIN;
+    if (item < 0 || item >= menu.count) {
+      item = -1;
+    }
 
-    // Draw small circle for icon
-    tft.drawCircle(stackCardX + 12, stackY1 + 12, 8, 0x4208);
-    tft.setTextSize(1);
-    tft.setTextColor(0x7BEF);
-    tft.setCursor(stackCardX + 10, stackY1 + 9); // Letter centered in circle
-    tft.print(icons[currentSelection + 1]);
+    // Empty stays empty across menus; a filled slot must show the same item of the same menu
+    if (item == drawnSlotItems[slot] && (item < 0 || drawnMenu == &menu)) {
+      continue;
+    }
 
-    // Draw text
-    tft.setCursor(stackCardX + 28, stackY1 + 8);
-    tft.print(options[currentSelection + 1]);
+    const MenuCardSlot &s = menuSlots[slot];
+    if (item < 0) {
+      tft.fillRect(s.x, s.y, s.w, s.h, COLOR_BACKGROUND);
+    } else {
+      drawMenuCard(slot, menu.items[item]);
+    }
+    drawnSlotItems[slot] = item;
   }
+  drawnMenu = &menu;
+}
 
-  // Draw card further below (next+1 item)
-  if (currentSelection < numItems - 2) {
-    int stackY2 = mainCardY + mainCardHeight + stackOffset + stackCardHeight + 6;
-    int stackCardWidth2 = 250;
-    int stackCardX2 = (SCREEN_WIDTH - stackCardWidth2) / 2;
-    tft.fillRoundRect(stackCardX2, stackY2, stackCardWidth2, 18, 4, 0x1082);
+// Draw one carousel card; each card fully covers its slot so no clear is needed
+void drawMenuCard(int slot, const MenuItem &item) {
+  const MenuCardSlot &s = menuSlots[slot];
+
+  if (slot == MENU_SLOT_MAIN) {
+    // Selected card (large and prominent)
+    tft.fillRoundRect(s.x, s.y, s.w, s.h, s.r, 0x249F); // Blue accent
+    tft.drawRoundRect(s.x, s.y, s.w, s.h, s.r, 0x34BF); // Lighter outline
+
+    // Draw icon circle for selected
+    tft.fillCircle(s.x + 30, s.y + 30, 20, 0x34BF);
+    tft.drawCircle(s.x + 30, s.y + 30, 20, ST77XX_WHITE); // White outline
+    tft.setTextSize(3);
+    tft.setTextColor(ST77XX_WHITE);
+    tft.setCursor(s.x + 23, s.y + 20); // Letter centered in circle
+    tft.print(item.icon);
+
+    // Draw menu text for selected (slightly larger)
+    tft.setTextSize(2);
+    tft.setTextColor(ST77XX_WHITE);
+    tft.setCursor(s.x + 65, s.y + 22);
+    tft.print(item.label);
+
+    // Draw selection arrow
+    tft.fillTriangle(s.x + s.w - 20, s.y + 25,
+                     s.x + s.w - 20, s.y + 35,
+                     s.x + s.w - 10, s.y + 30, ST77XX_WHITE);
+  }
+  else if (slot == MENU_SLOT_COUNT - 1) {
+    // Card further below (next+1 item), smaller and dimmer
+    tft.fillRoundRect(s.x, s.y, s.w, s.h, s.r, 0x1082);
 
     // Draw small circle for icon
-    tft.drawCircle(stackCardX2 + 10, stackY2 + 9, 6, 0x3186);
+    tft.drawCircle(s.x + 10, s.y + 9, 6, 0x3186);
     tft.setTextSize(1);
     tft.setTextColor(0x5AEB);
-    tft.setCursor(stackCardX2 + 8, stackY2 + 6); // Letter centered in circle
-    tft.print(icons[currentSelection + 2]);
+    tft.setCursor(s.x + 8, s.y + 6); // Letter centered in circle
+    tft.print(item.icon);
 
     // Draw text
-    tft.setCursor(stackCardX2 + 22, stackY2 + 5);
-    tft.print(options[currentSelection + 2]);
+    tft.setCursor(s.x + 22, s.y + 5);
+    tft.print(item.label);
   }
-
-  // Draw card above (previous item in list)
-  if (currentSelection > 0) {
-    int stackY0 = mainCardY - stackCardHeight - stackOffset;
-    tft.fillRoundRect(stackCardX, stackY0, stackCardWidth, stackCardHeight, 6, 0x2104);
+  else {
+    // Stack card directly above or below the selection
+    tft.fillRoundRect(s.x, s.y, s.w, s.h, s.r, 0x2104);
 
     // Draw small circle for icon
-    tft.drawCircle(stackCardX + 12, stackY0 + 12, 8, 0x4208);
+    tft.drawCircle(s.x + 12, s.y + 12, 8, 0x4208);
     tft.setTextSize(1);
     tft.setTextColor(0x7BEF);
-    tft.setCursor(stackCardX + 10, stackY0 + 9); // Letter centered in circle
-    tft.print(icons[currentSelection - 1]);
+    tft.setCursor(s.x + 10, s.y + 9); // Letter centered in circle
+    tft.print(item.icon);
 
     // Draw text
-    tft.setCursor(stackCardX + 28, stackY0 + 8);
-    tft.print(options[currentSelection - 1]);
+    tft.setCursor(s.x + 28, s.y + 8);
+    tft.print(item.label);
   }
 }
 
 void drawStatusIcons() {
+  DISPLAY_STATS_SCREEN("drawStatusIcons");
   int iconX = SCREEN_WIDTH - 10; // Start from right edge
   int iconY = 13; // Vertically centered in 40px header
 
@@ -625,6 +969,7 @@ void drawBatteryIcon(int x, int y) {
   // Battery outline (24x14 pixels - larger for better visibility)
   tft.drawRect(x, y, 24, 14, ST77XX_WHITE);
   tft.fillRect(x + 24, y + 4, 2, 6, ST77XX_WHITE); // Battery nub
+  tft.fillRect(x + 1, y + 1, 22, 12, 0x1082);       // Clear the old level (header colour)
 
   // Determine battery color based on percentage
   uint16_t fillColor;
@@ -639,14 +984,7 @@ void drawBatteryIcon(int x, int y) {
   // Fill battery based on percentage
   int fillWidth = (batteryPercent * 20) / 100; // 20 pixels max fill
 
-  if (DEBUG_ENABLED) {
-    Serial.print("Drawing battery: ");
-    Serial.print(batteryPercent);
-    Serial.print("% fillWidth=");
-    Serial.print(fillWidth);
-    Serial.print(" charging=");
-    Serial.println(isCharging ? "YES" : "NO");
-  }
+  TRACE(TRACE_BATTERY_ICON, batteryPercent, fillWidth, isCharging);
 
   if (fillWidth > 0) {
     tft.fillRect(x + 2, y + 2, fillWidth, 10, fillColor);
@@ -675,52 +1013,25 @@ void drawWiFiIcon(int x, int y) {
 }
 
 void updateStatus() {
+  SPAN("updateStatus");
   // Update WiFi status
   wifiConnected = WiFi.status() == WL_CONNECTED;
 
-  // Read battery voltage and percentage from I2C battery monitor
-  float voltage = 3.7; // Default
+  // Battery from the fuel gauge task's filtered snapshot (no I2C here)
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  float voltage = 3.7;
   batteryPercent = 50;
-
-  if (hasLC709203) {
-    voltage = lc.cellVoltage();
-    batteryPercent = (int)lc.cellPercent();
-  }
-  else if (hasMAX17048) {
-    voltage = maxlipo.cellVoltage();
-    batteryPercent = (int)maxlipo.cellPercent();
-  }
-  else {
-    // No battery monitor - show placeholder values
-    voltage = 3.7;
-    batteryPercent = 50;
-  }
-
-  // Validate readings
-  if (voltage < 2.5 || voltage > 5.0) {
-    voltage = 3.7;
-  }
-
-  // Constrain to 0-100%
-  if (batteryPercent > 100) batteryPercent = 100;
-  if (batteryPercent < 0) batteryPercent = 0;
-
-  // USB detection DISABLED - A3 conflicts with I2S_LCK_PIN (GPIO 15)
-  // Cannot use analogRead on GPIO 15 or it breaks I2S audio!
-  // Assume not charging for now (could use battery voltage trend instead)
   isCharging = false;
 
-  // Debug output
-  if (DEBUG_ENABLED) {
-    Serial.print("Battery: ");
-    Serial.print(voltage);
-    Serial.print("V (");
-    Serial.print(batteryPercent);
-    Serial.print("%) ");
-    Serial.print(isCharging ? "CHARGING" : "");
-    Serial.print(" | WiFi: ");
-    Serial.println(wifiConnected ? "Connected" : "Disconnected");
+  if (hasBatteryMonitor && gauge.valid) {
+    voltage = gauge.voltage;
+    batteryPercent = constrain((int)(gauge.percent + 0.5f), 0, 100);
+    // USB detection is unavailable (A3 is the I2S LRC pin); charging comes from the gauge trend
+    isCharging = gauge.charging;
   }
+  // No battery monitor (or no sample yet) - show placeholder values
+
+  TRACE(TRACE_STATUS, (int32_t)(voltage * 1000), batteryPercent, wifiConnected);
 }
 
 void drawFooter() {
@@ -745,94 +1056,110 @@ void drawFooter() {
 }
 
 void selectMenuItem() {
+  const MenuDef* menu = findMenu(currentMode);
+  if (menu == nullptr) {
+    return;
+  }
+
   // Play confirmation beep
   beep(TONE_SELECT, BEEP_MEDIUM);
 
-  String selectedItem;
-
-  if (currentMode == MODE_MAIN_MENU) {
-    selectedItem = mainMenuOptions[currentSelection];
-
-    // Handle main menu selections
-    if (currentSelection == 0) {
-      // Training
-      currentMode = MODE_TRAINING_MENU;
-      currentSelection = 0;
-      drawMenu();
+  MenuMode target = menu->items[currentSelection].target;
 
-    } else if (currentSelection == 1) {
-      // Settings
-      currentMode = MODE_SETTINGS_MENU;
-      currentSelection = 0;
-      drawMenu();
+  // Submenus are drawn by the carousel
+  if (findMenu(target) != nullptr) {
+    currentMode = target;
+    currentSelection = 0;
+    drawMenu();
+    return;
+  }
 
-    } else if (currentSelection == 2) {
-      // WiFi (Vail Repeater)
-      if (WiFi.status() != WL_CONNECTED) {
-        // Not connected to WiFi
-        tft.fillScreen(COLOR_BACKGROUND);
-        tft.setTextSize(2);
-        tft.setTextColor(ST77XX_RED);
-        tft.setCursor(30, 100);
-        tft.print("Connect WiFi");
-        tft.setTextSize(1);
-        tft.setTextColor(ST77XX_WHITE);
-        tft.setCursor(20, 130);
-        tft.print("Settings > WiFi Setup");
-        delay(2000);
-        drawMenu();
-      } else {
-        // Connected to WiFi, start Vail repeater
-        currentMode = MODE_VAIL_REPEATER;
-        startVailRepeater(tft);
-        connectToVail(vailChannel);  // Use default channel
-      }
+  // Everything else paints over the carousel
+  invalidateMenuCards();
 
-    } else if (currentSelection == 3) {
-      // Bluetooth
+  if (target == MODE_VAIL_REPEATER) {
+    // WiFi (Vail Repeater)
+    if (WiFi.status() != WL_CONNECTED) {
+      // Not connected to WiFi
       tft.fillScreen(COLOR_BACKGROUND);
       tft.setTextSize(2);
+      tft.setTextColor(ST77XX_RED);
+      tft.setCursor(30, 100);
+      tft.print("Connect WiFi");
+      tft.setTextSize(1);
       tft.setTextColor(ST77XX_WHITE);
-      tft.setCursor(50, 100);
-      tft.print("Bluetooth coming soon");
-      delay(1500);
+      tft.setCursor(20, 130);
+      tft.print("Settings > WiFi Setup");
+      delay(2000);
       drawMenu();
+    } else {
+      // Connected to WiFi, start Vail repeater
+      currentMode = MODE_VAIL_REPEATER;
+      startVailRepeater(tft);
+      connectToVail(vailChannel);  // Use default channel
     }
 
-  } else if (currentMode == MODE_TRAINING_MENU) {
-    selectedItem = trainingMenuOptions[currentSelection];
+  } else if (target == MODE_BLUETOOTH) {
+    // Bluetooth
+    tft.fillScreen(COLOR_BACKGROUND);
+    tft.setTextSize(2);
+    tft.setTextColor(ST77XX_WHITE);
+    tft.setCursor(50, 100);
+    tft.print("Bluetooth coming soon");
+    delay(1500);
+    drawMenu();
+
+  } else if (target == MODE_HEAR_IT_TYPE_IT) {
+    // Hear It Type It
+    currentMode = MODE_HEAR_IT_TYPE_IT;
+    randomSeed(analogRead(0)); // Seed random number generator
+    startNewCallsign();
+    drawMenu();
+    delay(1000); // Brief pause before starting
+    playCurrentCallsign();
+    drawHearItTypeItUI(tft);
 
-    // Handle training menu selections
-    if (currentSelection == 0) {
-      // Hear It Type It
-      currentMode = MODE_HEAR_IT_TYPE_IT;
-      randomSeed(analogRead(0)); // Seed random number generator
-      startNewCallsign();
-      drawMenu();
-      delay(1000); // Brief pause before starting
-      playCurrentCallsign();
-      drawHearItTypeItUI(tft);
-    } else if (currentSelection == 1) {
-      // Practice
-      currentMode = MODE_PRACTICE;
-      startPracticeMode(tft);
-    }
-  } else if (currentMode == MODE_SETTINGS_MENU) {
-    selectedItem = settingsMenuOptions[currentSelection];
-
-    // Handle settings menu selections
-    if (currentSelection == 0) {
-      // WiFi Setup
-      currentMode = MODE_WIFI_SETTINGS;
-      startWiFiSettings(tft);
-    } else if (currentSelection == 1) {
-      // CW Settings
-      currentMode = MODE_CW_SETTINGS;
-      startCWSettings(tft);
-    } else if (currentSelection == 2) {
-      // Volume Settings
-      currentMode = MODE_VOLUME_SETTINGS;
-      initVolumeSettings(tft);
+  } else if (target == MODE_PRACTICE) {
+    // Practice
+    currentMode = MODE_PRACTICE;
+    startPracticeMode(tft);
+
+  } else if (target == MODE_WIFI_SETTINGS) {
+    // WiFi Setup
+    currentMode = MODE_WIFI_SETTINGS;
+    startWiFiSettings(tft);
+
+  } else if (target == MODE_CW_SETTINGS) {
+    // CW Settings
+    currentMode = MODE_CW_SETTINGS;
+    startCWSettings(tft);
+
+  } else if (target == MODE_VOLUME_SETTINGS) {
+    // Volume Settings
+    currentMode = MODE_VOLUME_SETTINGS;
+    initVolumeSettings(tft);
+
+  } else if (target == MODE_POWER_DIAGNOSTICS) {
+    // Power profiles and measured current
+    currentMode = MODE_POWER_DIAGNOSTICS;
+    drawMenu();
+
+  } else if (target == MODE_ENERGY_REPORT) {
+    // Energy per state and runtime prediction
+    currentMode = MODE_ENERGY_REPORT;
+    drawMenu();
+
+  } else if (target == MODE_LATENCY_REPORT) {
+    // Paddle/network/audio latency histograms
+    currentMode = MODE_LATENCY_REPORT;
+    drawMenu();
+
+  } else if (target == MODE_RUNTIME_DIAGNOSTICS) {
+    // CPU, heap and stack per subsystem (sampled now if no status event has yet)
+    currentMode = MODE_RUNTIME_DIAGNOSTICS;
+    if (runtimeSampleData.atMs == 0) {
+      runtimeSample();
     }
+    drawMenu();
   }
 }
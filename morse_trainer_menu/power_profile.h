@@ -0,0 +1,312 @@
+/*
+ * Power Profiles
+ * CPU clock, WiFi power save and backlight per kind of screen
+ *
+ * loop() applies the profile for the current mode on every pass (a no-op
+ * unless it changed). Menus run slow with WiFi in maximum modem sleep;
+ * practice runs at full clock with WiFi off for clean audio and brings the
+ * previous connection back when it is left; Vail keeps the radio awake for
+ * low latency. Light sleep stays with the event loop's active-mode lock.
+ *
+ * Battery current per profile is estimated from the fuel gauge's charge
+ * rate (%/hr of BATTERY_CAPACITY_MAH) while discharging, after the gauge
+ * has had POWER_SETTLE_MS to catch up with a profile change.
+ */
+
+#ifndef POWER_PROFILE_H
+#define POWER_PROFILE_H
+
+#include <Adafruit_ST7789.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include "config.h"
+#include "display_stats.h"
+#include "event_loop.h"
+#include "fuel_gauge.h"
+#include "settings_wifi.h"
+
+enum PowerProfileId : uint8_t {
+  POWER_PROFILE_MENU,
+  POWER_PROFILE_PRACTICE,
+  POWER_PROFILE_HEAR_IT_TYPE_IT,
+  POWER_PROFILE_VAIL,
+  POWER_PROFILE_COUNT
+};
+
+// WiFi setting of a profile: off, or a modem power-save level
+enum PowerWiFi : uint8_t {
+  POWER_WIFI_OFF,
+  POWER_WIFI_AWAKE,      // WIFI_PS_NONE
+  POWER_WIFI_MAX_SAVE    // WIFI_PS_MAX_MODEM (wakes per listen interval)
+};
+
+struct PowerProfile {
+  const char* name;
+  uint16_t cpuMaxMHz;
+  uint16_t cpuMinMHz;    // Floor while idle (esp_pm)
+  PowerWiFi wifi;
+  uint8_t backlight;     // ledcWrite duty, 0-255
+};
+
+constexpr PowerProfile powerProfiles[POWER_PROFILE_COUNT] = {
+  {"Menu",     80,  80,  POWER_WIFI_MAX_SAVE, 160},  // SPI-bound redraws, nothing real-time
+  {"Practice", 240, 240, POWER_WIFI_OFF,      160},  // Keyer timing and sidetone; mostly listening
+  {"Hear It",  160, 80,  POWER_WIFI_MAX_SAVE, 255},  // Tone synthesis, typing
+  {"Vail",     240, 80,  POWER_WIFI_AWAKE,    255}   // WebSocket latency
+};
+
+// Measured battery current per profile (diagnostics screen, serial "power")
+struct PowerProfileStats {
+  uint32_t samples;      // Gauge samples counted (FUEL_GAUGE_SAMPLE_MS apart)
+  float totalMa;
+};
+
+PowerProfileStats powerProfileStats[POWER_PROFILE_COUNT] = {};
+int8_t activePowerProfile = -1;          // None applied yet
+uint32_t powerProfileSince = 0;          // millis() of the last change
+uint32_t powerLastGaugeSample = 0;       // Fuel gauge sample count already counted
+bool powerWiFiRestore = false;           // Reconnect when leaving a WiFi-off profile
+bool powerWiFiRestoreCached = false;     // powerWiFiNetwork holds the network that was up
+SavedNetwork powerWiFiNetwork;
+
+// Forward declarations
+void applyPowerProfile(PowerProfileId id);
+void updatePowerProfileStats();
+void drawPowerDiagnosticsUI(Adafruit_ST7789 &display);
+int handlePowerDiagnosticsInput(char key, Adafruit_ST7789 &display);
+void printPowerProfiles();
+void resetPowerProfileStats();
+
+const char* powerWiFiName(PowerWiFi wifi) {
+  switch (wifi) {
+    case POWER_WIFI_OFF:   return "off";
+    case POWER_WIFI_AWAKE: return "awake";
+    default:               return "max save";
+  }
+}
+
+// CPU clock through esp_pm (keeps light sleep if the event loop enabled it)
+void applyCpuFrequency(const PowerProfile &profile) {
+  esp_pm_config_t pmConfig = {};
+  pmConfig.max_freq_mhz = profile.cpuMaxMHz;
+  pmConfig.min_freq_mhz = profile.cpuMinMHz;
+  pmConfig.light_sleep_enable = lightSleepAvailable;
+  if (esp_pm_configure(&pmConfig) != ESP_OK) {
+    setCpuFrequencyMhz(profile.cpuMaxMHz);  // Core without power management: fixed clock
+  }
+}
+
+// Turn WiFi off, remembering the connection (or attempt) to bring back
+void suspendWiFiForProfile() {
+  bool connected = WiFi.status() == WL_CONNECTED;
+  if (connected || wifiConnectInProgress()) {
+    powerWiFiRestore = true;
+    powerWiFiRestoreCached = false;
+    if (connected) {
+      loadSavedNetworks();
+      int slot = findSavedNetwork(WiFi.SSID());
+      if (slot >= 0) {
+        powerWiFiNetwork = savedNetworks[slot];  // Cached BSSID/channel/lease for a fast reconnect
+        powerWiFiRestoreCached = true;
+      }
+    }
+  }
+  cancelWiFiConnection();
+  stopWiFiScan();
+  Serial.println("Power profile: WiFi off");
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+}
+
+/*
+ * Bring back what suspendWiFiForProfile() turned off. Runs inside
+ * applyPowerProfile(), so only non-blocking starts: the fast path to the
+ * network that was up, else auto-connect, whose passive scan is polled by
+ * updateWiFiConnection() like the connect itself.
+ */
+void restoreWiFiAfterProfile() {
+  if (!powerWiFiRestore) return;
+  powerWiFiRestore = false;
+  Serial.println("Power profile: restoring WiFi");
+  if (powerWiFiRestoreCached) {
+    resumeWiFiConnection(powerWiFiNetwork);
+  } else {
+    autoConnectWiFi();
+  }
+}
+
+/*
+ * Switch to a profile (cheap when it is already active). WiFi-off profiles
+ * are re-checked every pass, so a connection started in the background
+ * (boot auto-connect) is turned off as well.
+ */
+void applyPowerProfile(PowerProfileId id) {
+  const PowerProfile &profile = powerProfiles[id];
+
+  if (profile.wifi == POWER_WIFI_OFF && WiFi.getMode() != WIFI_OFF) {
+    suspendWiFiForProfile();
+  }
+  if (id == activePowerProfile) return;
+
+  const PowerProfile* previous = (activePowerProfile >= 0) ? &powerProfiles[activePowerProfile] : nullptr;
+  activePowerProfile = id;
+  powerProfileSince = millis();
+
+  applyCpuFrequency(profile);
+  ledcWrite(TFT_BL, profile.backlight);
+
+  // Kept by the WiFi class and applied whenever the station starts
+  if (profile.wifi == POWER_WIFI_AWAKE) {
+    WiFi.setSleep(WIFI_PS_NONE);
+  } else if (profile.wifi == POWER_WIFI_MAX_SAVE) {
+    WiFi.setSleep(WIFI_PS_MAX_MODEM);
+  }
+  if (previous != nullptr && previous->wifi == POWER_WIFI_OFF && profile.wifi != POWER_WIFI_OFF) {
+    restoreWiFiAfterProfile();
+  }
+
+  Serial.printf("Power profile: %s (%d-%d MHz, WiFi %s, backlight %d)\n", profile.name,
+                profile.cpuMinMHz, profile.cpuMaxMHz, powerWiFiName(profile.wifi), profile.backlight);
+}
+
+/*
+ * Count each new fuel gauge sample toward the active profile, once the
+ * gauge's averaged rate reflects it (call every loop pass)
+ */
+void updatePowerProfileStats() {
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  if (gauge.samples == powerLastGaugeSample) return;
+  powerLastGaugeSample = gauge.samples;
+
+  if (activePowerProfile < 0 || millis() - powerProfileSince < POWER_SETTLE_MS) return;
+  float ma = fuelGaugeCurrentMa(gauge);
+  if (isnan(ma) || ma <= 0) return;
+
+  PowerProfileStats &stats = powerProfileStats[activePowerProfile];
+  stats.samples++;
+  stats.totalMa += ma;
+}
+
+// Measured average for one profile ("--" until there is data)
+void formatProfileCurrent(int id, char* text, size_t size) {
+  const PowerProfileStats &stats = powerProfileStats[id];
+  if (stats.samples == 0) {
+    snprintf(text, size, "-- mA");
+    return;
+  }
+  uint32_t minutes = (uint32_t)((uint64_t)stats.samples * FUEL_GAUGE_SAMPLE_MS / 60000);
+  snprintf(text, size, "%.0f mA (%lu min)", stats.totalMa / stats.samples, (unsigned long)minutes);
+}
+
+/*
+ * Diagnostics screen (Settings > Power): each profile with its settings
+ * and measured current, the active one highlighted. Redrawn on EVENT_STATUS.
+ */
+void drawPowerDiagnosticsUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawPowerDiagnosticsUI");
+  display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
+
+  int cardX = 20;
+  int cardY = 50;
+  int cardW = SCREEN_WIDTH - 40;
+  int cardH = 154;
+
+  display.fillRoundRect(cardX, cardY, cardW, cardH, 12, 0x1082); // Dark blue fill
+  display.drawRoundRect(cardX, cardY, cardW, cardH, 12, 0x34BF); // Light blue outline
+
+  char text[32];
+  for (int id = 0; id < POWER_PROFILE_COUNT; id++) {
+    const PowerProfile &profile = powerProfiles[id];
+    int yPos = cardY + 5 + id * 36;
+    bool isActive = (id == activePowerProfile);
+
+    if (isActive) {
+      display.fillRoundRect(cardX + 8, yPos, cardW - 16, 34, 8, 0x249F); // Blue highlight
+    }
+
+    display.setTextSize(2);
+    display.setTextColor(isActive ? ST77XX_WHITE : ST77XX_CYAN);
+    display.setCursor(cardX + 15, yPos + 10);
+    display.print(profile.name);
+
+    display.setTextSize(1);
+    display.setTextColor(isActive ? ST77XX_WHITE : 0x7BEF); // Light gray
+    display.setCursor(cardX + 125, yPos + 7);
+    snprintf(text, sizeof(text), "%d MHz  WiFi %s", profile.cpuMaxMHz, powerWiFiName(profile.wifi));
+    display.print(text);
+
+    display.setCursor(cardX + 125, yPos + 20);
+    formatProfileCurrent(id, text, sizeof(text));
+    display.print("BL ");
+    display.print(profile.backlight * 100 / 255);
+    display.print("%  ");
+    display.print(text);
+  }
+
+  // Live reading under the card
+  FuelGaugeStatus gauge = getFuelGaugeStatus();
+  float ma = fuelGaugeCurrentMa(gauge);
+  if (!hasBatteryMonitor) {
+    snprintf(text, sizeof(text), "No battery monitor");
+  } else if (gauge.valid && gauge.charging) {
+    snprintf(text, sizeof(text), "Charging - not measuring");
+  } else if (isnan(ma)) {
+    snprintf(text, sizeof(text), "Waiting for the fuel gauge");
+  } else {
+    snprintf(text, sizeof(text), "Now: %.0f mA (%+.1f %%/hr)", ma, gauge.chargeRate);
+  }
+  display.setTextSize(1);
+  display.setTextColor(ST77XX_WHITE);
+  display.setCursor(cardX + 5, cardY + cardH + 6);
+  display.print(text);
+
+  display.setTextColor(COLOR_WARNING);
+  String footerText = "R Reset  ESC Back";
+
+  int16_t x1, y1;
+  uint16_t w, h;
+  display.getTextBounds(footerText, 0, 0, &x1, &y1, &w, &h);
+  int centerX = (SCREEN_WIDTH - w) / 2;
+  display.setCursor(centerX, SCREEN_HEIGHT - 12);
+  display.print(footerText);
+}
+
+// Returns: -1 to exit, 0 to continue
+int handlePowerDiagnosticsInput(char key, Adafruit_ST7789 &display) {
+  if (key == KEY_ESC) {
+    return -1;
+  }
+  if (key == 'r' || key == 'R') {
+    resetPowerProfileStats();
+    beep(TONE_SELECT, BEEP_SHORT);
+    drawPowerDiagnosticsUI(display);
+  }
+  return 0;
+}
+
+// Serial "power" command
+void printPowerProfiles() {
+  char text[32];
+  Serial.printf("Power profiles (active: %s, battery %d mAh):\n",
+                activePowerProfile >= 0 ? powerProfiles[activePowerProfile].name : "none",
+                BATTERY_CAPACITY_MAH);
+  for (int id = 0; id < POWER_PROFILE_COUNT; id++) {
+    const PowerProfile &profile = powerProfiles[id];
+    formatProfileCurrent(id, text, sizeof(text));
+    Serial.printf("  %-9s %3d-%3d MHz  WiFi %-8s  backlight %3d  %s\n", profile.name, profile.cpuMinMHz,
+                  profile.cpuMaxMHz, powerWiFiName(profile.wifi), profile.backlight, text);
+  }
+  float ma = fuelGaugeCurrentMa(getFuelGaugeStatus());
+  if (!isnan(ma)) {
+    Serial.printf("  Now: %.0f mA\n", ma);
+  }
+}
+
+void resetPowerProfileStats() {
+  for (int id = 0; id < POWER_PROFILE_COUNT; id++) {
+    powerProfileStats[id] = {};
+  }
+  powerProfileSince = millis();
+}
+
+#endif // POWER_PROFILE_H
@@ -0,0 +1,117 @@
+/*
+ * RTC Resume
+ * Picks up where deep sleep left off instead of cold-booting
+ *
+ * Before sleeping, the screen, settings, Vail channel, which battery monitor
+ * is fitted and the WiFi network that was up (with its cached BSSID, channel
+ * and lease) are copied to RTC slow memory, which keeps power in deep sleep.
+ * A paddle wake finds them there and skips the serial wait, the NVS reads,
+ * the battery monitor probe, the display reset pulse and the passive scan.
+ * Any other reset (power on, flashing, brownout) boots normally.
+ */
+
+#ifndef RTC_RESUME_H
+#define RTC_RESUME_H
+
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include "config.h"
+#include "settings_store.h"
+#include "wifi_credentials.h"
+#include "vail_repeater.h"
+
+// Bumps with the layout so a different firmware never reads a stale struct
+#define RESUME_MAGIC (0x52455300u | (uint32_t)(sizeof(ResumeState) & 0xFF))
+
+enum ResumeBattery : uint8_t {
+  RESUME_BATTERY_NONE,
+  RESUME_BATTERY_MAX17048,
+  RESUME_BATTERY_LC709203F,
+  RESUME_BATTERY_UNKNOWN = 0xFF  // Cold boot: probe for both
+};
+
+struct ResumeState {
+  uint32_t magic;           // RESUME_MAGIC while valid
+  uint8_t mode;             // MenuMode when sleep was entered
+  uint8_t selection;        // Menu cursor
+  uint8_t battery;          // ResumeBattery
+  bool wifiUp;              // network holds the connection that was up
+  DeviceSettings settings;
+  char vailChannel[24];
+  SavedNetwork network;
+};
+
+RTC_DATA_ATTR ResumeState resumeState;
+RTC_DATA_ATTR uint32_t deepSleepCount = 0;  // Since power on (RTC data is zeroed on a cold boot)
+
+bool resumedFromSleep = false;
+uint64_t resumeWakeMask = 0;     // Paddle pin(s) that woke us
+
+// Forward declarations
+void saveResumeState(uint8_t mode, uint8_t selection, uint8_t battery);
+bool checkResumeState();
+void enablePaddleWakeup();
+
+/*
+ * Copy everything a resume needs into RTC memory (call after flushSettings(),
+ * before WiFi is shut down)
+ */
+void saveResumeState(uint8_t mode, uint8_t selection, uint8_t battery) {
+  memset(&resumeState, 0, sizeof(resumeState));
+  deepSleepCount++;
+  resumeState.mode = mode;
+  resumeState.selection = selection;
+  resumeState.battery = battery;
+  resumeState.settings = deviceSettings;
+  strlcpy(resumeState.vailChannel, vailChannel.c_str(), sizeof(resumeState.vailChannel));
+
+  if (WiFi.status() == WL_CONNECTED) {
+    loadSavedNetworks();
+    int slot = findSavedNetwork(WiFi.SSID());
+    if (slot >= 0) {
+      resumeState.network = savedNetworks[slot];  // Cache refreshed on every connect
+      resumeState.wifiUp = true;
+    }
+  }
+  resumeState.magic = RESUME_MAGIC;
+}
+
+/*
+ * At boot: true when a paddle woke us and the RTC copy is good. Restores
+ * the settings and Vail channel; the sketch restores the rest. The copy is
+ * used once, so a crash during resume boots normally next time.
+ */
+bool checkResumeState() {
+#if SLEEP_RESUME_ENABLED
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT1 || resumeState.magic != RESUME_MAGIC) {
+    return false;
+  }
+  resumeState.magic = 0;
+  resumeWakeMask = esp_sleep_get_ext1_wakeup_status();
+  if (!restoreSettings(resumeState.settings)) {
+    return false;
+  }
+  resumeState.vailChannel[sizeof(resumeState.vailChannel) - 1] = '\0';
+  vailChannel = resumeState.vailChannel;
+  resumedFromSleep = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Wake on either paddle (ext1, any pin low). RTC peripherals stay powered
+ * so the pins keep their pull-ups through deep sleep.
+ */
+void enablePaddleWakeup() {
+  const gpio_num_t pins[] = {(gpio_num_t)DIT_PIN, (gpio_num_t)DAH_PIN};
+  for (gpio_num_t pin : pins) {
+    rtc_gpio_pullup_en(pin);
+    rtc_gpio_pulldown_dis(pin);
+  }
+  esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+  esp_sleep_enable_ext1_wakeup((1ULL << DIT_PIN) | (1ULL << DAH_PIN), ESP_EXT1_WAKEUP_ANY_LOW);
+}
+
+#endif // RTC_RESUME_H
@@ -0,0 +1,441 @@
+/*
+ * Runtime Diagnostics
+ * CPU, heap and stack per subsystem, and how long loop passes take
+ *
+ * On every EVENT_STATUS (STATUS_UPDATE_MS) runtimeSample() reads the
+ * FreeRTOS task table (run time and stack high-water mark per task) and
+ * the heap: free, lowest ever free, largest free block, fragmentation and
+ * PSRAM. Tasks belong to a subsystem by name (the I2C task to UI, lwIP
+ * and WiFi tasks to network, loopTask to the loop, the rest to system);
+ * the loop task's CPU is split by the time its subsystem scopes took
+ * (subsystem_scope.h), which also give the heap each subsystem holds.
+ * Every loop pass (after the event wait) goes into a histogram.
+ *
+ * Settings > Diagnostics shows the latest sample. "diag" prints it as
+ * CSV; "diag stream" adds a CSV row per sample, for logging a long
+ * session and spotting a slow leak before it brings the device down.
+ */
+
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include <Adafruit_ST7789.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "display_stats.h"
+#include "latency_stats.h"
+#include "subsystem_scope.h"
+
+#define RUNTIME_MAX_TASKS  24    // Task table size (uxTaskGetSystemState fails if there are more)
+#define RUNTIME_NO_STACK   UINT32_MAX
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define RUNTIME_TASK_STATS 1
+#else
+#define RUNTIME_TASK_STATS 0
+#endif
+
+const char* const subsystemNames[SUBSYSTEM_COUNT] = {"audio", "network", "ui", "loop", "system"};
+
+// Tasks by name prefix; IDLE tasks are idle time, anything unlisted is system
+struct TaskSubsystem {
+  const char* prefix;
+  Subsystem subsystem;
+};
+const TaskSubsystem taskSubsystems[] = {
+  {"loopTask",       SUBSYSTEM_LOOP},
+  {"i2c",            SUBSYSTEM_UI},       // CardKB polling (i2c_bus.h)
+  {"tiT",            SUBSYSTEM_NETWORK},  // lwIP
+  {"wifi",           SUBSYSTEM_NETWORK},
+  {"sys_evt",        SUBSYSTEM_NETWORK},
+  {"arduino_events", SUBSYSTEM_NETWORK}
+};
+
+struct RuntimeTask {
+  char name[16];            // configMAX_TASK_NAME_LEN
+  TaskHandle_t handle;
+  Subsystem subsystem;
+  bool idle;
+  int8_t core;              // -1 = either core
+  uint8_t priority;
+  uint32_t runCounter;      // FreeRTOS run time at the last sample
+  float cpuPercent;         // Of one core over the last sample
+  uint32_t stackFree;       // High-water mark: least stack ever free (bytes)
+};
+
+struct RuntimeSubsystem {
+  float cpuPercent;         // Of one core
+  uint32_t loopMicros;      // Loop time in its scopes over the last sample
+  int32_t heldBytes;        // Net heap allocated in its scopes since reset
+  uint32_t stackFree;       // Least free stack among its tasks
+};
+
+struct RuntimeSample {
+  uint32_t atMs;
+  uint32_t windowMs;
+  uint32_t heapFree;
+  uint32_t heapMinFree;
+  uint32_t heapLargest;
+  uint8_t fragmentation;    // 100 - largest block / free, in percent
+  uint32_t psramTotal;      // 0 = no PSRAM
+  uint32_t psramFree;
+  float idlePercent;        // Of both cores together
+  uint8_t taskCount;
+  RuntimeTask tasks[RUNTIME_MAX_TASKS];
+  RuntimeSubsystem subsystems[SUBSYSTEM_COUNT];
+};
+
+// Diagnostics state
+RuntimeSample runtimeSampleData;
+LatencyHistogram runtimeLoopHistogram;   // Loop pass time (shares latency_stats.h buckets)
+uint32_t runtimePrevTotalRun = 0;
+uint32_t runtimePrevSampleMs = 0;
+bool runtimeStreaming = false;
+
+// Forward declarations
+void startRuntimeStats();
+void runtimeSample();
+void drawRuntimeUI(Adafruit_ST7789 &display);
+int handleRuntimeInput(char key, Adafruit_ST7789 &display);
+void printRuntimeStats();
+void printRuntimeStreamRow();
+void resetRuntimeStats();
+bool handleRuntimeCommand(const char* args);
+void beep(int frequency, int duration);
+
+// One loop pass: the loop's own subsystem scope plus the pass histogram
+class LoopPassScope {
+public:
+  LoopPassScope() : startMicros(micros()), scope(SUBSYSTEM_LOOP) {}
+  ~LoopPassScope() { latencyRecord(runtimeLoopHistogram, micros() - startMicros); }
+
+private:
+  uint32_t startMicros;
+  SubsystemScope scope;
+};
+
+#if RUNTIME_STATS_ENABLED
+#define RUNTIME_LOOP_PASS() LoopPassScope runtimeLoopPass
+#else
+#define RUNTIME_LOOP_PASS()
+#endif
+
+// Call early in setup() (on the loop task)
+void startRuntimeStats() {
+  startSubsystemScopes();
+  runtimePrevSampleMs = millis();
+}
+
+Subsystem subsystemForTask(const char* name, bool &idle) {
+  idle = (strncmp(name, "IDLE", 4) == 0);
+  for (const TaskSubsystem &entry : taskSubsystems) {
+    if (strncmp(name, entry.prefix, strlen(entry.prefix)) == 0) return entry.subsystem;
+  }
+  return SUBSYSTEM_SYSTEM;
+}
+
+// Heap, task table and subsystem split (EVENT_STATUS)
+void runtimeSample() {
+  RuntimeSample &s = runtimeSampleData;
+  uint32_t now = millis();
+  s.atMs = now;
+  s.windowMs = now - runtimePrevSampleMs;
+  runtimePrevSampleMs = now;
+
+  s.heapFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  s.heapMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  s.heapLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  s.fragmentation = s.heapFree ? (uint8_t)(100 - (uint64_t)s.heapLargest * 100 / s.heapFree) : 0;
+  s.psramTotal = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+  s.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) {
+    s.subsystems[i].cpuPercent = 0;
+    s.subsystems[i].loopMicros = subsystemMicros[i];
+    s.subsystems[i].heldBytes = subsystemHeld[i];
+    s.subsystems[i].stackFree = RUNTIME_NO_STACK;
+    subsystemMicros[i] = 0;
+  }
+
+#if RUNTIME_TASK_STATS
+  static TaskStatus_t status[RUNTIME_MAX_TASKS];
+  uint32_t totalRun = 0;
+  UBaseType_t count = uxTaskGetSystemState(status, RUNTIME_MAX_TASKS, &totalRun);
+  uint32_t window = totalRun - runtimePrevTotalRun;
+  bool haveWindow = (runtimePrevTotalRun != 0 && window > 0);
+  runtimePrevTotalRun = totalRun;
+
+  static RuntimeTask previous[RUNTIME_MAX_TASKS];
+  uint8_t previousCount = s.taskCount;
+  memcpy(previous, s.tasks, sizeof(RuntimeTask) * previousCount);
+
+  float loopCpu = 0;
+  float idle = 0;
+  s.taskCount = count;
+  for (UBaseType_t i = 0; i < count; i++) {
+    RuntimeTask &task = s.tasks[i];
+    strncpy(task.name, status[i].pcTaskName, sizeof(task.name) - 1);
+    task.name[sizeof(task.name) - 1] = '\0';
+    task.handle = status[i].xHandle;
+    task.subsystem = subsystemForTask(task.name, task.idle);
+#if configTASKLIST_INCLUDE_COREID
+    task.core = (status[i].xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)status[i].xCoreID;
+#else
+    task.core = -1;
+#endif
+    task.priority = (uint8_t)status[i].uxCurrentPriority;
+    task.runCounter = status[i].ulRunTimeCounter;
+    task.stackFree = status[i].usStackHighWaterMark;
+
+    // A task's share needs its counter from the last sample
+    task.cpuPercent = 0;
+    for (int p = 0; p < previousCount && haveWindow; p++) {
+      if (previous[p].handle == task.handle && strcmp(previous[p].name, task.name) == 0) {
+        task.cpuPercent = 100.0f * (uint32_t)(task.runCounter - previous[p].runCounter) / window;
+        break;
+      }
+    }
+
+    if (task.idle) {
+      idle += task.cpuPercent;
+      continue;
+    }
+    RuntimeSubsystem &sub = s.subsystems[task.subsystem];
+    if (task.stackFree < sub.stackFree) sub.stackFree = task.stackFree;
+    if (task.subsystem == SUBSYSTEM_LOOP) {
+      loopCpu += task.cpuPercent;
+    } else {
+      sub.cpuPercent += task.cpuPercent;
+    }
+  }
+  s.idlePercent = idle / 2;
+
+  // The loop task's CPU goes to the subsystems it worked for
+  uint32_t loopTotal = 0;
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) loopTotal += s.subsystems[i].loopMicros;
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) {
+    float share = loopTotal ? (float)s.subsystems[i].loopMicros / loopTotal : (i == SUBSYSTEM_LOOP);
+    s.subsystems[i].cpuPercent += loopCpu * share;
+  }
+#else
+  s.taskCount = 0;
+  s.idlePercent = 0;
+#endif
+
+  if (runtimeStreaming) printRuntimeStreamRow();
+}
+
+// ============================================
+// Report
+// ============================================
+
+// "182.3K" style byte counts (signed for held bytes)
+void formatBytes(char* text, size_t size, int32_t bytes, bool sign) {
+  const char* prefix = (sign && bytes > 0) ? "+" : "";
+  if (bytes >= 1024 || bytes <= -1024) {
+    snprintf(text, size, "%s%.1fK", prefix, bytes / 1024.0);
+  } else {
+    snprintf(text, size, "%s%ld", prefix, (long)bytes);
+  }
+}
+
+/*
+ * Settings > Diagnostics: heap, CPU/held heap/stack per subsystem and the
+ * loop pass times. Redrawn on EVENT_STATUS.
+ */
+void drawRuntimeUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawRuntimeUI");
+  const RuntimeSample &s = runtimeSampleData;
+  display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
+
+  int cardX = 20;
+  int cardY = 50;
+  int cardW = SCREEN_WIDTH - 40;
+  int cardH = 136;
+
+  display.fillRoundRect(cardX, cardY, cardW, cardH, 12, 0x1082); // Dark blue fill
+  display.drawRoundRect(cardX, cardY, cardW, cardH, 12, 0x34BF); // Light blue outline
+
+  char freeText[12], minFree[12], largest[12], psram[12];
+  formatBytes(freeText, sizeof(freeText), s.heapFree, false);
+  formatBytes(minFree, sizeof(minFree), s.heapMinFree, false);
+  formatBytes(largest, sizeof(largest), s.heapLargest, false);
+  if (s.psramTotal) {
+    formatBytes(psram, sizeof(psram), s.psramFree, false);
+  } else {
+    strcpy(psram, "none");
+  }
+
+  char text[48];
+  display.setTextSize(1);
+  display.setTextColor(ST77XX_WHITE);
+  display.setCursor(cardX + 12, cardY + 10);
+  snprintf(text, sizeof(text), "Heap %s free, lowest %s", freeText, minFree);
+  display.print(text);
+  display.setCursor(cardX + 12, cardY + 22);
+  display.setTextColor(s.fragmentation >= 50 ? COLOR_WARNING : ST77XX_WHITE);
+  snprintf(text, sizeof(text), "Block %s, frag %d%%, PSRAM %s", largest, s.fragmentation, psram);
+  display.print(text);
+
+  // Column headings
+  display.setTextColor(0x7BEF); // Light gray
+  display.setCursor(cardX + 12, cardY + 40);
+  display.print("Subsystem");
+  display.setCursor(cardX + 110, cardY + 40);
+  display.print("CPU%");
+  display.setCursor(cardX + 160, cardY + 40);
+  display.print("Held");
+  display.setCursor(cardX + 210, cardY + 40);
+  display.print("Stack");
+
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) {
+    const RuntimeSubsystem &sub = s.subsystems[i];
+    int yPos = cardY + 56 + i * 15;
+
+    display.setTextColor(ST77XX_CYAN);
+    display.setCursor(cardX + 12, yPos);
+    display.print(subsystemNames[i]);
+
+    display.setTextColor(ST77XX_WHITE);
+    display.setCursor(cardX + 110, yPos);
+    snprintf(text, sizeof(text), "%.1f", sub.cpuPercent);
+    display.print(RUNTIME_TASK_STATS ? text : "n/a");
+
+    display.setCursor(cardX + 160, yPos);
+    if (i == SUBSYSTEM_SYSTEM) {
+      display.print("-");  // Other tasks' allocations are not tracked
+    } else {
+      formatBytes(text, sizeof(text), sub.heldBytes, true);
+      display.print(text);
+    }
+
+    display.setCursor(cardX + 210, yPos);
+    if (sub.stackFree == RUNTIME_NO_STACK) {
+      display.print("-");  // Runs on the loop task
+    } else {
+      display.setTextColor(sub.stackFree < 512 ? COLOR_WARNING : ST77XX_WHITE);
+      formatBytes(text, sizeof(text), sub.stackFree, false);
+      display.print(text);
+    }
+  }
+
+  // Loop pass times
+  const LatencyHistogram &h = runtimeLoopHistogram;
+  display.setTextColor(ST77XX_WHITE);
+  display.setCursor(cardX + 5, cardY + cardH + 8);
+  if (h.count == 0) {
+    display.print("Loop: no passes yet");
+  } else {
+    snprintf(text, sizeof(text), "Loop ms p50 %.1f  p99 %.1f  max %.1f",
+             latencyPercentile(h, 0.50f) / 1000.0, latencyPercentile(h, 0.99f) / 1000.0, h.maxMicros / 1000.0);
+    display.print(text);
+  }
+
+  display.setTextColor(COLOR_WARNING);
+  String footerText = "R Reset  ESC Back";
+
+  int16_t x1, y1;
+  uint16_t w, hgt;
+  display.getTextBounds(footerText, 0, 0, &x1, &y1, &w, &hgt);
+  int centerX = (SCREEN_WIDTH - w) / 2;
+  display.setCursor(centerX, SCREEN_HEIGHT - 12);
+  display.print(footerText);
+}
+
+// Returns: -1 to exit, 0 to continue
+int handleRuntimeInput(char key, Adafruit_ST7789 &display) {
+  if (key == KEY_ESC) {
+    return -1;
+  }
+  if (key == 'r' || key == 'R') {
+    resetRuntimeStats();
+    beep(TONE_SELECT, BEEP_SHORT);
+    drawRuntimeUI(display);
+  }
+  return 0;
+}
+
+// Serial "diag": heap, subsystems, tasks and loop passes as CSV blocks
+void printRuntimeStats() {
+  const RuntimeSample &s = runtimeSampleData;
+  Serial.println("heap_free,heap_min_free,heap_largest,frag_pct,psram_total,psram_free,idle_pct,sample_ms");
+  Serial.printf("%lu,%lu,%lu,%d,%lu,%lu,%.1f,%lu\n", (unsigned long)s.heapFree, (unsigned long)s.heapMinFree,
+                (unsigned long)s.heapLargest, s.fragmentation, (unsigned long)s.psramTotal,
+                (unsigned long)s.psramFree, s.idlePercent, (unsigned long)s.windowMs);
+
+  Serial.println("subsystem,cpu_pct,loop_us,held_bytes,stack_free");
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) {
+    const RuntimeSubsystem &sub = s.subsystems[i];
+    Serial.printf("%s,%.1f,%lu,%ld,", subsystemNames[i], sub.cpuPercent, (unsigned long)sub.loopMicros,
+                  (long)sub.heldBytes);
+    if (sub.stackFree == RUNTIME_NO_STACK) {
+      Serial.println();
+    } else {
+      Serial.printf("%lu\n", (unsigned long)sub.stackFree);
+    }
+  }
+
+  if (!RUNTIME_TASK_STATS) {
+    Serial.println("# Task stats need configUSE_TRACE_FACILITY and configGENERATE_RUN_TIME_STATS");
+  } else if (s.taskCount == 0 && s.atMs != 0) {
+    Serial.printf("# More than %d tasks, task table not read\n", RUNTIME_MAX_TASKS);
+  }
+  Serial.println("task,subsystem,core,priority,cpu_pct,stack_free");
+  for (int i = 0; i < s.taskCount; i++) {
+    const RuntimeTask &task = s.tasks[i];
+    Serial.printf("%s,%s,%d,%d,%.1f,%lu\n", task.name, task.idle ? "idle" : subsystemNames[task.subsystem],
+                  task.core, task.priority, task.cpuPercent, (unsigned long)task.stackFree);
+  }
+
+  const LatencyHistogram &h = runtimeLoopHistogram;
+  Serial.println("loop_passes,mean_us,p50_us,p90_us,p99_us,max_us");
+  Serial.printf("%lu,%lu,%lu,%lu,%lu,%lu\n", (unsigned long)h.count,
+                (unsigned long)(h.count ? h.sumMicros / h.count : 0),
+                (unsigned long)latencyPercentile(h, 0.50f), (unsigned long)latencyPercentile(h, 0.90f),
+                (unsigned long)latencyPercentile(h, 0.99f), (unsigned long)h.maxMicros);
+}
+
+// One "diag stream" row per sample
+void printRuntimeStreamRow() {
+  const RuntimeSample &s = runtimeSampleData;
+  const LatencyHistogram &h = runtimeLoopHistogram;
+  Serial.printf("diag,%lu,%lu,%lu,%lu,%d,%lu,%lu,%lu,%lu", (unsigned long)(s.atMs / 1000),
+                (unsigned long)s.heapFree, (unsigned long)s.heapMinFree, (unsigned long)s.heapLargest,
+                s.fragmentation, (unsigned long)s.psramFree, (unsigned long)latencyPercentile(h, 0.50f),
+                (unsigned long)latencyPercentile(h, 0.99f), (unsigned long)h.maxMicros);
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) Serial.printf(",%.1f", s.subsystems[i].cpuPercent);
+  for (int i = 0; i < SUBSYSTEM_LOOP + 1; i++) Serial.printf(",%ld", (long)s.subsystems[i].heldBytes);
+  Serial.println();
+}
+
+void resetRuntimeStats() {
+  memset(&runtimeLoopHistogram, 0, sizeof(runtimeLoopHistogram));
+  memset(subsystemHeld, 0, sizeof(subsystemHeld));
+  for (int i = 0; i < SUBSYSTEM_COUNT; i++) runtimeSampleData.subsystems[i].heldBytes = 0;
+}
+
+// "diag" arguments: none (CSV), "stream" (toggle a row per sample), "reset"; false if not recognised
+bool handleRuntimeCommand(const char* args) {
+  if (*args == '\0') {
+    printRuntimeStats();
+  } else if (strcmp(args, "stream") == 0) {
+    runtimeStreaming = !runtimeStreaming;
+    if (runtimeStreaming) {
+      Serial.printf("diag,time_s,heap_free,heap_min_free,heap_largest,frag_pct,psram_free,loop_p50_us,loop_p99_us,"
+                    "loop_max_us,cpu_audio,cpu_network,cpu_ui,cpu_loop,cpu_system,held_audio,held_network,"
+                    "held_ui,held_loop\n");
+    } else {
+      Serial.println("Diagnostics stream off");
+    }
+  } else if (strcmp(args, "reset") == 0) {
+    resetRuntimeStats();
+    Serial.println("Diagnostics reset");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+#endif // RUNTIME_STATS_H
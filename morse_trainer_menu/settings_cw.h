@@ -6,8 +6,9 @@
 #ifndef SETTINGS_CW_H
 #define SETTINGS_CW_H
 
-#include <Preferences.h>
 #include "config.h"
+#include "display_stats.h"
+#include "settings_store.h"
 
 // Key types
 enum KeyType {
@@ -28,7 +29,6 @@ CWSettingsState cwSettingState = CW_SETTING_SPEED;
 int cwSpeed = DEFAULT_WPM;         // WPM
 int cwTone = TONE_SIDETONE;        // Hz
 KeyType cwKeyType = KEY_IAMBIC_B;  // Default to Iambic B
-Preferences cwPrefs;
 
 // Setting selection
 int cwSettingSelection = 0;
@@ -41,13 +41,12 @@ int handleCWSettingsInput(char key, Adafruit_ST7789 &display);
 void saveCWSettings();
 void loadCWSettings();
 
-// Load CW settings from flash
+// Load CW settings from the settings store
 void loadCWSettings() {
-  cwPrefs.begin("cw", true);
-  cwSpeed = cwPrefs.getInt("speed", DEFAULT_WPM);
-  cwTone = cwPrefs.getInt("tone", TONE_SIDETONE);
-  cwKeyType = (KeyType)cwPrefs.getInt("keytype", KEY_IAMBIC_B);
-  cwPrefs.end();
+  loadSettings();
+  cwSpeed = deviceSettings.cwSpeed;
+  cwTone = deviceSettings.cwTone;
+  cwKeyType = (KeyType)deviceSettings.cwKeyType;
 
   // Validate settings
   if (cwSpeed < WPM_MIN) cwSpeed = WPM_MIN;
@@ -63,15 +62,12 @@ void loadCWSettings() {
   Serial.println(cwKeyType);
 }
 
-// Save CW settings to flash
+// Save CW settings (written to flash by the settings store after a quiet period)
 void saveCWSettings() {
-  cwPrefs.begin("cw", false);
-  cwPrefs.putInt("speed", cwSpeed);
-  cwPrefs.putInt("tone", cwTone);
-  cwPrefs.putInt("keytype", (int)cwKeyType);
-  cwPrefs.end();
-
-  Serial.println("CW Settings saved");
+  deviceSettings.cwSpeed = cwSpeed;
+  deviceSettings.cwTone = cwTone;
+  deviceSettings.cwKeyType = (uint8_t)cwKeyType;
+  settingsChanged(3);
 }
 
 // Start CW settings mode
@@ -82,6 +78,7 @@ void startCWSettings(Adafruit_ST7789 &display) {
 
 // Draw CW settings UI
 void drawCWSettingsUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawCWSettingsUI");
   // Clear screen (preserve header)
   display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
 
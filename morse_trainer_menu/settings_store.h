@@ -0,0 +1,217 @@
+/*
+ * Settings Store
+ * One versioned NVS blob for all device settings, written behind
+ *
+ * The modules keep their live globals (cwSpeed, audio_volume, ...); their
+ * save functions copy into deviceSettings and call settingsChanged(). The
+ * blob is written once the settings have been quiet for
+ * SETTINGS_FLUSH_DELAY_MS, or immediately before deep sleep, so holding an
+ * arrow key costs one flash write instead of one per press.
+ *
+ * A blob written by newer firmware (longer, higher version) is read up to
+ * the fields this build knows. It is left alone until a setting changes,
+ * and then only those fields are written over it, so the newer firmware
+ * still finds its own settings after a downgrade and upgrade.
+ *
+ * WiFi credentials are not part of the blob (see wifi_credentials.h).
+ */
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Preferences.h>
+#include "config.h"
+
+#define SETTINGS_VERSION 1
+#define SETTINGS_BLOB_MAX 255   // DeviceSettings.size is one byte
+
+// Blob layout; only append fields (older blobs load, new fields take defaults)
+struct DeviceSettings {
+  uint8_t version;      // SETTINGS_VERSION when written
+  uint8_t size;         // sizeof(DeviceSettings) when written
+  uint8_t volume;       // 0-100 %
+  uint8_t cwSpeed;      // WPM
+  uint16_t cwTone;      // Hz
+  uint8_t cwKeyType;    // KeyType (settings_cw.h)
+  uint8_t reserved;
+};
+
+DeviceSettings deviceSettings;
+DeviceSettings flashedSettings;       // What the blob in flash holds
+bool settingsLoaded = false;
+bool settingsDirty = false;
+unsigned long settingsChangedAt = 0;
+Preferences settingsPrefs;
+
+// Statistics (serial "settings" command)
+uint32_t settingsChangeCount = 0;     // Save requests from the UI
+uint32_t settingsLegacyWrites = 0;    // NVS writes the old per-key code would have made
+uint32_t settingsFlashWrites = 0;     // Blob writes actually made
+
+// Forward declarations
+void loadSettings();
+size_t readSettingsBlob(uint8_t* blob);
+bool restoreSettings(const DeviceSettings &saved);
+void settingsChanged(int legacyKeys);
+void flushSettings();
+void updateSettingsStore();
+uint32_t settingsFlushDelay();
+void printSettingsStore();
+
+void defaultSettings(DeviceSettings &s) {
+  memset(&s, 0, sizeof(s));
+  s.version = SETTINGS_VERSION;
+  s.size = sizeof(DeviceSettings);
+  s.volume = DEFAULT_VOLUME;
+  s.cwSpeed = DEFAULT_WPM;
+  s.cwTone = TONE_SIDETONE;
+  s.cwKeyType = 2;  // KEY_IAMBIC_B
+}
+
+// Read the blob from flash; its length, or 0 if there is none or it is damaged
+size_t readSettingsBlob(uint8_t* blob) {
+  settingsPrefs.begin("settings", true);
+  size_t length = settingsPrefs.getBytesLength("blob");
+  bool valid = length >= 2 && length <= SETTINGS_BLOB_MAX &&
+               settingsPrefs.getBytes("blob", blob, length) == length &&
+               blob[0] >= 1 && blob[1] == length;  // version, size
+  settingsPrefs.end();
+  return valid ? length : 0;
+}
+
+/*
+ * Load the blob once at boot. Without one, the old "audio" and "cw"
+ * namespaces are read, written as a blob and cleared.
+ */
+void loadSettings() {
+  if (settingsLoaded) return;
+  settingsLoaded = true;
+  defaultSettings(deviceSettings);
+
+  uint8_t blob[SETTINGS_BLOB_MAX];
+  size_t length = readSettingsBlob(blob);
+  if (length > 0) {
+    // Shorter (older) blob: the rest keeps defaults. Longer (newer): the fields we know
+    memcpy(&deviceSettings, blob, min(length, sizeof(DeviceSettings)));
+    deviceSettings.version = SETTINGS_VERSION;
+    deviceSettings.size = sizeof(DeviceSettings);
+    flashedSettings = deviceSettings;
+    if (length < sizeof(DeviceSettings)) {
+      Serial.printf("Settings blob v%d (%d bytes) upgraded to v%d\n", blob[0], (int)length, SETTINGS_VERSION);
+      flushSettings();
+    } else if (length > sizeof(DeviceSettings)) {
+      Serial.printf("Settings blob v%d (%d bytes) is from newer firmware, using its first %d bytes\n",
+                    blob[0], (int)length, (int)sizeof(DeviceSettings));
+    }
+    return;
+  }
+
+  // Migrate from the per-module namespaces (cleared afterwards so this runs once)
+  Serial.println("Migrating settings to a single blob");
+  Preferences legacy;
+  legacy.begin("audio", true);
+  bool hadAudio = legacy.isKey("volume");
+  deviceSettings.volume = legacy.getInt("volume", DEFAULT_VOLUME);
+  legacy.end();
+
+  legacy.begin("cw", true);
+  bool hadCW = legacy.isKey("speed");
+  deviceSettings.cwSpeed = legacy.getInt("speed", DEFAULT_WPM);
+  deviceSettings.cwTone = legacy.getInt("tone", TONE_SIDETONE);
+  deviceSettings.cwKeyType = legacy.getInt("keytype", deviceSettings.cwKeyType);
+  legacy.end();
+
+  memset(&flashedSettings, 0xFF, sizeof(flashedSettings));  // Force the first write
+  flushSettings();
+
+  if (hadAudio) {
+    legacy.begin("audio", false);
+    legacy.clear();
+    legacy.end();
+  }
+  if (hadCW) {
+    legacy.begin("cw", false);
+    legacy.clear();
+    legacy.end();
+  }
+}
+
+/*
+ * Take the settings kept in RTC memory over deep sleep instead of reading
+ * flash (they were flushed before sleeping, so flash holds the same)
+ */
+bool restoreSettings(const DeviceSettings &saved) {
+  if (saved.version != SETTINGS_VERSION || saved.size != sizeof(DeviceSettings)) {
+    return false;
+  }
+  deviceSettings = saved;
+  flashedSettings = saved;
+  settingsLoaded = true;
+  settingsDirty = false;
+  return true;
+}
+
+/*
+ * Note a change; legacyKeys is how many keys the old code wrote for it
+ * (used only for the flash-writes-avoided statistic)
+ */
+void settingsChanged(int legacyKeys) {
+  settingsDirty = true;
+  settingsChangedAt = millis();
+  settingsChangeCount++;
+  settingsLegacyWrites += legacyKeys;
+}
+
+// Write the blob now (if it differs from flash)
+void flushSettings() {
+  settingsDirty = false;
+  if (memcmp(&deviceSettings, &flashedSettings, sizeof(DeviceSettings)) == 0) {
+    return;  // Changed and changed back
+  }
+
+  unsigned long start = micros();
+
+  // A newer firmware's blob keeps its header and the fields past ours
+  uint8_t blob[SETTINGS_BLOB_MAX];
+  size_t length = readSettingsBlob(blob);
+  if (length > sizeof(DeviceSettings)) {
+    memcpy(blob + 2, (const uint8_t*)&deviceSettings + 2, sizeof(DeviceSettings) - 2);
+  } else {
+    length = sizeof(DeviceSettings);
+    memcpy(blob, &deviceSettings, length);
+  }
+
+  settingsPrefs.begin("settings", false);
+  settingsPrefs.putBytes("blob", blob, length);
+  settingsPrefs.end();
+  flashedSettings = deviceSettings;
+  settingsFlashWrites++;
+  Serial.printf("Settings saved (%lu us)\n", micros() - start);
+}
+
+// ms until a pending flush is due (0 = due now, 0xFFFFFFFF = nothing pending)
+uint32_t settingsFlushDelay() {
+  if (!settingsDirty) return 0xFFFFFFFF;
+  unsigned long quiet = millis() - settingsChangedAt;
+  return quiet >= SETTINGS_FLUSH_DELAY_MS ? 0 : SETTINGS_FLUSH_DELAY_MS - quiet;
+}
+
+// Flush once the settings have been quiet long enough (called from loop())
+void updateSettingsStore() {
+  if (settingsDirty && settingsFlushDelay() == 0) {
+    flushSettings();
+  }
+}
+
+void printSettingsStore() {
+  Serial.printf("Settings v%d (%d bytes): volume %d%%, %d WPM, %d Hz, key type %d%s\n",
+                deviceSettings.version, deviceSettings.size, deviceSettings.volume,
+                deviceSettings.cwSpeed, deviceSettings.cwTone, deviceSettings.cwKeyType,
+                settingsDirty ? " (unsaved)" : "");
+  uint32_t avoided = settingsLegacyWrites > settingsFlashWrites ? settingsLegacyWrites - settingsFlashWrites : 0;
+  Serial.printf("  %lu changes, %lu flash writes, %lu avoided (per-key saves would have made %lu)\n",
+                (unsigned long)settingsChangeCount, (unsigned long)settingsFlashWrites,
+                (unsigned long)avoided, (unsigned long)settingsLegacyWrites);
+}
+
+#endif // SETTINGS_STORE_H
@@ -9,6 +9,7 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
 #include "config.h"
+#include "display_stats.h"
 
 // Volume settings state
 bool volumeSettingsActive = false;
@@ -49,6 +50,7 @@ void initVolumeSettings(Adafruit_ST7789 &display) {
  * Draw volume level display
  */
 void drawVolumeDisplay(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawVolumeDisplay");
   // Clear display area
   display.fillRect(0, 50, SCREEN_WIDTH, 140, COLOR_BACKGROUND);
 
@@ -7,8 +7,12 @@
 #define SETTINGS_WIFI_H
 
 #include <WiFi.h>
+#include <esp_wifi.h>
 #include <Preferences.h>
 #include "config.h"
+#include "display_stats.h"
+#include "subsystem_scope.h"
+#include "wifi_credentials.h"
 
 // WiFi settings state machine
 enum WiFiSettingsState {
@@ -20,16 +24,17 @@ enum WiFiSettingsState {
   WIFI_STATE_ERROR
 };
 
-// WiFi network info
+// WiFi network info (scan result table, strongest first)
 struct WiFiNetwork {
-  String ssid;
-  int rssi;
+  char ssid[33];
+  int8_t rssi;
+  uint8_t channel;
   bool encrypted;
 };
 
 // WiFi settings globals
 WiFiSettingsState wifiState = WIFI_STATE_SCANNING;
-WiFiNetwork networks[20];  // Store up to 20 networks
+WiFiNetwork networks[WIFI_SCAN_MAX_RESULTS];
 int networkCount = 0;
 int selectedNetwork = 0;
 String passwordInput = "";
@@ -37,71 +42,187 @@ bool passwordVisible = false;
 unsigned long lastBlink = 0;
 bool cursorVisible = true;
 String statusMessage = "";
-Preferences wifiPrefs;
+
+// Channel-by-channel scan; the list fills in as each channel completes
+bool wifiScanActive = false;
+uint8_t wifiScanChannel = 0;      // Channel being scanned (1..WIFI_SCAN_CHANNELS)
+unsigned long wifiScanStartTime = 0;
+
+// Connection state machine (advanced by WiFi events, checked from loop())
+enum WiFiConnectState {
+  WIFI_CONNECT_IDLE,
+  WIFI_CONNECT_SCANNING,     // Auto-connect: passive scan ranking the saved networks
+  WIFI_CONNECT_ASSOCIATING,  // WiFi.begin() called, waiting for the access point
+  WIFI_CONNECT_GETTING_IP,   // Associated, waiting for DHCP
+  WIFI_CONNECT_CONNECTED,
+  WIFI_CONNECT_FAILED
+};
+
+WiFiConnectState wifiConnectState = WIFI_CONNECT_IDLE;
+String connectSSID = "";
+String connectPassword = "";
+bool connectSaveCredentials = false;  // Save on success (networks picked in WiFi Setup)
+unsigned long connectStartTime = 0;
+unsigned long attemptStartTime = 0;
+int connectAttempt = 0;
+const char* connectError = "";
+bool wifiConnectEventsRegistered = false;
+int connectSlot = -1;                 // Credential store slot (-1 = not saved)
+bool connectFast = false;             // Using the cached BSSID/channel/lease
+SavedNetwork connectCache;            // BSSID/channel/lease for a fast attempt
+bool connectStaticIP = false;         // Fast attempt reapplies the cached lease (still valid)
+bool connectIsResume = false;         // Network kept in RTC memory over deep sleep
+
+// Auto-connect walks the saved networks, best first
+bool connectIsAuto = false;
+int autoConnectOrder[WIFI_MAX_SAVED_NETWORKS];
+int autoConnectCount = 0;
+int autoConnectNext = 0;
+unsigned long autoConnectStartTime = 0;
+
+// Time to connected (serial "wifi" command)
+struct ConnectTimeStats {
+  uint32_t count;
+  uint32_t totalMs;
+  uint32_t minMs;
+  uint32_t maxMs;
+  uint32_t lastMs;
+};
+ConnectTimeStats connectTimeFull = {};  // Scan + association + DHCP
+ConnectTimeStats connectTimeFast = {};  // Cached channel/BSSID + static lease
+
+// Set by the WiFi event task, consumed by updateWiFiConnection()
+volatile bool wifiAssociatedFlag = false;
+volatile bool wifiGotIPFlag = false;
+volatile uint8_t wifiDisconnectReason = 0;  // 0 = nothing pending
 
 // Forward declarations
 void startWiFiSettings(Adafruit_ST7789 &display);
 void drawWiFiUI(Adafruit_ST7789 &display);
 int handleWiFiInput(char key, Adafruit_ST7789 &display);
-void scanNetworks();
+void startWiFiScan();
+void stopWiFiScan();
+bool updateWiFiScan();
 void drawNetworkList(Adafruit_ST7789 &display);
 void drawPasswordInput(Adafruit_ST7789 &display);
-void connectToWiFi(String ssid, String password);
-void saveWiFiCredentials(String ssid, String password);
-bool loadWiFiCredentials(String &ssid, String &password);
+void drawConnectProgress(Adafruit_ST7789 &display);
+void startWiFiConnection(const String &ssid, const String &password, bool saveOnSuccess);
+void beginWiFiConnection(const String &ssid, const String &password, bool saveOnSuccess, const SavedNetwork* cache);
+void cancelWiFiConnection();
+bool wifiConnectInProgress();
+bool updateWiFiConnection();
+void updateWiFiSettings(Adafruit_ST7789 &display);
 void autoConnectWiFi();
+void finishAutoConnect();
+void resumeWiFiConnection(const SavedNetwork &net);
+void printWiFiConnectStats();
 
 // Start WiFi settings mode
 void startWiFiSettings(Adafruit_ST7789 &display) {
+  cancelWiFiConnection();  // An attempt in progress would fight the scan; a live connection stays
   wifiState = WIFI_STATE_SCANNING;
   selectedNetwork = 0;
   passwordInput = "";
   statusMessage = "Scanning for networks...";
 
+  startWiFiScan();
   drawWiFiUI(display);
-  scanNetworks();
+}
 
-  if (networkCount > 0) {
-    wifiState = WIFI_STATE_NETWORK_LIST;
-  } else {
-    wifiState = WIFI_STATE_ERROR;
-    statusMessage = "No networks found";
+/*
+ * Scan one channel at a time (async) so results stream into the list; the
+ * driver returns to the home channel between scans, so an existing
+ * connection stays up
+ */
+void startWiFiScan() {
+  Serial.println("Scanning for WiFi networks...");
+  if (WiFi.getMode() == WIFI_OFF) {
+    WiFi.mode(WIFI_STA);
   }
 
-  drawWiFiUI(display);
+  networkCount = 0;
+  wifiScanChannel = 1;
+  wifiScanStartTime = millis();
+  wifiScanActive = true;
+  WiFi.scanNetworks(true, false, false, WIFI_SCAN_CHANNEL_MS, wifiScanChannel);
 }
 
-// Scan for WiFi networks
-void scanNetworks() {
-  Serial.println("Scanning for WiFi networks...");
-  WiFi.mode(WIFI_STA);
-  WiFi.disconnect();
-  delay(100);
+void stopWiFiScan() {
+  if (!wifiScanActive) return;
+  esp_wifi_scan_stop();
+  WiFi.scanDelete();
+  wifiScanActive = false;
+}
 
-  int n = WiFi.scanNetworks();
-  networkCount = min(n, 20);
+// Insert into the table by RSSI (one row per SSID, strongest kept)
+bool addScanResult(const String &ssid, int rssi, int channel, bool encrypted) {
+  if (ssid.length() == 0) return false;  // Hidden network
 
-  Serial.print("Found ");
-  Serial.print(n);
-  Serial.println(" networks");
+  for (int i = 0; i < networkCount; i++) {
+    if (ssid == networks[i].ssid) {
+      if (rssi <= networks[i].rssi) return false;
+      memmove(&networks[i], &networks[i + 1], (networkCount - i - 1) * sizeof(WiFiNetwork));
+      networkCount--;
+      break;
+    }
+  }
+
+  int pos = networkCount;
+  while (pos > 0 && networks[pos - 1].rssi < rssi) pos--;
+  if (pos >= WIFI_SCAN_MAX_RESULTS) return false;  // Table full of stronger networks
+
+  int moved = min(networkCount, WIFI_SCAN_MAX_RESULTS - 1) - pos;
+  memmove(&networks[pos + 1], &networks[pos], moved * sizeof(WiFiNetwork));
+  strlcpy(networks[pos].ssid, ssid.c_str(), sizeof(networks[pos].ssid));
+  networks[pos].rssi = rssi;
+  networks[pos].channel = channel;
+  networks[pos].encrypted = encrypted;
+  networkCount = min(networkCount + 1, WIFI_SCAN_MAX_RESULTS);
+  return true;
+}
+
+/*
+ * Merge a finished channel and start the next one (called from loop()).
+ * Returns true when a channel completed, i.e. the list needs a redraw.
+ */
+bool updateWiFiScan() {
+  if (!wifiScanActive) return false;
+  int16_t n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) return false;
+
+  // Keep the cursor on the same network while rows move
+  char selectedSSID[33] = "";
+  if (selectedNetwork < networkCount) {
+    strlcpy(selectedSSID, networks[selectedNetwork].ssid, sizeof(selectedSSID));
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (addScanResult(WiFi.SSID(i), WiFi.RSSI(i), WiFi.channel(i), WiFi.encryptionType(i) != WIFI_AUTH_OPEN)) {
+      Serial.printf("  ch %2d  %-32s %4d dBm %s\n", (int)WiFi.channel(i), WiFi.SSID(i).c_str(), (int)WiFi.RSSI(i),
+                    WiFi.encryptionType(i) != WIFI_AUTH_OPEN ? "[Encrypted]" : "[Open]");
+    }
+  }
+  WiFi.scanDelete();
 
   for (int i = 0; i < networkCount; i++) {
-    networks[i].ssid = WiFi.SSID(i);
-    networks[i].rssi = WiFi.RSSI(i);
-    networks[i].encrypted = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
-
-    Serial.print(i);
-    Serial.print(": ");
-    Serial.print(networks[i].ssid);
-    Serial.print(" (");
-    Serial.print(networks[i].rssi);
-    Serial.print(" dBm) ");
-    Serial.println(networks[i].encrypted ? "[Encrypted]" : "[Open]");
+    if (strcmp(networks[i].ssid, selectedSSID) == 0) {
+      selectedNetwork = i;
+      break;
+    }
   }
+
+  if (++wifiScanChannel > WIFI_SCAN_CHANNELS) {
+    wifiScanActive = false;
+    Serial.printf("Found %d networks in %lu ms\n", networkCount, millis() - wifiScanStartTime);
+  } else {
+    WiFi.scanNetworks(true, false, false, WIFI_SCAN_CHANNEL_MS, wifiScanChannel);
+  }
+  return true;
 }
 
 // Draw WiFi UI based on current state
 void drawWiFiUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawWiFiUI");
   // Clear screen (preserve header)
   display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
 
@@ -120,8 +241,17 @@ void drawWiFiUI(Adafruit_ST7789 &display) {
   else if (wifiState == WIFI_STATE_CONNECTING) {
     display.setTextSize(2);
     display.setTextColor(ST77XX_YELLOW);
-    display.setCursor(40, 100);
+    display.setCursor(40, 70);
     display.print("Connecting...");
+
+    display.setTextSize(1);
+    display.setTextColor(ST77XX_WHITE);
+    display.setCursor(40, 100);
+    display.print("Network: ");
+    display.print(connectSSID);
+
+    display.drawRect(40, 139, SCREEN_WIDTH - 80, 12, ST77XX_WHITE);
+    drawConnectProgress(display);
   }
   else if (wifiState == WIFI_STATE_CONNECTED) {
     display.setTextSize(2);
@@ -154,8 +284,12 @@ void drawWiFiUI(Adafruit_ST7789 &display) {
 
   if (wifiState == WIFI_STATE_NETWORK_LIST) {
     footerText = "Up/Down: Select  Enter: Connect  ESC: Back";
+  } else if (wifiState == WIFI_STATE_SCANNING) {
+    footerText = "ESC: Back";
   } else if (wifiState == WIFI_STATE_PASSWORD_INPUT) {
     footerText = "Type password  Enter: Connect  ESC: Cancel";
+  } else if (wifiState == WIFI_STATE_CONNECTING) {
+    footerText = "ESC: Cancel";
   } else if (wifiState == WIFI_STATE_CONNECTED || wifiState == WIFI_STATE_ERROR) {
     footerText = "Press ESC to return";
   }
@@ -170,11 +304,22 @@ void drawWiFiUI(Adafruit_ST7789 &display) {
 
 // Draw network list
 void drawNetworkList(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawNetworkList");
   display.setTextSize(1);
+  display.fillRect(10, 53, SCREEN_WIDTH - 20, 10, COLOR_BACKGROUND);
   display.setTextColor(ST77XX_CYAN);
   display.setCursor(10, 55);
   display.print("Available Networks:");
 
+  // Scan progress (right-aligned)
+  display.setTextColor(0x7BEF);
+  display.setCursor(SCREEN_WIDTH - 100, 55);
+  if (wifiScanActive) {
+    display.printf("Scanning %2d/%d", wifiScanChannel, WIFI_SCAN_CHANNELS);
+  } else {
+    display.printf("%2d found", networkCount);
+  }
+
   // Calculate visible range (show 5 networks at a time)
   int startIdx = max(0, selectedNetwork - 2);
   int endIdx = min(networkCount, startIdx + 5);
@@ -188,10 +333,8 @@ void drawNetworkList(Adafruit_ST7789 &display) {
   for (int i = startIdx; i < endIdx; i++) {
     bool isSelected = (i == selectedNetwork);
 
-    // Draw selection background
-    if (isSelected) {
-      display.fillRect(5, yPos - 2, SCREEN_WIDTH - 10, 22, 0x249F);
-    }
+    // Draw row background (also erases the previous selection / row contents)
+    display.fillRect(5, yPos - 2, SCREEN_WIDTH - 10, 22, isSelected ? 0x249F : COLOR_BACKGROUND);
 
     // Draw signal strength bars
     int bars = map(networks[i].rssi, -100, -40, 1, 4);
@@ -230,6 +373,7 @@ void drawNetworkList(Adafruit_ST7789 &display) {
   }
 
   // Draw scrollbar if needed
+  display.fillRect(SCREEN_WIDTH - 5, 73, 3, SCREEN_HEIGHT - 98, COLOR_BACKGROUND);
   if (networkCount > 5) {
     int scrollbarHeight = (SCREEN_HEIGHT - 100) * 5 / networkCount;
     int scrollbarY = 75 + (SCREEN_HEIGHT - 100 - scrollbarHeight) * selectedNetwork / (networkCount - 1);
@@ -239,6 +383,7 @@ void drawNetworkList(Adafruit_ST7789 &display) {
 
 // Draw password input screen
 void drawPasswordInput(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawPasswordInput");
   display.setTextSize(1);
   display.setTextColor(ST77XX_CYAN);
   display.setCursor(10, 55);
@@ -273,7 +418,7 @@ void drawPasswordInput(Adafruit_ST7789 &display) {
     display.print(passwordInput);
   } else {
     // Show asterisks
-    for (int i = 0; i < passwordInput.length(); i++) {
+    for (unsigned int i = 0; i < passwordInput.length(); i++) {
       display.print("*");
     }
   }
@@ -295,6 +440,43 @@ void drawPasswordInput(Adafruit_ST7789 &display) {
   display.print(" password");
 }
 
+// Redraw the connection phase and timeout bar (called every WIFI_PROGRESS_MS while connecting)
+void drawConnectProgress(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawConnectProgress");
+  display.setTextSize(1);
+
+  // Phase line
+  display.fillRect(40, 122, SCREEN_WIDTH - 80, 10, COLOR_BACKGROUND);
+  display.setTextColor(ST77XX_CYAN);
+  display.setCursor(40, 124);
+  if (wifiConnectState == WIFI_CONNECT_SCANNING) {
+    display.print("Looking for saved networks...");
+  } else if (wifiConnectState == WIFI_CONNECT_GETTING_IP) {
+    display.print(connectStaticIP ? "Restoring IP address..." : "Getting IP address...");
+  } else if (connectFast) {
+    display.print("Fast reconnect (cached channel)");
+  } else {
+    display.print("Joining network (try ");
+    display.print(connectAttempt);
+    display.print("/");
+    display.print(WIFI_CONNECT_ATTEMPTS);
+    display.print(")");
+  }
+
+  // Elapsed time against the timeout (bar interior only, the outline stays)
+  unsigned long elapsed = min((unsigned long)(millis() - connectStartTime), (unsigned long)WIFI_CONNECT_TIMEOUT_MS);
+  int barWidth = SCREEN_WIDTH - 84;
+  int filled = barWidth * elapsed / WIFI_CONNECT_TIMEOUT_MS;
+  display.fillRect(42, 141, filled, 8, ST77XX_YELLOW);
+  display.fillRect(42 + filled, 141, barWidth - filled, 8, COLOR_BACKGROUND);
+
+  display.fillRect(40, 158, 60, 10, COLOR_BACKGROUND);
+  display.setTextColor(0x7BEF);
+  display.setCursor(40, 160);
+  display.print(elapsed / 1000.0, 1);
+  display.print(" s");
+}
+
 // Handle WiFi settings input
 int handleWiFiInput(char key, Adafruit_ST7789 &display) {
   // Update cursor blink
@@ -333,16 +515,23 @@ int handleWiFiInput(char key, Adafruit_ST7789 &display) {
       } else {
         // Open network, connect immediately
         wifiState = WIFI_STATE_CONNECTING;
-        drawWiFiUI(display);
-        connectToWiFi(networks[selectedNetwork].ssid, "");
+        beep(TONE_SELECT, BEEP_MEDIUM);
+        startWiFiConnection(networks[selectedNetwork].ssid, "", true);
         return 2;
       }
       return 1;
     }
     else if (key == KEY_ESC) {
+      stopWiFiScan();
       return -1;  // Exit WiFi settings
     }
   }
+  else if (wifiState == WIFI_STATE_SCANNING) {
+    if (key == KEY_ESC) {
+      stopWiFiScan();
+      return -1;
+    }
+  }
   else if (wifiState == WIFI_STATE_PASSWORD_INPUT) {
     if (key == KEY_BACKSPACE) {
       if (passwordInput.length() > 0) {
@@ -357,8 +546,7 @@ int handleWiFiInput(char key, Adafruit_ST7789 &display) {
       // Connect with password
       wifiState = WIFI_STATE_CONNECTING;
       beep(TONE_SELECT, BEEP_MEDIUM);
-      drawWiFiUI(display);
-      connectToWiFi(networks[selectedNetwork].ssid, passwordInput);
+      startWiFiConnection(networks[selectedNetwork].ssid, passwordInput, true);
       return 2;
     }
     else if (key == KEY_ESC) {
@@ -383,6 +571,16 @@ int handleWiFiInput(char key, Adafruit_ST7789 &display) {
       return 1;
     }
   }
+  else if (wifiState == WIFI_STATE_CONNECTING) {
+    if (key == KEY_ESC) {
+      // Abort the attempt, back to network list
+      cancelWiFiConnection();
+      wifiState = WIFI_STATE_NETWORK_LIST;
+      beep(TONE_MENU_NAV, BEEP_SHORT);
+      drawWiFiUI(display);
+      return 1;
+    }
+  }
   else if (wifiState == WIFI_STATE_CONNECTED || wifiState == WIFI_STATE_ERROR) {
     if (key == KEY_ESC) {
       return -1;  // Exit WiFi settings
@@ -392,88 +590,342 @@ int handleWiFiInput(char key, Adafruit_ST7789 &display) {
   return 0;
 }
 
-// Connect to WiFi network
-void connectToWiFi(String ssid, String password) {
+// Follow the connection state machine from the WiFi Setup screen (called from loop())
+void updateWiFiSettings(Adafruit_ST7789 &display) {
+  if (updateWiFiScan()) {
+    if (wifiState == WIFI_STATE_SCANNING && networkCount > 0) {
+      wifiState = WIFI_STATE_NETWORK_LIST;  // First result: list becomes usable while the scan continues
+      drawWiFiUI(display);
+    } else if (wifiState == WIFI_STATE_SCANNING && !wifiScanActive) {
+      wifiState = WIFI_STATE_ERROR;
+      statusMessage = "No networks found";
+      drawWiFiUI(display);
+    } else if (wifiState == WIFI_STATE_NETWORK_LIST) {
+      drawNetworkList(display);
+    }
+  }
+
+  if (wifiState != WIFI_STATE_CONNECTING) return;
+
+  if (wifiConnectState == WIFI_CONNECT_CONNECTED) {
+    wifiState = WIFI_STATE_CONNECTED;
+    beep(TONE_SELECT, BEEP_MEDIUM);
+    drawWiFiUI(display);
+  } else if (wifiConnectState == WIFI_CONNECT_FAILED) {
+    wifiState = WIFI_STATE_ERROR;
+    statusMessage = connectError;
+    drawWiFiUI(display);
+  } else {
+    drawConnectProgress(display);
+  }
+}
+
+// WiFi event task: record progress for updateWiFiConnection(), no other work here
+void onWiFiConnectEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+    wifiAssociatedFlag = true;
+  } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    wifiGotIPFlag = true;
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    uint8_t reason = info.wifi_sta_disconnected.reason;
+    if (reason != WIFI_REASON_ASSOC_LEAVE) {  // Our own disconnect() before begin()
+      wifiDisconnectReason = reason ? reason : (uint8_t)WIFI_REASON_UNSPECIFIED;
+    }
+  }
+}
+
+// Issue WiFi.begin() for the current attempt (fast: cached channel, BSSID and lease)
+void beginWiFiAttempt() {
+  SUBSYSTEM_SCOPE(SUBSYSTEM_NETWORK);
+  attemptStartTime = millis();
+  wifiAssociatedFlag = false;
+  wifiGotIPFlag = false;
+  wifiDisconnectReason = 0;
+
+  if (connectFast) {
+    // Cached channel/BSSID; the address only while its lease is surely still ours
+    const SavedNetwork &net = connectCache;
+    if (connectStaticIP) {
+      WiFi.config(IPAddress(net.ip), IPAddress(net.gateway), IPAddress(net.subnet), IPAddress(net.dns));
+    } else {
+      WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    }
+    WiFi.begin(connectSSID.c_str(), connectPassword.c_str(), net.channel, net.bssid);
+  } else {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());  // Back to DHCP
+    WiFi.begin(connectSSID.c_str(), connectPassword.c_str());
+  }
+}
+
+/*
+ * Start connecting and return immediately; loop() follows progress with
+ * updateWiFiConnection(). Credentials are saved once an IP is assigned.
+ */
+void startWiFiConnection(const String &ssid, const String &password, bool saveOnSuccess) {
+  loadSavedNetworks();
+  connectSlot = findSavedNetwork(ssid);
+  bool cached = hasNetworkCache(connectSlot) && password == savedNetworks[connectSlot].password;
+  beginWiFiConnection(ssid, password, saveOnSuccess, cached ? &savedNetworks[connectSlot] : nullptr);
+}
+
+// Common start for a connection; cache (may be null) selects the fast path
+void beginWiFiConnection(const String &ssid, const String &password, bool saveOnSuccess, const SavedNetwork* cache) {
+  if (!wifiConnectEventsRegistered) {
+    WiFi.onEvent(onWiFiConnectEvent);
+    wifiConnectEventsRegistered = true;
+  }
+
+  stopWiFiScan();  // Scanning and associating would compete for the radio
+  connectFast = cache != nullptr;
+  connectStaticIP = false;
+  if (connectFast) {
+    connectCache = *cache;
+    connectStaticIP = networkLeaseValid(connectCache);
+  }
+
   Serial.print("Connecting to: ");
-  Serial.println(ssid);
+  Serial.print(ssid);
+  Serial.println(!connectFast ? "" : (connectStaticIP ? " (fast, cached channel/IP)" : " (fast, cached channel, DHCP)"));
+
+  connectSSID = ssid;
+  connectPassword = password;
+  connectSaveCredentials = saveOnSuccess;
+  connectIsAuto = false;
+  connectIsResume = false;
+  connectStartTime = millis();
+  connectAttempt = 1;
+  connectError = "";
+  wifiConnectState = WIFI_CONNECT_ASSOCIATING;
 
   WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), password.c_str());
+  beginWiFiAttempt();
+}
+
+// Try the next saved network in autoConnectOrder; false when none are left
+bool startNextAutoConnect() {
+  if (autoConnectNext >= autoConnectCount) return false;
+  const SavedNetwork &net = savedNetworks[autoConnectOrder[autoConnectNext++]];
+  startWiFiConnection(net.ssid, net.password, false);
+  connectIsAuto = true;
+  return true;
+}
+
+// After a failed attempt: the next saved network, or all of them if the resume network failed
+void tryNextNetwork() {
+  if (connectIsAuto) {
+    startNextAutoConnect();
+  } else if (connectIsResume) {
+    Serial.println("Previous network not available, trying saved networks");
+    autoConnectWiFi();
+  }
+}
 
-  // Wait up to 10 seconds for connection
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(250);
-    Serial.print(".");
-    attempts++;
+// Abort an attempt in progress (ESC on the connecting screen)
+void cancelWiFiConnection() {
+  autoConnectCount = 0;
+  if (!wifiConnectInProgress()) return;
+  if (wifiConnectState == WIFI_CONNECT_SCANNING) {
+    esp_wifi_scan_stop();
+    WiFi.scanDelete();
+  } else {
+    WiFi.disconnect();
   }
-  Serial.println();
+  wifiConnectState = WIFI_CONNECT_IDLE;
+  Serial.println("WiFi connection cancelled");
+}
+
+bool wifiConnectInProgress() {
+  return wifiConnectState == WIFI_CONNECT_SCANNING || wifiConnectState == WIFI_CONNECT_ASSOCIATING ||
+         wifiConnectState == WIFI_CONNECT_GETTING_IP;
+}
+
+// Short user-facing text for a disconnect reason code
+const char* wifiFailureText(uint8_t reason) {
+  switch (reason) {
+    case WIFI_REASON_NO_AP_FOUND:
+      return "Network not found";
+    case WIFI_REASON_AUTH_FAIL:
+    case WIFI_REASON_AUTH_EXPIRE:
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+      return "Wrong password?";
+    case WIFI_REASON_ASSOC_FAIL:
+    case WIFI_REASON_CONNECTION_FAIL:
+      return "Access point refused connection";
+    default:
+      return "Failed to connect";
+  }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("Connected!");
+/*
+ * Advance the connection state machine. Cheap when idle; call every loop
+ * pass. Returns true when the state changed.
+ */
+bool updateWiFiConnection() {
+  if (!wifiConnectInProgress()) return false;
+  unsigned long elapsed = millis() - connectStartTime;
+
+  if (wifiConnectState == WIFI_CONNECT_SCANNING) {
+    if (WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+      if (elapsed < WIFI_CONNECT_TIMEOUT_MS) return false;
+      Serial.println("Passive scan timed out");
+      esp_wifi_scan_stop();
+      WiFi.scanDelete();
+    }
+    finishAutoConnect();
+    return true;
+  }
+
+  if (wifiGotIPFlag) {
+    wifiConnectState = WIFI_CONNECT_CONNECTED;
+    autoConnectCount = 0;
+
+    ConnectTimeStats &stats = connectFast ? connectTimeFast : connectTimeFull;
+    stats.count++;
+    stats.totalMs += elapsed;
+    stats.lastMs = elapsed;
+    stats.minMs = (stats.count == 1) ? elapsed : min(stats.minMs, (uint32_t)elapsed);
+    stats.maxMs = max(stats.maxMs, (uint32_t)elapsed);
+
+    Serial.printf("Connected to %s in %lu ms (%s, attempt %d)\n", connectSSID.c_str(), elapsed,
+                  connectFast ? "fast" : "full", connectAttempt);
+    if (connectIsAuto || connectIsResume) {
+      Serial.printf("Auto-connect: %lu ms including network selection\n", millis() - autoConnectStartTime);
+    }
     Serial.print("IP: ");
     Serial.println(WiFi.localIP());
 
-    wifiState = WIFI_STATE_CONNECTED;
+    if (connectSaveCredentials) {
+      connectSlot = rememberNetwork(connectSSID, connectPassword);
+    } else if (connectSlot < 0) {
+      loadSavedNetworks();  // Resumed without reading the store; only needed now, for the cache
+      connectSlot = findSavedNetwork(connectSSID);
+    }
+    updateNetworkCache(connectSlot, !connectStaticIP);
+    return true;
+  }
 
-    // Save credentials
-    saveWiFiCredentials(ssid, password);
-  } else {
-    Serial.println("Connection failed!");
-    wifiState = WIFI_STATE_ERROR;
-    statusMessage = "Failed to connect";
+  bool changed = false;
+  if (wifiAssociatedFlag && wifiConnectState == WIFI_CONNECT_ASSOCIATING) {
+    wifiConnectState = WIFI_CONNECT_GETTING_IP;
+    changed = true;
   }
-}
 
-// Save WiFi credentials to flash memory
-void saveWiFiCredentials(String ssid, String password) {
-  wifiPrefs.begin("wifi", false);
-  wifiPrefs.putString("ssid", ssid);
-  wifiPrefs.putString("password", password);
-  wifiPrefs.end();
+  // Cached channel/BSSID/lease did not work: drop the cache and do a full connect.
+  // Once associated on DHCP the link is good, the server gets the full timeout.
+  uint8_t reason = wifiDisconnectReason;
+  bool fastTimedOut = (wifiConnectState == WIFI_CONNECT_ASSOCIATING || connectStaticIP) &&
+                      millis() - attemptStartTime >= WIFI_FAST_CONNECT_MS;
+  if (connectFast && (reason != 0 || fastTimedOut)) {
+    Serial.printf("Fast connect failed (reason %d), falling back to full connect\n", reason);
+    clearNetworkCache(connectSlot);
+    connectFast = false;
+    connectStaticIP = false;
+    WiFi.disconnect();
+    wifiConnectState = WIFI_CONNECT_ASSOCIATING;
+    beginWiFiAttempt();
+    return true;
+  }
 
-  Serial.println("WiFi credentials saved");
-}
+  if (reason != 0) {
+    wifiDisconnectReason = 0;
+    wifiAssociatedFlag = false;
+    Serial.printf("WiFi attempt %d failed (reason %d)\n", connectAttempt, reason);
+
+    if (connectAttempt < WIFI_CONNECT_ATTEMPTS && elapsed < WIFI_CONNECT_TIMEOUT_MS) {
+      connectAttempt++;
+      wifiConnectState = WIFI_CONNECT_ASSOCIATING;
+      beginWiFiAttempt();
+      return true;
+    }
+
+    connectError = wifiFailureText(reason);
+    wifiConnectState = WIFI_CONNECT_FAILED;
+    Serial.print("Connection failed: ");
+    Serial.println(connectError);
+    tryNextNetwork();
+    return true;
+  }
 
-// Load WiFi credentials from flash memory
-bool loadWiFiCredentials(String &ssid, String &password) {
-  wifiPrefs.begin("wifi", true);
-  ssid = wifiPrefs.getString("ssid", "");
-  password = wifiPrefs.getString("password", "");
-  wifiPrefs.end();
+  if (elapsed >= WIFI_CONNECT_TIMEOUT_MS) {
+    WiFi.disconnect();
+    connectError = "Connection timed out";
+    wifiConnectState = WIFI_CONNECT_FAILED;
+    Serial.println("Connection failed: timed out");
+    tryNextNetwork();
+    return true;
+  }
 
-  return (ssid.length() > 0);
+  return changed;
 }
 
-// Auto-connect to saved WiFi on startup
+/*
+ * Auto-connect on startup: best saved network first. Returns at once; with
+ * several saved networks the passive scan runs first (WIFI_CONNECT_SCANNING),
+ * then loop() follows the attempts and moves down the list.
+ */
 void autoConnectWiFi() {
-  String ssid, password;
+  autoConnectStartTime = millis();
+  autoConnectNext = 0;
+  autoConnectCount = 0;
+  loadSavedNetworks();
 
-  if (loadWiFiCredentials(ssid, password)) {
-    Serial.print("Auto-connecting to saved network: ");
-    Serial.println(ssid);
+  if (savedNetworkCount == 0) {
+    Serial.println("No saved WiFi credentials");
+    return;
+  }
 
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
-
-    // Wait up to 10 seconds
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-      delay(250);
-      Serial.print(".");
-      attempts++;
-    }
-    Serial.println();
+  stopWiFiScan();  // One scan at a time
+  if (startSavedNetworkScan()) {
+    wifiConnectState = WIFI_CONNECT_SCANNING;
+    connectStartTime = millis();
+    connectError = "";
+    return;
+  }
+  finishAutoConnect();
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("Auto-connect successful!");
-      Serial.print("IP: ");
-      Serial.println(WiFi.localIP());
+// Passive scan done (or not needed): rank the saved networks and start on the best
+void finishAutoConnect() {
+  autoConnectCount = rankSavedNetworks(autoConnectOrder);
+  Serial.print("Auto-connecting to saved network: ");
+  Serial.println(savedNetworks[autoConnectOrder[0]].ssid);
+  startNextAutoConnect();
+}
+
+/*
+ * Reconnect after deep sleep to the network that was up before, using the
+ * copy kept in RTC memory: no store read and no passive scan, just the fast
+ * path (a full connect if nothing was cached, all saved networks if it fails)
+ */
+void resumeWiFiConnection(const SavedNetwork &net) {
+  autoConnectStartTime = millis();
+  autoConnectCount = 0;
+  connectSlot = -1;  // Looked up once connected
+  bool cached = net.channel != 0 && net.ip != 0;
+  beginWiFiConnection(net.ssid, net.password, false, cached ? &net : nullptr);
+  connectIsResume = true;
+}
+
+// Serial "wifi" command: saved networks and time-to-connected, fast vs full
+void printWiFiConnectStats() {
+  printSavedNetworks();
+
+  const ConnectTimeStats* all[] = {&connectTimeFull, &connectTimeFast};
+  const char* names[] = {"full", "fast"};
+  Serial.println("Time to connected:");
+  for (int i = 0; i < 2; i++) {
+    const ConnectTimeStats &stats = *all[i];
+    if (stats.count == 0) {
+      Serial.printf("  %s: none yet\n", names[i]);
     } else {
-      Serial.println("Auto-connect failed");
+      Serial.printf("  %s: %lu connects, avg %lu ms, min %lu, max %lu, last %lu\n", names[i],
+                    (unsigned long)stats.count, (unsigned long)(stats.totalMs / stats.count),
+                    (unsigned long)stats.minMs, (unsigned long)stats.maxMs, (unsigned long)stats.lastMs);
     }
-  } else {
-    Serial.println("No saved WiFi credentials");
+  }
+  if (lastPassiveScanMs) {
+    Serial.printf("  Last passive scan: %lu ms\n", (unsigned long)lastPassiveScanMs);
   }
 }
 
@@ -0,0 +1,213 @@
+/*
+ * Span Tracing
+ * Where the loop's time goes, as a timeline
+ *
+ * SPAN("name") marks a scope: a loop phase, a draw routine (every
+ * DISPLAY_STATS_SCREEN() is also a span) or an I2S write. When the scope
+ * ends, its start, duration, core and task go into a ring that keeps the
+ * last SPAN_RING_SIZE spans from all tasks. "spans" prints them as Chrome
+ * trace JSON, one event per line; host/tools/span_export pulls that out of
+ * a serial capture into a file that Perfetto (ui.perfetto.dev) or
+ * chrome://tracing opens, with one process per core and one track per task.
+ *
+ * "spans arm" freezes the ring at the next audio underrun (a tone block
+ * written later than the DMA ring could cover), so the dump ends with
+ * whatever held up the audio path. SPAN_TRACE_ENABLED 0 compiles spans out.
+ */
+
+#ifndef SPAN_TRACE_H
+#define SPAN_TRACE_H
+
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+#define SPAN_RING_MASK  (SPAN_RING_SIZE - 1)
+#define SPAN_MAX_TASKS  12   // Distinct tasks named in one export
+
+static_assert((SPAN_RING_SIZE & SPAN_RING_MASK) == 0, "SPAN_RING_SIZE must be a power of two");
+
+struct SpanEntry {
+  const char* name;      // String literal
+  uint32_t start;        // Low 32 bits of esp_timer_get_time()
+  uint32_t duration;     // Microseconds
+  TaskHandle_t task;
+  uint8_t core;
+};
+
+struct SpanSlot {
+  std::atomic<uint32_t> sequence;  // Ring index + 1 once the entry is complete
+  SpanEntry entry;
+};
+
+// Span state
+SpanSlot spanRing[SPAN_RING_SIZE];
+std::atomic<uint32_t> spanHead{0};    // Next index to write (oldest entries are overwritten)
+volatile bool spanRecording = true;
+volatile bool spanArmed = false;      // Freeze at the next audio underrun
+uint32_t spanFrozenAt = 0;            // Time of the underrun that froze the ring (0 = none)
+uint32_t spanUnderrunMicros = 0;      // How long the audio path went without a block
+uint32_t spanUnderruns = 0;
+
+// Forward declarations
+void spanRecord(const char* name, uint32_t start, uint32_t duration);
+void spanAudioGap(uint32_t gapMicros);
+void printSpans();
+void resetSpans();
+bool handleSpanCommand(const char* args);
+
+// Records the enclosing scope when it ends
+class SpanScope {
+public:
+  SpanScope(const char* name) : name(name), start((uint32_t)esp_timer_get_time()) {}
+  ~SpanScope() { spanRecord(name, start, (uint32_t)esp_timer_get_time() - start); }
+
+private:
+  const char* name;
+  uint32_t start;
+};
+
+#if SPAN_TRACE_ENABLED
+#define SPAN_CONCAT_(a, b) a##b
+#define SPAN_CONCAT(a, b) SPAN_CONCAT_(a, b)
+#define SPAN(name) SpanScope SPAN_CONCAT(spanScope_, __LINE__)(name)
+#else
+#define SPAN(name)
+#endif
+
+// Store one finished span (any task; an ISR would need its own core/task lookup)
+void spanRecord(const char* name, uint32_t start, uint32_t duration) {
+  if (!spanRecording) return;
+  uint32_t index = spanHead.fetch_add(1, std::memory_order_relaxed);
+  SpanSlot &slot = spanRing[index & SPAN_RING_MASK];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  slot.entry.name = name;
+  slot.entry.start = start;
+  slot.entry.duration = duration;
+  slot.entry.task = xTaskGetCurrentTaskHandle();
+  slot.entry.core = (uint8_t)xPortGetCoreID();
+  slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+/*
+ * The tone path went gapMicros between two blocks with the DMA ring's
+ * I2S_RING_MICROS of audio queued, so the amplifier played silence
+ */
+void spanAudioGap(uint32_t gapMicros) {
+  spanUnderruns++;
+  if (!spanArmed) return;
+  spanArmed = false;
+  spanRecording = false;
+  spanFrozenAt = (uint32_t)esp_timer_get_time();
+  spanUnderrunMicros = gapMicros;
+  Serial.printf("Spans: audio underrun (%lu us without a block), ring frozen; \"spans\" to dump\n",
+                (unsigned long)gapMicros);
+}
+
+// ============================================
+// Export
+// ============================================
+
+/*
+ * Chrome trace JSON between marker lines, one event per line. Times are
+ * full esp_timer microseconds, so dumps from one boot line up.
+ */
+void printSpans() {
+  if (!SPAN_TRACE_ENABLED) {
+    Serial.println("Spans compiled out (SPAN_TRACE_ENABLED = 0)");
+    return;
+  }
+  spanRecording = false;  // The dump's own work stays out of the ring
+
+  int64_t now64 = esp_timer_get_time();
+  uint32_t now = (uint32_t)now64;
+  uint32_t head = spanHead.load(std::memory_order_acquire);
+  uint32_t first = head > SPAN_RING_SIZE ? head - SPAN_RING_SIZE : 0;
+
+  // Tasks seen, in order of first appearance (tid = index + 1)
+  TaskHandle_t tasks[SPAN_MAX_TASKS];
+  uint8_t taskCores[SPAN_MAX_TASKS];  // Bit per core the task ran on
+  int taskCount = 0;
+  for (uint32_t i = first; i != head; i++) {
+    const SpanSlot &slot = spanRing[i & SPAN_RING_MASK];
+    if (slot.sequence.load(std::memory_order_acquire) != i + 1) continue;
+    int t = 0;
+    while (t < taskCount && tasks[t] != slot.entry.task) t++;
+    if (t == taskCount && taskCount < SPAN_MAX_TASKS) {
+      tasks[taskCount] = slot.entry.task;
+      taskCores[taskCount++] = 0;
+    }
+    if (t < taskCount) taskCores[t] |= 1 << slot.entry.core;
+  }
+
+  Serial.printf("=== SPANS BEGIN %lu ===\n", (unsigned long)(head - first));
+  Serial.println("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  Serial.print("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":0,\"args\":{\"name\":\"Core 0\"}}");
+  Serial.print("\n,{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"Core 1\"}}");
+  for (int t = 0; t < taskCount; t++) {
+    for (int core = 0; core < 2; core++) {
+      if (!(taskCores[t] & (1 << core))) continue;
+      Serial.printf("\n,{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    core, t + 1, pcTaskGetName(tasks[t]));
+    }
+  }
+
+  int written = 0;
+  for (uint32_t i = first; i != head; i++) {
+    const SpanSlot &slot = spanRing[i & SPAN_RING_MASK];
+    if (slot.sequence.load(std::memory_order_acquire) != i + 1) continue;
+    SpanEntry entry = slot.entry;
+    int t = 0;
+    while (t < taskCount && tasks[t] != entry.task) t++;
+    long long start = (long long)(now64 - (int64_t)(uint32_t)(now - entry.start));
+    Serial.printf("\n,{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lu}",
+                  entry.name, entry.core, t + 1, start, (unsigned long)entry.duration);
+    written++;
+  }
+
+  // Instant marker where the ring froze
+  if (spanFrozenAt != 0) {
+    long long at = (long long)(now64 - (int64_t)(uint32_t)(now - spanFrozenAt));
+    Serial.printf("\n,{\"ph\":\"i\",\"name\":\"audio underrun\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%lld,"
+                  "\"args\":{\"gap_us\":%lu}}", at, (unsigned long)spanUnderrunMicros);
+  }
+  Serial.println("\n]}");
+  Serial.printf("=== SPANS END %d ===\n", written);
+
+  // Recording resumes (after a freeze too; "spans arm" again for the next underrun)
+  spanFrozenAt = 0;
+  spanRecording = true;
+}
+
+void resetSpans() {
+  for (int i = 0; i < SPAN_RING_SIZE; i++) {
+    spanRing[i].sequence.store(0, std::memory_order_relaxed);
+  }
+  spanHead.store(0, std::memory_order_release);
+  spanFrozenAt = 0;
+  spanUnderruns = 0;
+  spanRecording = true;
+}
+
+// "spans" arguments: none (dump), "arm", "reset"; false if not recognised
+bool handleSpanCommand(const char* args) {
+  if (*args == '\0') {
+    printSpans();
+  } else if (strcmp(args, "arm") == 0) {
+    spanArmed = true;
+    spanFrozenAt = 0;
+    spanRecording = true;
+    Serial.printf("Spans: armed, freezing at the next audio underrun (%lu so far)\n",
+                  (unsigned long)spanUnderruns);
+  } else if (strcmp(args, "reset") == 0) {
+    resetSpans();
+    Serial.println("Spans reset");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+#endif // SPAN_TRACE_H
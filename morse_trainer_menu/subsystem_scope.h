@@ -0,0 +1,94 @@
+/*
+ * Subsystem Scopes
+ * Which subsystem the loop is working for, and what it allocates meanwhile
+ *
+ * The loop task does the audio, network and UI work itself, so FreeRTOS
+ * run time alone cannot split it. SUBSYSTEM_SCOPE() marks a call (I2S
+ * writes, webSocket.loop(), draw routines, ...); nested scopes book to the
+ * innermost one, and whatever the pass does outside all of them books to
+ * the loop. Each scope adds its time and its change in free heap, so
+ * subsystemHeld[] is what each subsystem has allocated and not given back.
+ * Allocations by other tasks while a scope runs land in it too, so small
+ * swings are noise; a figure that only climbs is a leak.
+ *
+ * Only the loop task counts (startSubsystemScopes() records which it is).
+ * runtime_stats.h samples and reports the totals.
+ */
+
+#ifndef SUBSYSTEM_SCOPE_H
+#define SUBSYSTEM_SCOPE_H
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+enum Subsystem : uint8_t {
+  SUBSYSTEM_AUDIO,     // Sidetone, keyers, Vail playback
+  SUBSYSTEM_NETWORK,   // WiFi, WebSocket/TLS
+  SUBSYSTEM_UI,        // Draw routines, keyboard handling
+  SUBSYSTEM_LOOP,      // Rest of the loop pass
+  SUBSYSTEM_SYSTEM,    // Background tasks (gauge, trace, timers)
+  SUBSYSTEM_COUNT
+};
+
+// Totals from the loop task's scopes
+uint32_t subsystemMicros[SUBSYSTEM_COUNT];  // Since the last runtime sample
+int32_t subsystemHeld[SUBSYSTEM_COUNT];     // Net heap bytes since reset
+TaskHandle_t subsystemLoopTask = nullptr;
+
+class SubsystemScope;
+SubsystemScope* activeSubsystemScope = nullptr;
+
+// Forward declarations
+void startSubsystemScopes();
+
+// Books a call to a subsystem (loop task only)
+class SubsystemScope {
+public:
+  SubsystemScope(Subsystem subsystem) : subsystem(subsystem) {
+    active = (xTaskGetCurrentTaskHandle() == subsystemLoopTask);
+    if (!active) return;
+    parent = activeSubsystemScope;
+    activeSubsystemScope = this;
+    heapAtStart = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    startMicros = micros();
+  }
+
+  ~SubsystemScope() {
+    if (!active) return;
+    uint32_t elapsed = micros() - startMicros;
+    int32_t allocated = (int32_t)(heapAtStart - heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    subsystemMicros[subsystem] += elapsed - childMicros;
+    subsystemHeld[subsystem] += allocated - childHeld;
+    activeSubsystemScope = parent;
+    if (parent) {
+      parent->childMicros += elapsed;
+      parent->childHeld += allocated;
+    }
+  }
+
+private:
+  Subsystem subsystem;
+  bool active;
+  SubsystemScope* parent = nullptr;
+  uint32_t heapAtStart = 0;
+  uint32_t startMicros = 0;
+  uint32_t childMicros = 0;
+  int32_t childHeld = 0;
+};
+
+#if RUNTIME_STATS_ENABLED
+#define SUBSYSTEM_CONCAT_(a, b) a##b
+#define SUBSYSTEM_CONCAT(a, b) SUBSYSTEM_CONCAT_(a, b)
+#define SUBSYSTEM_SCOPE(subsystem) SubsystemScope SUBSYSTEM_CONCAT(subsystemScope_, __LINE__)(subsystem)
+#else
+#define SUBSYSTEM_SCOPE(subsystem)
+#endif
+
+// Call from setup() (which runs on the loop task)
+void startSubsystemScopes() {
+  subsystemLoopTask = xTaskGetCurrentTaskHandle();
+}
+
+#endif // SUBSYSTEM_SCOPE_H
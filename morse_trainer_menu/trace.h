@@ -0,0 +1,253 @@
+/*
+ * Trace Log
+ * Deferred logging for the keying, audio and Vail paths
+ *
+ * TRACE(event, args...) stores a fixed-size binary record (event number,
+ * esp_timer time, up to three ints) in a lock-free ring: one
+ * compare-and-swap to claim a slot, a few stores, no formatting and no
+ * UART wait. Any task or interrupt may write. A low-priority task drains
+ * the ring every TRACE_DRAIN_MS and writes it to the serial port, either
+ * formatted ("trace text", the default) or as COBS-framed binary records
+ * ("trace binary") that host/tools/trace_decode turns back into text with
+ * the formats in trace_events.h. A full ring drops records and says how
+ * many.
+ *
+ * The level is set at runtime ("trace debug" ... "trace error"); a record
+ * above it costs one compare. TRACE_ENABLED 0 compiles trace points out.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "span_trace.h"
+#include "trace_events.h"
+
+#define TRACE_MAX_ARGS   3
+#define TRACE_RING_MASK  (TRACE_RING_SIZE - 1)
+#define TRACE_FRAME_MAX  32   // Encoded record: 6 header bytes + 3 varints, COBS overhead, delimiters
+
+static_assert((TRACE_RING_SIZE & TRACE_RING_MASK) == 0, "TRACE_RING_SIZE must be a power of two");
+
+enum TraceOutput : uint8_t {
+  TRACE_OUTPUT_OFF,      // Drained and discarded
+  TRACE_OUTPUT_TEXT,     // Formatted on the drain task
+  TRACE_OUTPUT_BINARY    // COBS frames for host/tools/trace_decode
+};
+
+struct TraceEntry {
+  uint32_t micros;       // Low 32 bits of esp_timer_get_time()
+  uint8_t event;         // TraceEvent
+  uint8_t argc;
+  int32_t args[TRACE_MAX_ARGS];
+};
+
+struct TraceSlot {
+  std::atomic<uint32_t> sequence;  // Ring index + 1 once the entry is complete
+  TraceEntry entry;
+};
+
+// Trace state
+TraceSlot traceRing[TRACE_RING_SIZE];
+std::atomic<uint32_t> traceHead{0};      // Next index to claim
+std::atomic<uint32_t> traceTail{0};      // Next index to drain
+std::atomic<uint32_t> traceDropped{0};
+uint32_t traceDroppedReported = 0;
+uint32_t traceDrained = 0;
+uint32_t traceHighWater = 0;             // Most records waiting at one drain
+volatile uint8_t traceLevel = TRACE_LEVEL_INFO;
+volatile TraceOutput traceOutput = TRACE_OUTPUT_TEXT;
+std::atomic<bool> traceDraining{false};  // One drainer at a time (task or deep sleep flush)
+TaskHandle_t traceTaskHandle = nullptr;
+
+// Forward declarations
+void startTraceLog();
+void traceWrite(uint8_t event, uint8_t argc, int32_t a0, int32_t a1, int32_t a2);
+int drainTrace();
+void printTraceStatus();
+bool handleTraceCommand(const char* args);
+
+inline void traceEmit(TraceEvent event) { traceWrite(event, 0, 0, 0, 0); }
+inline void traceEmit(TraceEvent event, int32_t a0) { traceWrite(event, 1, a0, 0, 0); }
+inline void traceEmit(TraceEvent event, int32_t a0, int32_t a1) { traceWrite(event, 2, a0, a1, 0); }
+inline void traceEmit(TraceEvent event, int32_t a0, int32_t a1, int32_t a2) { traceWrite(event, 3, a0, a1, a2); }
+
+#if TRACE_ENABLED
+#define TRACE(event, ...) do { \
+    if (traceEventLevels[event] <= traceLevel) traceEmit(event, ##__VA_ARGS__); \
+  } while (0)
+#else
+#define TRACE(event, ...) do {} while (0)
+#endif
+
+// Claim a slot, fill it, publish it (safe from any task or interrupt)
+void IRAM_ATTR traceWrite(uint8_t event, uint8_t argc, int32_t a0, int32_t a1, int32_t a2) {
+  uint32_t head = traceHead.load(std::memory_order_relaxed);
+  do {
+    if (head - traceTail.load(std::memory_order_acquire) >= TRACE_RING_SIZE) {
+      traceDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!traceHead.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+  TraceSlot &slot = traceRing[head & TRACE_RING_MASK];
+  slot.entry.micros = (uint32_t)esp_timer_get_time();
+  slot.entry.event = event;
+  slot.entry.argc = argc;
+  slot.entry.args[0] = a0;
+  slot.entry.args[1] = a1;
+  slot.entry.args[2] = a2;
+  slot.sequence.store(head + 1, std::memory_order_release);
+}
+
+// ============================================
+// Output
+// ============================================
+
+// "[seconds.micros] L message"
+void writeTraceText(const TraceEntry &entry) {
+  char line[160];
+  int n = snprintf(line, sizeof(line), "[%lu.%06lu] %c ", (unsigned long)(entry.micros / 1000000),
+                   (unsigned long)(entry.micros % 1000000), "?EWID"[traceEventLevels[entry.event]]);
+  n += snprintf(line + n, sizeof(line) - n, traceEventFormats[entry.event],
+                (int)entry.args[0], (int)entry.args[1], (int)entry.args[2]);
+  if (n > (int)sizeof(line) - 3) n = sizeof(line) - 3;
+  line[n++] = '\r';
+  line[n++] = '\n';
+  Serial.write((const uint8_t*)line, n);
+}
+
+/*
+ * Binary record: event, argc, micros (4 bytes, little-endian),
+ * then each argument as a zigzag varint. COBS-encoded and sent between two
+ * 0x00 bytes, which console text never contains.
+ */
+void writeTraceBinary(const TraceEntry &entry) {
+  uint8_t raw[6 + TRACE_MAX_ARGS * 5];
+  int n = 0;
+  raw[n++] = entry.event;
+  raw[n++] = entry.argc;
+  for (int i = 0; i < 4; i++) raw[n++] = (uint8_t)(entry.micros >> (8 * i));
+  for (int a = 0; a < entry.argc; a++) {
+    uint32_t zigzag = ((uint32_t)entry.args[a] << 1) ^ (uint32_t)(entry.args[a] >> 31);
+    while (zigzag >= 0x80) {
+      raw[n++] = (uint8_t)(zigzag | 0x80);
+      zigzag >>= 7;
+    }
+    raw[n++] = (uint8_t)zigzag;
+  }
+
+  uint8_t frame[TRACE_FRAME_MAX];
+  frame[0] = 0;
+  int out = 2;
+  int code = 1;  // Index of the current block's length byte
+  for (int i = 0; i < n; i++) {
+    if (raw[i] == 0) {
+      frame[code] = out - code;
+      code = out++;
+    } else {
+      frame[out++] = raw[i];
+    }
+  }
+  frame[code] = out - code;
+  frame[out++] = 0;
+  Serial.write(frame, out);
+}
+
+void writeTraceEntry(const TraceEntry &entry) {
+  if (traceOutput == TRACE_OUTPUT_TEXT) {
+    writeTraceText(entry);
+  } else if (traceOutput == TRACE_OUTPUT_BINARY) {
+    writeTraceBinary(entry);
+  }
+}
+
+/*
+ * Write out everything published so far (drain task, and before deep sleep).
+ * Slots are released before the serial write, so writers never wait on the UART.
+ */
+int drainTrace() {
+  if (traceDraining.exchange(true, std::memory_order_acquire)) return 0;
+  SPAN("drainTrace");
+  uint32_t tail = traceTail.load(std::memory_order_relaxed);
+  uint32_t head = traceHead.load(std::memory_order_acquire);
+  if (head - tail > traceHighWater) traceHighWater = head - tail;
+
+  int drained = 0;
+  while (tail != head) {
+    TraceSlot &slot = traceRing[tail & TRACE_RING_MASK];
+    if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;  // Still being written
+    TraceEntry entry = slot.entry;
+    traceTail.store(++tail, std::memory_order_release);
+    writeTraceEntry(entry);
+    drained++;
+  }
+  traceDrained += drained;
+
+  uint32_t dropped = traceDropped.load(std::memory_order_relaxed);
+  if (dropped != traceDroppedReported) {
+    TraceEntry note = {(uint32_t)esp_timer_get_time(), TRACE_DROPPED, 1,
+                       {(int32_t)(dropped - traceDroppedReported), 0, 0}};
+    traceDroppedReported = dropped;
+    writeTraceEntry(note);
+  }
+  traceDraining.store(false, std::memory_order_release);
+  return drained;
+}
+
+void traceTask(void* param) {
+  while (true) {
+    drainTrace();
+    vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_MS));
+  }
+}
+
+// Start the drain task (early in setup; records written before it are kept)
+void startTraceLog() {
+#if TRACE_ENABLED
+  xTaskCreatePinnedToCore(traceTask, "trace", 3072, NULL, 1, &traceTaskHandle, 0);
+#endif
+}
+
+// ============================================
+// Serial console
+// ============================================
+
+void printTraceStatus() {
+  static const char* levels[] = {"?", "error", "warn", "info", "debug"};
+  static const char* outputs[] = {"off", "text", "binary"};
+  if (!TRACE_ENABLED) {
+    Serial.println("Trace compiled out (TRACE_ENABLED = 0)");
+    return;
+  }
+  Serial.printf("Trace: level %s, output %s, %lu records written, %lu dropped, ring %lu/%d at most\n",
+                levels[traceLevel], outputs[traceOutput], (unsigned long)traceDrained,
+                (unsigned long)traceDropped.load(), (unsigned long)traceHighWater, TRACE_RING_SIZE);
+}
+
+// "trace" arguments: a level or an output; false if not recognised
+bool handleTraceCommand(const char* args) {
+  static const char* levels[] = {"error", "warn", "info", "debug"};  // TRACE_LEVEL_ERROR..DEBUG
+  static const char* outputs[] = {"off", "text", "binary"};          // TraceOutput order
+  bool known = (*args == '\0');
+  for (int i = 0; i < 4; i++) {
+    if (strcmp(args, levels[i]) == 0) {
+      traceLevel = TRACE_LEVEL_ERROR + i;
+      known = true;
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    if (strcmp(args, outputs[i]) == 0) {
+      traceOutput = (TraceOutput)i;
+      known = true;
+    }
+  }
+  if (known) printTraceStatus();
+  return known;
+}
+
+#endif // TRACE_H
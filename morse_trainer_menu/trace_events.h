@@ -0,0 +1,62 @@
+/*
+ * Trace Event Table
+ * One line per trace point: name, level and printf format (up to three
+ * int arguments). Shared by the firmware (trace.h) and the host decoder
+ * (host/tools/trace_decode.cpp), so it only uses the preprocessor.
+ *
+ * Events are numbered in table order and the binary log carries only the
+ * number: append new events at the end, and decode a log with the table of
+ * the build that wrote it.
+ */
+
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+// Levels (runtime threshold: records above it are not written)
+#define TRACE_LEVEL_ERROR  1
+#define TRACE_LEVEL_WARN   2
+#define TRACE_LEVEL_INFO   3
+#define TRACE_LEVEL_DEBUG  4
+
+#define TRACE_EVENTS(X) \
+  X(TRACE_DROPPED,          TRACE_LEVEL_WARN,  "Trace: %d records dropped (ring full)") \
+  X(TRACE_I2S_WRITE_ERROR,  TRACE_LEVEL_ERROR, "I2S write error: %d") \
+  X(TRACE_PLAY_TONE,        TRACE_LEVEL_DEBUG, "playTone(%d Hz, %d ms), %d samples") \
+  X(TRACE_PLAY_TONE_DONE,   TRACE_LEVEL_DEBUG, "playTone wrote %d samples") \
+  X(TRACE_START_TONE,       TRACE_LEVEL_DEBUG, "Starting tone: %d Hz") \
+  X(TRACE_BEEP,             TRACE_LEVEL_DEBUG, "beep(%d Hz, %d ms)") \
+  X(TRACE_STRAIGHT_KEY,     TRACE_LEVEL_DEBUG, "Straight key tone %d") \
+  X(TRACE_WS_RECEIVED,      TRACE_LEVEL_DEBUG, "[WS] Received %d bytes") \
+  X(TRACE_VAIL_PARSE_ERROR, TRACE_LEVEL_WARN,  "Vail: JSON parse error %d") \
+  X(TRACE_VAIL_ECHO,        TRACE_LEVEL_INFO,  "Vail: ignoring echo of our own transmission") \
+  X(TRACE_VAIL_QUEUED,      TRACE_LEVEL_INFO,  "Vail: queued %d elements (%d waiting), plays in %d ms") \
+  X(TRACE_VAIL_CLOCK_SYNC,  TRACE_LEVEL_INFO,  "Vail: clock sync, skew %d.%03d s") \
+  X(TRACE_VAIL_SEND,        TRACE_LEVEL_INFO,  "Vail: sending %d elements (%d bytes), timestamp ...%06d") \
+  X(TRACE_VAIL_NOT_SENT,    TRACE_LEVEL_WARN,  "Vail: not connected, %d elements not sent") \
+  X(TRACE_PLAYBACK_WAIT,    TRACE_LEVEL_DEBUG, "Vail: next playback in %d ms") \
+  X(TRACE_PLAYBACK_START,   TRACE_LEVEL_INFO,  "Vail: playing %d elements, %d ms late") \
+  X(TRACE_PLAYBACK_ELEMENT, TRACE_LEVEL_DEBUG, "Vail: element %d, %d ms, tone %d") \
+  X(TRACE_PLAYBACK_DONE,    TRACE_LEVEL_INFO,  "Vail: playback complete") \
+  X(TRACE_BATTERY_ICON,     TRACE_LEVEL_DEBUG, "Battery icon: %d%%, fill %d px, charging %d") \
+  X(TRACE_STATUS,           TRACE_LEVEL_DEBUG, "Status: battery %d mV (%d%%), WiFi %d") \
+  X(TRACE_AUDIO_UNDERRUN,   TRACE_LEVEL_WARN,  "Audio underrun: %d us between tone blocks") \
+  X(TRACE_VAIL_ECHO_RTT,    TRACE_LEVEL_INFO,  "Vail: echo after %d ms (jitter %d ms, probe %d)") \
+  X(TRACE_VAIL_MARKER,      TRACE_LEVEL_DEBUG, "Vail: ignoring probe marker (%d elements)") \
+  X(TRACE_VAIL_PLAYOUT_DELAY, TRACE_LEVEL_INFO, "Vail: playout delay %d ms (was %d)")
+
+#define TRACE_EVENT_ENUM(name, level, format) name,
+enum TraceEvent {
+  TRACE_EVENTS(TRACE_EVENT_ENUM)
+  TRACE_EVENT_COUNT
+};
+#undef TRACE_EVENT_ENUM
+
+#define TRACE_EVENT_LEVEL(name, level, format) level,
+static const unsigned char traceEventLevels[TRACE_EVENT_COUNT] = { TRACE_EVENTS(TRACE_EVENT_LEVEL) };
+#undef TRACE_EVENT_LEVEL
+
+#define TRACE_EVENT_FORMAT(name, level, format) format,
+static const char* const traceEventFormats[TRACE_EVENT_COUNT] = { TRACE_EVENTS(TRACE_EVENT_FORMAT) };
+#undef TRACE_EVENT_FORMAT
+
+#endif // TRACE_EVENTS_H
@@ -9,6 +9,7 @@
 #include "morse_code.h"
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
+#include "display_stats.h"
 
 // Training state
 String currentCallsign = "";
@@ -85,6 +86,7 @@ void drawHeader();
 
 // Draw just the input box (for fast updates while typing)
 void drawInputBox(Adafruit_ST7789& tft) {
+  DISPLAY_STATS_SCREEN("drawInputBox");
   int boxX = 30;
   int boxY = 125;
   int boxW = SCREEN_WIDTH - 60;
@@ -118,6 +120,7 @@ void drawInputBox(Adafruit_ST7789& tft) {
 
 // Draw the Hear It Type It UI
 void drawHearItTypeItUI(Adafruit_ST7789& tft) {
+  DISPLAY_STATS_SCREEN("drawHearItTypeItUI");
   // Draw header to ensure it's properly sized
   drawHeader();
 
@@ -7,7 +7,13 @@
 #define TRAINING_PRACTICE_H
 
 #include "config.h"
+#include "display_stats.h"
+#include "keying_timeline.h"
+#include "latency_stats.h"
+#include "trace.h"
 #include "settings_cw.h"
+#include "span_trace.h"
+#include "subsystem_scope.h"
 
 // Practice mode state
 bool practiceActive = false;
@@ -51,13 +57,7 @@ void startPracticeMode(Adafruit_ST7789 &display) {
   ditMemory = false;
   dahMemory = false;
 
-  // Disable WiFi to prevent audio interference
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("Disabling WiFi for clean audio in practice mode");
-    WiFi.disconnect(true);
-    WiFi.mode(WIFI_OFF);
-    delay(100);
-  }
+  // WiFi is turned off (and restored afterwards) by the practice power profile, see power_profile.h
 
   // Reinitialize I2S to ensure clean state
   Serial.println("Reinitializing I2S for practice mode...");
@@ -67,6 +67,9 @@ void startPracticeMode(Adafruit_ST7789 &display) {
   // Calculate dit duration from current speed setting
   ditDuration = DIT_DURATION(cwSpeed);
 
+  // Keying timeline strip below the settings
+  startKeyingTimeline(display, 185, ditDuration);
+
   // Reset statistics
   practiceStartTime = millis();
   ditCount = 0;
@@ -91,6 +94,7 @@ void startPracticeMode(Adafruit_ST7789 &display) {
 
 // Draw practice UI
 void drawPracticeUI(Adafruit_ST7789 &display) {
+  DISPLAY_STATS_SCREEN("drawPracticeUI");
   // Clear screen (preserve header)
   display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
 
@@ -132,11 +136,13 @@ void drawPracticeUI(Adafruit_ST7789 &display) {
     display.print("Iambic B");
   }
 
-  // No visual indicators - keeps display static for best audio performance
+  // Only the keying timeline updates during practice (single-column blits)
   display.setTextColor(ST77XX_WHITE);
   display.setCursor(30, 165);
   display.print("Key to practice - ESC to exit");
 
+  drawKeyingTimeline(display);
+
   // Draw footer instructions
   display.setTextSize(1);
   display.setTextColor(COLOR_WARNING);
@@ -186,6 +192,7 @@ int handlePracticeInput(char key, Adafruit_ST7789 &display) {
   if (key == KEY_ESC) {
     practiceActive = false;
     stopTone();
+    stopKeyingTimeline();
     return -1;  // Exit practice mode
   }
 
@@ -195,6 +202,8 @@ int handlePracticeInput(char key, Adafruit_ST7789 &display) {
 // Update practice oscillator (called in main loop)
 void updatePracticeOscillator() {
   if (!practiceActive) return;
+  SPAN("updatePracticeOscillator");
+  SUBSYSTEM_SCOPE(SUBSYSTEM_AUDIO);
 
   // Read paddle/key inputs
   ditPressed = (digitalRead(DIT_PIN) == PADDLE_ACTIVE);
@@ -220,14 +229,17 @@ void straightKeyHandler() {
   // Use DIT pin as straight key
   if (ditPressed) {
     if (!isTonePlaying()) {
+      latencyElementStart(false);
       startTone(cwTone);
-      Serial.println("Started tone");
+      setTimelineKeyDown(true);
+      TRACE(TRACE_STRAIGHT_KEY, 1);
     }
     continueTone(cwTone);
   } else {
     if (isTonePlaying()) {
       stopTone();
-      Serial.println("Stopped tone");
+      setTimelineKeyDown(false);
+      TRACE(TRACE_STRAIGHT_KEY, 0);
     }
   }
 }
@@ -246,7 +258,9 @@ void iambicKeyerHandler() {
       inSpacing = false;
       elementStartTime = currentTime;
       ditCount++;
+      latencyElementStart(false);
       startTone(cwTone);
+      setTimelineKeyDown(true);
 
       // Clear dit memory
       ditMemory = false;
@@ -259,7 +273,9 @@ void iambicKeyerHandler() {
       inSpacing = false;
       elementStartTime = currentTime;
       dahCount++;
+      latencyElementStart(false);
       startTone(cwTone);
+      setTimelineKeyDown(true);
 
       // Clear dah memory
       dahMemory = false;
@@ -294,6 +310,8 @@ void iambicKeyerHandler() {
     if (currentTime - elementStartTime >= elementDuration) {
       // Element complete, turn off tone and start spacing
       stopTone();
+      setTimelineKeyDown(false);
+      latencyElementEnd(ditDuration);
       keyerActive = false;
       sendingDit = false;
       sendingDah = false;
@@ -318,7 +336,7 @@ void iambicKeyerHandler() {
     }
 
     // Wait for 1 dit duration (inter-element gap)
-    if (currentTime - elementStartTime >= ditDuration) {
+    if (currentTime - elementStartTime >= (unsigned long)ditDuration) {
       inSpacing = false;
       // Now ready to send next element if memory is set or paddle still pressed
     }
@@ -0,0 +1,375 @@
+/*
+ * Vail Capture
+ * Records a channel session to LittleFS and replays it into the RX path
+ *
+ * While recording, every received message (clock syncs included, our own
+ * echo excluded) and every message this device sends becomes a record in
+ * /vail/NNNN.vcap (vail_capture_format.h). Records collect in a RAM buffer
+ * that goes to flash between tones, or when it would overflow. A flash
+ * write can take milliseconds, and the WebSocket callback and the tone
+ * path run on the loop task. Recording stops at VAIL_CAPTURE_MAX_BYTES.
+ *
+ * Replay feeds a capture's records back through the same queue the
+ * network fills, at the times they were logged. RX and TX records are
+ * both replayed; clock syncs are not. At SPEED x the gaps and element
+ * lengths are divided by SPEED. Timestamps keep their age relative to the
+ * log time, so the playback delay acts as it did live. Replay starts on
+ * the next pass through Vail mode.
+ *
+ * "vailrec dump N" prints a capture as base64 between marker lines;
+ * host/tools/vail_capture turns that (or a .vcap file) into text or a WAV.
+ */
+
+#ifndef VAIL_CAPTURE_H
+#define VAIL_CAPTURE_H
+
+#include <LittleFS.h>
+#include <vector>
+#include "config.h"
+#include "i2s_audio.h"
+#include "vail_capture_format.h"
+
+// Recording state
+File vailCaptureFile;
+int vailCaptureNumber = 0;             // File being written (0 = not recording)
+uint8_t vailCaptureBuffer[VAIL_CAPTURE_BUFFER_BYTES];
+size_t vailCaptureBuffered = 0;
+unsigned long vailCaptureBufferedSince = 0;  // millis() of the oldest unwritten record
+VcapCursor vailCaptureCursor;
+size_t vailCaptureBytes = 0;           // File size including the buffer
+uint32_t vailCaptureRecords = 0;
+uint32_t vailCaptureFlushes = 0;
+uint32_t vailCaptureForcedFlushes = 0; // Written at once because the buffer filled (maybe mid-tone)
+uint32_t vailCaptureMaxFlushMicros = 0;
+bool vailCaptureMounted = false;
+
+// Replay state
+File vailReplayFile;
+int vailReplayNumber = 0;              // Capture being replayed (0 = none)
+float vailReplaySpeed = 1.0f;
+int64_t vailReplayBase = 0;            // Server ms replay started (0 = on the next update)
+int64_t vailReplayFirstLogged = 0;
+VcapCursor vailReplayCursor;
+VcapRecord vailReplayRecord;           // Next record to deliver
+bool vailReplayPending = false;
+uint8_t vailReplayBuffer[VCAP_RECORD_MAX];
+size_t vailReplayBuffered = 0;
+uint32_t vailReplayed = 0;
+
+// Forward declarations
+bool vailCaptureStart(const String &channel, int64_t now);
+void vailCaptureStop();
+void vailCaptureRecord(VcapKind kind, int64_t timestamp, uint16_t clients,
+                       const std::vector<uint16_t> &durations, int64_t now);
+void vailCaptureFlush();
+bool vailReplayStart(int number, float speed);
+void vailReplayStop();
+void updateVailCapture(int64_t now);
+void printVailCaptures();
+void dumpVailCapture(int number);
+bool handleVailCaptureCommand(const char* args);
+void vailReplayDeliver(int64_t timestamp, const uint16_t* durations, uint16_t count);  // vail_repeater.h
+
+bool vailCaptureRecording() { return vailCaptureNumber != 0; }
+bool vailReplaying() { return vailReplayNumber != 0; }
+
+String vailCapturePath(int number) {
+  char path[24];
+  snprintf(path, sizeof(path), VAIL_CAPTURE_DIR "/%04d.vcap", number);
+  return String(path);
+}
+
+// Mount on first use (formats an empty partition), not at boot
+bool vailCaptureMount() {
+  if (vailCaptureMounted) return true;
+  if (!LittleFS.begin(true)) {
+    Serial.println("Vail capture: LittleFS mount failed");
+    return false;
+  }
+  if (!LittleFS.exists(VAIL_CAPTURE_DIR)) LittleFS.mkdir(VAIL_CAPTURE_DIR);
+  vailCaptureMounted = true;
+  return true;
+}
+
+// Highest capture number on flash (0 if none)
+int lastVailCapture() {
+  int last = 0;
+  File dir = LittleFS.open(VAIL_CAPTURE_DIR);
+  if (!dir || !dir.isDirectory()) return 0;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    int number = atoi(f.name());
+    if (number > last) last = number;
+  }
+  return last;
+}
+
+// ============================================
+// Recording
+// ============================================
+
+bool vailCaptureStart(const String &channel, int64_t now) {
+  if (vailCaptureRecording()) return true;
+  if (!vailCaptureMount()) return false;
+
+  int number = lastVailCapture() + 1;
+  vailCaptureFile = LittleFS.open(vailCapturePath(number), FILE_WRITE);
+  if (!vailCaptureFile) {
+    Serial.printf("Vail capture: cannot create %s\n", vailCapturePath(number).c_str());
+    return false;
+  }
+
+  uint8_t header[VCAP_HEADER_MAX];
+  size_t length = vcapEncodeHeader(channel.c_str(), now, header);
+  vailCaptureFile.write(header, length);
+  vailCaptureNumber = number;
+  vailCaptureCursor = {now, now};
+  vailCaptureBuffered = 0;
+  vailCaptureBytes = length;
+  vailCaptureRecords = 0;
+  needsUIRedraw = true;
+  Serial.printf("Vail capture: recording %s to %s\n", channel.c_str(), vailCapturePath(number).c_str());
+  return true;
+}
+
+void vailCaptureStop() {
+  if (!vailCaptureRecording()) return;
+  vailCaptureFlush();
+  vailCaptureFile.close();
+  Serial.printf("Vail capture: %s closed, %lu records, %lu bytes\n", vailCapturePath(vailCaptureNumber).c_str(),
+                (unsigned long)vailCaptureRecords, (unsigned long)vailCaptureBytes);
+  vailCaptureNumber = 0;
+  needsUIRedraw = true;
+}
+
+// Buffered records -> flash
+void vailCaptureFlush() {
+  if (vailCaptureBuffered == 0) return;
+  uint32_t start = micros();
+  size_t written = vailCaptureFile.write(vailCaptureBuffer, vailCaptureBuffered);
+  vailCaptureFile.flush();
+  uint32_t elapsed = micros() - start;
+  if (elapsed > vailCaptureMaxFlushMicros) vailCaptureMaxFlushMicros = elapsed;
+  vailCaptureFlushes++;
+  bool full = written != vailCaptureBuffered;
+  vailCaptureBuffered = 0;
+  if (full) {
+    Serial.println("Vail capture: flash full, recording stopped");
+    vailCaptureFile.close();
+    vailCaptureNumber = 0;
+    needsUIRedraw = true;
+  }
+}
+
+// One message heard or sent (now: server ms)
+void vailCaptureRecord(VcapKind kind, int64_t timestamp, uint16_t clients,
+                       const std::vector<uint16_t> &durations, int64_t now) {
+  if (!vailCaptureRecording()) return;
+
+  static VcapRecord record;
+  record.kind = kind;
+  record.timestamp = timestamp;
+  record.loggedAt = now;
+  record.clients = clients;
+  record.count = (uint16_t)std::min(durations.size(), (size_t)VCAP_MAX_DURATIONS);
+  memcpy(record.durations, durations.data(), record.count * sizeof(uint16_t));
+
+  uint8_t encoded[VCAP_RECORD_MAX];
+  VcapCursor cursor = vailCaptureCursor;
+  size_t length = vcapEncodeRecord(record, cursor, encoded);
+  if (vailCaptureBytes + length > VAIL_CAPTURE_MAX_BYTES) {
+    Serial.printf("Vail capture: %d bytes reached, recording stopped\n", VAIL_CAPTURE_MAX_BYTES);
+    vailCaptureStop();
+    return;
+  }
+  if (vailCaptureBuffered + length > sizeof(vailCaptureBuffer)) {
+    vailCaptureForcedFlushes++;
+    vailCaptureFlush();
+    if (!vailCaptureRecording()) return;
+  }
+  if (vailCaptureBuffered == 0) vailCaptureBufferedSince = millis();
+  memcpy(vailCaptureBuffer + vailCaptureBuffered, encoded, length);
+  vailCaptureBuffered += length;
+  vailCaptureCursor = cursor;
+  vailCaptureBytes += length;
+  vailCaptureRecords++;
+}
+
+// ============================================
+// Replay
+// ============================================
+
+// Decode the next record into vailReplayRecord; false at the end
+bool vailReplayNext() {
+  vailReplayBuffered += vailReplayFile.read(vailReplayBuffer + vailReplayBuffered,
+                                            sizeof(vailReplayBuffer) - vailReplayBuffered);
+  int used = vcapDecodeRecord(vailReplayBuffer, vailReplayBuffered, vailReplayCursor, vailReplayRecord);
+  if (used <= 0) return false;  // End of file, cut short or malformed
+  vailReplayBuffered -= used;
+  memmove(vailReplayBuffer, vailReplayBuffer + used, vailReplayBuffered);
+  return true;
+}
+
+bool vailReplayStart(int number, float speed) {
+  if (!vailCaptureMount()) return false;
+  vailReplayStop();
+  if (number == 0) number = lastVailCapture();
+  if (number == vailCaptureNumber) vailCaptureFlush();
+
+  vailReplayFile = LittleFS.open(vailCapturePath(number), FILE_READ);
+  if (!vailReplayFile) {
+    Serial.printf("Vail capture: no %s\n", vailCapturePath(number).c_str());
+    return false;
+  }
+  uint8_t header[VCAP_HEADER_MAX];
+  size_t length = vailReplayFile.read(header, sizeof(header));
+  VcapHeader info;
+  int used = vcapDecodeHeader(header, length, info);
+  if (used <= 0) {
+    Serial.printf("Vail capture: %s is not a capture\n", vailCapturePath(number).c_str());
+    vailReplayFile.close();
+    return false;
+  }
+  vailReplayFile.seek(used);
+  vailReplayCursor = {info.startMs, info.startMs};
+  vailReplayBuffered = 0;
+  vailReplayPending = vailReplayNext();
+  vailReplayFirstLogged = vailReplayRecord.loggedAt;
+  vailReplayNumber = number;
+  vailReplaySpeed = speed;
+  vailReplayBase = 0;
+  vailReplayed = 0;
+  needsUIRedraw = true;
+  Serial.printf("Vail capture: replaying %s (%s) at %.1fx\n", vailCapturePath(number).c_str(), info.channel, speed);
+  return true;
+}
+
+void vailReplayStop() {
+  if (!vailReplaying()) return;
+  vailReplayFile.close();
+  Serial.printf("Vail capture: replay of %s stopped, %lu messages\n", vailCapturePath(vailReplayNumber).c_str(),
+                (unsigned long)vailReplayed);
+  vailReplayNumber = 0;
+  needsUIRedraw = true;
+}
+
+// From updateVailRepeater(): flush between tones, deliver due replay records
+void updateVailCapture(int64_t now) {
+  if (vailCaptureBuffered > 0 && !isTonePlaying() &&
+      (vailCaptureBuffered >= sizeof(vailCaptureBuffer) / 2 ||
+       millis() - vailCaptureBufferedSince >= VAIL_CAPTURE_FLUSH_MS)) {
+    vailCaptureFlush();
+  }
+
+  if (!vailReplaying()) return;
+  if (vailReplayBase == 0) vailReplayBase = now;
+  while (vailReplayPending) {
+    VcapRecord &r = vailReplayRecord;
+    int64_t due = vailReplayBase + (int64_t)((r.loggedAt - vailReplayFirstLogged) / vailReplaySpeed);
+    if (due > now) break;
+    if (r.count > 0) {
+      for (uint16_t i = 0; i < r.count; i++) {
+        r.durations[i] = (uint16_t)std::max(1.0f, r.durations[i] / vailReplaySpeed);
+      }
+      vailReplayDeliver(vailReplayBase + (int64_t)((r.timestamp - vailReplayFirstLogged) / vailReplaySpeed),
+                        r.durations, r.count);
+      vailReplayed++;
+    }
+    vailReplayPending = vailReplayNext();
+  }
+  if (!vailReplayPending) vailReplayStop();
+}
+
+// ============================================
+// Serial console
+// ============================================
+
+void printVailCaptures() {
+  if (!vailCaptureMount()) return;
+  Serial.printf("Vail captures (%lu of %lu bytes used):\n", (unsigned long)LittleFS.usedBytes(),
+                (unsigned long)LittleFS.totalBytes());
+  File dir = LittleFS.open(VAIL_CAPTURE_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    uint8_t header[VCAP_HEADER_MAX];
+    VcapHeader info;
+    size_t length = f.read(header, sizeof(header));
+    if (vcapDecodeHeader(header, length, info) > 0) {
+      Serial.printf("  %-10s %7lu bytes  %s\n", f.name(), (unsigned long)f.size(), info.channel);
+    }
+  }
+  if (vailCaptureRecording()) {
+    Serial.printf("Recording %s: %lu records, %lu bytes, %lu flushes (%lu forced), slowest %lu us\n",
+                  vailCapturePath(vailCaptureNumber).c_str(), (unsigned long)vailCaptureRecords,
+                  (unsigned long)vailCaptureBytes, (unsigned long)vailCaptureFlushes,
+                  (unsigned long)vailCaptureForcedFlushes, (unsigned long)vailCaptureMaxFlushMicros);
+  }
+  if (vailReplaying()) {
+    Serial.printf("Replaying %s: %lu messages so far\n", vailCapturePath(vailReplayNumber).c_str(),
+                  (unsigned long)vailReplayed);
+  }
+}
+
+// Base64 between marker lines (host/tools/vail_capture reads it back)
+void dumpVailCapture(int number) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  if (!vailCaptureMount()) return;
+  if (number == 0) number = lastVailCapture();
+  if (number == vailCaptureNumber) vailCaptureFlush();
+  File f = LittleFS.open(vailCapturePath(number), FILE_READ);
+  if (!f) {
+    Serial.printf("Vail capture: no %s\n", vailCapturePath(number).c_str());
+    return;
+  }
+  Serial.printf("=== VAILREC BEGIN %d %lu ===\n", number, (unsigned long)f.size());
+  uint8_t in[48];
+  char line[65];
+  size_t length;
+  while ((length = f.read(in, sizeof(in))) > 0) {
+    size_t n = 0;
+    for (size_t i = 0; i < length; i += 3) {
+      uint32_t bits = (uint32_t)in[i] << 16;
+      if (i + 1 < length) bits |= in[i + 1] << 8;
+      if (i + 2 < length) bits |= in[i + 2];
+      line[n++] = alphabet[(bits >> 18) & 63];
+      line[n++] = alphabet[(bits >> 12) & 63];
+      line[n++] = i + 1 < length ? alphabet[(bits >> 6) & 63] : '=';
+      line[n++] = i + 2 < length ? alphabet[bits & 63] : '=';
+    }
+    line[n] = '\0';
+    Serial.println(line);
+  }
+  Serial.println("=== VAILREC END ===");
+}
+
+/*
+ * "vailrec" arguments: none (list), "start", "stop", "play [N] [SPEED]",
+ * "dump [N]", "delete N"; N defaults to the latest capture. False if not
+ * recognised.
+ */
+bool handleVailCaptureCommand(const char* args) {
+  if (*args == '\0') {
+    printVailCaptures();
+  } else if (strcmp(args, "start") == 0) {
+    vailCaptureStart(vailChannel, getCurrentTimestamp());
+  } else if (strcmp(args, "stop") == 0) {
+    vailCaptureStop();
+    vailReplayStop();
+  } else if (strncmp(args, "play", 4) == 0 && (args[4] == '\0' || args[4] == ' ')) {
+    int number = 0;
+    float speed = 1.0f;
+    sscanf(args + 4, "%d %f", &number, &speed);
+    vailReplayStart(number, constrain(speed, 1.0f, VAIL_REPLAY_MAX_SPEED));
+  } else if (strncmp(args, "dump", 4) == 0 && (args[4] == '\0' || args[4] == ' ')) {
+    dumpVailCapture(atoi(args + 4));
+  } else if (strncmp(args, "delete ", 7) == 0) {
+    int number = atoi(args + 7);
+    if (number == vailCaptureNumber) vailCaptureStop();
+    if (number == vailReplayNumber) vailReplayStop();
+    bool removed = vailCaptureMount() && LittleFS.remove(vailCapturePath(number));
+    Serial.printf("Vail capture: %s %s\n", vailCapturePath(number).c_str(), removed ? "deleted" : "not found");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+#endif // VAIL_CAPTURE_H
@@ -0,0 +1,160 @@
+/*
+ * Vail Capture Format
+ * Binary session log written by vail_capture.h and read by the same file
+ * on replay and by host/tools/vail_capture. Plain C++ (no Arduino), so the
+ * host tool can include it.
+ *
+ * A capture is a header followed by records, appended as they happen:
+ *
+ *   header  "VCAP", version (1 byte), channel length (1 byte), channel,
+ *           start time (int64 little-endian, server ms)
+ *   record  kind (1 byte: VCAP_RX or VCAP_TX)
+ *           Timestamp - previous Timestamp (zigzag varint)
+ *           logged at - previous logged at (varint, server ms)
+ *           Clients (varint, RX only)
+ *           element count (varint), then each duration (varint)
+ *
+ * "Previous" starts at the header's start time. An RX record with no
+ * elements is a clock sync. A typical five-element message takes about 13
+ * bytes (against 70 of JSON). A record cut short at the end of the file
+ * (power lost mid-write) is ignored.
+ */
+
+#ifndef VAIL_CAPTURE_FORMAT_H
+#define VAIL_CAPTURE_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define VCAP_VERSION        1
+#define VCAP_MAX_CHANNEL    32    // Channel name bytes kept in the header
+#define VCAP_MAX_DURATIONS  128   // Elements per record (a 512-byte Vail frame holds fewer)
+#define VCAP_HEADER_MAX     (4 + 1 + 1 + VCAP_MAX_CHANNEL + 8)
+#define VCAP_RECORD_MAX     (1 + 10 + 10 + 3 + 3 + 3 * VCAP_MAX_DURATIONS)
+
+enum VcapKind : uint8_t {
+  VCAP_RX = 0,  // Received (another operator, or a clock sync)
+  VCAP_TX = 1   // Sent by this device
+};
+
+struct VcapHeader {
+  char channel[VCAP_MAX_CHANNEL + 1];
+  int64_t startMs;
+};
+
+struct VcapRecord {
+  uint8_t kind;
+  int64_t timestamp;  // Message Timestamp (server ms; tone start for TX)
+  int64_t loggedAt;   // When it arrived or was sent (server ms)
+  uint16_t clients;
+  uint16_t count;
+  uint16_t durations[VCAP_MAX_DURATIONS];
+};
+
+// Delta state shared by consecutive records of one file
+struct VcapCursor {
+  int64_t timestamp;
+  int64_t loggedAt;
+};
+
+inline size_t vcapPutVarint(uint8_t* out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+// Bytes used, 0 if the buffer ends first, -1 if malformed
+inline int vcapGetVarint(const uint8_t* in, size_t len, uint64_t& value) {
+  value = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (i == 10) return -1;
+    value |= (uint64_t)(in[i] & 0x7F) << (7 * i);
+    if (!(in[i] & 0x80)) return (int)(i + 1);
+  }
+  return 0;
+}
+
+inline size_t vcapEncodeHeader(const char* channel, int64_t startMs, uint8_t* out) {
+  size_t channelLength = strlen(channel);
+  if (channelLength > VCAP_MAX_CHANNEL) channelLength = VCAP_MAX_CHANNEL;
+  memcpy(out, "VCAP", 4);
+  out[4] = VCAP_VERSION;
+  out[5] = (uint8_t)channelLength;
+  memcpy(out + 6, channel, channelLength);
+  size_t n = 6 + channelLength;
+  for (int i = 0; i < 8; i++) out[n++] = (uint8_t)((uint64_t)startMs >> (8 * i));
+  return n;
+}
+
+// Bytes used, 0 if incomplete, -1 if not a capture this build reads
+inline int vcapDecodeHeader(const uint8_t* in, size_t len, VcapHeader& header) {
+  if (len < 6) return 0;
+  if (memcmp(in, "VCAP", 4) != 0 || in[4] != VCAP_VERSION || in[5] > VCAP_MAX_CHANNEL) return -1;
+  size_t channelLength = in[5];
+  if (len < 6 + channelLength + 8) return 0;
+  memcpy(header.channel, in + 6, channelLength);
+  header.channel[channelLength] = '\0';
+  uint64_t start = 0;
+  for (int i = 0; i < 8; i++) start |= (uint64_t)in[6 + channelLength + i] << (8 * i);
+  header.startMs = (int64_t)start;
+  return (int)(6 + channelLength + 8);
+}
+
+inline size_t vcapEncodeRecord(const VcapRecord& record, VcapCursor& cursor, uint8_t* out) {
+  int64_t delta = record.timestamp - cursor.timestamp;
+  size_t n = 0;
+  out[n++] = record.kind;
+  n += vcapPutVarint(out + n, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+  n += vcapPutVarint(out + n, (uint64_t)(record.loggedAt > cursor.loggedAt ? record.loggedAt - cursor.loggedAt : 0));
+  if (record.kind == VCAP_RX) n += vcapPutVarint(out + n, record.clients);
+  n += vcapPutVarint(out + n, record.count);
+  for (uint16_t i = 0; i < record.count; i++) n += vcapPutVarint(out + n, record.durations[i]);
+  cursor.timestamp = record.timestamp;
+  if (record.loggedAt > cursor.loggedAt) cursor.loggedAt = record.loggedAt;
+  return n;
+}
+
+// Bytes used, 0 if incomplete, -1 if malformed (cursor moves only on success)
+inline int vcapDecodeRecord(const uint8_t* in, size_t len, VcapCursor& cursor, VcapRecord& record) {
+  if (len < 1) return 0;
+  record.kind = in[0];
+  if (record.kind != VCAP_RX && record.kind != VCAP_TX) return -1;
+  size_t n = 1;
+  uint64_t value;
+  int used;
+
+#define VCAP_NEXT()                                      \
+  if ((used = vcapGetVarint(in + n, len - n, value)) <= 0) return used; \
+  n += used
+
+  VCAP_NEXT();
+  int64_t delta = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  VCAP_NEXT();
+  uint64_t loggedDelta = value;
+  record.clients = 0;
+  if (record.kind == VCAP_RX) {
+    VCAP_NEXT();
+    record.clients = (uint16_t)value;
+  }
+  VCAP_NEXT();
+  if (value > VCAP_MAX_DURATIONS) return -1;
+  record.count = (uint16_t)value;
+  for (uint16_t i = 0; i < record.count; i++) {
+    VCAP_NEXT();
+    if (value > 0xFFFF) return -1;
+    record.durations[i] = (uint16_t)value;
+  }
+#undef VCAP_NEXT
+
+  record.timestamp = cursor.timestamp + delta;
+  record.loggedAt = cursor.loggedAt + (int64_t)loggedDelta;
+  cursor.timestamp = record.timestamp;
+  cursor.loggedAt = record.loggedAt;
+  return (int)n;
+}
+
+#endif // VAIL_CAPTURE_FORMAT_H
@@ -0,0 +1,342 @@
+/*
+ * Vail Link Quality
+ * Round trip, jitter, loss and reconnects to the repeater, and the playout
+ * delay they call for
+ *
+ * The repeater sends every message back to its sender. Each message we
+ * send goes into a ring of VAIL_TX_PENDING Timestamps with its send time;
+ * the echo carrying the same Timestamp is dropped and gives one
+ * round-trip sample, however many sends are in flight. Keyed elements give
+ * samples for free. With probing on, a marker goes out every
+ * VAIL_PROBE_INTERVAL_MS while the paddle is idle: Duration [0], which
+ * the web client plays as nothing and this firmware ignores from anyone.
+ * A send not echoed within VAIL_PROBE_TIMEOUT_MS counts as lost.
+ *
+ * Jitter is the smoothed mean deviation of the round trip (RTTVAR, as TCP
+ * keeps it). Received messages' ages on arrival (our clock, the one
+ * playback runs on, minus their Timestamp) go into a window. The auto
+ * playout delay is the second-highest age in the window plus
+ * VAIL_PLAYOUT_MARGIN_MS, or SRTT + 4 x RTTVAR before anyone else has
+ * keyed. Raising takes effect at once, for the message that needed it.
+ * Lowering waits until nothing has been queued for VAIL_PLAYOUT_SETTLE_MS
+ * and goes VAIL_PLAYOUT_STEP_MS at a time, so a QSO's timing does not shift
+ * under it. Each message keeps the delay it was queued with.
+ *
+ * In Vail mode, L shows the figures; "link" prints them.
+ */
+
+#ifndef VAIL_LINK_H
+#define VAIL_LINK_H
+
+#include <Adafruit_ST7789.h>
+#include "config.h"
+#include "display_stats.h"
+#include "latency_stats.h"
+#include "trace.h"
+
+struct VailPendingSend {
+  int64_t timestamp;   // Message Timestamp (0 = free slot)
+  uint32_t sentAt;     // millis() at sendTXT()
+  bool probe;
+};
+
+struct VailLinkStats {
+  uint32_t sent;             // Messages that went out (probes included)
+  uint32_t probes;
+  uint32_t echoed;
+  uint32_t lost;             // No echo within VAIL_PROBE_TIMEOUT_MS
+  uint32_t recentOutcomes;   // Last 32 sends, bit set = lost (newest in bit 0)
+  uint8_t recentCount;
+  uint32_t rttLastMs;
+  uint32_t rttMinMs;
+  float srttMs;              // Smoothed round trip (0 = no sample yet)
+  float rttvarMs;            // Smoothed mean deviation (jitter)
+  uint32_t drops;            // Connection lost (not a channel change or exit)
+  uint32_t reconnects;       // Connected again after a drop
+  unsigned long connectedAt; // millis() of the last connect (0 = down)
+  unsigned long downMs;      // Time spent down after drops
+  unsigned long downSince;   // millis() of the last drop (0 = not down after a drop)
+};
+
+// Link state
+VailPendingSend vailPending[VAIL_TX_PENDING];
+VailLinkStats vailLink;
+LatencyHistogram vailRttHistogram;   // Round trips, us
+LatencyHistogram vailAgeHistogram;   // Received messages' age on arrival, us (negative ages as 0)
+int32_t vailAges[VAIL_LINK_AGE_WINDOW];
+uint8_t vailAgeCount = 0;
+uint8_t vailAgeNext = 0;
+bool vailProbing = false;
+unsigned long vailLastProbe = 0;
+bool vailPlayoutAuto = VAIL_PLAYOUT_AUTO;
+unsigned long vailLastQueued = 0;    // millis() a received message was last queued
+unsigned long vailLastLowered = 0;
+bool vailLinkView = false;           // Vail mode shows the link card instead of the channel card
+unsigned long vailLinkDrawnAt = 0;
+
+// Forward declarations
+void resetVailLink();
+void vailLinkSent(int64_t timestamp, bool probe);
+bool vailLinkEcho(int64_t timestamp);
+void vailLinkAge(int64_t ageMs);
+void vailLinkConnected();
+void vailLinkDisconnected(bool expected);
+void updateVailLink();
+bool vailProbeDue();
+unsigned long vailPlayoutTarget();
+unsigned long vailTunePlayout(unsigned long current, bool idle);
+void drawVailLinkUI(Adafruit_ST7789 &display, unsigned long delayMs);
+void printVailLink(unsigned long delayMs);
+
+void resetVailLink() {
+  bool up = vailLink.connectedAt != 0;
+  memset(&vailLink, 0, sizeof(vailLink));
+  memset(vailPending, 0, sizeof(vailPending));
+  memset(&vailRttHistogram, 0, sizeof(vailRttHistogram));
+  memset(&vailAgeHistogram, 0, sizeof(vailAgeHistogram));
+  vailAgeCount = 0;
+  vailAgeNext = 0;
+  if (up) vailLink.connectedAt = millis();
+}
+
+void vailLinkOutcome(bool lost) {
+  vailLink.recentOutcomes = (vailLink.recentOutcomes << 1) | (lost ? 1 : 0);
+  if (vailLink.recentCount < 32) vailLink.recentCount++;
+}
+
+// A message went out; its echo is expected back
+void vailLinkSent(int64_t timestamp, bool probe) {
+  int slot = 0;
+  for (int i = 0; i < VAIL_TX_PENDING; i++) {
+    if (vailPending[i].timestamp == 0) { slot = i; break; }
+    if (vailPending[i].sentAt < vailPending[slot].sentAt) slot = i;  // Full: reuse the oldest
+  }
+  if (vailPending[slot].timestamp != 0) {
+    vailLink.lost++;
+    vailLinkOutcome(true);
+  }
+  vailPending[slot] = {timestamp, (uint32_t)millis(), probe};
+  vailLink.sent++;
+  if (probe) vailLink.probes++;
+}
+
+// A received message with our Timestamp: true if it was our echo
+bool vailLinkEcho(int64_t timestamp) {
+  for (int i = 0; i < VAIL_TX_PENDING; i++) {
+    VailPendingSend &p = vailPending[i];
+    if (p.timestamp == 0 || p.timestamp != timestamp) continue;
+
+    uint32_t rtt = (uint32_t)millis() - p.sentAt;
+    p.timestamp = 0;
+    vailLink.echoed++;
+    vailLinkOutcome(false);
+    vailLink.rttLastMs = rtt;
+    if (vailLink.rttMinMs == 0 || rtt < vailLink.rttMinMs) vailLink.rttMinMs = rtt;
+    if (vailLink.srttMs == 0) {
+      vailLink.srttMs = rtt;
+      vailLink.rttvarMs = rtt / 2.0f;
+    } else {
+      vailLink.rttvarMs += (fabsf(vailLink.srttMs - rtt) - vailLink.rttvarMs) / 4;
+      vailLink.srttMs += (rtt - vailLink.srttMs) / 8;
+    }
+    latencyRecord(vailRttHistogram, rtt * 1000);
+    TRACE(TRACE_VAIL_ECHO_RTT, rtt, (int32_t)vailLink.rttvarMs, p.probe);
+    return true;
+  }
+  return false;
+}
+
+// Another operator's message arrived ageMs after its Timestamp (our clock)
+void vailLinkAge(int64_t ageMs) {
+  int32_t age = (int32_t)constrain(ageMs, -60000LL, 60000LL);
+  vailAges[vailAgeNext] = age;
+  vailAgeNext = (vailAgeNext + 1) % VAIL_LINK_AGE_WINDOW;
+  if (vailAgeCount < VAIL_LINK_AGE_WINDOW) vailAgeCount++;
+  latencyRecord(vailAgeHistogram, age > 0 ? (uint32_t)age * 1000 : 0);
+  vailLastQueued = millis();
+}
+
+void vailLinkConnected() {
+  vailLink.connectedAt = millis();
+  if (vailLink.downSince) {
+    vailLink.reconnects++;
+    vailLink.downMs += millis() - vailLink.downSince;
+    vailLink.downSince = 0;
+  }
+}
+
+// expected: we closed it (channel change, exit), so it is not a drop
+void vailLinkDisconnected(bool expected) {
+  if (vailLink.connectedAt == 0) return;  // Already down
+  vailLink.connectedAt = 0;
+  if (!expected) {
+    vailLink.drops++;
+    vailLink.downSince = millis();
+  }
+  memset(vailPending, 0, sizeof(vailPending));  // Echoes of these will not come
+}
+
+// Expire sends whose echo never came
+void updateVailLink() {
+  uint32_t now = millis();
+  for (int i = 0; i < VAIL_TX_PENDING; i++) {
+    if (vailPending[i].timestamp != 0 && now - vailPending[i].sentAt > VAIL_PROBE_TIMEOUT_MS) {
+      vailPending[i].timestamp = 0;
+      vailLink.lost++;
+      vailLinkOutcome(true);
+    }
+  }
+}
+
+bool vailProbeDue() {
+  if (!vailProbing || millis() - vailLastProbe < VAIL_PROBE_INTERVAL_MS) return false;
+  vailLastProbe = millis();
+  return true;
+}
+
+// Delay that would have played the recent messages on time (0 = no data yet)
+unsigned long vailPlayoutTarget() {
+  long need;
+  if (vailAgeCount >= 2) {
+    int32_t highest = INT32_MIN, second = INT32_MIN;
+    for (int i = 0; i < vailAgeCount; i++) {
+      if (vailAges[i] > highest) {
+        second = highest;
+        highest = vailAges[i];
+      } else if (vailAges[i] > second) {
+        second = vailAges[i];
+      }
+    }
+    need = second + VAIL_PLAYOUT_MARGIN_MS;
+  } else if (vailLink.srttMs > 0) {
+    need = (long)(vailLink.srttMs + 4 * vailLink.rttvarMs);
+  } else {
+    return 0;
+  }
+  return constrain(need, (long)VAIL_PLAYOUT_MIN_MS, (long)VAIL_PLAYOUT_MAX_MS);
+}
+
+/*
+ * Next playout delay: up to the target at once, down one step at a time
+ * once nothing is queued (idle) and no message came in for a while
+ */
+unsigned long vailTunePlayout(unsigned long current, bool idle) {
+  unsigned long target = vailPlayoutTarget();
+  if (!vailPlayoutAuto || target == 0 || target == current) return current;
+  if (target > current) {
+    TRACE(TRACE_VAIL_PLAYOUT_DELAY, target, current);
+    return target;
+  }
+  unsigned long now = millis();
+  if (!idle || now - vailLastQueued < VAIL_PLAYOUT_SETTLE_MS || now - vailLastLowered < VAIL_PLAYOUT_SETTLE_MS) {
+    return current;
+  }
+  vailLastLowered = now;
+  unsigned long lowered = current - target > VAIL_PLAYOUT_STEP_MS ? current - VAIL_PLAYOUT_STEP_MS : target;
+  TRACE(TRACE_VAIL_PLAYOUT_DELAY, lowered, current);
+  return lowered;
+}
+
+// ============================================
+// Report
+// ============================================
+
+uint32_t vailLinkLossPercent() {
+  uint32_t outcomes = vailLink.echoed + vailLink.lost;
+  return outcomes ? (vailLink.lost * 100 + outcomes / 2) / outcomes : 0;
+}
+
+/*
+ * Vail mode, L: round trip, jitter, loss, ages, playout delay and
+ * reconnects on one card. Redrawn every VAIL_LINK_REDRAW_MS between tones.
+ */
+void drawVailLinkUI(Adafruit_ST7789 &display, unsigned long delayMs) {
+  DISPLAY_STATS_SCREEN("drawVailLinkUI");
+  display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
+  vailLinkDrawnAt = millis();
+
+  int cardX = 20;
+  int cardY = 50;
+  int cardW = SCREEN_WIDTH - 40;
+  int cardH = 150;
+
+  display.fillRoundRect(cardX, cardY, cardW, cardH, 12, 0x1082); // Dark blue fill
+  display.drawRoundRect(cardX, cardY, cardW, cardH, 12, 0x34BF); // Light blue outline
+
+  const char* labels[] = {"Round trip", "Jitter", "Loss", "Msg age", "Playout", "Link"};
+  char values[6][48];
+  if (vailRttHistogram.count) {
+    snprintf(values[0], sizeof(values[0]), "%lu ms  p50 %lu  p99 %lu", (unsigned long)vailLink.rttLastMs,
+             (unsigned long)(latencyPercentile(vailRttHistogram, 0.50f) / 1000),
+             (unsigned long)(latencyPercentile(vailRttHistogram, 0.99f) / 1000));
+    snprintf(values[1], sizeof(values[1]), "%.0f ms  (srtt %.0f)", vailLink.rttvarMs, vailLink.srttMs);
+  } else {
+    snprintf(values[0], sizeof(values[0]), vailProbing ? "waiting for an echo" : "- (P to probe)");
+    snprintf(values[1], sizeof(values[1]), "-");
+  }
+  int recentLost = __builtin_popcount(vailLink.recentCount < 32
+                                          ? vailLink.recentOutcomes & ((1u << vailLink.recentCount) - 1)
+                                          : vailLink.recentOutcomes);
+  snprintf(values[2], sizeof(values[2]), "%lu%%  (last %d: %d lost)", (unsigned long)vailLinkLossPercent(),
+           vailLink.recentCount, recentLost);
+  if (vailAgeHistogram.count) {
+    snprintf(values[3], sizeof(values[3]), "p50 %lu  p99 %lu ms",
+             (unsigned long)(latencyPercentile(vailAgeHistogram, 0.50f) / 1000),
+             (unsigned long)(latencyPercentile(vailAgeHistogram, 0.99f) / 1000));
+  } else {
+    snprintf(values[3], sizeof(values[3]), "-");
+  }
+  unsigned long target = vailPlayoutTarget();
+  if (target) {
+    snprintf(values[4], sizeof(values[4]), "%lu ms  %s, needs %lu", delayMs, vailPlayoutAuto ? "auto" : "fixed", target);
+  } else {
+    snprintf(values[4], sizeof(values[4]), "%lu ms  %s", delayMs, vailPlayoutAuto ? "auto" : "fixed");
+  }
+  snprintf(values[5], sizeof(values[5]), "%s %lus, %lu drops", vailLink.connectedAt ? "up" : "down",
+           (millis() - (vailLink.connectedAt ? vailLink.connectedAt : vailLink.downSince)) / 1000,
+           (unsigned long)vailLink.drops);
+
+  display.setTextSize(1);
+  for (int row = 0; row < 6; row++) {
+    int yPos = cardY + 14 + row * 22;
+    display.setTextColor(0x7BEF); // Light gray
+    display.setCursor(cardX + 12, yPos);
+    display.print(labels[row]);
+    display.setTextColor(row == 2 && vailLink.lost ? ST77XX_YELLOW : ST77XX_WHITE);
+    display.setCursor(cardX + 85, yPos);
+    display.print(values[row]);
+  }
+
+  // Probe indicator
+  if (vailProbing) {
+    display.fillCircle(cardX + cardW - 20, cardY + 17, 4, ST77XX_GREEN);
+  }
+
+  display.setTextColor(COLOR_WARNING);
+  display.setCursor(10, SCREEN_HEIGHT - 12);
+  display.print("P Probe  A Auto  R Reset  L/ESC Back");
+}
+
+// Serial "link" command
+void printVailLink(unsigned long delayMs) {
+  Serial.printf("Vail link: %lu sent (%lu probes), %lu echoed, %lu lost (%lu%%), probing %s\n",
+                (unsigned long)vailLink.sent, (unsigned long)vailLink.probes, (unsigned long)vailLink.echoed,
+                (unsigned long)vailLink.lost, (unsigned long)vailLinkLossPercent(), vailProbing ? "on" : "off");
+  Serial.printf("  round trip: last %lu ms, min %lu, p50 %lu, p99 %lu, max %lu, srtt %.1f, jitter %.1f\n",
+                (unsigned long)vailLink.rttLastMs, (unsigned long)vailLink.rttMinMs,
+                (unsigned long)(latencyPercentile(vailRttHistogram, 0.50f) / 1000),
+                (unsigned long)(latencyPercentile(vailRttHistogram, 0.99f) / 1000),
+                (unsigned long)(vailRttHistogram.maxMicros / 1000), vailLink.srttMs, vailLink.rttvarMs);
+  Serial.printf("  message age: %lu received, p50 %lu ms, p99 %lu, max %lu\n", (unsigned long)vailAgeHistogram.count,
+                (unsigned long)(latencyPercentile(vailAgeHistogram, 0.50f) / 1000),
+                (unsigned long)(latencyPercentile(vailAgeHistogram, 0.99f) / 1000),
+                (unsigned long)(vailAgeHistogram.maxMicros / 1000));
+  Serial.printf("  playout delay: %lu ms (%s), target %lu\n", delayMs, vailPlayoutAuto ? "auto" : "fixed",
+                vailPlayoutTarget());
+  Serial.printf("  connection: %s, %lu drops, %lu reconnects, down %lu ms after drops\n",
+                vailLink.connectedAt ? "up" : "down", (unsigned long)vailLink.drops,
+                (unsigned long)vailLink.reconnects,
+                vailLink.downMs + (vailLink.downSince ? millis() - vailLink.downSince : 0));
+}
+
+#endif // VAIL_LINK_H
@@ -22,10 +22,19 @@
 #endif
 
 #include "config.h"
+#include "display_stats.h"
+#include "keying_timeline.h"
+#include "latency_stats.h"
 #include "settings_cw.h"
+#include "span_trace.h"
+#include "subsystem_scope.h"
+#include "trace.h"
+#include "vail_capture_format.h"
+#include "vail_link.h"
 
 // Default channel - always defined
 String vailChannel = "General";
+bool vailConnectPending = false;  // Connect to vailChannel once WiFi is up (resume from deep sleep)
 
 #if VAIL_ENABLED
 
@@ -44,8 +53,9 @@ enum VailState {
 WebSocketsClient webSocket;
 VailState vailState = VAIL_DISCONNECTED;
 VailState lastVailState = VAIL_DISCONNECTED;
-String vailServer = "vail.woozle.org";
-int vailPort = 443;  // WSS (secure WebSocket)
+String vailServer = VAIL_SERVER_HOST;
+int vailPort = VAIL_SERVER_PORT;
+bool vailUseTLS = VAIL_SERVER_TLS;  // wss:// (false: ws://)
 int connectedClients = 0;
 int lastConnectedClients = 0;
 String statusText = "";
@@ -57,7 +67,6 @@ unsigned long vailTxStartTime = 0;
 bool vailTxToneOn = false;
 unsigned long vailTxElementStart = 0;
 std::vector<uint16_t> vailTxDurations;
-int64_t lastTxTimestamp = 0;  // Track our last transmission to filter echoes
 int64_t vailToneStartTimestamp = 0;  // Timestamp when current tone started
 
 // Keyer state for Vail (similar to practice mode)
@@ -77,10 +86,12 @@ struct VailMessage {
   int64_t timestamp;
   uint16_t clients;
   std::vector<uint16_t> durations;
+  uint32_t receivedAt = 0;  // Latency probe time of the frame (latency_stats.h)
+  int64_t playAt = 0;       // Timestamp + the playout delay when queued
 };
 
 std::vector<VailMessage> rxQueue;
-unsigned long playbackDelay = 500;  // 500ms delay for network jitter
+unsigned long playbackDelay = VAIL_PLAYOUT_FIXED_MS;  // Network jitter allowance (auto-tuned by vail_link.h)
 int64_t clockSkew = 0;  // Offset to convert millis() to server time
 
 // Forward declarations
@@ -92,10 +103,28 @@ void connectToVail(String channel);
 void disconnectFromVail();
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length);
 void sendVailMessage(std::vector<uint16_t> durations, int64_t timestamp = 0);
+void sendVailProbe();
 void processReceivedMessage(String jsonPayload);
+DeserializationError parseVailMessage(const String &jsonPayload, VailMessage &msg);
+String buildVailMessage(const std::vector<uint16_t> &durations, int64_t timestamp);
 void playbackMessages();
 int64_t getCurrentTimestamp();
 void updateVailPaddles();
+void queueVailMessage(VailMessage &msg);
+void vailReplayDeliver(int64_t timestamp, const uint16_t* durations, uint16_t count);
+bool isVailMarker(const std::vector<uint16_t> &durations);
+bool handleVailLinkCommand(const char* args);
+
+// Session capture (vail_capture.h)
+void vailCaptureRecord(VcapKind kind, int64_t timestamp, uint16_t clients,
+                       const std::vector<uint16_t> &durations, int64_t now);
+void vailCaptureStop();
+void vailReplayStop();
+void updateVailCapture(int64_t now);
+bool vailCaptureRecording();
+bool vailReplaying();
+bool vailCaptureStart(const String &channel, int64_t now);
+bool vailReplayStart(int number, float speed);
 
 // Get current timestamp in milliseconds (Unix epoch)
 int64_t getCurrentTimestamp() {
@@ -124,6 +153,8 @@ void startVailRepeater(Adafruit_ST7789 &display) {
   vailIsTransmitting = false;
   rxQueue.clear();
   vailTxDurations.clear();
+  resetVailLink();
+  vailLinkView = false;
 
   // Initialize keyer state
   vailKeyerActive = false;
@@ -132,6 +163,9 @@ void startVailRepeater(Adafruit_ST7789 &display) {
   vailDahMemory = false;
   vailDitDuration = DIT_DURATION(cwSpeed);
 
+  // Keying timeline strip under the info card
+  startKeyingTimeline(display, 192, vailDitDuration);
+
   // Redraw header with correct title
   drawHeader();
 
@@ -140,7 +174,9 @@ void startVailRepeater(Adafruit_ST7789 &display) {
 
 // Connect to Vail repeater
 void connectToVail(String channel) {
+  SUBSYSTEM_SCOPE(SUBSYSTEM_NETWORK);
   vailChannel = channel;
+  vailConnectPending = false;
   vailState = VAIL_CONNECTING;
   statusText = "Connecting...";
 
@@ -151,7 +187,7 @@ void connectToVail(String channel) {
   String path = "/chat?repeater=" + channel;
 
   Serial.println("WebSocket connecting...");
-  Serial.print("URL: wss://");
+  Serial.print(vailUseTLS ? "URL: wss://" : "URL: ws://");
   Serial.print(vailServer);
   Serial.print(":");
   Serial.print(vailPort);
@@ -167,7 +203,11 @@ void connectToVail(String channel) {
   webSocket.setExtraHeaders("Sec-WebSocket-Protocol: json.vail.woozle.org");
 
   // Simple beginSSL - library should handle SSL automatically
-  webSocket.beginSSL(vailServer.c_str(), vailPort, path.c_str());
+  if (vailUseTLS) {
+    webSocket.beginSSL(vailServer.c_str(), vailPort, path.c_str());
+  } else {
+    webSocket.begin(vailServer.c_str(), vailPort, path.c_str());
+  }
 
   // Set reconnect interval
   webSocket.setReconnectInterval(5000);
@@ -177,6 +217,8 @@ void connectToVail(String channel) {
 
 // Disconnect from Vail
 void disconnectFromVail() {
+  vailConnectPending = false;
+  vailLinkDisconnected(true);  // Ours, not a drop
   webSocket.disconnect();
   vailState = VAIL_DISCONNECTED;
   statusText = "Disconnected";
@@ -189,6 +231,7 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       Serial.println("[WS] Disconnected");
       vailState = VAIL_DISCONNECTED;
       statusText = "Disconnected";
+      vailLinkDisconnected(false);
       needsUIRedraw = true;
       break;
 
@@ -197,6 +240,7 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
         Serial.println("[WS] Connected");
         vailState = VAIL_CONNECTED;
         statusText = "Connected";
+        vailLinkConnected();
         needsUIRedraw = true;
 
         // Get the URL we connected to
@@ -207,7 +251,8 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       break;
 
     case WStype_TEXT:
-      Serial.printf("[WS] Received: %s\n", payload);
+      latencyWireReceive();
+      TRACE(TRACE_WS_RECEIVED, length);
       processReceivedMessage(String((char*)payload));
       break;
 
@@ -231,19 +276,46 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
 }
 
 // Process received JSON message
-void processReceivedMessage(String jsonPayload) {
+// Decode a repeater message (durations empty for a clock sync)
+DeserializationError parseVailMessage(const String &jsonPayload, VailMessage &msg) {
   StaticJsonDocument<512> doc;
   DeserializationError error = deserializeJson(doc, jsonPayload);
+  if (error) return error;
 
-  if (error) {
-    Serial.print("JSON parse error: ");
-    Serial.println(error.c_str());
-    return;
+  msg.timestamp = doc["Timestamp"].as<int64_t>();
+  msg.clients = doc["Clients"].as<uint16_t>();
+  msg.durations.clear();
+  JsonArray durations = doc["Duration"];
+  for (uint16_t duration : durations) {
+    msg.durations.push_back(duration);
   }
+  return error;
+}
 
+// Encode an outgoing message (Clients is filled in by the server)
+String buildVailMessage(const std::vector<uint16_t> &durations, int64_t timestamp) {
+  StaticJsonDocument<512> doc;
+  doc["Timestamp"] = timestamp;
+  doc["Clients"] = 0;
+
+  JsonArray durArray = doc.createNestedArray("Duration");
+  for (uint16_t dur : durations) {
+    durArray.add(dur);
+  }
+
+  String output;
+  serializeJson(doc, output);
+  return output;
+}
+
+void processReceivedMessage(String jsonPayload) {
   VailMessage msg;
-  msg.timestamp = doc["Timestamp"].as<int64_t>();
-  msg.clients = doc["Clients"].as<uint16_t>();
+  DeserializationError error = parseVailMessage(jsonPayload, msg);
+
+  if (error) {
+    TRACE(TRACE_VAIL_PARSE_ERROR, error.code());
+    return;
+  }
 
   // Update client count and trigger UI redraw if changed
   if (connectedClients != msg.clients) {
@@ -251,83 +323,153 @@ void processReceivedMessage(String jsonPayload) {
     needsUIRedraw = true;
   }
 
-  JsonArray durations = doc["Duration"];
-  if (durations.size() > 0) {
-    // Check if this is our own message echoed back (within 100ms tolerance)
-    if (abs(msg.timestamp - lastTxTimestamp) < 100) {
-      Serial.println("Ignoring echo of our own transmission");
+  if (msg.durations.size() > 0) {
+    // Our own message echoed back (one round-trip sample, vail_link.h)
+    if (vailLinkEcho(msg.timestamp)) {
+      TRACE(TRACE_VAIL_ECHO);
       return;
     }
 
-    for (uint16_t duration : durations) {
-      msg.durations.push_back(duration);
+    // Someone else's link probe: nothing to play
+    if (isVailMarker(msg.durations)) {
+      TRACE(TRACE_VAIL_MARKER, msg.durations.size());
+      return;
     }
 
-    // Add to receive queue with playback delay
-    rxQueue.push_back(msg);
-
-    Serial.print("Queued message: ");
-    Serial.print(msg.durations.size());
-    Serial.println(" elements");
+    int64_t now = getCurrentTimestamp();
+    vailCaptureRecord(VCAP_RX, msg.timestamp, msg.clients, msg.durations, now);
+    vailLinkAge(now - msg.timestamp);
+    playbackDelay = vailTunePlayout(playbackDelay, false);
+    msg.receivedAt = latencyReceivedAt;
+    queueVailMessage(msg);
   } else {
     // Empty duration = clock sync message
     // Calculate offset from server time to our millis()
     clockSkew = msg.timestamp - (int64_t)millis();
-    Serial.print("Clock sync: server=");
-    Serial.print((long)msg.timestamp);
-    Serial.print(" millis=");
-    Serial.print((long)millis());
-    Serial.print(" skew=");
-    Serial.print((long)clockSkew);
-    Serial.println(" ms");
+    TRACE(TRACE_VAIL_CLOCK_SYNC, (int32_t)(clockSkew / 1000), (int32_t)llabs(clockSkew % 1000));
+    vailCaptureRecord(VCAP_RX, msg.timestamp, msg.clients, msg.durations, getCurrentTimestamp());
+  }
+}
+
+// A message whose elements are all zero carries no tone (link probes)
+bool isVailMarker(const std::vector<uint16_t> &durations) {
+  for (uint16_t duration : durations) {
+    if (duration != 0) return false;
   }
+  return true;
+}
+
+// Add to receive queue with playback delay
+void queueVailMessage(VailMessage &msg) {
+  msg.playAt = msg.timestamp + playbackDelay;
+  rxQueue.push_back(msg);
+  TRACE(TRACE_VAIL_QUEUED, msg.durations.size(), rxQueue.size(),
+        (int32_t)(msg.playAt - getCurrentTimestamp()));
+}
+
+// A replayed capture record takes the received path (vail_capture.h)
+void vailReplayDeliver(int64_t timestamp, const uint16_t* durations, uint16_t count) {
+  VailMessage msg;
+  msg.timestamp = timestamp;
+  msg.clients = connectedClients;
+  msg.durations.assign(durations, durations + count);
+  queueVailMessage(msg);
 }
 
 // Send message to Vail repeater
 void sendVailMessage(std::vector<uint16_t> durations, int64_t timestamp) {
+  SUBSYSTEM_SCOPE(SUBSYSTEM_NETWORK);
   if (vailState != VAIL_CONNECTED) {
-    Serial.println("Not connected to Vail");
+    TRACE(TRACE_VAIL_NOT_SENT, durations.size());
+    latencyWireFrom = 0;  // Nothing went on the wire
     return;
   }
 
-  StaticJsonDocument<512> doc;
-
   // Use provided timestamp (when tone started), or get current time if not provided
   if (timestamp == 0) {
     timestamp = getCurrentTimestamp();
   }
-  doc["Timestamp"] = timestamp;
-  doc["Clients"] = 0;  // Server will fill this in
+  String output = buildVailMessage(durations, timestamp);
 
-  JsonArray durArray = doc.createNestedArray("Duration");
-  for (uint16_t dur : durations) {
-    durArray.add(dur);
-  }
+  TRACE(TRACE_VAIL_SEND, durations.size(), output.length(), (int32_t)(timestamp % 1000000));
 
-  String output;
-  serializeJson(doc, output);
+  // Remember this timestamp to filter out the echo and time its round trip
+  vailLinkSent(timestamp, false);
 
-  Serial.print("Sending (ts=");
-  Serial.print((long)timestamp);
-  Serial.print("): ");
-  Serial.println(output);
+  latencyWireSend();
+  webSocket.sendTXT(output);
+  vailCaptureRecord(VCAP_TX, timestamp, 0, durations, getCurrentTimestamp());
+}
 
-  // Remember this timestamp to filter out the echo
-  lastTxTimestamp = timestamp;
+// Send a link probe: a marker that comes back to us as a round-trip sample
+void sendVailProbe() {
+  SUBSYSTEM_SCOPE(SUBSYSTEM_NETWORK);
+  if (vailState != VAIL_CONNECTED) return;
 
+  // Duration [0]: the server drops messages with no elements
+  int64_t timestamp = getCurrentTimestamp();
+  String output = buildVailMessage({0}, timestamp);
+  vailLinkSent(timestamp, true);
   webSocket.sendTXT(output);
 }
 
+// Serial "link [probe|auto|reset]"
+bool handleVailLinkCommand(const char* args) {
+  if (strcmp(args, "probe") == 0) {
+    vailProbing = !vailProbing;
+    Serial.printf("Vail link: probing %s\n", vailProbing ? "on" : "off");
+  } else if (strcmp(args, "auto") == 0) {
+    vailPlayoutAuto = !vailPlayoutAuto;
+    if (!vailPlayoutAuto) playbackDelay = VAIL_PLAYOUT_FIXED_MS;
+    Serial.printf("Vail link: playout delay %s (%lu ms)\n", vailPlayoutAuto ? "auto" : "fixed", playbackDelay);
+  } else if (strcmp(args, "reset") == 0) {
+    resetVailLink();
+    Serial.println("Vail link stats reset");
+  } else if (*args != '\0') {
+    return false;
+  }
+  printVailLink(playbackDelay);
+  return true;
+}
+
 // Update Vail repeater (call in main loop)
 void updateVailRepeater(Adafruit_ST7789 &display) {
-  webSocket.loop();
+  if (vailConnectPending && WiFi.status() == WL_CONNECTED) {
+    connectToVail(vailChannel);
+    needsUIRedraw = true;
+  }
+  {
+    SPAN("webSocket.loop");
+    SUBSYSTEM_SCOPE(SUBSYSTEM_NETWORK);
+    webSocket.loop();
+  }
 
   // Update paddle transmission
   updateVailPaddles();
 
+  // Link quality: expire lost sends, probe while the paddle is idle, relax the playout delay
+  updateVailLink();
+  if (vailState == VAIL_CONNECTED && !vailIsTransmitting && vailProbeDue()) {
+    sendVailProbe();
+  }
+  playbackDelay = vailTunePlayout(playbackDelay, rxQueue.empty());
+
+  // Advance the keying timeline strip (hidden behind the link card)
+  if (!vailLinkView) {
+    updateKeyingTimeline(display);
+  } else if (millis() - vailLinkDrawnAt >= VAIL_LINK_REDRAW_MS && !isTonePlaying()) {
+    needsUIRedraw = true;
+  }
+
+  // Flush the session capture between tones, feed a replay
+  updateVailCapture(getCurrentTimestamp());
+
   // Playback received messages
   playbackMessages();
 
+  // Keep the sidetone or received tone fed (startTone() writes one block only)
+  continueTone(cwTone);
+
   // Redraw UI if status changed
   if (needsUIRedraw) {
     drawVailUI(display);
@@ -346,7 +488,9 @@ void vailStraightKeyHandler() {
     vailTxToneOn = true;
     vailTxElementStart = millis();
     vailTxDurations.clear();
+    latencyElementStart(true);
     startTone(cwTone);
+    setTimelineKeyDown(true);
   }
 
   if (vailIsTransmitting) {
@@ -358,20 +502,23 @@ void vailStraightKeyHandler() {
       vailTxToneOn = ditPressed;
 
       if (ditPressed) {
+        latencyElementStart(true);
         startTone(cwTone);
       } else {
         stopTone();
       }
+      setTimelineKeyDown(ditPressed);
     }
 
     // End transmission after 3 dit units of silence (letter spacing)
-    if (!ditPressed && (millis() - vailTxElementStart > (vailDitDuration * 3))) {
+    if (!ditPressed && (millis() - vailTxElementStart > (unsigned long)(vailDitDuration * 3))) {
       unsigned long duration = millis() - vailTxElementStart;
       vailTxDurations.push_back((uint16_t)duration);
       sendVailMessage(vailTxDurations);
       vailIsTransmitting = false;
       vailTxDurations.clear();
       stopTone();
+      setTimelineKeyDown(false);
     }
   }
 }
@@ -390,7 +537,9 @@ void vailIambicKeyerHandler() {
       vailInSpacing = false;
       vailElementStartTime = currentTime;
       vailToneStartTimestamp = getCurrentTimestamp();  // Capture when tone starts
+      latencyElementStart(true);
       startTone(cwTone);
+      setTimelineKeyDown(true);
 
       // Start new transmission if needed
       if (!vailIsTransmitting) {
@@ -409,7 +558,9 @@ void vailIambicKeyerHandler() {
       vailInSpacing = false;
       vailElementStartTime = currentTime;
       vailToneStartTimestamp = getCurrentTimestamp();  // Capture when tone starts
+      latencyElementStart(true);
       startTone(cwTone);
+      setTimelineKeyDown(true);
 
       // Start new transmission if needed
       if (!vailIsTransmitting) {
@@ -452,6 +603,8 @@ void vailIambicKeyerHandler() {
 
       // Element complete, turn off tone and start spacing
       stopTone();
+      setTimelineKeyDown(false);
+      latencyElementEnd(vailDitDuration);
       vailKeyerActive = false;
       vailSendingDit = false;
       vailSendingDah = false;
@@ -477,7 +630,7 @@ void vailIambicKeyerHandler() {
     unsigned long spaceDuration = currentTime - vailElementStartTime;
 
     // Check if next element is starting (memory set)
-    if ((vailDitMemory || vailDahMemory) && spaceDuration >= vailDitDuration) {
+    if ((vailDitMemory || vailDahMemory) && spaceDuration >= (unsigned long)vailDitDuration) {
       // Don't send silences - just move to next element
       vailInSpacing = false;
       vailTxStartTime = millis();  // Reset idle timer
@@ -493,6 +646,8 @@ void vailIambicKeyerHandler() {
 
 // Handle paddle input for transmission
 void updateVailPaddles() {
+  SPAN("updateVailPaddles");
+  SUBSYSTEM_SCOPE(SUBSYSTEM_AUDIO);
   vailDitPressed = (digitalRead(DIT_PIN) == PADDLE_ACTIVE);
   vailDahPressed = (digitalRead(DAH_PIN) == PADDLE_ACTIVE);
 
@@ -511,6 +666,9 @@ static unsigned long playbackElementStart = 0;
 
 // Playback received messages (non-blocking)
 void playbackMessages() {
+  SPAN("playbackMessages");
+  SUBSYSTEM_SCOPE(SUBSYSTEM_AUDIO);
+
   // Don't play if transmitting
   if (vailIsTransmitting) {
     if (isPlaying) {
@@ -528,27 +686,20 @@ void playbackMessages() {
   // Start playing if not already playing
   if (!isPlaying && !rxQueue.empty()) {
     VailMessage &msg = rxQueue[0];
-    int64_t playTime = msg.timestamp + playbackDelay;
+    int64_t playTime = msg.playAt;
 
-    Serial.print("Checking playback: now=");
-    Serial.print((long)now);
-    Serial.print(" playTime=");
-    Serial.print((long)playTime);
-    Serial.print(" diff=");
-    Serial.println((long)(playTime - now));
+    TRACE(TRACE_PLAYBACK_WAIT, (int32_t)(playTime - now));
 
     if (now >= playTime) {
-      Serial.print("Starting playback of ");
-      Serial.print(msg.durations.size());
-      Serial.println(" elements");
+      TRACE(TRACE_PLAYBACK_START, msg.durations.size(), (int32_t)(now - playTime));
       isPlaying = true;
       playbackIndex = 0;
       playbackElementStart = millis();
+      latencyPlaybackStart(msg.receivedAt, (uint32_t)(now - playTime) * 1000);
 
       // Start first element
       if (msg.durations.size() > 0) {
-        Serial.print("First element duration: ");
-        Serial.println(msg.durations[0]);
+        TRACE(TRACE_PLAYBACK_ELEMENT, 0, msg.durations[0], 1);
         startTone(cwTone);  // First element is always a tone
       }
     }
@@ -570,24 +721,18 @@ void playbackMessages() {
         isPlaying = false;
         playbackIndex = 0;
         rxQueue.erase(rxQueue.begin());
-        Serial.println("Playback complete");
+        TRACE(TRACE_PLAYBACK_DONE);
       } else {
         // Start next element
         playbackElementStart = millis();
 
-        Serial.print("Element ");
-        Serial.print(playbackIndex);
-        Serial.print(": ");
-        Serial.print(msg.durations[playbackIndex]);
-        Serial.print("ms ");
+        TRACE(TRACE_PLAYBACK_ELEMENT, playbackIndex, msg.durations[playbackIndex], playbackIndex % 2 == 0);
 
         if (playbackIndex % 2 == 0) {
           // Even index = tone
-          Serial.println("TONE");
           startTone(cwTone);
         } else {
           // Odd index = silence
-          Serial.println("SILENCE");
           stopTone();
         }
       }
@@ -597,6 +742,12 @@ void playbackMessages() {
 
 // Draw Vail UI
 void drawVailUI(Adafruit_ST7789 &display) {
+  if (vailLinkView) {
+    drawVailLinkUI(display, playbackDelay);
+    return;
+  }
+
+  DISPLAY_STATS_SCREEN("drawVailUI");
   // Clear screen (preserve header)
   display.fillRect(0, 42, SCREEN_WIDTH, SCREEN_HEIGHT - 42, COLOR_BACKGROUND);
 
@@ -665,6 +816,14 @@ void drawVailUI(Adafruit_ST7789 &display) {
     display.print(connectedClients);
   }
 
+  // Capture indicator (recording or replaying)
+  if (vailCaptureRecording() || vailReplaying()) {
+    display.setTextSize(1);
+    display.setTextColor(vailCaptureRecording() ? ST77XX_RED : ST77XX_CYAN);
+    display.setCursor(cardX + cardW - 65, cardY + 65);
+    display.print(vailCaptureRecording() ? "REC" : "PLAY");
+  }
+
   // TX indicator on card
   if (vailIsTransmitting) {
     display.fillCircle(cardX + cardW - 25, cardY + 25, 8, ST77XX_RED);
@@ -674,26 +833,75 @@ void drawVailUI(Adafruit_ST7789 &display) {
     display.print("TX");
   }
 
-  // Instructions
-  display.setTextSize(1);
-  display.setTextColor(0x7BEF); // Light gray
-  display.setCursor(30, 200);
-  display.print("Use paddle to transmit");
+  // Keying timeline (replaces the "use paddle" hint)
+  drawKeyingTimeline(display);
 
   // Footer with controls
   display.setTextColor(COLOR_WARNING);
   display.setTextSize(1);
   display.setCursor(10, SCREEN_HEIGHT - 12);
-  display.print("\x18\x19 Chan  \x1B\x1A Spd  ESC Exit");
+  display.print("\x18\x19 Chan  \x1B\x1A Spd  R Rec  P Play  L Link  ESC");
 }
 
 // Handle Vail input
 int handleVailInput(char key, Adafruit_ST7789 &display) {
+  // Link card: P probes, A toggles the auto playout delay, R resets, L/ESC go back
+  if (vailLinkView) {
+    if (key == KEY_ESC || key == 'l' || key == 'L') {
+      vailLinkView = false;
+    } else if (key == 'p' || key == 'P') {
+      vailProbing = !vailProbing;
+    } else if (key == 'a' || key == 'A') {
+      vailPlayoutAuto = !vailPlayoutAuto;
+      if (!vailPlayoutAuto) playbackDelay = VAIL_PLAYOUT_FIXED_MS;
+    } else if (key == 'r' || key == 'R') {
+      resetVailLink();
+    } else {
+      return 0;
+    }
+    needsUIRedraw = true;
+    beep(TONE_MENU_NAV, BEEP_SHORT);
+    return 0;
+  }
+
   if (key == KEY_ESC) {
+    vailCaptureStop();
+    vailReplayStop();
     disconnectFromVail();
+    stopKeyingTimeline();
     return -1;  // Exit Vail mode
   }
 
+  // R: start/stop recording the session; P: replay the latest capture (again: stop)
+  if (key == 'r' || key == 'R') {
+    if (vailCaptureRecording()) {
+      vailCaptureStop();
+    } else {
+      vailCaptureStart(vailChannel, getCurrentTimestamp());
+    }
+    needsUIRedraw = true;
+    beep(TONE_MENU_NAV, BEEP_SHORT);
+    return 0;
+  }
+
+  if (key == 'l' || key == 'L') {
+    vailLinkView = true;
+    needsUIRedraw = true;
+    beep(TONE_MENU_NAV, BEEP_SHORT);
+    return 0;
+  }
+
+  if (key == 'p' || key == 'P') {
+    if (vailReplaying()) {
+      vailReplayStop();
+    } else {
+      vailReplayStart(0, 1.0f);
+    }
+    needsUIRedraw = true;
+    beep(TONE_MENU_NAV, BEEP_SHORT);
+    return 0;
+  }
+
   // Arrow Up/Down: Change channel
   if (key == KEY_UP) {
     // Cycle through channels: General, 1-10
@@ -742,6 +950,7 @@ int handleVailInput(char key, Adafruit_ST7789 &display) {
     if (cwSpeed > 5) {
       cwSpeed--;
       vailDitDuration = DIT_DURATION(cwSpeed);
+      setTimelineSpeed(vailDitDuration);
       saveCWSettings();
       needsUIRedraw = true;
       beep(TONE_MENU_NAV, BEEP_SHORT);
@@ -753,6 +962,7 @@ int handleVailInput(char key, Adafruit_ST7789 &display) {
     if (cwSpeed < 40) {
       cwSpeed++;
       vailDitDuration = DIT_DURATION(cwSpeed);
+      setTimelineSpeed(vailDitDuration);
       saveCWSettings();
       needsUIRedraw = true;
       beep(TONE_MENU_NAV, BEEP_SHORT);
@@ -805,6 +1015,19 @@ void disconnectFromVail() {
   // Nothing to do
 }
 
+int64_t getCurrentTimestamp() {
+  return (int64_t)millis();
+}
+
+void vailReplayDeliver(int64_t timestamp, const uint16_t* durations, uint16_t count) {
+  // Nothing to do
+}
+
+bool handleVailLinkCommand(const char* args) {
+  Serial.println("Vail repeater disabled");
+  return true;
+}
+
 #endif // VAIL_ENABLED
 
 #endif // VAIL_REPEATER_H
@@ -0,0 +1,333 @@
+/*
+ * WiFi Credential Store
+ * Saved networks with a per-network connection cache
+ *
+ * Up to WIFI_MAX_SAVED_NETWORKS networks live in the "wifi" Preferences
+ * namespace, one blob per slot. Besides SSID and password each slot caches
+ * the BSSID and channel it last joined and the DHCP lease it got, so a
+ * reconnect can skip the scan (channel + BSSID given to WiFi.begin()) and
+ * the DHCP exchange (lease applied as a static config). When more than one
+ * network is saved, a single passive scan (async, polled from loop()) picks
+ * the strongest one in range.
+ *
+ * The DHCP lease time is not known, so a cached address is reused only for
+ * WIFI_LEASE_REUSE_S after DHCP handed it out (a static reuse does not
+ * renew it), measured on the RTC clock. That clock runs through deep sleep
+ * but restarts at power on, so each slot records which power-on clock its
+ * time came from; after a cold boot every network goes back to DHCP once.
+ */
+
+#ifndef WIFI_CREDENTIALS_H
+#define WIFI_CREDENTIALS_H
+
+#include <WiFi.h>
+#include <Preferences.h>
+#include "config.h"
+
+#define WIFI_STORE_VERSION 2  // 2: lease time added to SavedNetwork (1 is read without it)
+
+struct SavedNetwork {
+  char ssid[33];
+  char password[65];
+  uint8_t bssid[6];
+  uint8_t channel;      // 0 = nothing cached
+  uint32_t ip;          // Cached lease (0 = none)
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t lastUsed;    // Store sequence number; highest = most recently connected
+  uint32_t leaseAt;     // wifiClockSeconds() when DHCP handed out ip
+  uint32_t leaseClock;  // wifiClockId when leaseAt was taken (0 = no lease time)
+};
+
+#define WIFI_STORE_V1_SIZE offsetof(SavedNetwork, leaseAt)
+
+SavedNetwork savedNetworks[WIFI_MAX_SAVED_NETWORKS];
+int savedNetworkCount = 0;
+uint32_t savedNetworkSeq = 0;
+bool savedNetworksLoaded = false;
+uint32_t lastPassiveScanMs = 0;
+unsigned long passiveScanStartTime = 0;
+Preferences credentialPrefs;
+RTC_DATA_ATTR uint32_t wifiClockId = 0;  // Drawn once per power on (RTC memory is zeroed then)
+
+// Forward declarations
+void loadSavedNetworks();
+int findSavedNetwork(const String &ssid);
+int rememberNetwork(const String &ssid, const String &password);
+void updateNetworkCache(int slot, bool dhcpLease);
+void clearNetworkCache(int slot);
+bool hasNetworkCache(int slot);
+bool networkLeaseValid(const SavedNetwork &net);
+bool startSavedNetworkScan();
+int rankSavedNetworks(int order[]);
+void printSavedNetworks();
+
+// Write one slot (and the header) to flash
+void writeSavedNetwork(int slot) {
+  char key[8];
+  snprintf(key, sizeof(key), "net%d", slot);
+  credentialPrefs.begin("wifi", false);
+  credentialPrefs.putBytes(key, &savedNetworks[slot], sizeof(SavedNetwork));
+  credentialPrefs.putUChar("count", savedNetworkCount);
+  credentialPrefs.putUChar("version", WIFI_STORE_VERSION);
+  credentialPrefs.end();
+}
+
+// Rewrite the whole store at the current slot size (storedCount: slots there were)
+void writeAllSavedNetworks(int storedCount) {
+  credentialPrefs.begin("wifi", false);
+  for (uint8_t i = 0; i < max(savedNetworkCount, storedCount); i++) {  // count is stored as a byte
+    char key[8];
+    snprintf(key, sizeof(key), "net%d", i);
+    if (i < savedNetworkCount) {
+      credentialPrefs.putBytes(key, &savedNetworks[i], sizeof(SavedNetwork));
+    } else {
+      credentialPrefs.remove(key);
+    }
+  }
+  credentialPrefs.putUChar("count", savedNetworkCount);
+  credentialPrefs.putUChar("version", WIFI_STORE_VERSION);
+  credentialPrefs.end();
+}
+
+/*
+ * Load the store; a single ssid/password pair from older firmware is
+ * moved into slot 0 (without a cache) and the old keys are removed.
+ * Version 1 slots (shorter) are read too and the store is rewritten at the
+ * current size before anything marks it version 2; a damaged slot is
+ * skipped, not the end of the store.
+ */
+void loadSavedNetworks() {
+  if (savedNetworksLoaded) return;
+  savedNetworksLoaded = true;
+  savedNetworkCount = 0;
+  savedNetworkSeq = 0;
+
+  credentialPrefs.begin("wifi", true);
+  uint8_t version = credentialPrefs.getUChar("version", 0);
+  int count = (version == 1 || version == WIFI_STORE_VERSION) ? credentialPrefs.getUChar("count", 0) : 0;
+  bool rewrite = false;
+  for (int i = 0; i < count && savedNetworkCount < WIFI_MAX_SAVED_NETWORKS; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "net%d", i);
+    size_t length = credentialPrefs.getBytesLength(key);
+    if (length != sizeof(SavedNetwork) && length != WIFI_STORE_V1_SIZE) {
+      rewrite = true;  // Later slots move down
+      continue;
+    }
+    SavedNetwork &net = savedNetworks[savedNetworkCount];
+    memset(&net, 0, sizeof(SavedNetwork));  // Version 1: no lease time, DHCP next time
+    credentialPrefs.getBytes(key, &net, length);
+    if (length != sizeof(SavedNetwork)) rewrite = true;
+    savedNetworkSeq = max(savedNetworkSeq, net.lastUsed);
+    savedNetworkCount++;
+  }
+  String legacySSID = credentialPrefs.getString("ssid", "");
+  String legacyPassword = credentialPrefs.getString("password", "");
+  credentialPrefs.end();
+
+  if (rewrite || count > savedNetworkCount) {
+    Serial.printf("WiFi store rewritten (%d of %d networks kept)\n", savedNetworkCount, count);
+    writeAllSavedNetworks(count);
+  }
+
+  if (legacySSID.length() > 0) {
+    Serial.print("Migrating saved WiFi network: ");
+    Serial.println(legacySSID);
+    rememberNetwork(legacySSID, legacyPassword);
+    credentialPrefs.begin("wifi", false);
+    credentialPrefs.remove("ssid");
+    credentialPrefs.remove("password");
+    credentialPrefs.end();
+  }
+
+  Serial.printf("%d saved WiFi network(s)\n", savedNetworkCount);
+}
+
+int findSavedNetwork(const String &ssid) {
+  for (int i = 0; i < savedNetworkCount; i++) {
+    if (ssid == savedNetworks[i].ssid) return i;
+  }
+  return -1;
+}
+
+/*
+ * Add or update a network and mark it most recently used. A changed password
+ * drops the cache. When the store is full the least recently used slot goes.
+ */
+int rememberNetwork(const String &ssid, const String &password) {
+  loadSavedNetworks();
+
+  int slot = findSavedNetwork(ssid);
+  if (slot >= 0 && password == savedNetworks[slot].password) {
+    if (savedNetworks[slot].lastUsed == savedNetworkSeq) {
+      return slot;  // Already saved and newest, nothing to write
+    }
+  } else if (slot < 0) {
+    if (savedNetworkCount < WIFI_MAX_SAVED_NETWORKS) {
+      slot = savedNetworkCount++;
+    } else {
+      slot = 0;
+      for (int i = 1; i < savedNetworkCount; i++) {
+        if (savedNetworks[i].lastUsed < savedNetworks[slot].lastUsed) slot = i;
+      }
+      Serial.print("WiFi store full, forgetting ");
+      Serial.println(savedNetworks[slot].ssid);
+    }
+    memset(&savedNetworks[slot], 0, sizeof(SavedNetwork));
+    strlcpy(savedNetworks[slot].ssid, ssid.c_str(), sizeof(savedNetworks[slot].ssid));
+    strlcpy(savedNetworks[slot].password, password.c_str(), sizeof(savedNetworks[slot].password));
+  } else {
+    strlcpy(savedNetworks[slot].password, password.c_str(), sizeof(savedNetworks[slot].password));
+    clearNetworkCache(slot);
+  }
+
+  savedNetworks[slot].lastUsed = ++savedNetworkSeq;
+  writeSavedNetwork(slot);
+  Serial.println("WiFi credentials saved");
+  return slot;
+}
+
+// Seconds on the RTC clock (runs through deep sleep, restarts at power on)
+uint32_t wifiClockSeconds() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint32_t)tv.tv_sec;
+}
+
+uint32_t currentWiFiClockId() {
+  while (wifiClockId == 0) wifiClockId = esp_random();
+  return wifiClockId;
+}
+
+/*
+ * Record BSSID, channel and lease after a successful connect. dhcpLease:
+ * the address came from DHCP just now (not a cached one reapplied), so the
+ * reuse window starts again. Flash is only written when something changed,
+ * so a routine fast reconnect costs nothing.
+ */
+void updateNetworkCache(int slot, bool dhcpLease) {
+  if (slot < 0 || slot >= savedNetworkCount) return;
+  SavedNetwork &net = savedNetworks[slot];
+  SavedNetwork before = net;
+
+  WiFi.BSSID(net.bssid);
+  net.channel = WiFi.channel();
+  net.ip = WiFi.localIP();
+  net.gateway = WiFi.gatewayIP();
+  net.subnet = WiFi.subnetMask();
+  net.dns = WiFi.dnsIP();
+  if (dhcpLease) {
+    net.leaseAt = wifiClockSeconds();
+    net.leaseClock = currentWiFiClockId();
+  }
+  if (net.lastUsed != savedNetworkSeq) {
+    net.lastUsed = ++savedNetworkSeq;
+  }
+
+  if (memcmp(&before, &net, sizeof(SavedNetwork)) != 0) {
+    writeSavedNetwork(slot);
+  }
+}
+
+// Forget the cached BSSID/channel/lease (fast connect failed with them)
+void clearNetworkCache(int slot) {
+  if (slot < 0 || slot >= savedNetworkCount) return;
+  SavedNetwork &net = savedNetworks[slot];
+  memset(net.bssid, 0, sizeof(net.bssid));
+  net.channel = 0;
+  net.ip = net.gateway = net.subnet = net.dns = 0;
+  net.leaseAt = net.leaseClock = 0;
+}
+
+// The cached address is still ours: DHCP gave it out on this clock, recently enough
+bool networkLeaseValid(const SavedNetwork &net) {
+  return net.ip != 0 && net.leaseClock != 0 && net.leaseClock == currentWiFiClockId() &&
+         wifiClockSeconds() - net.leaseAt < WIFI_LEASE_REUSE_S;
+}
+
+bool hasNetworkCache(int slot) {
+  return slot >= 0 && slot < savedNetworkCount &&
+         savedNetworks[slot].channel != 0 && savedNetworks[slot].ip != 0;
+}
+
+/*
+ * Start the passive scan that ranks saved networks (async; poll
+ * WiFi.scanComplete(), then call rankSavedNetworks()). False when there is
+ * nothing to choose between, so no scan is needed.
+ */
+bool startSavedNetworkScan() {
+  loadSavedNetworks();
+  if (savedNetworkCount <= 1) return false;
+  passiveScanStartTime = millis();
+  WiFi.mode(WIFI_STA);
+  return WiFi.scanNetworks(true, false, true, WIFI_PASSIVE_SCAN_MS) == WIFI_SCAN_RUNNING;
+}
+
+/*
+ * Order saved networks for auto-connect; returns how many are in order[].
+ * Several saved: strongest in the finished passive scan first; if none was
+ * heard (or the scan failed or was never started), most recently used first.
+ */
+int rankSavedNetworks(int order[]) {
+  loadSavedNetworks();
+  if (savedNetworkCount <= 1) {
+    order[0] = 0;
+    return savedNetworkCount;
+  }
+
+  int rssi[WIFI_MAX_SAVED_NETWORKS];
+  for (int i = 0; i < savedNetworkCount; i++) rssi[i] = -1000;
+
+  int n = WiFi.scanComplete();
+  for (int i = 0; i < n; i++) {
+    int slot = findSavedNetwork(WiFi.SSID(i));
+    if (slot < 0 || WiFi.RSSI(i) <= rssi[slot]) continue;
+    rssi[slot] = WiFi.RSSI(i);
+
+    // Roamed or the AP changed channel: the cached BSSID/channel are stale
+    SavedNetwork &net = savedNetworks[slot];
+    if (net.channel != WiFi.channel(i) || memcmp(net.bssid, WiFi.BSSID(i), 6) != 0) {
+      memcpy(net.bssid, WiFi.BSSID(i), 6);
+      net.channel = WiFi.channel(i);
+    }
+  }
+  if (n >= 0) {
+    WiFi.scanDelete();
+    lastPassiveScanMs = millis() - passiveScanStartTime;
+    Serial.printf("Passive scan: %d networks in %lu ms\n", n, (unsigned long)lastPassiveScanMs);
+  }
+
+  for (int i = 0; i < savedNetworkCount; i++) order[i] = i;
+  for (int i = 1; i < savedNetworkCount; i++) {
+    int slot = order[i];
+    int j = i - 1;
+    while (j >= 0 && (rssi[order[j]] < rssi[slot] ||
+                      (rssi[order[j]] == rssi[slot] && savedNetworks[order[j]].lastUsed < savedNetworks[slot].lastUsed))) {
+      order[j + 1] = order[j];
+      j--;
+    }
+    order[j + 1] = slot;
+  }
+  return savedNetworkCount;
+}
+
+// Serial "wifi" command: list the store and what is cached
+void printSavedNetworks() {
+  loadSavedNetworks();
+  Serial.printf("Saved networks (%d/%d):\n", savedNetworkCount, WIFI_MAX_SAVED_NETWORKS);
+  for (int i = 0; i < savedNetworkCount; i++) {
+    const SavedNetwork &net = savedNetworks[i];
+    Serial.printf("  %d %-24s ", i, net.ssid);
+    if (hasNetworkCache(i)) {
+      Serial.printf("ch %2d  %02X:%02X:%02X:%02X:%02X:%02X  %s%s\n", net.channel,
+                    net.bssid[0], net.bssid[1], net.bssid[2], net.bssid[3], net.bssid[4], net.bssid[5],
+                    IPAddress(net.ip).toString().c_str(), networkLeaseValid(net) ? "" : " (lease expired, DHCP)");
+    } else {
+      Serial.println("(no cache)");
+    }
+  }
+}
+
+#endif // WIFI_CREDENTIALS_H